@@ -0,0 +1,200 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/binary.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/os/path.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/thread.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/utility.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class buffer_size_benchmark_app : public app {
+private:
+   //! Count of bytes transferred by each test.
+   static std::size_t const data_size = 64 * 1024 * 1024;
+   //! Size of each record written by the tests.
+   static std::size_t const record_size = 256;
+
+public:
+   /*! Main function of the program.
+
+   A test file is written to and read from the current directory, and the same amount of data is sent
+   through a pipe, once for each buffer size, plus once letting the buffers adapt to the stream (“auto”).
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Buffer [KiB]  file write [ns]  [MiB/s]  file read [ns]  [MiB/s]  pipe [ns]  [MiB/s]\n"
+      ));
+      os::path path(LOFTY_SL("buffer-size-benchmark.bin"));
+      // 0 stands for automatic sizing.
+      static std::size_t const buf_sizes[] = { 0x1000, 0x4000, 0x10000, 0x40000, 0x100000, 0 };
+      for (std::size_t i = 0; i < sizeof buf_sizes / sizeof buf_sizes[0]; ++i) {
+         std::size_t buf_size = buf_sizes[i];
+         auto write_sw(write_file(path, buf_size)), read_sw(read_file(path, buf_size));
+         auto pipe_sw(transfer_through_pipe(buf_size));
+         if (buf_size) {
+            io::text::stdout->print(LOFTY_SL("{:12}"), buf_size / 1024);
+         } else {
+            io::text::stdout->print(LOFTY_SL("auto        "));
+         }
+         io::text::stdout->print(
+            LOFTY_SL("  {:15}  {:7}  {:14}  {:7}  {:9}  {:7}\n"),
+            write_sw, get_mib_per_s(write_sw), read_sw, get_mib_per_s(read_sw),
+            pipe_sw, get_mib_per_s(pipe_sw)
+         );
+      }
+      return 0;
+   }
+
+private:
+   /*! Reads all the data from a buffered stream.
+
+   @param buf_istream
+      Stream to read from.
+   @return
+      Count of bytes read.
+   */
+   static std::size_t drain(io::binary::buffered_istream * buf_istream) {
+      std::size_t read_size = 0;
+      for (;;) {
+         auto peeked(buf_istream->peek<std::uint8_t>(1));
+         if (!peeked.size) {
+            break;
+         }
+         read_size += peeked.size;
+         buf_istream->consume<std::uint8_t>(peeked.size);
+      }
+      return read_size;
+   }
+
+   /*! Writes data_size bytes to a buffered stream, one record at a time.
+
+   @param buf_ostream
+      Stream to write to.
+   */
+   static void fill(io::binary::buffered_ostream * buf_ostream) {
+      for (std::size_t written_size = 0; written_size < data_size; written_size += record_size) {
+         auto record(buf_ostream->get_buffer<std::uint8_t>(record_size));
+         for (std::size_t i = 0; i < record_size; ++i) {
+            record.ptr[i] = static_cast<std::uint8_t>(i);
+         }
+         buf_ostream->commit<std::uint8_t>(record_size);
+      }
+      buf_ostream->close();
+   }
+
+   /*! Returns the throughput achieved by a test.
+
+   @param sw
+      Time taken by the test.
+   @return
+      Throughput, in MiB/s.
+   */
+   static std::uint64_t get_mib_per_s(perf::stopwatch const & sw) {
+      return static_cast<std::uint64_t>(data_size / 1024 / 1024) * 1000000000u /
+         (sw.duration() > 0 ? sw.duration() : 1);
+   }
+
+   /*! Reads the test file.
+
+   @param path
+      Path to the file to read.
+   @param buf_size
+      Size of the buffer, or 0 for automatic sizing.
+   @return
+      Time taken to read the file.
+   */
+   static perf::stopwatch read_file(os::path const & path, std::size_t buf_size) {
+      LOFTY_TRACE_FUNC();
+
+      perf::stopwatch sw;
+      sw.start();
+      auto buf_istream(io::binary::buffer_istream(io::binary::open_istream(path), buf_size));
+      std::size_t read_size = drain(buf_istream.get());
+      sw.stop();
+      if (read_size != data_size) {
+         io::text::stdout->print(LOFTY_SL("ERROR: read {} bytes from {}\n"), read_size, path);
+      }
+      return sw;
+   }
+
+   /*! Sends data_size bytes through a pipe, from a separate thread.
+
+   @param buf_size
+      Size of the buffers at both ends of the pipe, or 0 for automatic sizing.
+   @return
+      Time taken to receive all the data.
+   */
+   static perf::stopwatch transfer_through_pipe(std::size_t buf_size) {
+      LOFTY_TRACE_FUNC();
+
+      perf::stopwatch sw;
+      io::binary::pipe pipe;
+      sw.start();
+      // Let the buffered write end be the only owner of the pipe’s write end, so it will close it.
+      auto buf_ostream(io::binary::buffer_ostream(_std::move(pipe.write_end), buf_size));
+      thread writer_thread([&buf_ostream] () {
+         fill(buf_ostream.get());
+      });
+      auto buf_istream(io::binary::buffer_istream(pipe.read_end, buf_size));
+      std::size_t read_size = drain(buf_istream.get());
+      writer_thread.join();
+      sw.stop();
+      if (read_size != data_size) {
+         io::text::stdout->print(LOFTY_SL("ERROR: read {} bytes from a pipe\n"), read_size);
+      }
+      return sw;
+   }
+
+   /*! (Re)creates the test file.
+
+   @param path
+      Path to the file to write.
+   @param buf_size
+      Size of the buffer, or 0 for automatic sizing.
+   @return
+      Time taken to write the file.
+   */
+   static perf::stopwatch write_file(os::path const & path, std::size_t buf_size) {
+      LOFTY_TRACE_FUNC();
+
+      perf::stopwatch sw;
+      sw.start();
+      auto buf_ostream(io::binary::buffer_ostream(io::binary::open_ostream(path), buf_size));
+      fill(buf_ostream.get());
+      sw.stop();
+      return sw;
+   }
+};
+
+LOFTY_APP_CLASS(buffer_size_benchmark_app)
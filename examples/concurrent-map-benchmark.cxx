@@ -0,0 +1,156 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/concurrent_hash_map.hxx>
+#include <lofty/collections/hash_map.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/thread.hxx>
+#include <lofty/_std/atomic.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+//! hash_map guarded by a single mutex, the alternative to concurrent_hash_map.
+class locked_hash_map {
+public:
+   bool add_or_assign(unsigned key, unsigned value) {
+      _std::lock_guard<_std::mutex> lock(mutex);
+      return map.add_or_assign(key, value).added;
+   }
+
+   bool find(unsigned key, unsigned * value) const {
+      _std::lock_guard<_std::mutex> lock(mutex);
+      auto itr(map.find(key));
+      if (itr == map.cend()) {
+         return false;
+      }
+      *value = itr->value;
+      return true;
+   }
+
+private:
+   //! Guards map.
+   mutable _std::mutex mutex;
+   //! Map.
+   collections::hash_map<unsigned, unsigned> map;
+};
+
+} //namespace
+
+//! Application class for this program.
+class concurrent_map_benchmark_app : public app {
+private:
+   //! Count of keys in the map.
+   static unsigned const keys_size = 100000;
+   //! Count of operations performed by each thread.
+   static unsigned const ops_per_thread = 200000;
+
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Threads  Reads [%]  hash_map + mutex [ns]  concurrent_hash_map [ns]\n"
+      ));
+      static unsigned const threads_sizes[] = { 1, 2, 4, 8 };
+      static unsigned const read_percents[] = { 100, 90, 50 };
+      for (std::size_t i = 0; i < sizeof threads_sizes / sizeof threads_sizes[0]; ++i) {
+         for (std::size_t j = 0; j < sizeof read_percents / sizeof read_percents[0]; ++j) {
+            unsigned threads_size = threads_sizes[i], read_percent = read_percents[j];
+            locked_hash_map locked_map;
+            collections::concurrent_hash_map<unsigned, unsigned> concurrent_map;
+            auto locked_sw(run_test(&locked_map, threads_size, read_percent));
+            auto concurrent_sw(run_test(&concurrent_map, threads_size, read_percent));
+            io::text::stdout->print(
+               LOFTY_SL("{:7}  {:9}  {:21}  {:24}\n"), threads_size, read_percent, locked_sw, concurrent_sw
+            );
+         }
+      }
+      return 0;
+   }
+
+private:
+   /*! Fills a map, then has the specified count of threads perform a mix of lookups and assignments on it.
+
+   @param map
+      Pointer to the map to test.
+   @param threads_size
+      Count of threads to run.
+   @param read_percent
+      Percentage of operations that are lookups; the rest are assignments.
+   @return
+      Time taken by the threads to complete their operations.
+   */
+   template <typename TMap>
+   perf::stopwatch run_test(TMap * map, unsigned threads_size, unsigned read_percent) {
+      LOFTY_TRACE_METHOD();
+
+      for (unsigned key = 0; key < keys_size; ++key) {
+         map->add_or_assign(key, key);
+      }
+      _std::atomic<unsigned> errors(0);
+      _std::unique_ptr<thread[]> threads(new thread[threads_size]);
+      perf::stopwatch sw;
+      sw.start();
+      for (unsigned i = 0; i < threads_size; ++i) {
+         threads[i] = thread([map, read_percent, i, &errors] () {
+            // Cheap per-thread pseudo-random sequence (xorshift).
+            std::uint32_t rand = 2463534242u + i;
+            for (unsigned op = 0; op < ops_per_thread; ++op) {
+               rand ^= rand << 13;
+               rand ^= rand >> 17;
+               rand ^= rand << 5;
+               unsigned key = rand % keys_size;
+               if (rand / keys_size % 100 < read_percent) {
+                  unsigned value;
+                  if (!map->find(key, &value) || value != key) {
+                     ++errors;
+                  }
+               } else {
+                  map->add_or_assign(key, key);
+               }
+            }
+         });
+      }
+      for (unsigned i = 0; i < threads_size; ++i) {
+         threads[i].join();
+      }
+      sw.stop();
+      if (errors.load()) {
+         io::text::stdout->print(LOFTY_SL("ERROR: {} lookups failed\n"), errors.load());
+      }
+      return sw;
+   }
+};
+
+LOFTY_APP_CLASS(concurrent_map_benchmark_app)
@@ -0,0 +1,846 @@
+/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+/*! @file
+Coroutine scheduler benchmark
+
+Simulates a server with many mostly idle connections: each connection is a pipe with a coroutine blocked
+reading from it, and a driver coroutine repeatedly writes to a small subset of the pipes at once, so that
+many file descriptors become ready at the same moment. For each scheduler configuration, the program reports
+how many times the scheduler entered the OS readiness notification API (Linux only) for each coroutine
+context switch it performed.
+
+Then it runs CPU-bound coroutines that periodically yield, on an increasing number of threads sharing the
+same scheduler, to show how well the scheduler spreads work across threads.
+
+Then it counts how many memory allocations (Linux only) each context switch costs once coroutines are
+running in a steady state, whether they yield or wait for a pipe or an event; this should always be none.
+
+Then it runs many echo connections over pipes (Linux only) with I/O performed via epoll readiness
+notifications and via io_uring, comparing time and readiness notification syscalls.
+
+Then it passes values from producer to consumer coroutines, via pairs of events and via channels, one value
+at a time and in batches, to compare the throughput of each handoff method.
+
+Then it has many coroutines contend for a single lock: a lofty::mutex, a lofty::shared_mutex locked
+exclusively, and a lofty::shared_mutex locked mostly for reading.
+
+Finally, it simulates RPC-style clients of a lofty::keyed_demux: thousands of coroutines each send a request
+key to a source coroutine, and wait for the response with that key. */
+
+#include <lofty/app.hxx>
+#include <lofty/channel.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/coroutine.hxx>
+#include <lofty/event.hxx>
+#include <lofty/io/binary.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/keyed_demux.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/mutex.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/range.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/thread.hxx>
+#include <lofty/_std/atomic.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
+#if LOFTY_HOST_API_POSIX
+   #include <sys/resource.h> // getrlimit() setrlimit()
+#endif
+#if LOFTY_HOST_API_LINUX
+   #include <dlfcn.h> // dlsym()
+#endif
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+//! Count of calls made to the OS readiness notification API since the last reset.
+_std::atomic<std::size_t> poll_syscalls(0);
+//! Count of memory allocations since the last reset.
+_std::atomic<std::size_t> allocations(0);
+//! Count of context switches performed by each coroutine in the allocations test before counting begins.
+std::size_t const steady_state_warmup_switches = 1000;
+//! Count of context switches performed by each coroutine in the allocations test while counting.
+std::size_t const steady_state_switches = 100000;
+//! Count of times the driver will wake a subset of the connections.
+std::size_t const rounds = 100;
+//! 1 out of this many connections is woken up in each round.
+std::size_t const active_conns_divisor = 20;
+//! Count of CPU-bound coroutines to run in the scaling test.
+std::size_t const cpu_bound_coros = 256;
+//! Count of times each CPU-bound coroutine yields before returning.
+std::size_t const cpu_bound_slices = 200;
+//! Iterations of busy work performed by CPU-bound coroutines between yields.
+std::size_t const cpu_bound_slice_iterations = 5000;
+//! Count of connections in the echo test.
+std::size_t const echo_conns = 256;
+//! Count of round trips performed on each connection in the echo test.
+std::size_t const echo_round_trips = 200;
+//! Count of producer/consumer pairs in the handoff test.
+std::size_t const handoff_pairs = 16;
+//! Count of values passed from each producer to its consumer in the handoff test.
+std::size_t const handoff_values = 20000;
+//! Maximum count of values passed at once in batched handoffs.
+std::size_t const handoff_batch_size = 64;
+//! Capacity of each channel in the handoff test.
+std::size_t const handoff_channel_capacity = 256;
+//! Count of coroutines contending for the lock in the lock test.
+std::size_t const lock_coros = 64;
+//! Count of times each coroutine in the lock test acquires the lock.
+std::size_t const lock_iterations = 5000;
+//! In the readers/writer variant of the lock test, 1 out of this many acquisitions is exclusive.
+std::size_t const lock_writes_divisor = 10;
+//! Count of clients, each with its own key, in the keyed_demux test.
+std::size_t const demux_clients = 4096;
+//! Count of requests sent by each client in the keyed_demux test.
+std::size_t const demux_requests = 50;
+
+} //namespace
+
+#if LOFTY_HOST_API_LINUX
+/* Interpose the epoll API used by lofty::coroutine::scheduler to count how many times it enters the kernel.
+<sys/epoll.h> is deliberately not included, to avoid conflicting with its declarations. */
+
+struct epoll_event;
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, ::epoll_event * ee);
+extern "C" int epoll_wait(int epfd, ::epoll_event * ees, int ees_max, int timeout);
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, ::epoll_event * ee) {
+   typedef int (* epoll_ctl_fn)(int, int, int, ::epoll_event *);
+   static epoll_ctl_fn real_epoll_ctl = reinterpret_cast<epoll_ctl_fn>(::dlsym(RTLD_NEXT, "epoll_ctl"));
+   poll_syscalls.fetch_add(1);
+   return real_epoll_ctl(epfd, op, fd, ee);
+}
+
+extern "C" int epoll_wait(int epfd, ::epoll_event * ees, int ees_max, int timeout) {
+   typedef int (* epoll_wait_fn)(int, ::epoll_event *, int, int);
+   static epoll_wait_fn real_epoll_wait = reinterpret_cast<epoll_wait_fn>(::dlsym(RTLD_NEXT, "epoll_wait"));
+   poll_syscalls.fetch_add(1);
+   return real_epoll_wait(epfd, ees, ees_max, timeout);
+}
+
+/* Interpose the C allocator, which both Lofty and operator new end up calling, to count allocations. dlsym()
+can allocate memory, so the glibc entry points are called directly instead. */
+
+extern "C" void * __libc_malloc(std::size_t size);
+extern "C" void * __libc_calloc(std::size_t count, std::size_t size);
+extern "C" void * __libc_realloc(void * p, std::size_t size);
+
+extern "C" void * malloc(std::size_t size) {
+   allocations.fetch_add(1);
+   return __libc_malloc(size);
+}
+
+extern "C" void * calloc(std::size_t count, std::size_t size) {
+   allocations.fetch_add(1);
+   return __libc_calloc(count, size);
+}
+
+extern "C" void * realloc(void * p, std::size_t size) {
+   allocations.fetch_add(1);
+   return __libc_realloc(p, size);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class coroutines_benchmark_app : public app {
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      std::size_t conns = raise_file_limit(10000);
+      io::text::stdout->print(
+         LOFTY_SL("{} connections, {} rounds, {} ready connections per round\n"),
+         conns, rounds, conns / active_conns_divisor
+      );
+      io::text::stdout->print(LOFTY_SL(
+         "  max_events_per_wait     Total time [ns]  Context switches  Poll syscalls  Syscalls/100 switches\n"
+      ));
+      static unsigned const max_events_per_wait_values[] = { 1, 16, 64, 256 };
+      LOFTY_FOR_EACH(unsigned max_events_per_wait, max_events_per_wait_values) {
+         coroutine::scheduler_options coro_sched_opts;
+         coro_sched_opts.max_events_per_wait = max_events_per_wait;
+         run_idle_connections_test(coro_sched_opts, conns);
+      }
+
+      io::text::stdout->print(
+         LOFTY_SL("\n{} CPU-bound coroutines, {} slices each\n"), cpu_bound_coros, cpu_bound_slices
+      );
+      io::text::stdout->print(LOFTY_SL("  Threads     Total time [ns]  Context switches\n"));
+      static std::size_t const threads_sizes[] = { 1, 2, 4, 8 };
+      LOFTY_FOR_EACH(std::size_t threads_size, threads_sizes) {
+         run_cpu_bound_test(threads_size);
+      }
+
+#if LOFTY_HOST_API_LINUX
+      io::text::stdout->print(
+         LOFTY_SL("\nSteady state after {} context switches per coroutine\n"), steady_state_warmup_switches
+      );
+      io::text::stdout->print(
+         LOFTY_SL("  Context switches  Allocations  Allocations/1000 switches  Wait type\n")
+      );
+      run_yield_allocations_test();
+      run_pipe_allocations_test();
+      run_event_allocations_test();
+
+      io::text::stdout->print(
+         LOFTY_SL("\n{} echo connections, {} round trips each\n"), echo_conns, echo_round_trips
+      );
+      io::text::stdout->print(LOFTY_SL("      Total time [ns]  Poll syscalls  Engine\n"));
+      run_echo_test(false);
+      run_echo_test(true);
+#endif
+
+      io::text::stdout->print(
+         LOFTY_SL("\n{} producer/consumer pairs, {} values each\n"), handoff_pairs, handoff_values
+      );
+      io::text::stdout->print(LOFTY_SL("  Threads     Total time [ns]      Values/s  Handoff\n"));
+      static std::size_t const handoff_threads_sizes[] = { 1, 4 };
+      LOFTY_FOR_EACH(std::size_t threads_size, handoff_threads_sizes) {
+         run_handoff_test(threads_size, false, false);
+         run_handoff_test(threads_size, true, false);
+         run_handoff_test(threads_size, true, true);
+      }
+
+      io::text::stdout->print(
+         LOFTY_SL("\n{} coroutines contending for a lock, {} acquisitions each\n"),
+         lock_coros, lock_iterations
+      );
+      io::text::stdout->print(LOFTY_SL("  Threads     Total time [ns]       Locks/s  Lock\n"));
+      LOFTY_FOR_EACH(std::size_t threads_size, handoff_threads_sizes) {
+         run_lock_test(threads_size, false, false);
+         run_lock_test(threads_size, true, false);
+         run_lock_test(threads_size, true, true);
+      }
+
+      io::text::stdout->print(
+         LOFTY_SL("\n{} keyed_demux clients, {} requests each\n"), demux_clients, demux_requests
+      );
+      io::text::stdout->print(LOFTY_SL("      Total time [ns]   Responses/s\n"));
+      run_demux_test();
+      return 0;
+   }
+
+private:
+   /*! Prints the results of an allocations test.
+
+   @param wait_type
+      Description of what the coroutines waited for.
+   @param context_switches
+      Count of context switches performed while counting allocations.
+   @param allocs
+      Count of allocations performed while counting.
+   */
+   static void print_allocations(
+      text::str const & wait_type, std::size_t context_switches, std::size_t allocs
+   ) {
+      io::text::stdout->print(
+         LOFTY_SL("  {:16}  {:11}  {:25}  {}\n"), context_switches, allocs,
+         context_switches ? allocs * 1000 / context_switches : 0, wait_type
+      );
+   }
+
+   /*! Raises the limit of open file descriptors as necessary to run the test with the requested count of
+   connections.
+
+   @param conns
+      Desired count of connections.
+   @return
+      Count of connections that can be opened within the allowed limit.
+   */
+   static std::size_t raise_file_limit(std::size_t conns) {
+#if LOFTY_HOST_API_POSIX
+      // Each connection uses two file descriptors; leave some room for everything else.
+      ::rlim_t needed = static_cast< ::rlim_t>(conns * 2 + 64);
+      ::rlimit rl;
+      if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < needed) {
+         rl.rlim_cur = rl.rlim_max == RLIM_INFINITY || rl.rlim_max > needed ? needed : rl.rlim_max;
+         if (::setrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < needed) {
+            conns = static_cast<std::size_t>((rl.rlim_cur - 64) / 2);
+         } else if (rl.rlim_cur < needed) {
+            ::getrlimit(RLIMIT_NOFILE, &rl);
+            conns = static_cast<std::size_t>((rl.rlim_cur - 64) / 2);
+         }
+      }
+#endif
+      return conns;
+   }
+
+   /*! Runs CPU-bound coroutines on a new coroutine scheduler shared by the specified count of threads, then
+   prints the results.
+
+   @param threads_size
+      Count of threads that will run the scheduler, including the current one.
+   */
+   void run_cpu_bound_test(std::size_t threads_size) {
+      LOFTY_TRACE_METHOD();
+
+      auto coro_sched(this_thread::attach_coroutine_scheduler());
+      _std::atomic<std::size_t> context_switches(0);
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), cpu_bound_coros)) {
+         LOFTY_UNUSED_ARG(i);
+         coroutine([&context_switches] () {
+            std::size_t volatile work = 0;
+            LOFTY_FOR_EACH(auto slice, make_range(std::size_t(0), cpu_bound_slices)) {
+               LOFTY_UNUSED_ARG(slice);
+               LOFTY_FOR_EACH(auto j, make_range(std::size_t(0), cpu_bound_slice_iterations)) {
+                  work = work + j;
+               }
+               // Yield to the other coroutines.
+               this_coroutine::sleep_for_ms(0);
+            }
+            context_switches.fetch_add(cpu_bound_slices);
+         });
+      }
+      perf::stopwatch sw;
+      sw.start();
+      run_coroutines_on_threads(coro_sched, threads_size);
+      sw.stop();
+
+      io::text::stdout->print(
+         LOFTY_SL("  {:7}  {:18}  {:16}\n"), threads_size, sw, context_switches.load()
+      );
+   }
+
+   /*! Runs client coroutines that wait for responses from a keyed_demux, on a new coroutine scheduler, then
+   prints the results. Only one thread is used, since a client must be waiting for a response before the
+   source can return it. */
+   void run_demux_test() {
+      LOFTY_TRACE_METHOD();
+
+      this_thread::attach_coroutine_scheduler();
+      {
+         // Requests from the clients, consumed by the demux source.
+         channel<std::size_t> requests;
+         keyed_demux<std::size_t, std::size_t> responses;
+         responses.set_source([&requests] (std::size_t * key) -> std::size_t {
+            /* A request with the client’s key is answered with key + 1, since 0 would end the source. If many
+            requests are queued, this will return responses without blocking, delivering them in a burst. */
+            if (!requests.receive(key)) {
+               return 0;
+            }
+            return *key + 1;
+         });
+         _std::atomic<std::size_t> clients_left(demux_clients), responses_sum(0);
+         LOFTY_FOR_EACH(auto client, make_range(std::size_t(0), demux_clients)) {
+            coroutine([&requests, &responses, &clients_left, &responses_sum, client] () {
+               std::size_t sum = 0;
+               LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), demux_requests)) {
+                  LOFTY_UNUSED_ARG(i);
+                  requests.send(client);
+                  sum += responses.get(client);
+               }
+               responses_sum.fetch_add(sum);
+               if (clients_left.fetch_sub(1) == 1) {
+                  requests.close();
+               }
+            });
+         }
+
+         perf::stopwatch sw;
+         sw.start();
+         this_thread::run_coroutines();
+         auto ns = sw.stop();
+
+         if (responses_sum.load() != demux_requests * demux_clients * (demux_clients + 1) / 2) {
+            io::text::stderr->print(LOFTY_SL("keyed_demux test: responses were lost or mismatched\n"));
+         }
+         std::size_t responses_size = demux_clients * demux_requests;
+         io::text::stdout->print(
+            LOFTY_SL("  {:19}  {:12}\n"), sw,
+            ns ? static_cast<std::uint64_t>(responses_size) * 1000000000u / ns : 0
+         );
+      }
+      this_thread::detach_coroutine_scheduler();
+   }
+
+   /*! Runs producer coroutines that pass values to consumer coroutines, on a new coroutine scheduler shared
+   by the specified count of threads, then prints the results.
+
+   @param threads_size
+      Count of threads that will run the scheduler, including the current one.
+   @param use_channel
+      If true, values will be passed via a channel; if false, via a pair of events, one value at a time.
+   @param batch
+      If true (and use_channel is true), values will be sent and received up to handoff_batch_size at a time.
+   */
+   void run_handoff_test(std::size_t threads_size, bool use_channel, bool batch) {
+      LOFTY_TRACE_METHOD();
+
+      //! Value slot and the events used to hand it off.
+      struct event_handoff {
+         //! Triggered by the producer when value is ready.
+         event ready;
+         //! Triggered by the consumer after reading value.
+         event taken;
+         //! Value being passed.
+         std::size_t value;
+      };
+
+      auto coro_sched(this_thread::attach_coroutine_scheduler());
+      // Must be created while the scheduler is attached, to be usable by coroutines.
+      collections::vector<_std::unique_ptr<event_handoff>> event_handoffs;
+      collections::vector<_std::unique_ptr<channel<std::size_t>>> channels;
+      _std::atomic<std::size_t> received_sum(0);
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), handoff_pairs)) {
+         LOFTY_UNUSED_ARG(i);
+         if (use_channel) {
+            auto chan = new channel<std::size_t>(handoff_channel_capacity);
+            channels.push_back(_std::unique_ptr<channel<std::size_t>>(chan));
+            coroutine([chan, batch] () {
+               if (batch) {
+                  std::size_t values[handoff_batch_size];
+                  for (std::size_t sent = 0; sent < handoff_values; sent += handoff_batch_size) {
+                     std::size_t count = handoff_values - sent;
+                     if (count > handoff_batch_size) {
+                        count = handoff_batch_size;
+                     }
+                     LOFTY_FOR_EACH(auto j, make_range(std::size_t(0), count)) {
+                        values[j] = sent + j;
+                     }
+                     chan->send_many(values, count);
+                  }
+               } else {
+                  LOFTY_FOR_EACH(auto value, make_range(std::size_t(0), handoff_values)) {
+                     chan->send(value);
+                  }
+               }
+               chan->close();
+            });
+            coroutine([chan, batch, &received_sum] () {
+               std::size_t sum = 0;
+               if (batch) {
+                  std::size_t values[handoff_batch_size];
+                  while (std::size_t count = chan->receive_many(values, handoff_batch_size)) {
+                     LOFTY_FOR_EACH(auto j, make_range(std::size_t(0), count)) {
+                        sum += values[j];
+                     }
+                  }
+               } else {
+                  std::size_t value;
+                  while (chan->receive(&value)) {
+                     sum += value;
+                  }
+               }
+               received_sum.fetch_add(sum);
+            });
+         } else {
+            auto handoff = new event_handoff();
+            event_handoffs.push_back(_std::unique_ptr<event_handoff>(handoff));
+            coroutine([handoff] () {
+               LOFTY_FOR_EACH(auto value, make_range(std::size_t(0), handoff_values)) {
+                  handoff->value = value;
+                  handoff->ready.trigger();
+                  handoff->taken.wait();
+               }
+            });
+            coroutine([handoff, &received_sum] () {
+               std::size_t sum = 0;
+               LOFTY_FOR_EACH(auto j, make_range(std::size_t(0), handoff_values)) {
+                  LOFTY_UNUSED_ARG(j);
+                  handoff->ready.wait();
+                  sum += handoff->value;
+                  handoff->taken.trigger();
+               }
+               received_sum.fetch_add(sum);
+            });
+         }
+      }
+
+      perf::stopwatch sw;
+      sw.start();
+      run_coroutines_on_threads(coro_sched, threads_size);
+      auto ns = sw.stop();
+
+      if (received_sum.load() != handoff_pairs * handoff_values * (handoff_values - 1) / 2) {
+         io::text::stderr->print(LOFTY_SL("handoff test: values were lost or duplicated\n"));
+      }
+      std::size_t values_size = handoff_pairs * handoff_values;
+      text::str handoff;
+      if (!use_channel) {
+         handoff = LOFTY_SL("events");
+      } else if (batch) {
+         handoff = LOFTY_SL("channel, batched");
+      } else {
+         handoff = LOFTY_SL("channel");
+      }
+      io::text::stdout->print(
+         LOFTY_SL("  {:7}  {:18}  {:12}  {}\n"), threads_size, sw,
+         ns ? static_cast<std::uint64_t>(values_size) * 1000000000u / ns : 0, handoff
+      );
+   }
+
+   /*! Runs coroutines that repeatedly acquire the same lock, on a new coroutine scheduler shared by the
+   specified count of threads, then prints the results.
+
+   @param threads_size
+      Count of threads that will run the scheduler, including the current one.
+   @param use_shared_mutex
+      If true, the lock will be a lofty::shared_mutex; if false, a lofty::mutex.
+   @param mostly_shared
+      If true (and use_shared_mutex is true), most acquisitions will be shared instead of exclusive.
+   */
+   void run_lock_test(std::size_t threads_size, bool use_shared_mutex, bool mostly_shared) {
+      LOFTY_TRACE_METHOD();
+
+      auto coro_sched(this_thread::attach_coroutine_scheduler());
+      // Must be created while the scheduler is attached, to be usable by coroutines.
+      mutex excl_mutex;
+      shared_mutex rw_mutex;
+      // Only modified while holding an exclusive lock; verifies that no increments are lost.
+      std::size_t counter = 0;
+      _std::atomic<std::size_t> expected_counter(0);
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), lock_coros)) {
+         coroutine([
+            &excl_mutex, &rw_mutex, &counter, &expected_counter, use_shared_mutex, mostly_shared, i
+         ] () {
+            std::size_t volatile read_value = 0;
+            std::size_t writes = 0;
+            LOFTY_FOR_EACH(auto j, make_range(std::size_t(0), lock_iterations)) {
+               if (!use_shared_mutex) {
+                  _std::lock_guard<mutex> lock(excl_mutex);
+                  ++counter;
+                  ++writes;
+               } else if (mostly_shared && (i + j) % lock_writes_divisor != 0) {
+                  rw_mutex.lock_shared();
+                  read_value = counter;
+                  rw_mutex.unlock_shared();
+               } else {
+                  rw_mutex.lock();
+                  ++counter;
+                  rw_mutex.unlock();
+                  ++writes;
+               }
+               if (j % 100 == 99) {
+                  // Let other coroutines on this thread run, too.
+                  this_coroutine::sleep_for_ms(0);
+               }
+            }
+            LOFTY_UNUSED_ARG(read_value);
+            expected_counter.fetch_add(writes);
+         });
+      }
+
+      perf::stopwatch sw;
+      sw.start();
+      run_coroutines_on_threads(coro_sched, threads_size);
+      auto ns = sw.stop();
+
+      if (counter != expected_counter.load()) {
+         io::text::stderr->print(LOFTY_SL("lock test: increments were lost\n"));
+      }
+      std::size_t locks_size = lock_coros * lock_iterations;
+      text::str lock_type;
+      if (!use_shared_mutex) {
+         lock_type = LOFTY_SL("mutex");
+      } else if (mostly_shared) {
+         lock_type = LOFTY_SL("shared_mutex, mostly shared");
+      } else {
+         lock_type = LOFTY_SL("shared_mutex, exclusive");
+      }
+      io::text::stdout->print(
+         LOFTY_SL("  {:7}  {:18}  {:12}  {}\n"), threads_size, sw,
+         ns ? static_cast<std::uint64_t>(locks_size) * 1000000000u / ns : 0, lock_type
+      );
+   }
+
+   /*! Runs a coroutine scheduler that’s attached to the current thread on the specified count of threads,
+   until all its coroutines terminate. Detaches the scheduler from the current thread before returning.
+
+   @param coro_sched
+      Scheduler to run.
+   @param threads_size
+      Count of threads that will run the scheduler, including the current one.
+   */
+   static void run_coroutines_on_threads(
+      _std::shared_ptr<coroutine::scheduler> const & coro_sched, std::size_t threads_size
+   ) {
+      // Threads must not be started while this thread has a scheduler; see the coroutine tests.
+      this_thread::detach_coroutine_scheduler();
+      collections::vector<thread> threads;
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(1), threads_size)) {
+         LOFTY_UNUSED_ARG(i);
+         threads.push_back(thread([&coro_sched] () {
+            this_thread::attach_coroutine_scheduler(coro_sched);
+            this_thread::run_coroutines();
+         }));
+      }
+      this_thread::attach_coroutine_scheduler(coro_sched);
+      this_thread::run_coroutines();
+      LOFTY_FOR_EACH(auto & thread, threads) {
+         thread.join();
+      }
+      this_thread::detach_coroutine_scheduler();
+   }
+
+   /*! Runs the test on a new coroutine scheduler, then prints the results.
+
+   @param coro_sched_opts
+      Options for the scheduler.
+   @param conns
+      Count of connections to simulate.
+   */
+   void run_idle_connections_test(
+      coroutine::scheduler_options const & coro_sched_opts, std::size_t conns
+   ) {
+      LOFTY_TRACE_METHOD();
+
+      this_thread::attach_coroutine_scheduler(coro_sched_opts);
+
+      collections::vector<_std::unique_ptr<io::binary::pipe>> pipes;
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), conns)) {
+         LOFTY_UNUSED_ARG(i);
+         pipes.push_back(_std::unique_ptr<io::binary::pipe>(new io::binary::pipe()));
+      }
+
+      std::size_t context_switches = 0, reads = 0, expected_reads = 0;
+      // Triggered by the reader that completes a round.
+      event * round_done_ptr = nullptr;
+      LOFTY_FOR_EACH(auto & pipe, pipes) {
+         auto read_end(pipe->read_end);
+         coroutine([read_end, &context_switches, &reads, &expected_reads, &round_done_ptr] () {
+            int i;
+            for (;;) {
+               // This will block most of the time, so that resuming here counts as a context switch.
+               std::size_t bytes_read = read_end->read(&i);
+               ++context_switches;
+               if (bytes_read == 0) {
+                  break;
+               }
+               if (++reads == expected_reads) {
+                  round_done_ptr->trigger();
+               }
+            }
+         });
+      }
+
+      // The driver wakes a different subset of connections in each round.
+      coroutine([&pipes, &expected_reads, &round_done_ptr, conns] () {
+         std::size_t active_conns = conns / active_conns_divisor;
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), rounds)) {
+            event round_done;
+            round_done_ptr = &round_done;
+            expected_reads += active_conns;
+            std::size_t first_conn = round % active_conns_divisor;
+            LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), active_conns)) {
+               pipes[static_cast<std::ptrdiff_t>(first_conn + i * active_conns_divisor)]->write_end->write(
+                  static_cast<int>(round)
+               );
+            }
+            // Wait for the readers to catch up.
+            round_done.wait();
+            round_done_ptr = nullptr;
+         }
+         LOFTY_FOR_EACH(auto & pipe, pipes) {
+            pipe->write_end->close();
+         }
+      });
+
+      perf::stopwatch sw;
+      poll_syscalls.store(0);
+      sw.start();
+      this_thread::run_coroutines();
+      sw.stop();
+      this_thread::detach_coroutine_scheduler();
+
+      io::text::stdout->print(
+         LOFTY_SL("  {:19}  {:18}  {:16}  {:13}  {:21}\n"),
+         coro_sched_opts.max_events_per_wait, sw, context_switches, poll_syscalls.load(),
+         context_switches ? poll_syscalls.load() * 100 / context_switches : 0
+      );
+   }
+
+#if LOFTY_HOST_API_LINUX
+   /*! Runs clients that send values over pipes to servers that echo them back, then prints the results.
+
+   @param use_io_uring
+      If true, I/O will be performed via io_uring; if false, via epoll readiness notifications.
+   */
+   void run_echo_test(bool use_io_uring) {
+      LOFTY_TRACE_METHOD();
+
+      coroutine::scheduler_options coro_sched_opts;
+      coro_sched_opts.use_io_uring = use_io_uring;
+      this_thread::attach_coroutine_scheduler(coro_sched_opts);
+
+      collections::vector<_std::shared_ptr<io::binary::pipe>> requests, replies;
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), echo_conns)) {
+         LOFTY_UNUSED_ARG(i);
+         auto request(_std::make_shared<io::binary::pipe>()), reply(_std::make_shared<io::binary::pipe>());
+         requests.push_back(request);
+         replies.push_back(reply);
+         coroutine([request, reply] () {
+            int value;
+            // Echo every value back, until the client is done.
+            while (request->read_end->read(&value)) {
+               reply->write_end->write(value);
+            }
+            reply->write_end->close();
+         });
+         coroutine([request, reply] () {
+            int value = 0;
+            LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), echo_round_trips)) {
+               LOFTY_UNUSED_ARG(round);
+               request->write_end->write(value + 1);
+               reply->read_end->read(&value);
+            }
+            request->write_end->close();
+         });
+      }
+
+      perf::stopwatch sw;
+      poll_syscalls.store(0);
+      sw.start();
+      this_thread::run_coroutines();
+      sw.stop();
+      this_thread::detach_coroutine_scheduler();
+
+      text::str engine;
+      if (use_io_uring) {
+         engine = LOFTY_SL("io_uring");
+      } else {
+         engine = LOFTY_SL("epoll");
+      }
+      io::text::stdout->print(LOFTY_SL("  {:19}  {:13}  {}\n"), sw, poll_syscalls.load(), engine);
+   }
+
+   /*! Counts the allocations performed by two coroutines that take turns blocking on an event, then prints
+   the results. */
+   void run_event_allocations_test() {
+      LOFTY_TRACE_METHOD();
+
+      this_thread::attach_coroutine_scheduler();
+      std::size_t const total_switches = steady_state_warmup_switches + steady_state_switches;
+      event ping, pong;
+      std::size_t allocs = 0;
+      coroutine([&ping, &pong, &allocs] () {
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_warmup_switches)) {
+            LOFTY_UNUSED_ARG(round);
+            ping.trigger();
+            pong.wait();
+         }
+         allocations.store(0);
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_switches)) {
+            LOFTY_UNUSED_ARG(round);
+            ping.trigger();
+            // Block until the other coroutine replies.
+            pong.wait();
+         }
+         allocs = allocations.load();
+         // Let the other coroutine return.
+         ping.trigger();
+      });
+      coroutine([&ping, &pong, total_switches] () {
+         // Block until the other coroutine triggers its event, then reply; the last round lets this return.
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), total_switches + 1)) {
+            LOFTY_UNUSED_ARG(round);
+            ping.wait();
+            pong.trigger();
+         }
+      });
+      this_thread::run_coroutines();
+      this_thread::detach_coroutine_scheduler();
+
+      print_allocations(LOFTY_SL("event"), steady_state_switches * 2, allocs);
+   }
+
+   /*! Counts the allocations performed by two coroutines that take turns blocking on a pipe, then prints the
+   results. */
+   void run_pipe_allocations_test() {
+      LOFTY_TRACE_METHOD();
+
+      this_thread::attach_coroutine_scheduler();
+      io::binary::pipe ping, pong;
+      std::size_t allocs = 0;
+      coroutine([&ping, &pong, &allocs] () {
+         int i = 0;
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_warmup_switches)) {
+            LOFTY_UNUSED_ARG(round);
+            ping.write_end->write(i);
+            pong.read_end->read(&i);
+         }
+         allocations.store(0);
+         LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_switches)) {
+            LOFTY_UNUSED_ARG(round);
+            ping.write_end->write(i);
+            // Block until the other coroutine replies.
+            pong.read_end->read(&i);
+         }
+         allocs = allocations.load();
+         ping.write_end->close();
+      });
+      coroutine([&ping, &pong] () {
+         int i;
+         // Block until the other coroutine writes, then reply; stop when the other coroutine is done.
+         while (ping.read_end->read(&i)) {
+            pong.write_end->write(i + 1);
+         }
+         pong.write_end->close();
+      });
+      this_thread::run_coroutines();
+      this_thread::detach_coroutine_scheduler();
+
+      print_allocations(LOFTY_SL("pipe"), steady_state_switches * 2, allocs);
+   }
+
+   /*! Counts the allocations performed by two coroutines that repeatedly yield to each other, then prints
+   the results. */
+   void run_yield_allocations_test() {
+      LOFTY_TRACE_METHOD();
+
+      this_thread::attach_coroutine_scheduler();
+      std::size_t allocs = 0;
+      LOFTY_FOR_EACH(auto i, make_range(0, 2)) {
+         coroutine([i, &allocs] () {
+            LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_warmup_switches)) {
+               LOFTY_UNUSED_ARG(round);
+               this_coroutine::sleep_for_ms(0);
+            }
+            if (i == 0) {
+               allocations.store(0);
+            }
+            LOFTY_FOR_EACH(auto round, make_range(std::size_t(0), steady_state_switches)) {
+               LOFTY_UNUSED_ARG(round);
+               this_coroutine::sleep_for_ms(0);
+            }
+            if (i == 0) {
+               allocs = allocations.load();
+            }
+         });
+      }
+      this_thread::run_coroutines();
+      this_thread::detach_coroutine_scheduler();
+
+      print_allocations(LOFTY_SL("yield"), steady_state_switches * 2, allocs);
+   }
+#endif
+};
+
+LOFTY_APP_CLASS(coroutines_benchmark_app)
@@ -0,0 +1,159 @@
+/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/hash_map.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/_std/memory.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+//! Key/value pair used as input to build maps.
+struct key_value {
+   //! Key.
+   unsigned key;
+   //! Value.
+   unsigned value;
+};
+
+} //namespace
+
+//! Application class for this program.
+class hash_map_build_benchmark_app : public app {
+private:
+   //! Type of the maps being built.
+   typedef collections::hash_map<unsigned, unsigned> map_type;
+
+   //! Arguments for map_type::set_growth_policy().
+   struct growth_policy {
+      //! Maximum load.
+      unsigned max_load_percent;
+      //! Whether neighborhoods are widened before growing the table.
+      bool widen_neighborhoods;
+   };
+
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Pairs     Max load [%]  Widen  add_or_assign [ns]  set_capacity + add_or_assign [ns]  "
+         "add_or_assign_range [ns]\n"
+      ));
+      static std::size_t const pairs_sizes[] = { 100000, 1000000, 4000000 };
+      // The default policy, then neighborhood widening with two maximum loads.
+      static growth_policy const growth_policies[] = { { 100, false }, { 100, true }, { 75, true } };
+      for (std::size_t i = 0; i < sizeof pairs_sizes / sizeof pairs_sizes[0]; ++i) {
+         std::size_t pairs_size = pairs_sizes[i];
+         // Generate pairs with pseudo-random keys (xorshift).
+         _std::unique_ptr<key_value[]> pairs(new key_value[pairs_size]);
+         std::uint32_t rand = 2463534242u;
+         for (std::size_t j = 0; j < pairs_size; ++j) {
+            rand ^= rand << 13;
+            rand ^= rand >> 17;
+            rand ^= rand << 5;
+            pairs[j].key = rand;
+            pairs[j].value = static_cast<unsigned>(j);
+         }
+         for (std::size_t j = 0; j < sizeof growth_policies / sizeof growth_policies[0]; ++j) {
+            growth_policy const & policy = growth_policies[j];
+            auto incremental_sw(build_incremental(pairs.get(), pairs_size, policy, false));
+            auto presized_sw(build_incremental(pairs.get(), pairs_size, policy, true));
+            auto bulk_sw(build_bulk(pairs.get(), pairs_size, policy));
+            io::text::stdout->print(
+               LOFTY_SL("{:8}  {:12}  {}  {:18}  {:33}  {:24}\n"), pairs_size, policy.max_load_percent,
+               // Padded to the width of the column, since strings don’t support a width in their format.
+               policy.widen_neighborhoods ? LOFTY_SL("yes  ") : LOFTY_SL("no   "), incremental_sw, presized_sw,
+               bulk_sw
+            );
+         }
+      }
+      return 0;
+   }
+
+private:
+   /*! Builds a map by adding one pair at a time.
+
+   @param pairs
+      Pairs to add.
+   @param pairs_size
+      Count of pairs.
+   @param policy
+      Growth policy for the map.
+   @param presize
+      If true, the map’s capacity will be set to pairs_size before adding any pairs.
+   @return
+      Time taken to build the map.
+   */
+   perf::stopwatch build_incremental(
+      key_value const * pairs, std::size_t pairs_size, growth_policy const & policy, bool presize
+   ) {
+      LOFTY_TRACE_METHOD();
+
+      perf::stopwatch sw;
+      map_type map;
+      map.set_growth_policy(map.table_growth_factor(), policy.max_load_percent, policy.widen_neighborhoods);
+      sw.start();
+      if (presize) {
+         map.set_capacity(pairs_size);
+      }
+      for (std::size_t i = 0; i < pairs_size; ++i) {
+         map.add_or_assign(pairs[i].key, pairs[i].value);
+      }
+      sw.stop();
+      return sw;
+   }
+
+   /*! Builds a map by adding all pairs at once.
+
+   @param pairs
+      Pairs to add.
+   @param pairs_size
+      Count of pairs.
+   @param policy
+      Growth policy for the map.
+   @return
+      Time taken to build the map.
+   */
+   perf::stopwatch build_bulk(key_value const * pairs, std::size_t pairs_size, growth_policy const & policy) {
+      LOFTY_TRACE_METHOD();
+
+      perf::stopwatch sw;
+      map_type map;
+      map.set_growth_policy(map.table_growth_factor(), policy.max_load_percent, policy.widen_neighborhoods);
+      sw.start();
+      map.add_or_assign_range(pairs, pairs + pairs_size);
+      sw.stop();
+      return sw;
+   }
+};
+
+LOFTY_APP_CLASS(hash_map_build_benchmark_app)
@@ -13,6 +13,7 @@ more details.
 ------------------------------------------------------------------------------------------------------------*/
 
 #include <lofty/app.hxx>
+#include <lofty/collections/flat_hash_map.hxx>
 #include <lofty/collections/hash_map.hxx>
 #include <lofty/collections/vector.hxx>
 #include <lofty/io/text.hxx>
@@ -22,6 +23,7 @@ more details.
 #include <lofty/_std/functional.hxx>
 #include <lofty/_std/tuple.hxx>
 #include <lofty/text/str.hxx>
+#include <lofty/to_str.hxx>
 #include <map>
 #include <unordered_map>
 
@@ -97,6 +99,14 @@ public:
             map.neighborhood_size(), get<0>(ret), get<1>(ret), get<2>(ret)
          );
       }
+      {
+         lofty::collections::flat_hash_map<int, int, _std::hash<int>> map;
+         auto ret(run_test(&map, good_hash_range));
+         io::text::stdout->print(
+            LOFTY_SL("  lofty::collections::flat_hash_map      {:11}  {:11}  {:11}\n"),
+            get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
 
       auto poor_hash_range(make_range(0, 10000));
       io::text::stdout->print(LOFTY_SL("{}, 100% collisions\n"), poor_hash_range.size());
@@ -116,6 +126,68 @@ public:
             map.neighborhood_size(), get<0>(ret), get<1>(ret), get<2>(ret)
          );
       }
+      {
+         lofty::collections::flat_hash_map<int, int, poor_hash<int>> map;
+         auto ret(run_test(&map, poor_hash_range));
+         io::text::stdout->print(
+            LOFTY_SL("  lofty::collections::flat_hash_map      {:11}  {:11}  {:11}\n"),
+            get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
+
+      /* String keys shaped like paths, all sharing a long prefix; misses are looked up with keys that only
+      differ from hits in their last characters. */
+      std::size_t const str_keys_size = 1000000;
+      collections::vector<text::str> str_keys, str_miss_keys;
+      collections::vector<text::hashed_str> hashed_str_keys, hashed_str_miss_keys;
+      for (std::size_t i = 0; i < str_keys_size; ++i) {
+         text::str key(LOFTY_SL("/usr/share/doc/lofty/html/") + to_str(i));
+         str_keys.push_back(key + LOFTY_SL(".html"));
+         str_miss_keys.push_back(key + LOFTY_SL(".txt"));
+         hashed_str_keys.push_back(text::hashed_str(str_keys.back()));
+         hashed_str_miss_keys.push_back(text::hashed_str(str_miss_keys.back()));
+      }
+      io::text::stdout->print(LOFTY_SL("{}, string keys\n"), str_keys_size);
+      {
+         std::unordered_map<text::str, std::size_t, _std::hash<text::str>> map;
+         auto ret(run_str_test(&map, str_keys, str_miss_keys));
+         io::text::stdout->print(
+            LOFTY_SL("  std::unordered_map                     {:11}  {:11}  {:11}\n"),
+            get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
+      {
+         lofty::collections::hash_map<text::str, std::size_t> map;
+         auto ret(run_str_test(&map, str_keys, str_miss_keys));
+         io::text::stdout->print(
+            LOFTY_SL("  lofty::collections::hash_map (nh: {:5}) {:11}  {:11}  {:11}\n"),
+            map.neighborhood_size(), get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
+      {
+         lofty::collections::hash_map<text::hashed_str, std::size_t> map;
+         auto ret(run_str_test(&map, hashed_str_keys, hashed_str_miss_keys));
+         io::text::stdout->print(
+            LOFTY_SL("  … with text::hashed_str keys (nh: {:5}) {:11}  {:11}  {:11}\n"),
+            map.neighborhood_size(), get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
+      {
+         lofty::collections::flat_hash_map<text::str, std::size_t> map;
+         auto ret(run_str_test(&map, str_keys, str_miss_keys));
+         io::text::stdout->print(
+            LOFTY_SL("  lofty::collections::flat_hash_map      {:11}  {:11}  {:11}\n"),
+            get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
+      {
+         lofty::collections::flat_hash_map<text::hashed_str, std::size_t> map;
+         auto ret(run_str_test(&map, hashed_str_keys, hashed_str_miss_keys));
+         io::text::stdout->print(
+            LOFTY_SL("  … with text::hashed_str keys           {:11}  {:11}  {:11}\n"),
+            get<0>(ret), get<1>(ret), get<2>(ret)
+         );
+      }
 
       return 0;
    }
@@ -207,6 +279,73 @@ private:
 
       return run_test_ret(std::move(add_sw), std::move(hit_lookup_sw), std::move(miss_lookup_sw));
    }
+
+   template <typename TValue, typename THash>
+   run_test_ret run_test(
+      collections::flat_hash_map<TValue, TValue, THash> * map, range<TValue> const & range
+   ) {
+      LOFTY_TRACE_METHOD();
+
+      perf::stopwatch add_sw;
+      {
+         add_sw.start();
+         LOFTY_FOR_EACH(auto i, range) {
+            map->add_or_assign(i, i);
+         }
+         add_sw.stop();
+      }
+      auto hit_lookup_sw(hit_lookup_test(*map, range));
+      auto miss_lookup_sw(miss_lookup_test(*map, range));
+
+      return run_test_ret(std::move(add_sw), std::move(hit_lookup_sw), std::move(miss_lookup_sw));
+   }
+
+   template <typename TKey, typename TValue, typename THash>
+   static void add(std::unordered_map<TKey, TValue, THash> * map, TKey const & key, TValue value) {
+      map->insert(std::make_pair(key, value));
+   }
+
+   template <typename TKey, typename TValue, typename THash>
+   static void add(collections::hash_map<TKey, TValue, THash> * map, TKey const & key, TValue value) {
+      map->add_or_assign(key, value);
+   }
+
+   template <typename TKey, typename TValue, typename THash>
+   static void add(collections::flat_hash_map<TKey, TValue, THash> * map, TKey const & key, TValue value) {
+      map->add_or_assign(key, value);
+   }
+
+   template <typename TMap, typename TKey>
+   run_test_ret run_str_test(
+      TMap * map, collections::vector<TKey> const & keys, collections::vector<TKey> const & miss_keys
+   ) {
+      LOFTY_TRACE_METHOD();
+
+      perf::stopwatch add_sw, hit_lookup_sw, miss_lookup_sw;
+      add_sw.start();
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+         add(map, keys[static_cast<std::ptrdiff_t>(i)], i);
+      }
+      add_sw.stop();
+      hit_lookup_sw.start();
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+         // Consume (*map)[key] in some way.
+         if ((*map)[keys[static_cast<std::ptrdiff_t>(i)]] != i) {
+            io::text::stdout->print(LOFTY_SL("ERROR for i={}\n"), i);
+         }
+      }
+      hit_lookup_sw.stop();
+      auto end(map->end());
+      miss_lookup_sw.start();
+      for (std::size_t i = 0; i < miss_keys.size(); ++i) {
+         if (map->find(miss_keys[static_cast<std::ptrdiff_t>(i)]) != end) {
+            io::text::stdout->print(LOFTY_SL("ERROR for i={}\n"), i);
+         }
+      }
+      miss_lookup_sw.stop();
+
+      return run_test_ret(std::move(add_sw), std::move(hit_lookup_sw), std::move(miss_lookup_sw));
+   }
 };
 
 LOFTY_APP_CLASS(maps_comparison_app)
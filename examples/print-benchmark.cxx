@@ -0,0 +1,101 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/io/text/str.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text/str.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class print_benchmark_app : public app {
+private:
+   //! Count of print() calls for each test.
+   static unsigned const iterations = 1000000;
+
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Format                               print() [ns]  prepared_format [ns]\n"
+      ));
+
+      {
+         text::str const format(LOFTY_SL("{} {:x} {:08} {:#x} {}\n"));
+         io::text::prepared_format<int, unsigned, int, unsigned, long> const prepared(format);
+         perf::stopwatch print_sw, prepared_sw;
+         text::str buf;
+         io::text::str_ostream ostream(external_buffer, &buf);
+         print_sw.start();
+         for (unsigned i = 0; i < iterations; ++i) {
+            ostream.clear();
+            ostream.print(format, static_cast<int>(i), i, -static_cast<int>(i), i * 7u, 1000000L * i);
+         }
+         print_sw.stop();
+         prepared_sw.start();
+         for (unsigned i = 0; i < iterations; ++i) {
+            ostream.clear();
+            prepared.print(&ostream, static_cast<int>(i), i, -static_cast<int>(i), i * 7u, 1000000L * i);
+         }
+         prepared_sw.stop();
+         io::text::stdout->print(
+            LOFTY_SL("  integers                           {:12}  {:20}\n"), print_sw, prepared_sw
+         );
+      }
+      {
+         text::str const format(LOFTY_SL("{0}: {1} {{{2}}} – {1}, {3}\n"));
+         io::text::prepared_format<text::str, text::str, text::str, text::str> const prepared(format);
+         text::str s1(LOFTY_SL("responder")), s2(LOFTY_SL("GET /index.html HTTP/1.1")),
+            s3(LOFTY_SL("Content-Type: text/html")), s4(LOFTY_SL("keep-alive"));
+         perf::stopwatch print_sw, prepared_sw;
+         text::str buf;
+         io::text::str_ostream ostream(external_buffer, &buf);
+         print_sw.start();
+         for (unsigned i = 0; i < iterations; ++i) {
+            ostream.clear();
+            ostream.print(format, s1, s2, s3, s4);
+         }
+         print_sw.stop();
+         prepared_sw.start();
+         for (unsigned i = 0; i < iterations; ++i) {
+            ostream.clear();
+            prepared.print(&ostream, s1, s2, s3, s4);
+         }
+         prepared_sw.stop();
+         io::text::stdout->print(
+            LOFTY_SL("  strings                            {:12}  {:20}\n"), print_sw, prepared_sw
+         );
+      }
+
+      return 0;
+   }
+};
+
+LOFTY_APP_CLASS(print_benchmark_app)
@@ -0,0 +1,151 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/binary.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/os/path.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class read_lines_benchmark_app : public app {
+private:
+   //! Approximate size of each test file, in bytes.
+   static std::size_t const file_size = 64 * 1024 * 1024;
+
+public:
+   /*! Main function of the program.
+
+   Test files with LF, CR+LF and mixed line terminators are (re)created in the current directory, then read
+   line by line with lines() and line_views(), and with line_views() from a memory-mapped binary stream.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Terminators  lines() [ns]  lines() [MiB/s]  line_views() [ns]  line_views() [MiB/s]  "
+         "mapped [ns]  mapped [MiB/s]\n"
+      ));
+      static struct {
+         text::char_t const * name;
+         text::char_t const * file_name;
+      } const inputs[] = {
+         { LOFTY_SL("LF   "), LOFTY_SL("read-lines-benchmark-lf.txt")    },
+         { LOFTY_SL("CR+LF"), LOFTY_SL("read-lines-benchmark-crlf.txt")  },
+         { LOFTY_SL("mixed"), LOFTY_SL("read-lines-benchmark-mixed.txt") }
+      };
+      for (unsigned input = 0; input < sizeof inputs / sizeof inputs[0]; ++input) {
+         os::path path(text::str(external_buffer, inputs[input].file_name));
+         create_file(path, input);
+         auto lines_sw(read_file(path, false, false)), line_views_sw(read_file(path, true, false));
+         auto mapped_sw(read_file(path, true, true));
+         io::text::stdout->print(
+            LOFTY_SL("{}        {:12}  {:15}  {:17}  {:20}  {:11}  {:14}\n"),
+            text::str(external_buffer, inputs[input].name), lines_sw, get_mib_per_s(lines_sw),
+            line_views_sw, get_mib_per_s(line_views_sw), mapped_sw, get_mib_per_s(mapped_sw)
+         );
+      }
+      return 0;
+   }
+
+private:
+   /*! Writes a test file, made of lines of varying length with some non-ASCII characters.
+
+   @param path
+      Path to the file to create.
+   @param lterms
+      Line terminators to use: 0 for LF, 1 for CR+LF, 2 for a mix of LF, CR+LF and CR.
+   */
+   static void create_file(os::path const & path, unsigned lterms) {
+      LOFTY_TRACE_FUNC();
+
+      static text::char_t const * const lterm_strs[] = { LOFTY_SL("\n"), LOFTY_SL("\r\n"), LOFTY_SL("\r") };
+      auto ostream(io::text::open_ostream(path));
+      // Prevent the ostream from translating LFs.
+      ostream->set_line_terminator(text::line_terminator::lf);
+      text::str line;
+      for (std::size_t written = 0, i = 0; written < file_size; ++i) {
+         line.clear();
+         // Lines from 1 to 160 characters long, with a U+00E8 every now and then.
+         for (std::size_t j = i * 37 % 160; j > 0; --j) {
+            line += (j + i) % 41 == 0 ? char32_t(0x00e8) : char32_t('x');
+         }
+         line += text::str(external_buffer, lterm_strs[lterms < 2 ? lterms : i % 3]);
+         ostream->write(line);
+         written += line.size_in_chars();
+      }
+      ostream->close();
+   }
+
+   /*! Returns the throughput achieved reading a whole test file.
+
+   @param sw
+      Time taken to read the file.
+   @return
+      Throughput, in MiB/s.
+   */
+   static std::uint64_t get_mib_per_s(perf::stopwatch const & sw) {
+      return static_cast<std::uint64_t>(file_size / 1024 / 1024) * 1000000000u /
+         (sw.duration() > 0 ? sw.duration() : 1);
+   }
+
+   /*! Reads a test file line by line.
+
+   @param path
+      Path to the file to read.
+   @param views
+      If true, lines will be read with line_views() instead of lines().
+   @param mapped
+      If true, the file will be mapped in memory instead of being read.
+   @return
+      Time taken to read the file.
+   */
+   static perf::stopwatch read_file(os::path const & path, bool views, bool mapped) {
+      LOFTY_TRACE_FUNC();
+
+      perf::stopwatch sw;
+      auto istream(
+         mapped
+            ? io::text::make_istream(io::binary::open_mapped_istream(path), text::encoding::utf8)
+            : io::text::open_istream(path, text::encoding::utf8)
+      );
+      std::size_t chars = 0;
+      sw.start();
+      LOFTY_FOR_EACH(auto & line, views ? istream->line_views() : istream->lines()) {
+         chars += line.size_in_chars();
+      }
+      sw.stop();
+      if (chars == 0) {
+         io::text::stdout->print(LOFTY_SL("ERROR: no characters read from {}\n"), path);
+      }
+      return sw;
+   }
+};
+
+LOFTY_APP_CLASS(read_lines_benchmark_app)
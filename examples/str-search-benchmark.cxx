@@ -0,0 +1,111 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/text/str_traits.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class str_search_benchmark_app : public app {
+private:
+   //! Count of characters searched for each test.
+   static std::size_t const total_chars = 256 * 1024 * 1024;
+
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      io::text::stdout->print(LOFTY_SL(
+         "Haystack [chars]  find_char [ns]  find_char_last [ns]  find(cp) [ns]  find_substr [ns]  "
+         "str_searcher [ns]\n"
+      ));
+      static std::size_t const haystack_sizes[] = { 64, 1024, 1024 * 1024 };
+      for (std::size_t i = 0; i < sizeof haystack_sizes / sizeof haystack_sizes[0]; ++i) {
+         std::size_t haystack_size = haystack_sizes[i], iterations = total_chars / haystack_size;
+         /* Text with frequent partial matches for the substring and for the lead byte of the code point; the
+         searched-for characters are only found at the very end, or at the start for backwards searches. */
+         text::str const filler(LOFTY_SL("Content-Length: 42\r\nContent-Type: text/plain\r\nè"));
+         text::str const tail(LOFTY_SL("é~Content-Tyqe|"));
+         text::str haystack(LOFTY_SL("^"));
+         while (haystack.size_in_chars() + filler.size_in_chars() + tail.size_in_chars() <= haystack_size) {
+            haystack += filler;
+         }
+         while (haystack.size_in_chars() + tail.size_in_chars() < haystack_size) {
+            haystack += ' ';
+         }
+         haystack += tail;
+         text::str const substr(LOFTY_SL("Content-Tyqe"));
+         text::str_searcher const searcher(substr.data(), substr.data_end());
+         char32_t const cp = 0x00e9;
+         text::char_t const * begin = haystack.data(), * end = haystack.data_end();
+
+         perf::stopwatch find_char_sw, find_char_last_sw, find_cp_sw, find_substr_sw, searcher_sw;
+         // Accumulate the results, so that the searches can’t be optimized away.
+         std::size_t check = 0;
+         find_char_sw.start();
+         for (std::size_t j = 0; j < iterations; ++j) {
+            check += static_cast<std::size_t>(text::str_traits::find_char(begin, end, '|') - begin);
+         }
+         find_char_sw.stop();
+         find_char_last_sw.start();
+         for (std::size_t j = 0; j < iterations; ++j) {
+            check += static_cast<std::size_t>(text::str_traits::find_char_last(begin, end, '^') - begin);
+         }
+         find_char_last_sw.stop();
+         find_cp_sw.start();
+         for (std::size_t j = 0; j < iterations; ++j) {
+            check += static_cast<std::size_t>(text::str_traits::find_char(begin, end, cp) - begin);
+         }
+         find_cp_sw.stop();
+         find_substr_sw.start();
+         for (std::size_t j = 0; j < iterations; ++j) {
+            check += static_cast<std::size_t>(text::str_traits::find_substr(
+               begin, end, substr.data(), substr.data_end()
+            ) - begin);
+         }
+         find_substr_sw.stop();
+         searcher_sw.start();
+         for (std::size_t j = 0; j < iterations; ++j) {
+            check += static_cast<std::size_t>(searcher.find(begin, end) - begin);
+         }
+         searcher_sw.stop();
+         io::text::stdout->print(
+            LOFTY_SL("{:16}  {:14}  {:19}  {:13}  {:16}  {:17}\n"), haystack.size_in_chars(), find_char_sw,
+            find_char_last_sw, find_cp_sw, find_substr_sw, searcher_sw
+         );
+         LOFTY_LOG(debug, LOFTY_SL("check: {}\n"), check);
+      }
+      return 0;
+   }
+};
+
+LOFTY_APP_CLASS(str_search_benchmark_app)
@@ -0,0 +1,199 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/app.hxx>
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/binary.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/os/path.hxx>
+#include <lofty/perf/stopwatch.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/_std/memory.hxx>
+
+using namespace lofty;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//! Application class for this program.
+class transcode_benchmark_app : public app {
+private:
+   //! Size of each source buffer, in UTF-8 bytes.
+   static std::size_t const src_size = 16 * 1024 * 1024;
+   //! Count of transcode() calls for each test.
+   static unsigned const iterations = 10;
+
+public:
+   /*! Main function of the program.
+
+   @param args
+      Arguments that were provided to this program via command line.
+   @return
+      Return value of this program.
+   */
+   virtual int main(collections::vector<text::str> & args) override {
+      LOFTY_TRACE_METHOD();
+
+      LOFTY_UNUSED_ARG(args);
+
+      // UTF-32 needs at most four bytes per UTF-8 byte.
+      _std::unique_ptr<std::uint8_t[]> ascii(new std::uint8_t[src_size]), mixed(new std::uint8_t[src_size]),
+         cjk(new std::uint8_t[src_size]), utf16(new std::uint8_t[src_size * 2]),
+         dst(new std::uint8_t[src_size * 4]);
+      for (std::size_t i = 0; i < src_size; ++i) {
+         ascii[i] = static_cast<std::uint8_t>(' ' + i % 95);
+      }
+      /* Mostly ASCII text with a two-byte character (U+00E8) every 61 bytes, as would be found in text in
+      most Latin-script languages. */
+      for (std::size_t i = 0; i < src_size; ++i) {
+         if (i % 61 == 59 && i + 1 < src_size) {
+            mixed[i++] = 0xc3;
+            mixed[i] = 0xa8;
+         } else {
+            mixed[i] = static_cast<std::uint8_t>('a' + i % 26);
+         }
+      }
+      // Three-byte characters (U+4E00-U+4EFF) with an ASCII space every 31 bytes, as found in CJK text.
+      for (std::size_t i = 0; i < src_size; ++i) {
+         if (i % 31 == 30 || i + 3 > src_size) {
+            cjk[i] = ' ';
+         } else {
+            cjk[i    ] = 0xe4;
+            cjk[i + 1] = static_cast<std::uint8_t>(0xb8 + (i / 31) % 4);
+            cjk[i + 2] = static_cast<std::uint8_t>(0x80 + i % 64);
+            i += 2;
+         }
+      }
+
+      io::text::stdout->print(LOFTY_SL("Input   Conversion          Time [ns]  Throughput [MiB/s]\n"));
+      static struct {
+         text::char_t const * name;
+         text::encoding src_enc;
+         text::encoding dst_enc;
+      } const conversions[] = {
+         { LOFTY_SL("utf8 -> utf8   "), text::encoding::utf8,    text::encoding::utf8    },
+         { LOFTY_SL("utf8 -> utf16le"), text::encoding::utf8,    text::encoding::utf16le },
+         { LOFTY_SL("utf8 -> utf32le"), text::encoding::utf8,    text::encoding::utf32le },
+         { LOFTY_SL("utf16le -> utf8"), text::encoding::utf16le, text::encoding::utf8    }
+      };
+      static text::char_t const * const input_names[] = {
+         LOFTY_SL("ascii"), LOFTY_SL("mixed"), LOFTY_SL("cjk  ")
+      };
+      std::uint8_t const * const inputs[] = { ascii.get(), mixed.get(), cjk.get() };
+      for (unsigned input = 0; input < 3; ++input) {
+         std::uint8_t const * src_utf8 = inputs[input];
+         // Prepare a UTF-16 copy of the input, for the conversions that need it.
+         void const * src = src_utf8;
+         void * utf16_end = utf16.get();
+         std::size_t src_bytes = src_size, utf16_free = src_size * 2, utf16_size = text::transcode(
+            true, text::encoding::utf8, &src, &src_bytes, text::encoding::utf16le, &utf16_end, &utf16_free
+         );
+
+         for (std::size_t conv = 0; conv < sizeof conversions / sizeof conversions[0]; ++conv) {
+            bool from_utf16 = conversions[conv].src_enc == text::encoding::utf16le;
+            perf::stopwatch sw;
+            sw.start();
+            for (unsigned i = 0; i < iterations; ++i) {
+               src = from_utf16 ? static_cast<void const *>(utf16.get()) : src_utf8;
+               src_bytes = from_utf16 ? utf16_size : src_size;
+               void * dst_end = dst.get();
+               std::size_t dst_free = src_size * 4;
+               text::transcode(
+                  true, conversions[conv].src_enc, &src, &src_bytes, conversions[conv].dst_enc, &dst_end,
+                  &dst_free
+               );
+            }
+            sw.stop();
+            std::uint64_t mib_per_s = static_cast<std::uint64_t>(src_size / 1024 / 1024) * iterations *
+               1000000000u / (sw.duration() > 0 ? sw.duration() : 1);
+            io::text::stdout->print(
+               LOFTY_SL("{}   {}  {:12}  {:18}\n"),
+               text::str(external_buffer, input_names[input]),
+               text::str(external_buffer, conversions[conv].name), sw, mib_per_s
+            );
+         }
+      }
+
+      run_corpus_tests(dst.get());
+      return 0;
+   }
+
+private:
+   /*! Converts each file in the I/O test data, tiled until it’s about as large as the synthetic inputs, from
+   its own encoding to UTF-8, or from UTF-8 to UTF-16LE.
+
+   @param dst
+      Destination buffer, at least src_size * 4 bytes large.
+   */
+   static void run_corpus_tests(std::uint8_t * dst) {
+      static text::char_t const * const file_names[] = {
+         LOFTY_SL("utf8.txt"),
+         LOFTY_SL("utf8_lf_no-trailing-nl.txt"),
+         LOFTY_SL("utf8_mixed_no-trailing-nl.txt"),
+         LOFTY_SL("utf16be+bom.txt"),
+         LOFTY_SL("utf16be+bom_lf_no-trailing-nl.txt"),
+         LOFTY_SL("utf16le+bom_lf_no-trailing-nl.txt"),
+         LOFTY_SL("utf16le+bom_mixed_no-trailing-nl.txt"),
+         LOFTY_SL("utf32le+bom_lf_no-trailing-nl.txt"),
+         LOFTY_SL("utf32le+bom_mixed_no-trailing-nl.txt")
+      };
+
+      io::text::stdout->print(LOFTY_SL("\nConversion       Time [ns]  Throughput [MiB/s]  File\n"));
+      _std::unique_ptr<std::uint8_t[]> src(new std::uint8_t[src_size]);
+      for (std::size_t file = 0; file < sizeof file_names / sizeof file_names[0]; ++file) {
+         text::str file_name(external_buffer, file_names[file]);
+         std::uint8_t file_bytes[4096];
+         std::size_t file_size = 0;
+         {
+            os::path path(LOFTY_SL("test/lofty/io/text/data/") + file_name);
+            auto istream(io::binary::open_istream(path));
+            std::size_t read_size;
+            do {
+               read_size = istream->read(file_bytes + file_size, sizeof file_bytes - file_size);
+               file_size += read_size;
+            } while (read_size);
+         }
+         std::size_t bom_size;
+         text::encoding src_enc = text::guess_encoding(file_bytes, file_bytes + file_size, 0, &bom_size);
+         text::encoding dst_enc = src_enc == text::encoding::utf8 ?
+            text::encoding::utf16le : text::encoding::utf8;
+         // Tile the contents, minus the BOM, as many whole times as they fit.
+         std::size_t content_size = file_size - bom_size, tiled_size = 0;
+         for (; tiled_size + content_size <= src_size; tiled_size += content_size) {
+            for (std::size_t i = 0; i < content_size; ++i) {
+               src[tiled_size + i] = file_bytes[bom_size + i];
+            }
+         }
+
+         perf::stopwatch sw;
+         sw.start();
+         for (unsigned i = 0; i < iterations; ++i) {
+            void const * src_ptr = src.get();
+            std::size_t src_bytes = tiled_size;
+            void * dst_end = dst;
+            std::size_t dst_free = src_size * 4;
+            text::transcode(true, src_enc, &src_ptr, &src_bytes, dst_enc, &dst_end, &dst_free);
+         }
+         sw.stop();
+         std::uint64_t mib_per_s = static_cast<std::uint64_t>(tiled_size) * iterations * 1000000000u /
+            1024 / 1024 / (sw.duration() > 0 ? sw.duration() : 1);
+         io::text::stdout->print(
+            LOFTY_SL("{} -> {}  {:12}  {:18}  {}\n"), src_enc, dst_enc, sw, mib_per_s, file_name
+         );
+      }
+   }
+};
+
+LOFTY_APP_CLASS(transcode_benchmark_app)
@@ -0,0 +1,437 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _LOFTY_CHANNEL_HXX
+
+#ifndef _LOFTY_NOPUB
+   #define _LOFTY_NOPUB
+   #define _LOFTY_CHANNEL_HXX
+#endif
+
+#ifndef _LOFTY_CHANNEL_HXX_NOPUB
+#define _LOFTY_CHANNEL_HXX_NOPUB
+
+#include <lofty/memory.hxx>
+#include <lofty/noncopyable.hxx>
+#include <lofty/type_void_adapter.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
+#include <lofty/_std/new.hxx>
+#include <lofty/_std/utility.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace _pvt {
+
+/*! Non-template implementation of lofty::channel. Manages the ring buffer of elements, and the coroutines and
+threads waiting to send or receive them. */
+class LOFTY_SYM channel_impl : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   /*! Returns the maximum count of elements the channel can hold.
+
+   @return
+      Capacity of the channel, or 0 if the channel is unbounded.
+   */
+   std::size_t capacity() const {
+      return max_size;
+   }
+
+   /*! Closes the channel. Senders will not be able to add any more elements, and receivers will be able to
+   receive the elements already in the channel, and will then stop blocking. Every sender and receiver that is
+   blocked waiting will be resumed. */
+   void close();
+
+   /*! Returns true if close() has been called.
+
+   @return
+      true if the channel is closed, or false otherwise.
+   */
+   bool closed() const;
+
+   /*! Returns the count of elements currently in the channel.
+
+   @return
+      Count of elements.
+   */
+   std::size_t size() const;
+
+protected:
+   //! Coroutine or thread blocked in a send or receive operation.
+   struct waiter;
+
+   //! List of coroutines and threads waiting for the same condition, in the order they started waiting.
+   struct waiter_list {
+      //! First (oldest) waiter.
+      waiter * first;
+      //! Last (newest) waiter.
+      waiter * last;
+   };
+
+protected:
+   /*! Constructor.
+
+   @param max_size_
+      Maximum count of elements the channel can hold, or 0 for no limit.
+   */
+   explicit channel_impl(std::size_t max_size_);
+
+   //! Destructor.
+   ~channel_impl();
+
+   /*! Destructs all the elements in the channel.
+
+   @param type
+      Adapter for the elements’ type.
+   */
+   void destruct_elements(lofty::_LOFTY_PUBNS type_void_adapter const & type);
+
+   /*! Doubles the space allocated for the elements, moving them to the new buffer.
+
+   @param type
+      Adapter for the elements’ type.
+   */
+   void grow(lofty::_LOFTY_PUBNS type_void_adapter const & type);
+
+   /*! Blocks until the channel has elements to receive, or is closed. Must be called while holding *lock.
+
+   @param lock
+      Lock on mutex; released while blocking.
+   @return
+      true if there are elements to receive, or false if the channel has been closed and is empty.
+   */
+   bool wait_for_elements(_std::_LOFTY_PUBNS unique_lock<_std::_LOFTY_PUBNS mutex> * lock);
+
+   /*! Blocks until the channel has room for at least one more element, or is closed. Must be called while
+   holding *lock.
+
+   @param lock
+      Lock on mutex; released while blocking.
+   @return
+      true if an element can be added, or false if the channel has been closed.
+   */
+   bool wait_for_space(_std::_LOFTY_PUBNS unique_lock<_std::_LOFTY_PUBNS mutex> * lock);
+
+   /*! Resumes receivers after elements have been added. Must be called while holding a lock on mutex.
+
+   @param count
+      Count of elements added.
+   */
+   void wake_receivers(std::size_t count) {
+      if (receivers.first) {
+         wake(&receivers, count);
+      }
+   }
+
+   /*! Resumes senders after elements have been removed. Must be called while holding a lock on mutex.
+
+   @param count
+      Count of elements removed.
+   */
+   void wake_senders(std::size_t count) {
+      if (senders.first) {
+         wake(&senders, count);
+      }
+   }
+
+private:
+   /*! Removes a waiter from a list.
+
+   @param list
+      List containing *w.
+   @param w
+      Waiter to remove.
+   */
+   static void unlink(waiter_list * list, waiter * w);
+
+   /*! Blocks the current coroutine or thread until woken by wake(). Must be called while holding *lock.
+
+   @param list
+      List to add the current coroutine or thread to.
+   @param lock
+      Lock on mutex; released while blocking.
+   */
+   void wait(waiter_list * list, _std::_LOFTY_PUBNS unique_lock<_std::_LOFTY_PUBNS mutex> * lock);
+
+   /*! Resumes the first waiters in a list, removing them from it.
+
+   @param list
+      List of waiters.
+   @param count
+      Maximum count of waiters to resume.
+   */
+   static void wake(waiter_list * list, std::size_t count);
+
+protected:
+   //! Ring buffer of elements.
+   _std::_LOFTY_PUBNS unique_ptr<void, memory::_LOFTY_PUBNS freeing_deleter> elements;
+   //! Count of elements that fit in elements. Always a power of 2, or 0 if elements has not been allocated.
+   std::size_t elements_capacity;
+   //! Index of the first element in elements.
+   std::size_t first_index;
+   //! Count of elements in the channel.
+   std::size_t elements_size;
+   //! Maximum count of elements in the channel, or 0 if unbounded.
+   std::size_t const max_size;
+   //! true if close() has been called.
+   bool closed_;
+   //! Guards every other member.
+   mutable _std::_LOFTY_PUBNS mutex mutex;
+
+private:
+   //! Receivers waiting for elements.
+   waiter_list receivers;
+   //! Senders waiting for space (bounded channels only).
+   waiter_list senders;
+};
+
+}} //namespace lofty::_pvt
+
+namespace lofty {
+_LOFTY_PUBNS_BEGIN
+
+/*! First-in, first-out queue of values passed between coroutines, or between threads not running coroutines,
+that blocks receivers while it’s empty and, if bounded, blocks senders while it’s full.
+
+Any number of coroutines can send and receive through the same channel, including coroutines running on
+different threads that share the same coroutine scheduler. Coroutines blocked by a channel are resumed
+directly by the coroutine that unblocks them, without involving any scheduler event; the batch operations
+send_many() and receive_many() move many values for a single wakeup.
+
+Blocking operations are interruption points: if the coroutine or thread is interrupted while blocked, the
+resulting execution_interruption exception is thrown without losing or duplicating any values. After
+close(), senders fail and receivers drain the remaining values, then fail instead of blocking. */
+template <typename T>
+class channel : public lofty::_pvt::channel_impl {
+public:
+   /*! Constructor.
+
+   @param capacity_
+      Maximum count of values the channel can hold before senders block, or 0 for no limit.
+   */
+   explicit channel(std::size_t capacity_ = 0) :
+      lofty::_pvt::channel_impl(capacity_) {
+   }
+
+   //! Destructor. No coroutines or threads must be blocked on the channel.
+   ~channel() {
+      lofty::_pub::type_void_adapter type;
+      type.set_destruct<T>();
+      type.set_size<T>();
+      destruct_elements(type);
+   }
+
+   /*! Receives a value, blocking until one is available.
+
+   @param dst
+      Pointer to the variable that will receive the value.
+   @return
+      true if a value was received, or false if the channel was closed and is empty.
+   */
+   bool receive(T * dst) {
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      if (!wait_for_elements(&lock)) {
+         return false;
+      }
+      pop_front(dst, 1);
+      wake_senders(1);
+      return true;
+   }
+
+   /*! Receives as many values as available, up to the specified count, blocking until at least one is
+   available.
+
+   @param dst
+      Pointer to an array that will receive the values.
+   @param dst_max
+      Count of elements in dst.
+   @return
+      Count of values received, or 0 if the channel was closed and is empty.
+   */
+   std::size_t receive_many(T * dst, std::size_t dst_max) {
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      if (!wait_for_elements(&lock)) {
+         return 0;
+      }
+      std::size_t count = elements_size < dst_max ? elements_size : dst_max;
+      pop_front(dst, count);
+      wake_senders(count);
+      return count;
+   }
+
+   /*! Sends a value, blocking while the channel is full.
+
+   @param t
+      Value to send.
+   @return
+      true if the value was sent, or false if the channel was closed.
+   */
+   bool send(T const & t) {
+      T copy(t);
+      return send(_std::_pub::move(copy));
+   }
+
+   /*! Sends a value, blocking while the channel is full.
+
+   @param t
+      Value to send. Only moved from if sent.
+   @return
+      true if the value was sent, or false if the channel was closed.
+   */
+   bool send(T && t) {
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      if (!wait_for_space(&lock)) {
+         return false;
+      }
+      push_back(&t, 1);
+      wake_receivers(1);
+      return true;
+   }
+
+   /*! Sends multiple values, blocking while the channel is full. Receivers are resumed as soon as a value is
+   sent, without waiting for the rest.
+
+   @param src
+      Pointer to an array of values to send; each one is moved from if sent.
+   @param count
+      Count of elements in src.
+   @return
+      Count of values sent; less than count only if the channel was closed.
+   */
+   std::size_t send_many(T * src, std::size_t count) {
+      std::size_t sent = 0;
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      while (sent < count && wait_for_space(&lock)) {
+         std::size_t batch = count - sent;
+         if (max_size && batch > max_size - elements_size) {
+            batch = max_size - elements_size;
+         }
+         push_back(src + sent, batch);
+         sent += batch;
+         wake_receivers(batch);
+      }
+      return sent;
+   }
+
+   /*! Receives a value if one is available, without blocking.
+
+   @param dst
+      Pointer to the variable that will receive the value.
+   @return
+      true if a value was received, or false if the channel was empty.
+   */
+   bool try_receive(T * dst) {
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      if (elements_size == 0) {
+         return false;
+      }
+      pop_front(dst, 1);
+      wake_senders(1);
+      return true;
+   }
+
+   /*! Sends a value if the channel has room for it, without blocking.
+
+   @param t
+      Value to send.
+   @return
+      true if the value was sent, or false if the channel was full or closed.
+   */
+   bool try_send(T const & t) {
+      T copy(t);
+      return try_send(_std::_pub::move(copy));
+   }
+
+   /*! Sends a value if the channel has room for it, without blocking.
+
+   @param t
+      Value to send. Only moved from if sent.
+   @return
+      true if the value was sent, or false if the channel was full or closed.
+   */
+   bool try_send(T && t) {
+      _std::_pub::unique_lock<_std::_pub::mutex> lock(mutex);
+      if (closed_ || (max_size && elements_size >= max_size)) {
+         return false;
+      }
+      push_back(&t, 1);
+      wake_receivers(1);
+      return true;
+   }
+
+private:
+   /*! Moves values out of the front of the ring buffer. Must be called while holding a lock on mutex.
+
+   @param dst
+      Pointer to an array that will receive the values.
+   @param count
+      Count of values to move; must not exceed elements_size.
+   */
+   void pop_front(T * dst, std::size_t count) {
+      T * ring = static_cast<T *>(elements.get());
+      std::size_t mask = elements_capacity - 1;
+      for (std::size_t i = 0; i < count; ++i) {
+         T * src = ring + ((first_index + i) & mask);
+         dst[i] = _std::_pub::move(*src);
+         src->~T();
+      }
+      first_index = (first_index + count) & mask;
+      elements_size -= count;
+   }
+
+   /*! Moves values to the back of the ring buffer, allocating more space as necessary. Must be called while
+   holding a lock on mutex.
+
+   @param src
+      Pointer to an array of values to move.
+   @param count
+      Count of values to move.
+   */
+   void push_back(T * src, std::size_t count) {
+      for (std::size_t i = 0; i < count; ++i) {
+         if (elements_size == elements_capacity) {
+            lofty::_pub::type_void_adapter type;
+            type.set_destruct<T>();
+            type.set_move_construct<T>();
+            type.set_size<T>();
+            grow(type);
+         }
+         T * ring = static_cast<T *>(elements.get());
+         ::new(ring + ((first_index + elements_size) & (elements_capacity - 1))) T(_std::_pub::move(src[i]));
+         ++elements_size;
+      }
+   }
+};
+
+_LOFTY_PUBNS_END
+} //namespace lofty
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif //ifndef _LOFTY_CHANNEL_HXX_NOPUB
+
+#ifdef _LOFTY_CHANNEL_HXX
+   #undef _LOFTY_NOPUB
+
+   namespace lofty {
+
+   using _pub::channel;
+
+   }
+
+   #ifdef LOFTY_CXX_PRAGMA_ONCE
+      #pragma once
+   #endif
+#endif
+
+#endif //ifndef _LOFTY_CHANNEL_HXX
@@ -0,0 +1,390 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX
+
+#ifndef _LOFTY_NOPUB
+   #define _LOFTY_NOPUB
+   #define _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX
+#endif
+
+#ifndef _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX_NOPUB
+#define _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX_NOPUB
+
+#include <lofty/explicit_operator_bool.hxx>
+#include <lofty/memory.hxx>
+#include <lofty/numeric.hxx>
+#include <lofty/_std/iterator.hxx>
+#include <lofty/_std/memory.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Forward declaration.
+namespace lofty {
+_LOFTY_PUBNS_BEGIN
+
+class type_void_adapter;
+
+_LOFTY_PUBNS_END
+}
+
+namespace lofty { namespace collections { namespace _pvt {
+
+/*! Non-template implementation class for lofty::collections::flat_hash_map.
+
+Each slot stores a key immediately followed by its value, so that a successful lookup only touches the slot
+itself, besides the control bytes. Control bytes are kept in a separate array, one per slot: an empty or
+deleted slot has the most significant bit set, while a used slot stores 7 bits derived from the key’s hash.
+Slots are probed in aligned groups of group_size, and all the control bytes of a group are compared to the
+searched hash in a single vector operation. */
+class LOFTY_SYM flat_hash_map_impl :
+   public lofty::_LOFTY_PUBNS support_explicit_operator_bool<flat_hash_map_impl> {
+protected:
+   typedef bool (* keys_equal_fn_type)(
+      flat_hash_map_impl const * this_ptr, void const * key1, void const * key2
+   );
+   typedef std::size_t (* key_hash_fn_type)(flat_hash_map_impl const * this_ptr, void const * key);
+
+   //! Type returned by add_or_assign().
+   struct add_or_assign_impl_ret {
+      //! Slot containing the (possibly newly-added) key/value.
+      std::size_t slot;
+      /*! true if the key/value pair was just added, or false if the key already existed in the map and the
+      corresponding value was overwritten. */
+      bool added;
+
+      /*! Constructor.
+
+      @param slot_
+         Slot containing the (possibly newly-added) key/value.
+      @param added_
+         true if the key/value pair was just added, or false if the key already existed in the map and the
+         corresponding value was overwritten.
+      */
+      add_or_assign_impl_ret(std::size_t slot_, bool added_) :
+         slot(slot_),
+         added(added_) {
+      }
+   };
+
+   //! Integer type used to track changes in the map.
+   typedef std::uint16_t rev_int_t;
+
+   //! Base class for flat_hash_map iterator implementations.
+   class LOFTY_SYM iterator_base {
+   private:
+      friend class flat_hash_map_impl;
+
+   public:
+      typedef _std::_LOFTY_PUBNS forward_iterator_tag iterator_category;
+
+   public:
+      //! Default constructor.
+      iterator_base();
+
+      /*! Constructor.
+
+      @param owner_map
+         Pointer to the map owning the iterated objects.
+      @param slot
+         Index of the current slot.
+      */
+      iterator_base(flat_hash_map_impl const * owner_map, std::size_t slot);
+
+      /*! Equality relational operator.
+
+      @param other
+         Object to compare to *this.
+      @return
+         true if *this is an iterator to the same key/value pair as other, or false otherwise.
+      */
+      bool operator==(iterator_base const & other) const {
+         return owner_map == other.owner_map && slot == other.slot;
+      }
+
+      /*! Inequality relational operator.
+
+      @param other
+         Object to compare to *this.
+      @return
+         true if *this has a different key/value pair than other, or false otherwise.
+      */
+      bool operator!=(iterator_base const & other) const {
+         return !operator==(other);
+      }
+
+   protected:
+      //! Moves the iterator to next used slot.
+      void increment() {
+         slot = owner_map->find_first_used_slot(slot + 1);
+      }
+
+      /*! Throws a collections::out_of_range exception if the iterator is at the end of the container or has
+      been invalidated by a change in the container. */
+      void validate() const;
+
+   protected:
+      //! Pointer to the map to iterate over.
+      flat_hash_map_impl const * owner_map;
+      //! Current slot index.
+      std::size_t slot;
+      //! Last container revision number known to the iterator.
+      rev_int_t rev;
+   };
+
+public:
+   /*! Constructor.
+
+   @param slot_size
+      Size of a slot, i.e. of a key followed by its value, including any padding needed to align them.
+   @param value_offset
+      Offset of the value from the start of its slot.
+   */
+   flat_hash_map_impl(std::size_t slot_size, std::size_t value_offset);
+
+   /*! Move constructor.
+
+   @param src
+      Source object.
+   */
+   flat_hash_map_impl(flat_hash_map_impl && src);
+
+   //! Destructor.
+   ~flat_hash_map_impl();
+
+   /*! Move-assignment operator.
+
+   @param src
+      Source object.
+   @return
+      *this.
+   */
+   flat_hash_map_impl & operator=(flat_hash_map_impl && src);
+
+   /*! Boolean evaluation operator.
+
+   @return
+      true if the map is not empty, or false otherwise.
+   */
+   LOFTY_EXPLICIT_OPERATOR_BOOL() const {
+      return used_slots > 0;
+   }
+
+   /*! Returns the maximum number of key/value pairs the map can currently hold.
+
+   @return
+      Current size of the allocated storage, in elements.
+   */
+   std::size_t capacity() const {
+      return total_slots;
+   }
+
+   /*! Returns the count of elements in the map.
+
+   @return
+      Count of elements.
+   */
+   std::size_t size() const {
+      return used_slots;
+   }
+
+protected:
+   /*! Adds a key/value pair to the map, or overwrites the value if the key is already in the map.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param keys_equal_fn
+      Pointer to a function that returns true if two keys compare as equal.
+   @param key_hash_fn
+      Pointer to a function that returns the hash of a key; used to relocate keys when the table is resized.
+   @param key
+      Pointer to the key to add.
+   @param key_hash
+      Hash of *key.
+   @param value
+      Pointer to the value to add.
+   @param move
+      Bitmask; 1 (bit 0) indicates that *key should be moved, while 2 (bit 1) indicates that *value should be
+      moved.
+   @return
+      Object containing the index of the (possibly newly-occupied) slot and a bool value that is true if the
+      key/value pair was just added, or false if the key already existed in the map and the corresponding
+      value was overwritten.
+   */
+   add_or_assign_impl_ret add_or_assign(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, keys_equal_fn_type keys_equal_fn,
+      key_hash_fn_type key_hash_fn, void * key, std::size_t key_hash, void * value, unsigned move
+   );
+
+   /*! Removes all elements from the map.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   */
+   void clear(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type
+   );
+
+   /*! Marks a slot as unused and destructs the corresponding key and value.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param itr
+      Iterator to the slot to empty.
+   */
+   void empty_slot(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, iterator_base itr
+   ) {
+      itr.validate();
+      empty_slot(key_type, value_type, itr.slot);
+   }
+
+   /*! Marks a slot as unused and destructs the corresponding key and value.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param slot
+      Index of the slot to empty.
+   */
+   void empty_slot(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t slot
+   );
+
+   /*! Finds the first used slot, if any.
+
+   @param skip
+      Optional number of slots to skip from the start.
+   @return
+      Index of the first used slot, or null_index if there are no used slots.
+   */
+   std::size_t find_first_used_slot(std::size_t skip = 0) const;
+
+   /*! Looks for a specific key in the map.
+
+   @param keys_equal_fn
+      Pointer to a function that returns true if two keys compare as equal.
+   @param key
+      Pointer to the key to lookup.
+   @param key_hash
+      Hash of *key.
+   @return
+      Index of the slot at which the key could be found, or null_index if the key could not be found.
+   */
+   std::size_t lookup_key(keys_equal_fn_type keys_equal_fn, void const * key, std::size_t key_hash) const;
+
+   /*! Returns a pointer to the key in the specified slot.
+
+   @param slot
+      Slot index.
+   @return
+      Pointer to the key.
+   */
+   void * slot_key(std::size_t slot) const {
+      return static_cast<std::int8_t *>(slots.get()) + slot_size * slot;
+   }
+
+   /*! Returns a pointer to the value in the specified slot.
+
+   @param slot
+      Slot index.
+   @return
+      Pointer to the value.
+   */
+   void * slot_value(std::size_t slot) const {
+      return static_cast<std::int8_t *>(slots.get()) + slot_size * slot + value_offset;
+   }
+
+private:
+   /*! Returns the index of the first unused (empty or deleted) slot in the probe sequence for a hash.
+
+   @param mixed_hash
+      Mixed hash of the key that will be stored in the slot.
+   @return
+      Index of the unused slot.
+   */
+   std::size_t find_unused_slot(std::size_t mixed_hash) const;
+
+   /*! Moves all the keys and values to newly-allocated arrays, dropping any deleted slots in the process.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param key_hash_fn
+      Pointer to a function that returns the hash of a key.
+   @param new_total_slots
+      New slot count. Must be a power of 2, and large enough for used_slots.
+   */
+   void resize(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, key_hash_fn_type key_hash_fn,
+      std::size_t new_total_slots
+   );
+
+protected:
+   //! Array of control bytes, one per slot.
+   _std::_LOFTY_PUBNS unique_ptr<std::int8_t[]> ctrls;
+   //! Array of slots, each containing a key and a value.
+   _std::_LOFTY_PUBNS unique_ptr<void, memory::_LOFTY_PUBNS freeing_deleter> slots;
+   //! Count of total slots. Always 0 or a power of two no smaller than group_size.
+   std::size_t total_slots;
+   //! Count of elements / used slots.
+   std::size_t used_slots;
+   //! Count of empty slots that can still be used before the table exceeds its maximum load factor.
+   std::size_t growth_left;
+   //! Size of each slot.
+   std::size_t slot_size;
+   //! Offset of the value from the start of its slot.
+   std::size_t value_offset;
+   //! Indicates the revision number of the map contents.
+   rev_int_t rev;
+
+   //! Count of slots, and therefore of control bytes, examined at once.
+   static std::size_t const group_size = 16;
+   //! Control byte value indicating that a slot has never been used since the last resize.
+   static std::int8_t const ctrl_empty = -128;
+   //! Control byte value indicating that a slot was used, and is now unused.
+   static std::int8_t const ctrl_deleted = -2;
+   /*! Special index returned by several methods to indicate a logical “null index”. Code in
+   iterator_base::increment() relies on null_index + 1 == 0. */
+   static std::size_t const null_index = numeric::_LOFTY_PUBNS max<std::size_t>::value;
+};
+
+}}} //namespace lofty::collections::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif //ifndef _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX_NOPUB
+
+#ifdef _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX
+   #undef _LOFTY_NOPUB
+
+   #ifdef LOFTY_CXX_PRAGMA_ONCE
+      #pragma once
+   #endif
+#endif
+
+#endif //ifndef _LOFTY_COLLECTIONS__PVT_FLAT_HASH_MAP_IMPL_HXX
@@ -72,6 +72,14 @@ protected:
    //! Integer type used to track changes in the map.
    typedef std::uint16_t rev_int_t;
 
+   //! Hash of a key, and index of the key in a source range. Used to sort a range by bucket.
+   struct hashed_index {
+      //! Hash of the key.
+      std::size_t hash;
+      //! Index of the key in the source range.
+      std::size_t index;
+   };
+
    //! Base class for hash_map iterator implementations.
    class LOFTY_SYM iterator_base {
    private:
@@ -175,6 +183,15 @@ public:
       return total_buckets;
    }
 
+   /*! Returns the maximum load, as percentage of used buckets, that the map will reach before growing.
+
+   @return
+      Maximum load percentage.
+   */
+   unsigned max_load_percent() const {
+      return max_load_percent_;
+   }
+
    /*! Returns the current neighborhood size.
 
    @return
@@ -184,6 +201,25 @@ public:
       return neighborhood_size_;
    }
 
+   /*! Changes how the hash table grows. This does not resize the table; the new policy will be applied the
+   next time the table needs to grow.
+
+   @param new_table_growth_factor
+      Factor by which the hash table is enlarged when it’s full. Must be a power of 2 greater than 1.
+   @param new_max_load_percent
+      Maximum percentage of used buckets; adding a key/value pair beyond this will grow the table even if an
+      empty bucket could still be found. Must be between 1 and 100. Lower values make lookups and additions
+      faster, at the cost of memory.
+   @param new_widen_neighborhoods
+      If true, a key that can’t be placed in its neighborhood will first cause neighborhoods to be widened, up
+      to a few times their ideal size, and only then the table to grow, as long as the table is below the
+      maximum load. This lets large tables reach much higher loads, at the cost of slower lookups of missing
+      keys. If false, the table grows on the first such failure.
+   */
+   void set_growth_policy(
+      std::size_t new_table_growth_factor, unsigned new_max_load_percent, bool new_widen_neighborhoods = false
+   );
+
    /*! Returns the count of elements in the map.
 
    @return
@@ -193,6 +229,24 @@ public:
       return used_buckets;
    }
 
+   /*! Returns the factor by which the hash table is enlarged when it’s full.
+
+   @return
+      Table growth factor.
+   */
+   std::size_t table_growth_factor() const {
+      return table_growth_factor_;
+   }
+
+   /*! Returns true if the map widens neighborhoods before growing the table; see set_growth_policy().
+
+   @return
+      true if neighborhoods are widened before growing the table, or false otherwise.
+   */
+   bool widens_neighborhoods() const {
+      return widen_neighborhoods;
+   }
+
 protected:
    /*! Returns the index of the bucket matching the specified key, or locates an empty bucket and returns its
    index after moving it in the key’s neighborhood.
@@ -302,6 +356,50 @@ protected:
       lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t bucket
    );
 
+   /*! Ensures that the map can hold at least new_capacity_min key/value pairs, within the maximum load,
+   without having to grow the hash table.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param new_capacity_min
+      Count of key/value pairs the map must be able to hold.
+   */
+   void set_capacity(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t new_capacity_min
+   );
+
+   /*! Shrinks the hash table to the smallest size that can hold the current contents within the maximum
+   load, releasing it completely if the map is empty. If the contents don’t fit in any smaller table, the map
+   is left unchanged.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   */
+   void shrink_to_fit(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type
+   );
+
+   /*! Sorts a set of hashes by the index of the bucket they would be stored in, so that adding them in that
+   order will access the hash table sequentially instead of randomly. Hashes that land in the same bucket
+   retain their relative order.
+
+   @param entries
+      Pointer to the hashes to sort.
+   @param scratch
+      Pointer to an array with as many elements as entries, used as temporary storage.
+   @param size
+      Count of elements in entries.
+   @return
+      Pointer to the sorted hashes, which will be either entries or scratch.
+   */
+   hashed_index * sort_by_bucket(hashed_index * entries, hashed_index * scratch, std::size_t size) const;
+
 private:
    /*! Finds the first (non-empty) bucket whose contents can be moved to the specified bucket.
 
@@ -343,24 +441,6 @@ private:
       lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t nh_begin, std::size_t nh_end
    );
 
-   /*! Locates an empty bucket where the specified key may be stored, and returns its index after moving it in
-   the key’s neighborhood.
-
-   @param key_type
-      Adapter for the key type.
-   @param value_type
-      Adapter for the value type.
-   @param key_hash
-      Hash of *key.
-   @return
-      Index of the bucket for the specified key. If key no empty bucket can be found or moved in the key’s
-      neighborhood, the returned index is null_index.
-   */
-   std::size_t get_empty_bucket_for_key(
-      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
-      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t key_hash
-   );
-
    /*! Returns the index of the bucket matching the specified key, or locates an empty bucket and returns its
    index after moving it in the key’s neighborhood.
 
@@ -384,20 +464,34 @@ private:
       void const * key, std::size_t key_hash
    );
 
-   /*! Enlarges the neighborhood size by a factor of growth_factor. This does not require moving the contents
-   of any buckets, since buckets will still be part of the correct neighborhood. */
-   void grow_neighborhoods() {
-      neighborhood_size_ *= growth_factor;
+   /*! Returns true if a key that could not be placed in its neighborhood should be dealt with by widening
+   the neighborhoods instead of enlarging the table, which only happens if enabled by set_growth_policy().
+   With small neighborhoods, the first such failure happens at lower loads the larger the table is, so growing
+   the table every time leaves most of it empty.
+
+   @param total_buckets_
+      Count of buckets in the hash table.
+   @param curr_neighborhood_size
+      Current neighborhood size.
+   @return
+      true if neighborhoods should be widened, or false if the table should be enlarged.
+   */
+   bool can_widen_neighborhoods(std::size_t total_buckets_, std::size_t curr_neighborhood_size) const {
+      return widen_neighborhoods && used_buckets < max_load_buckets(total_buckets_) &&
+         curr_neighborhood_size < max_widened_neighborhood_size && curr_neighborhood_size < total_buckets_;
    }
 
-   /*! Enlarges the hash table by a factor of growth_factor. The contents of each bucket are moved from the
-   old arrays to new temporary ones, and the two array sets are then swapped.
+   /*! Enlarges the neighborhood size by a factor of neighborhood_growth_factor, up to the table size. This
+   does not require moving the contents of any buckets, since buckets will still be part of the correct
+   neighborhood. */
+   void grow_neighborhoods() {
+      neighborhood_size_ *= neighborhood_growth_factor;
+      if (neighborhood_size_ > total_buckets) {
+         neighborhood_size_ = total_buckets;
+      }
+   }
 
-   The bucket contents transfer work is done by reusing functions that obtain the arrays to operate on via
-   member variables. In the assumption that transferring the contents of a bucket won’t throw because it only
-   involves move-constructions and destructions, we optimistically update the member variables as soon as all
-   memory allocations are done; if anything were to go wrong after that, we’d have no guaranteed-safe way of
-   recovering from a half-transferred scenario anyway.
+   /*! Enlarges the hash table by a factor of table_growth_factor_.
 
    @param key_type
       Adapter for the key type.
@@ -407,7 +501,12 @@ private:
    void grow_table(
       lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
       lofty::_LOFTY_PUBNS type_void_adapter const & value_type
-   );
+   ) {
+      rehash(
+         key_type, value_type, total_buckets ? total_buckets * table_growth_factor_ : min_buckets,
+         null_index
+      );
+   }
 
    /*! Looks for a specific key or an unused bucket in the map.
 
@@ -430,6 +529,67 @@ private:
       void const * key, std::size_t key_hash, lofty::_LOFTY_PUBNS range<std::size_t> nh_range
    ) const;
 
+   /*! Returns the count of buckets that can be used in a hash table of the specified size without exceeding
+   the maximum load.
+
+   @param total_buckets_
+      Count of buckets in the hash table.
+   @return
+      Count of usable buckets.
+   */
+   std::size_t max_load_buckets(std::size_t total_buckets_) const {
+      // Avoid overflowing in the multiplication.
+      return total_buckets_ / 100 * max_load_percent_ + total_buckets_ % 100 * max_load_percent_ / 100;
+   }
+
+   /*! Returns the smallest hash table size that can hold the specified count of key/value pairs without
+   exceeding the maximum load.
+
+   @param capacity
+      Count of key/value pairs.
+   @return
+      Count of buckets.
+   */
+   std::size_t min_total_buckets_for(std::size_t capacity) const;
+
+   /*! Stores a hash in an empty bucket in its neighborhood, moving other hashes to make room if needed. Only
+   the hashes array is modified; source_indices is updated in parallel to track the original location of each
+   hash, so that keys and values can be moved in one pass once all the hashes have been placed.
+
+   @param key_hash
+      Hash to store.
+   @param source_indices
+      Array that tracks the original index of each hash.
+   @param source_index
+      Original index of key_hash.
+   @return
+      Index of the bucket the hash was stored in, or one of need_larger_neighborhoods or need_larger_table.
+   */
+   std::size_t place_hash(std::size_t key_hash, std::size_t * source_indices, std::size_t source_index);
+
+   /*! Changes the size of the hash table, moving its contents to new arrays.
+
+   If the contents don’t fit in a table of size new_total_buckets, a larger table (or larger neighborhoods)
+   will be tried, unless that would reach max_total_buckets.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param new_total_buckets
+      Count of buckets to try first. Must be a power of 2.
+   @param max_total_buckets
+      Size at which to give up trying larger tables; null_index means no limit.
+   @return
+      true if the table was resized, or false if the contents couldn’t be placed in a table smaller than
+      max_total_buckets.
+   */
+   bool rehash(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t new_total_buckets,
+      std::size_t max_total_buckets
+   );
+
    /*! Copies or moves a value, and optionally a key, to the specified bucket.
 
    @param key_type
@@ -453,6 +613,30 @@ private:
       unsigned move
    );
 
+   /*! Attempts to move the contents of the hash table to new arrays of the specified size.
+
+   All memory allocations are done first; then every hash is placed in the new table via place_hash(), which
+   cannot throw and only needs the hashes array; finally, keys and values are moved to their new buckets in a
+   single pass. If any hash cannot be placed, the original table is left untouched.
+
+   @param key_type
+      Adapter for the key type.
+   @param value_type
+      Adapter for the value type.
+   @param new_total_buckets
+      Count of buckets in the new table. Must be a power of 2.
+   @param new_neighborhood_size
+      Neighborhood size for the new table.
+   @return
+      0 if the contents were moved, or one of need_larger_neighborhoods or need_larger_table if they didn’t
+      fit.
+   */
+   std::size_t try_rehash(
+      lofty::_LOFTY_PUBNS type_void_adapter const & key_type,
+      lofty::_LOFTY_PUBNS type_void_adapter const & value_type, std::size_t new_total_buckets,
+      std::size_t new_neighborhood_size
+   );
+
 protected:
    //! Array containing the hash of each key.
    _std::_LOFTY_PUBNS unique_ptr<std::size_t[]> hashes;
@@ -468,17 +652,34 @@ protected:
    be smaller if the table is too small, or larger if the hash function results in too many collisions. In the
    worst case, this will be the same as total_buckets. */
    std::size_t neighborhood_size_;
+   //! Factor by which the hash table is enlarged when it’s full. Always a power of 2.
+   std::size_t table_growth_factor_;
+   //! Maximum percentage of used buckets before the hash table is enlarged.
+   unsigned max_load_percent_;
+   //! If true, neighborhoods are widened before enlarging the hash table.
+   bool widen_neighborhoods;
    //! Indicates the revision number of the map contents.
    rev_int_t rev;
 
    //! Minimum bucket count. Must be a power of 2.
    static std::size_t const min_buckets = 8;
+   /*! How many pairs ahead of the current one are prefetched when adding a range. Large enough to cover the
+   latency of a read from memory, small enough to not evict prefetched pairs before they’re used. */
+   static std::size_t const bulk_prefetch_distance = 16;
    //! Special hash value used to indicate that a bucket is empty.
    static std::size_t const empty_bucket_hash = 0;
-   //! Hash table or neighborhood growth factor. Must be a power of 2.
-   static std::size_t const growth_factor = 4;
+   //! Neighborhood growth factor. Must be a power of 2.
+   static std::size_t const neighborhood_growth_factor = 4;
+   //! Default value of table_growth_factor_. Must be a power of 2.
+   static std::size_t const default_table_growth_factor = 4;
+   /*! Default value of max_load_percent_. Hopscotch hashing tolerates full tables, so by default the table
+   only grows when a key cannot be placed in its neighborhood. */
+   static unsigned const default_max_load_percent = 100;
    //! Default/ideal neighborhood size.
    static std::size_t const ideal_neighborhood_size;
+   /*! Largest neighborhood size that can_widen_neighborhoods() will allow; larger neighborhoods are only used
+   to tolerate hash collisions. */
+   static std::size_t const max_widened_neighborhood_size;
    /*! Hash value substituted when the hash function returns 0; this is so we can use 0 (aliased by
    empty_bucket_hash) as a special value. This specific value is merely the largest prime number that will fit
    in 2^16, which is the (future, if ever) minimum word size supported by Lofty. */
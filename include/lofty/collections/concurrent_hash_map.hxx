@@ -0,0 +1,271 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX
+
+#ifndef _LOFTY_NOPUB
+   #define _LOFTY_NOPUB
+   #define _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX
+#endif
+
+#ifndef _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX_NOPUB
+#define _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX_NOPUB
+
+#include <lofty/bitmanip.hxx>
+#include <lofty/collections.hxx>
+#include <lofty/collections/hash_map.hxx>
+#include <lofty/noncopyable.hxx>
+#include <lofty/_std/functional.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
+#include <lofty/_std/utility.hxx>
+#include <climits> // CHAR_BIT
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace collections {
+_LOFTY_PUBNS_BEGIN
+
+/*! Key/value map that can be used by multiple threads at the same time.
+
+The map is split into shards, each being a hash_map guarded by its own mutex; a key is always stored in the
+same shard, selected by the high bits of its scrambled hash, so that threads working on different keys rarely
+contend for the same lock. Since another thread could change or remove a value as soon as its shard is
+unlocked, there are no iterators nor references to values: find() and pop() return copies, and for_each()
+visits one shard at a time. */
+template <
+   typename TKey,
+   typename TValue,
+   typename THasher = _std::_LOFTY_PUBNS hash<TKey>,
+   typename TKeyEqual = _std::_LOFTY_PUBNS equal_to<TKey>
+>
+class concurrent_hash_map : public lofty::_LOFTY_PUBNS noncopyable, private THasher {
+public:
+   //! Key type.
+   typedef TKey key_type;
+   //! Mapped value type.
+   typedef TValue mapped_type;
+   //! Hash generator for TKey.
+   typedef THasher hasher;
+   //! Functor that can compare two TKey instances for equality.
+   typedef TKeyEqual key_equal;
+
+   //! Default count of shards.
+   static std::size_t const default_shards_size = 64;
+
+public:
+   /*! Constructor.
+
+   @param shards_size_
+      Count of shards to split the map into; it will be rounded up to a power of 2. More shards reduce the
+      likelihood of two threads contending for the same lock, at the cost of memory.
+   */
+   explicit concurrent_hash_map(std::size_t shards_size_ = default_shards_size) :
+      shards_size(bitmanip::_LOFTY_PUBNS ceiling_to_pow2(shards_size_ ? shards_size_ : 1)),
+      shards(new shard[shards_size]),
+      shard_hash_shift(sizeof(std::size_t) * CHAR_BIT) {
+      for (std::size_t i = shards_size; i > 1; i >>= 1) {
+         --shard_hash_shift;
+      }
+   }
+
+   //! Destructor.
+   ~concurrent_hash_map() {
+   }
+
+   /*! Adds a key/value pair to the map, overwriting the value if key is already associated to one.
+
+   @param key
+      Key to add.
+   @param value
+      Value to add.
+   @return
+      true if the key/value pair was just added, or false if the key already existed in the map and the
+      corresponding value was overwritten.
+   */
+   bool add_or_assign(TKey key, TValue value) {
+      auto & s = shard_for(key);
+      _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+      return s.map.add_or_assign(_std::_pub::move(key), _std::_pub::move(value)).added;
+   }
+
+   //! Removes all elements from the map. Each shard is cleared atomically, but not the map as a whole.
+   void clear() {
+      for (std::size_t i = 0; i < shards_size; ++i) {
+         auto & s = shards[i];
+         _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+         s.map.clear();
+      }
+   }
+
+   /*! Searches the map for a specific key, returning a copy of the corresponding value if found.
+
+   @param key
+      Key to search for.
+   @param value
+      Pointer to a variable that will receive a copy of the value, if found. May be nullptr to just check
+      whether the key is in the map.
+   @return
+      true if the key was found, or false otherwise.
+   */
+   bool find(TKey const & key, TValue * value) const {
+      auto & s = shard_for(key);
+      _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+      auto itr(s.map.find(key));
+      if (itr == s.map.cend()) {
+         return false;
+      }
+      if (value) {
+         *value = itr->value;
+      }
+      return true;
+   }
+
+   /*! Invokes a function on each key/value pair in the map.
+
+   Shards are locked and visited one at a time, so other threads can keep using the map: pairs added to or
+   removed from a shard that has not been visited yet may or may not be visited, but no pair will be visited
+   more than once. The function must not use the map, since the shard being visited is locked.
+
+   @param fn
+      Function to invoke, as fn(key, value); value is a non-const reference, and may be modified.
+   */
+   template <typename TFn>
+   void for_each(TFn fn) {
+      for (std::size_t i = 0; i < shards_size; ++i) {
+         auto & s = shards[i];
+         _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+         for (auto itr(s.map.begin()), end(s.map.end()); itr != end; ++itr) {
+            fn(itr->key, itr->value);
+         }
+      }
+   }
+
+   /*! Removes and returns a value given a key, which must be in the map.
+
+   @param key
+      Key associated to the value to extract.
+   @return
+      Value removed from the map.
+   */
+   TValue pop(TKey const & key) {
+      auto & s = shard_for(key);
+      _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+      return s.map.pop(key);
+   }
+
+   /*! Removes a value given a key, which must be in the map.
+
+   @param key
+      Key associated to the value to remove.
+   */
+   void remove(TKey const & key) {
+      if (!remove_if_found(key)) {
+         // TODO: provide more information in the exception.
+         LOFTY_THROW(bad_key, ());
+      }
+   }
+
+   /*! Removes a value given a key, if found in the map. If the key is not in the map, no removal occurs.
+
+   @param key
+      Key associated to the value to remove.
+   @return
+      true if a value matching the key was found (and removed), or false otherwise.
+   */
+   bool remove_if_found(TKey const & key) {
+      auto & s = shard_for(key);
+      _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+      return s.map.remove_if_found(key);
+   }
+
+   /*! Returns the count of elements in the map. Since shards are counted one at a time, the result may not
+   reflect concurrent changes.
+
+   @return
+      Count of elements.
+   */
+   std::size_t size() const {
+      std::size_t ret = 0;
+      for (std::size_t i = 0; i < shards_size; ++i) {
+         auto & s = shards[i];
+         _std::_LOFTY_PUBNS lock_guard<_std::_LOFTY_PUBNS mutex> lock(s.mutex);
+         ret += s.map.size();
+      }
+      return ret;
+   }
+
+private:
+   //! Independently locked portion of the map.
+   struct shard {
+      //! Guards map.
+      _std::_LOFTY_PUBNS mutex mutex;
+      //! Key/value pairs whose key belongs in this shard.
+      hash_map<TKey, TValue, THasher, TKeyEqual> map;
+   };
+
+private:
+   /*! Returns the shard that contains or would contain a key.
+
+   The shard is selected using the high bits of the hash, scrambled by multiplication with a large odd
+   constant, so that it doesn’t correlate with the (low) bits used by hash_map to select buckets, even for
+   hashes that don’t use all bits, such as that of integers.
+
+   @param key
+      Key to locate.
+   @return
+      Reference to the shard.
+   */
+   shard & shard_for(TKey const & key) const {
+      std::size_t key_hash = hasher::operator()(key);
+#if LOFTY_HOST_WORD_SIZE == 64
+      key_hash *= static_cast<std::size_t>(0x9e3779b97f4a7c15ull);
+#else
+      key_hash *= static_cast<std::size_t>(0x9e3779b9u);
+#endif
+      // Shifting by the whole word size is undefined, so the shift for a single shard is special-cased.
+      return shards[shards_size > 1 ? key_hash >> shard_hash_shift : 0];
+   }
+
+private:
+   //! Count of shards. Always a power of 2.
+   std::size_t const shards_size;
+   //! Shards.
+   _std::_LOFTY_PUBNS unique_ptr<shard[]> shards;
+   //! Right shift that leaves log2(shards_size) bits of a scrambled hash, used to select a shard.
+   unsigned shard_hash_shift;
+};
+
+_LOFTY_PUBNS_END
+}} //namespace lofty::collections
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif //ifndef _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX_NOPUB
+
+#ifdef _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX
+   #undef _LOFTY_NOPUB
+
+   namespace lofty { namespace collections {
+
+   using _pub::concurrent_hash_map;
+
+   }}
+
+   #ifdef LOFTY_CXX_PRAGMA_ONCE
+      #pragma once
+   #endif
+#endif
+
+#endif //ifndef _LOFTY_COLLECTIONS_CONCURRENT_HASH_MAP_HXX
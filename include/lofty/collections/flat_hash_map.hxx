@@ -0,0 +1,688 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#ifndef _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX
+
+#ifndef _LOFTY_NOPUB
+   #define _LOFTY_NOPUB
+   #define _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX
+#endif
+
+#ifndef _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX_NOPUB
+#define _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX_NOPUB
+
+#include <lofty/collections.hxx>
+#include <lofty/collections/_pvt/flat_hash_map_impl.hxx>
+#include <lofty/_std/functional.hxx>
+#include <lofty/_std/utility.hxx>
+#include <lofty/type_void_adapter.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace collections {
+_LOFTY_PUBNS_BEGIN
+
+/*! Key/value map using open addressing with control bytes probed in groups (“Swiss table” layout).
+
+Compared to hash_map, each key is stored next to its value, and the slots of a whole group are compared with
+the searched key’s hash in a single vector operation; this makes lookups touch fewer cache lines, at the cost
+of calling the hasher again for each key when the table is resized. */
+template <
+   typename TKey,
+   typename TValue,
+   typename THasher = _std::_LOFTY_PUBNS hash<TKey>,
+   typename TKeyEqual = _std::_LOFTY_PUBNS equal_to<TKey>
+>
+class flat_hash_map : public _pvt::flat_hash_map_impl, private THasher, private TKeyEqual {
+public:
+   //! Key type.
+   typedef TKey key_type;
+   //! Mapped value type.
+   typedef TValue mapped_type;
+   //! Hash generator for TKey.
+   typedef THasher hasher;
+   //! Functor that can compare two TKey instances for equality.
+   typedef TKeyEqual key_equal;
+
+   /*! Type used to contain both a key and a value. Note that this is not used in the internal data model, so
+   it’s not the same as value_type. */
+   struct pair_type {
+      //! Key.
+      TKey key;
+      //! Value.
+      TValue value;
+
+      //! Constructor.
+      pair_type(TKey && key_, TValue && value_) :
+         key(_std::_pub::move(key_)),
+         value(_std::_pub::move(value_)) {
+      }
+   };
+
+   /*! Pointer type returned by iterator::operator->() that behaves like a pointer, but in fact includes the
+   object it points to.
+
+   Needed because iterator::operator->() must return a pointer-like type to a key/value pair, but keys and
+   values are not stored in the map as a pair. */
+   template <typename TRefPair>
+   class pair_ptr {
+   public:
+      /*! Constructor.
+
+      @param key
+         Pointer to the key in the map.
+      @param value
+         Pointer to the value in the map.
+      */
+      pair_ptr(TKey * key, TValue * value) :
+         ref_pair(key, value) {
+      }
+
+      /*! Dereferencing operator.
+
+      @return
+         Reference to the key/value reference pair.
+      */
+      TRefPair const & operator*() const {
+         return ref_pair;
+      }
+
+      /*! Dereferencing member access operator.
+
+      @return
+         Pointer to the key/value reference pair.
+      */
+      TRefPair const * operator->() const {
+         return &ref_pair;
+      }
+
+   private:
+      //! Pair of references returned by operator->().
+      TRefPair const ref_pair;
+   };
+
+   //! Const iterator type.
+   class const_iterator : public flat_hash_map_impl::iterator_base {
+   private:
+      friend class flat_hash_map;
+
+   public:
+      //! Const key/value type. It should be called ref_pair, but iterators need to have value_type.
+      struct value_type {
+         //! Reference to the key.
+         TKey const & key;
+         //! Reference to the value.
+         TValue const & value;
+
+         /*! Constructor.
+
+         @param key_
+            Pointer to the key to refer to.
+         @param value_
+            Pointer to the value to refer to.
+         */
+         value_type(TKey const * key_, TValue const * value_) :
+            key(*key_),
+            value(*value_) {
+         }
+      };
+
+      typedef value_type * pointer;
+      typedef value_type & reference;
+
+   public:
+      //! Default constructor.
+      const_iterator() {
+      }
+
+      /*! Dereferencing operator.
+
+      @return
+         Reference to the current key/value pair.
+      */
+      value_type operator*() const {
+         validate();
+         flat_hash_map const * map = static_cast<flat_hash_map const *>(owner_map);
+         return value_type(map->key_ptr(slot), map->value_ptr(slot));
+      }
+
+      /*! Dereferencing member access operator.
+
+      @return
+         Pointer to the current key/value pair.
+      */
+      pair_ptr<value_type> operator->() const {
+         validate();
+         flat_hash_map const * map = static_cast<flat_hash_map const *>(owner_map);
+         return pair_ptr<value_type>(map->key_ptr(slot), map->value_ptr(slot));
+      }
+
+      /*! Preincrement operator.
+
+      @return
+         *this.
+      */
+      const_iterator & operator++() {
+         validate();
+         increment();
+         return *this;
+      }
+
+      /*! Postincrement operator.
+
+      @return
+         Iterator pointing to the previous key/value pair.
+      */
+      const_iterator operator++(int) {
+         validate();
+         std::size_t old_slot = slot;
+         increment();
+         return const_iterator(owner_map, old_slot);
+      }
+
+   protected:
+      //! See flat_hash_map_impl::iterator_base::iterator_base.
+      const_iterator(flat_hash_map_impl const * owner_map_, std::size_t slot_) :
+         flat_hash_map_impl::iterator_base(owner_map_, slot_) {
+      }
+   };
+
+   //! Iterator type.
+   class iterator : public const_iterator {
+   private:
+      friend class flat_hash_map;
+
+   public:
+      //! Key/value type. It should be called ref_pair, but iterators need to have value_type.
+      struct value_type {
+         //! Reference to the key.
+         TKey const & key;
+         //! Reference to the value.
+         TValue & value;
+
+         /*! Constructor.
+
+         @param key_
+            Pointer to the key to refer to.
+         @param value_
+            Pointer to the value to refer to.
+         */
+         value_type(TKey const * key_, TValue * value_) :
+            key(*key_),
+            value(*value_) {
+         }
+      };
+
+      typedef value_type * pointer;
+      typedef value_type & reference;
+
+   public:
+      //! Default constructor.
+      iterator() {
+      }
+
+      //! See const_iterator::operator*().
+      value_type operator*() const {
+         this->validate();
+         auto map = static_cast<flat_hash_map const *>(this->owner_map);
+         return value_type(map->key_ptr(this->slot), map->value_ptr(this->slot));
+      }
+
+      /*! Dereferencing member access operator.
+
+      @return
+         Pointer to the current key/value pair.
+      */
+      pair_ptr<value_type> operator->() const {
+         this->validate();
+         auto map = static_cast<flat_hash_map const *>(this->owner_map);
+         return pair_ptr<value_type>(map->key_ptr(this->slot), map->value_ptr(this->slot));
+      }
+
+      //! See const_iterator.operator++().
+      iterator & operator++() {
+         return static_cast<iterator &>(const_iterator::operator++());
+      }
+
+      //! See const_iterator::operator++(int).
+      iterator operator++(int) {
+         return iterator(const_iterator::operator++());
+      }
+
+   protected:
+      //! See const_iterator::const_iterator.
+      iterator(flat_hash_map_impl const * owner_map_, std::size_t slot_) :
+         const_iterator(owner_map_, slot_) {
+      }
+
+   private:
+      /*! Constructor used for cv-removing promotions from const_iterator to iterator.
+
+      @param it
+         Source object.
+      */
+      iterator(const_iterator const & it) :
+         const_iterator(it) {
+      }
+   };
+
+   typedef typename iterator::value_type value_type;
+   typedef typename const_iterator::value_type const_value_type;
+
+   //! Type returned by add_or_assign().
+   struct add_or_assign_ret {
+      //! Iterator to the (possibly newly-added) key/value.
+      iterator itr;
+      /*! true if the key/value pair was just added, or false if the key already existed in the map and the
+      corresponding value was overwritten. */
+      bool added;
+
+      /*! Constructor.
+
+      @param owner_map
+         Pointer to the map owning the iterator.
+      @param impl
+         add_or_assign_impl_ret instance to convert into an add_or_assign_ret instance.
+      */
+      add_or_assign_ret(flat_hash_map const * owner_map, add_or_assign_impl_ret impl) :
+         itr(iterator(owner_map, impl.slot)),
+         added(impl.added) {
+      }
+   };
+
+public:
+   //! Default constructor.
+   flat_hash_map() :
+      _pvt::flat_hash_map_impl(slot_size_bytes(), value_offset_bytes()) {
+   }
+
+   /*! Move constructor.
+
+   @param src
+      Source object.
+   */
+   flat_hash_map(flat_hash_map && src) :
+      _pvt::flat_hash_map_impl(_std::_pub::move(src)) {
+   }
+
+   //! Destructor.
+   ~flat_hash_map() {
+      clear();
+   }
+
+   /*! Move-assignment operator.
+
+   @param src
+      Source object.
+   @return
+      *this.
+   */
+   flat_hash_map & operator=(flat_hash_map && src) {
+      _pvt::flat_hash_map_impl::operator=(_std::_pub::move(src));
+      return *this;
+   }
+
+   /*! Element lookup operator.
+
+   @param key
+      Key to lookup.
+   @return
+      Value corresponding to key. If key is not in the map, an exception will be thrown.
+   */
+   TValue & operator[](TKey const & key) const {
+      std::size_t slot = lookup_key(key);
+      if (slot == null_index) {
+         // TODO: provide more information in the exception.
+         LOFTY_THROW(bad_key, ());
+      }
+      return *value_ptr(slot);
+   }
+
+   /*! Adds a key/value pair to the map, overwriting the value if key is already associated to one.
+
+   TODO: make four copies of this method, taking const &/const&, &&/&&, const &/&&, &&/const &; this requires
+   more work to avoid the commented-out set_copy_construct() below for non-copiable types.
+
+   @param key
+      Key to add.
+   @param value
+      Value to add.
+   @return
+      Object containing an iterator to the (possibly newly-added) key/value, and a bool value that is true if
+      the key/value pair was just added, or false if the key already existed in the map and the corresponding
+      value was overwritten.
+   */
+   add_or_assign_ret add_or_assign(TKey key, TValue value) {
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+//      key_adapter.set_copy_construct<TKey>();
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_move_construct<TKey>();
+      key_adapter.set_size<TKey>();
+//      value_adapter.set_copy_construct<TValue>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_move_construct<TValue>();
+      value_adapter.set_size<TValue>();
+      return add_or_assign_ret(this, flat_hash_map_impl::add_or_assign(
+         key_adapter, value_adapter, &keys_equal, &key_hash, &key, hasher::operator()(key), &value, 1 | 2
+      ));
+   }
+
+   /*! Returns an iterator set to the first key/value pair in the map.
+
+   @return
+      Iterator to the first key/value pair.
+   */
+   iterator begin() {
+      return iterator(this, find_first_used_slot());
+   }
+
+   /*! Returns a const iterator set to the first key/value pair in the map.
+
+   @return
+      Const iterator to the first key/value pair.
+   */
+   const_iterator begin() const {
+      return const_cast<flat_hash_map *>(this)->begin();
+   }
+
+   /*! Returns a const iterator set to the first key/value pair in the map.
+
+   @return
+      Const iterator to the first key/value pair.
+   */
+   const_iterator cbegin() const {
+      return const_cast<flat_hash_map *>(this)->begin();
+   }
+
+   /*! Returns a const iterator set beyond the last key/value pair in the map.
+
+   @return
+      Const iterator set to beyond the last key/value pair.
+   */
+   const_iterator cend() const {
+      return const_cast<flat_hash_map *>(this)->end();
+   }
+
+   //! Removes all elements from the map.
+   void clear() {
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_size<TKey>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_size<TValue>();
+      flat_hash_map_impl::clear(key_adapter, value_adapter);
+   }
+
+   /*! Returns an iterator set beyond the last key/value pair in the map.
+
+   @return
+      Iterator set to beyond the last key/value pair.
+   */
+   iterator end() {
+      return iterator(this, null_index);
+   }
+
+   /*! Returns a const iterator set beyond the last key/value pair in the map.
+
+   @return
+      Const iterator set to beyond the last key/value pair.
+   */
+   const_iterator end() const {
+      return const_cast<flat_hash_map *>(this)->end();
+   }
+
+   /*! Searches the map for a specific key, returning an iterator to the corresponding key/value pair if
+   found.
+
+   @param key
+      Key to search for.
+   @return
+      Iterator to the matching key/value, or cend() if the key could not be found.
+   */
+   iterator find(TKey const & key) {
+      std::size_t slot = lookup_key(key);
+      return iterator(this, slot);
+   }
+
+   /*! Searches the map for a specific key, returning an iterator to the corresponding key/value pair if
+   found.
+
+   @param key
+      Key to search for.
+   @return
+      Iterator to the matching key/value, or cend() if the key could not be found.
+   */
+   const_iterator find(TKey const & key) const {
+      std::size_t slot = lookup_key(key);
+      return const_iterator(this, slot);
+   }
+
+   /*! Removes and returns a value given an iterator to it.
+
+   @param itr
+      Iterator to the key/value to extract.
+   @return
+      Value removed from the map.
+   */
+   TValue pop(const_iterator itr) {
+      itr.validate();
+      TValue value(_std::_pub::move(*value_ptr(itr.slot)));
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_size<TKey>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_size<TValue>();
+      empty_slot(key_adapter, value_adapter, itr.slot);
+      return _std::_pub::move(value);
+   }
+
+   /*! Removes and returns a value given a key, which must be in the map.
+
+   @param key
+      Key associated to the value to extract.
+   @return
+      Value removed from the map.
+   */
+   TValue pop(TKey const & key) {
+      std::size_t slot = lookup_key(key);
+      if (slot == null_index) {
+         // TODO: provide more information in the exception.
+         LOFTY_THROW(bad_key, ());
+      }
+      TValue value(_std::_pub::move(*value_ptr(slot)));
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_size<TKey>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_size<TValue>();
+      empty_slot(key_adapter, value_adapter, slot);
+      return _std::_pub::move(value);
+   }
+
+   /*! Removes and returns a non-random key/value pair from the map.
+
+   @return
+      Pair containing the removed key/value.
+   */
+   pair_type pop() {
+      std::size_t slot = find_first_used_slot();
+      if (slot == null_index) {
+         LOFTY_THROW(bad_access, ());
+      }
+      pair_type ret(_std::_pub::move(*key_ptr(slot)), _std::_pub::move(*value_ptr(slot)));
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_size<TKey>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_size<TValue>();
+      empty_slot(key_adapter, value_adapter, slot);
+      return _std::_pub::move(ret);
+   }
+
+   /*! Removes a value given an iterator to it.
+
+   @param it
+      Iterator to the key/value to remove.
+   */
+   void remove(const_iterator it) {
+      lofty::_pub::type_void_adapter key_adapter, value_adapter;
+      key_adapter.set_destruct<TKey>();
+      key_adapter.set_size<TKey>();
+      value_adapter.set_destruct<TValue>();
+      value_adapter.set_size<TValue>();
+      empty_slot(key_adapter, value_adapter, it);
+   }
+
+   /*! Removes a value given a key, which must be in the map.
+
+   @param key
+      Key associated to the value to remove.
+   */
+   void remove(TKey const & key) {
+      if (!remove_if_found(key)) {
+         // TODO: provide more information in the exception.
+         LOFTY_THROW(bad_key, ());
+      }
+   }
+
+   /*! Removes a value given a key, if found in the map. If the key is not in the map, no removal occurs.
+
+   @param key
+      Key associated to the value to remove.
+   @return
+      true if a value matching the key was found (and removed), or false otherwise.
+   */
+   bool remove_if_found(TKey const & key) {
+      std::size_t slot = lookup_key(key);
+      if (slot != null_index) {
+         lofty::_pub::type_void_adapter key_adapter, value_adapter;
+         key_adapter.set_destruct<TKey>();
+         key_adapter.set_size<TKey>();
+         value_adapter.set_destruct<TValue>();
+         value_adapter.set_size<TValue>();
+         empty_slot(key_adapter, value_adapter, slot);
+         return true;
+      } else {
+         return false;
+      }
+   }
+
+private:
+   /*! Returns a pointer to the key in the specified slot.
+
+   @param slot
+      Slot index.
+   @return
+      Pointer to the key.
+   */
+   TKey * key_ptr(std::size_t slot) const {
+      return static_cast<TKey *>(slot_key(slot));
+   }
+
+   /*! Calculates the hash of a key. Static helper used by _pvt::flat_hash_map_impl.
+
+   @param this_ptr
+      Pointer to *this.
+   @param key
+      Pointer to the key to calculate a hash value for.
+   @return
+      Hash value of *key.
+   */
+   static std::size_t key_hash(flat_hash_map_impl const * this_ptr, void const * key) {
+      auto map = static_cast<flat_hash_map const *>(this_ptr);
+      return map->hasher::operator()(*static_cast<TKey const *>(key));
+   }
+
+   /*! Compares two keys for equality. Static helper used by _pvt::flat_hash_map_impl.
+
+   @param this_ptr
+      Pointer to *this.
+   @param key1
+      Pointer to the first key to compare.
+   @param key2
+      Pointer to the second key to compare.
+   @return
+      true if the two keys compare as equal, or false otherwise.
+   */
+   static bool keys_equal(flat_hash_map_impl const * this_ptr, void const * key1, void const * key2) {
+      auto map = static_cast<flat_hash_map const *>(this_ptr);
+      return map->key_equal::operator()(*static_cast<TKey const *>(key1), *static_cast<TKey const *>(key2));
+   }
+
+   /*! Looks for a specific key in the map.
+
+   @param key
+      Key to lookup.
+   @return
+      Index of the slot at which the key could be found, or null_index if the key could not be found.
+   */
+   std::size_t lookup_key(TKey const & key) const {
+      return flat_hash_map_impl::lookup_key(&keys_equal, &key, hasher::operator()(key));
+   }
+
+   /*! Returns the size of a slot, which contains a key followed by its value, padded so that both will be
+   aligned in every slot of an array.
+
+   @return
+      Slot size, in bytes.
+   */
+   static std::size_t slot_size_bytes() {
+      std::size_t align = alignof(TKey) > alignof(TValue) ? alignof(TKey) : alignof(TValue);
+      return (value_offset_bytes() + sizeof(TValue) + align - 1) / align * align;
+   }
+
+   /*! Returns the offset of the value in a slot, which immediately follows the key plus any padding needed to
+   align the value.
+
+   @return
+      Value offset, in bytes.
+   */
+   static std::size_t value_offset_bytes() {
+      return (sizeof(TKey) + alignof(TValue) - 1) / alignof(TValue) * alignof(TValue);
+   }
+
+   /*! Returns a pointer to the value in the specified slot.
+
+   @param slot
+      Slot index.
+   @return
+      Pointer to the value.
+   */
+   TValue * value_ptr(std::size_t slot) const {
+      return static_cast<TValue *>(slot_value(slot));
+   }
+};
+
+_LOFTY_PUBNS_END
+}} //namespace lofty::collections
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif //ifndef _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX_NOPUB
+
+#ifdef _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX
+   #undef _LOFTY_NOPUB
+
+   namespace lofty { namespace collections {
+
+   using _pub::flat_hash_map;
+
+   }}
+
+   #ifdef LOFTY_CXX_PRAGMA_ONCE
+      #pragma once
+   #endif
+#endif
+
+#endif //ifndef _LOFTY_COLLECTIONS_FLAT_HASH_MAP_HXX
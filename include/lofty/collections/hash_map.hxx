@@ -25,6 +25,7 @@ more details.
 #include <lofty/collections.hxx>
 #include <lofty/collections/_pvt/hash_map_impl.hxx>
 #include <lofty/_std/functional.hxx>
+#include <lofty/_std/memory.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/type_void_adapter.hxx>
 
@@ -306,6 +307,18 @@ public:
    hash_map() {
    }
 
+   /*! Constructor that adds key/value pairs from a range; see add_or_assign_range().
+
+   @param begin
+      Iterator to the first pair to add.
+   @param end
+      Iterator to beyond the last pair to add.
+   */
+   template <typename TIterator>
+   hash_map(TIterator begin, TIterator end) {
+      add_or_assign_range(begin, end);
+   }
+
    /*! Move constructor.
 
    @param src
@@ -378,6 +391,52 @@ public:
       ));
    }
 
+   /*! Adds copies of the key/value pairs in a range to the map, overwriting values whose key is already in
+   the map. Equivalent to calling add_or_assign() for each pair, but much faster for large ranges: the hash
+   table is grown only once, and pairs are added in the order of the buckets they land in, which makes
+   accesses to the table sequential instead of random.
+
+   @param begin
+      Random-access iterator to the first pair to add. Pairs can be of any type with key and value members,
+      such as pair_type.
+   @param end
+      Iterator to beyond the last pair to add.
+   */
+   template <typename TIterator>
+   void add_or_assign_range(TIterator begin, TIterator end) {
+      std::size_t pairs_size = static_cast<std::size_t>(end - begin);
+      if (pairs_size == 0) {
+         return;
+      }
+      lofty::_pub::type_void_adapter key_type, value_type;
+      key_type.set_destruct<TKey>();
+      key_type.set_move_construct<TKey>();
+      key_type.set_size<TKey>();
+      value_type.set_destruct<TValue>();
+      value_type.set_move_construct<TValue>();
+      value_type.set_size<TValue>();
+      hash_map_impl::set_capacity(key_type, value_type, used_buckets + pairs_size);
+
+      _std::_pub::unique_ptr<hashed_index[]> entries(new hashed_index[pairs_size]);
+      _std::_pub::unique_ptr<hashed_index[]> scratch(new hashed_index[pairs_size]);
+      for (std::size_t i = 0; i < pairs_size; ++i) {
+         entries[i].hash = calculate_and_adjust_hash(begin[static_cast<std::ptrdiff_t>(i)].key);
+         entries[i].index = i;
+      }
+      hashed_index const * sorted = sort_by_bucket(entries.get(), scratch.get(), pairs_size);
+      for (std::size_t i = 0; i < pairs_size; ++i) {
+         /* Pairs are now read in random order; prefetch the one a few iterations ahead, so that its read will
+         overlap with adding the current one. */
+         if (i + bulk_prefetch_distance < pairs_size) {
+            LOFTY_PREFETCH(&begin[static_cast<std::ptrdiff_t>(sorted[i + bulk_prefetch_distance].index)]);
+         }
+         auto const & pair = begin[static_cast<std::ptrdiff_t>(sorted[i].index)];
+         TKey key(pair.key);
+         TValue value(pair.value);
+         hash_map_impl::add_or_assign(key_type, value_type, &keys_equal, &key, sorted[i].hash, &value, 1 | 2);
+      }
+   }
+
    /*! Returns an iterator set to the first key/value pair in the map.
 
    @return
@@ -578,6 +637,36 @@ public:
       }
    }
 
+   /*! Sizes the hash table to hold at least new_capacity_min key/value pairs within the maximum load, so that
+   adding a known count of pairs won’t repeatedly resize it. Unless neighborhoods are widened (see
+   set_growth_policy()), a key that can’t be placed in its neighborhood may still grow the table.
+
+   @param new_capacity_min
+      Count of key/value pairs the map must be able to hold.
+   */
+   void set_capacity(std::size_t new_capacity_min) {
+      lofty::_pub::type_void_adapter key_type, value_type;
+      key_type.set_destruct<TKey>();
+      key_type.set_move_construct<TKey>();
+      key_type.set_size<TKey>();
+      value_type.set_destruct<TValue>();
+      value_type.set_move_construct<TValue>();
+      value_type.set_size<TValue>();
+      hash_map_impl::set_capacity(key_type, value_type, new_capacity_min);
+   }
+
+   //! Shrinks the hash table to the smallest size that can hold the current contents.
+   void shrink_to_fit() {
+      lofty::_pub::type_void_adapter key_type, value_type;
+      key_type.set_destruct<TKey>();
+      key_type.set_move_construct<TKey>();
+      key_type.set_size<TKey>();
+      value_type.set_destruct<TValue>();
+      value_type.set_move_construct<TValue>();
+      value_type.set_size<TValue>();
+      hash_map_impl::shrink_to_fit(key_type, value_type);
+   }
+
 private:
    /*! Calculates, adjusts and returns the hash value for the specified key.
 
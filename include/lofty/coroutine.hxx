@@ -97,6 +97,46 @@ public:
    //! Schedules coroutine execution.
    class scheduler;
 
+   /*! Tuning parameters for a new coroutine::scheduler; see
+   lofty::this_thread::attach_coroutine_scheduler(). */
+   struct LOFTY_SYM scheduler_options {
+      /*! (POSIX only) Maximum count of jobs that can wait for one of the blocking I/O threads (see
+      blocking_io_threads); once reached, lofty::this_coroutine::run_blocking_io() suspends the coroutines
+      submitting additional jobs until a thread dequeues one, slowing them down without stalling other
+      coroutines. */
+      std::size_t blocking_io_queue_depth;
+      /*! (POSIX only) Maximum count of threads that will run blocking I/O operations, such as reading regular
+      files, on behalf of coroutines; see lofty::this_coroutine::run_blocking_io(). Threads are only started
+      as needed. If 0, such operations block the thread running the coroutine. */
+      std::size_t blocking_io_threads;
+      /*! Maximum count of readiness notifications that a thread will collect from the OS with a single wait;
+      all of them are then resolved in one pass, and the resulting coroutines queued as ready. 1 means that
+      each wait will only return one notification. */
+      unsigned max_events_per_wait;
+      /*! Size of the stack of each coroutine, in bytes; rounded up to a multiple of the memory page size.
+      This does not include the guard region placed beneath each stack, which turns a stack overflow into a
+      lofty::memory::stack_overflow exception instead of memory corruption. Under Win32, this is the initial
+      commit size of each fiber’s stack, and stacks are not pooled. */
+      std::size_t stack_size;
+      /*! Maximum count of stacks of terminated coroutines that the scheduler will keep to reuse for new
+      coroutines, instead of unmapping them. */
+      std::size_t max_pooled_stacks;
+      /*! If true, the memory of each stack is committed by the OS as it’s used for the first time, so that
+      coroutines that only use a small portion of their stack don’t cost memory for the rest of it; if false,
+      each stack is fully committed when allocated, so that running out of memory is reported when creating a
+      coroutine rather than by a fault while it’s running. */
+      bool lazy_stack_commit;
+      /*! (Linux only) If true, the scheduler will set up an io_uring, and lofty::io and lofty::net classes
+      will submit their I/O operations to it and wait for their completion, instead of waiting for their file
+      descriptors to become ready and then retrying the operations; see
+      lofty::this_coroutine::perform_uring_op(). If the OS doesn’t support io_uring, the scheduler silently
+      falls back to waiting for readiness. */
+      bool use_io_uring;
+
+      //! Default constructor. Initializes all members to their default values.
+      scheduler_options();
+   };
+
 public:
    //! Default constructor.
    coroutine();
@@ -225,6 +265,41 @@ LOFTY_SYM coroutine::id_type id();
 interruptions. See @ref interruption-points for more information. */
 LOFTY_SYM void interruption_point();
 
+#if LOFTY_HOST_API_LINUX
+/*! Submits a completion-based I/O operation to the io_uring of the current coroutine’s scheduler, and
+suspends execution of the current coroutine until the operation completes. Submissions from all the coroutines
+that block during the same scheduling round are handed to the OS together.
+
+@param op
+   Operation to perform; op->result will be set once the operation completes.
+@param timeout_millisecs
+   Time after which the operation will be cancelled, resulting in an exception of type lofty::io::timeout; 0
+   to wait indefinitely.
+@return
+   true if the operation was performed, or false if the caller is not running in a coroutine, or its scheduler
+   has no io_uring (see coroutine::scheduler_options::use_io_uring); in the latter case, the caller should
+   perform the I/O operation directly, using sleep_until_fd_ready() to wait for its file descriptor.
+*/
+LOFTY_SYM bool perform_uring_op(io::_LOFTY_PUBNS uring_op * op, unsigned timeout_millisecs);
+#endif
+
+/*! Runs a function that performs blocking I/O, such as reading a regular file, on one of the blocking I/O
+threads of the current coroutine’s scheduler, and suspends execution of the current coroutine until the
+function returns. This allows other coroutines to keep running while the OS blocks the function. If the caller
+is not running in a coroutine, or the scheduler has no blocking I/O threads (see
+coroutine::scheduler_options::blocking_io_threads), the function is run on the calling thread instead. If too
+many jobs are already queued (see coroutine::scheduler_options::blocking_io_queue_depth), the coroutine is
+suspended until there’s room for its job.
+
+Since the function may run on a thread not managed by Lofty, it must not throw exceptions, and must not use
+lofty::this_thread or lofty::this_coroutine; it should just invoke the OS. The value of errno when the
+function returns is propagated to the caller.
+
+@param fn
+   Function to run.
+*/
+LOFTY_SYM void run_blocking_io(_std::_LOFTY_PUBNS function<void ()> const & fn);
+
 /*! Suspends execution of the current coroutine for at least the specified duration.
 
 @param millisecs
@@ -271,6 +346,10 @@ _LOFTY_PUBNS_END
 
    using _pub::id;
    using _pub::interruption_point;
+   #if LOFTY_HOST_API_LINUX
+   using _pub::perform_uring_op;
+   #endif
+   using _pub::run_blocking_io;
    using _pub::sleep_for_ms;
    using _pub::sleep_until_fd_ready;
 
@@ -272,7 +272,8 @@ public:
       math_floating_point_error,
       math_overflow,
       memory_bad_pointer,
-      memory_bad_pointer_alignment
+      memory_bad_pointer_alignment,
+      memory_stack_overflow
    );
 
 public:
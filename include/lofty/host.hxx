@@ -163,6 +163,8 @@ LOFTY_HOST_API_MACH, LOFTY_HOST_API_POSIX. */
 #define LOFTY_HOST_ARCH_ALPHA 0
 //! 1 if building for the ARM architecture, or 0 otherwise.
 #define LOFTY_HOST_ARCH_ARM 0
+//! 1 if building for the ARM64 architecture also known as AArch64, or 0 otherwise.
+#define LOFTY_HOST_ARCH_ARM64 0
 //! 1 if building for the i386 architecture also known as x86, or 0 otherwise.
 #define LOFTY_HOST_ARCH_I386 0
 //! 1 if building for the IA64 architecture, or 0 otherwise.
@@ -178,6 +180,9 @@ LOFTY_HOST_API_MACH, LOFTY_HOST_API_POSIX. */
 #elif defined(__arm__) || defined(_M_ARM)
    #undef LOFTY_HOST_ARCH_ARM
    #define LOFTY_HOST_ARCH_ARM 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+   #undef LOFTY_HOST_ARCH_ARM64
+   #define LOFTY_HOST_ARCH_ARM64 1
 #elif defined(__i386__) || defined(_M_IX86)
    #undef LOFTY_HOST_ARCH_I386
    #define LOFTY_HOST_ARCH_I386 1
@@ -216,8 +221,8 @@ LOFTY_HOST_API_MACH, LOFTY_HOST_API_POSIX. */
 #define LOFTY_HOST_BIG_ENDIAN 0
 
 // Assume that ARM is always used in little-endian mode.
-#if LOFTY_HOST_ARCH_ALPHA || LOFTY_HOST_ARCH_ARM || LOFTY_HOST_ARCH_I386 || LOFTY_HOST_ARCH_IA64 || \
-      LOFTY_HOST_ARCH_X86_64
+#if LOFTY_HOST_ARCH_ALPHA || LOFTY_HOST_ARCH_ARM || LOFTY_HOST_ARCH_ARM64 || LOFTY_HOST_ARCH_I386 || \
+      LOFTY_HOST_ARCH_IA64 || LOFTY_HOST_ARCH_X86_64
    #undef LOFTY_HOST_LITTLE_ENDIAN
    #define LOFTY_HOST_LITTLE_ENDIAN 1
 #elif LOFTY_HOST_ARCH_PPC
@@ -697,6 +702,20 @@ exception). This allows optimizations based on the fact that code following its
    #define LOFTY_FUNC_NORETURN
 #endif
 
+/*! Hints the CPU to start loading into its cache the memory at the specified address, because it will be read
+soon. Useful to hide the latency of reads from unpredictable addresses that are known in advance.
+
+@param ptr
+   Address of the memory that will be read.
+*/
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #define LOFTY_PREFETCH(ptr) \
+      __builtin_prefetch(ptr)
+#else
+   #define LOFTY_PREFETCH(ptr) \
+      static_cast<void>(ptr)
+#endif
+
 //! Declares a symbol to be publicly visible (exported) in the shared library being built.
 #if LOFTY_HOST_API_WIN32
    #if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_MSC
@@ -68,10 +68,11 @@ extern LOFTY_SYM filedesc_t const filedesc_t_null;
 
 //! File access modes.
 LOFTY_ENUM_AUTO_VALUES(access_mode,
-   read,        //! Read-only access.
-   read_write,  //! Read/write access.
-   write,       //! Write-only access.
-   write_append //! Append-only access.
+   read,         //! Read-only access.
+   read_write,   //! Read/write access.
+   write,        //! Write-only access.
+   write_append, //! Append-only access.
+   read_mapped   //! Read-only access, mapping regular files in memory instead of reading them.
 );
 
 //! Position indicators to which offsets may be relative.
@@ -209,16 +210,13 @@ public:
       return fd;
    }
 
-   /*! Yields ownership over the wrapped file descriptor, returning it.
+   /*! Yields ownership over the wrapped file descriptor, returning it. Since the new owner may close it
+   without notice, coroutine schedulers will forget about it.
 
    @return
       Unowned raw file descriptor.
    */
-   filedesc_t release() {
-      auto old_fd = fd;
-      fd = filedesc_t_null;
-      return old_fd;
-   }
+   filedesc_t release();
 
 #if LOFTY_HOST_API_POSIX
    /*! Sets the NONBLOCK flag.
@@ -311,6 +309,73 @@ _LOFTY_PUBNS_END
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#if LOFTY_HOST_API_LINUX
+namespace lofty { namespace io {
+_LOFTY_PUBNS_BEGIN
+
+/*! Completion-based I/O operation, to be performed by the io_uring of the current coroutine scheduler via
+lofty::this_coroutine::perform_uring_op(). The members map to those of ::io_uring_sqe with the same names, so
+that this header doesn’t need <linux/io_uring.h>; the latter is still needed for the IORING_OP_* constants. */
+struct uring_op {
+   /*! Constructor.
+
+   @param opcode_
+      Operation to perform; one of the IORING_OP_* constants.
+   @param fd_
+      File descriptor to perform the operation on.
+   @param addr_
+      Buffer, ::msghdr or ::sockaddr, depending on opcode_.
+   @param len_
+      Size of the buffer at addr_; capped to what a single I/O operation can transfer.
+   @param off_
+      File offset, or ~0 to use (and advance) the current file offset. For IORING_OP_ACCEPT, pointer to the
+      ::socklen_t receiving the size of the ::sockaddr at addr_.
+   @param op_flags_
+      Operation-specific flags, such as the flags for ::accept4().
+   */
+   uring_op(
+      std::uint8_t opcode_, filedesc_t fd_, void * addr_, std::size_t len_,
+      std::uint64_t off_ = ~std::uint64_t(0), std::uint32_t op_flags_ = 0
+   ) :
+      opcode(opcode_),
+      fd(fd_),
+      addr(addr_),
+      len(static_cast<std::uint32_t>(len_ < 0x7ffff000 ? len_ : 0x7ffff000)),
+      off(off_),
+      op_flags(op_flags_),
+      result(0) {
+   }
+
+   /*! Returns the result of the operation in the same form as the equivalent system call would.
+
+   @return
+      Value of result if the operation succeeded, or -1 after setting errno to the error code if it failed.
+   */
+   long syscall_result() const;
+
+   //! Operation to perform.
+   std::uint8_t opcode;
+   //! File descriptor to perform the operation on.
+   filedesc_t fd;
+   //! Buffer, ::msghdr or ::sockaddr.
+   void * addr;
+   //! Size of the buffer at addr, or count of ::msghdr.
+   std::uint32_t len;
+   //! File offset, or pointer to ::socklen_t.
+   std::uint64_t off;
+   //! Operation-specific flags.
+   std::uint32_t op_flags;
+   /*! Set once the operation completes to the value that the equivalent system call would return, except
+   that errors are returned as negative error codes instead of via errno. */
+   std::int32_t result;
+};
+
+_LOFTY_PUBNS_END
+}} //namespace lofty::io
+#endif //if LOFTY_HOST_API_LINUX
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty { namespace io {
 _LOFTY_PUBNS_BEGIN
 
@@ -424,6 +489,9 @@ _LOFTY_PUBNS_END
    using _pub::seek_from;
    using _pub::stdfile;
    using _pub::timeout;
+   #if LOFTY_HOST_API_LINUX
+   using _pub::uring_op;
+   #endif
 
    }}
 
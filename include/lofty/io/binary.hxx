@@ -24,6 +24,7 @@ more details.
 
 #include <lofty/io.hxx>
 #include <lofty/noncopyable.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/memory.hxx>
 #include <lofty/_std/type_traits.hxx>
 #include <lofty/_std/utility.hxx>
@@ -194,6 +195,19 @@ public:
    */
    virtual std::size_t write_bytes(void const * src, std::size_t src_size) = 0;
 
+   /*! Writes multiple arrays of bytes, in order. The default implementation calls write_bytes() once for each
+   array; streams backed by a file descriptor write all the arrays with a single system call (scatter-gather
+   I/O) whenever possible.
+
+   @param ranges
+      Pointer to the array of ranges of bytes to write.
+   @param ranges_size
+      Count of elements in the array pointed to by ranges.
+   @return
+      Count of bytes written.
+   */
+   virtual std::size_t write_vectored(buffer_range<void const> const * ranges, std::size_t ranges_size);
+
 protected:
    //! Default constructor.
    ostream();
@@ -442,6 +456,24 @@ public:
    */
    virtual std::size_t write_bytes(void const * src, std::size_t src_size) override;
 
+   /*! Writes an array of bytes without copying it into the buffer, if the implementation allows. The bytes
+   will be written after any bytes previously written to the stream, and no later than the next flush of the
+   buffer; in the meantime, the caller must keep them unchanged.
+
+   The default implementation just calls write_bytes() and then written_fn.
+
+   @param src
+      Address of the source buffer.
+   @param src_size
+      Size of the source buffer, in bytes.
+   @param written_fn
+      Function to invoke once the stream no longer needs the source buffer, because its contents have been
+      written or, in case of errors, discarded. May be empty.
+   */
+   virtual void write_bytes_by_ref(
+      void const * src, std::size_t src_size, _std::_LOFTY_PUBNS function<void ()> written_fn
+   );
+
 protected:
    //! Default constructor.
    buffered_ostream();
@@ -544,6 +576,30 @@ public:
 
    //! See ostream::write_bytes().
    virtual std::size_t write_bytes(void const * src, std::size_t src_size) override;
+
+   //! See ostream::write_vectored().
+   virtual std::size_t write_vectored(
+      buffer_range<void const> const * ranges, std::size_t ranges_size
+   ) override;
+
+#if LOFTY_HOST_API_POSIX
+protected:
+   /*! Implementation of write_vectored(), using ::writev().
+
+   @param ranges
+      Pointer to the array of ranges of bytes to write.
+   @param ranges_size
+      Count of elements in the array pointed to by ranges.
+   @param blocking
+      If true, fd can’t be waited for by the coroutine scheduler, so unless an io_uring is available,
+      ::writev() will be called via this_coroutine::run_blocking_io().
+   @return
+      Count of bytes written.
+   */
+   std::size_t writev_ranges(
+      buffer_range<void const> const * ranges, std::size_t ranges_size, bool blocking
+   );
+#endif
 };
 
 _LOFTY_PUBNS_END
@@ -627,24 +683,37 @@ _LOFTY_PUBNS_BEGIN
 
 /*! Creates and returns a buffered input stream for the specified unbuffered binary input stream.
 
+Unless specified, the size of the buffer is initially based on the type of *bin_istream (terminal, pipe,
+socket, regular file), and grows as long as reads keep filling it, since that means that the stream could
+provide more bytes per system call.
+
 @param bin_istream
    Pointer to an unbuffered binary stream.
+@param buf_size
+   Fixed size of the buffer, in bytes, or 0 to have it adapt to *bin_istream. Ignored if *bin_istream is
+   already buffered.
 @return
    Pointer to a buffered wrapper for *bin_istream.
 */
 LOFTY_SYM _std::_LOFTY_PUBNS shared_ptr<buffered_istream> buffer_istream(
-   _std::_LOFTY_PUBNS shared_ptr<istream> bin_istream
+   _std::_LOFTY_PUBNS shared_ptr<istream> bin_istream, std::size_t buf_size = 0
 );
 
 /*! Creates and returns a buffered output stream for the specified unbuffered binary output stream.
 
+Unless specified, the size of the buffer is initially based on the type of *bin_ostream (terminal, pipe,
+socket, regular file), and grows as long as writes keep flushing a full buffer.
+
 @param bin_ostream
    Pointer to an unbuffered binary stream.
+@param buf_size
+   Fixed size of the buffer, in bytes, or 0 to have it adapt to *bin_ostream. Ignored if *bin_ostream is
+   already buffered.
 @return
    Pointer to a buffered wrapper for *bin_ostream.
 */
 LOFTY_SYM _std::_LOFTY_PUBNS shared_ptr<buffered_ostream> buffer_ostream(
-   _std::_LOFTY_PUBNS shared_ptr<ostream> bin_ostream
+   _std::_LOFTY_PUBNS shared_ptr<ostream> bin_ostream, std::size_t buf_size = 0
 );
 
 /*! Creates and returns a binary input stream for the specified file descriptor.
@@ -708,6 +777,23 @@ inline _std::_LOFTY_PUBNS shared_ptr<file_istream> open_istream(
    );
 }
 
+/*! Opens a file for binary reading, mapping it in memory if it’s a regular file. Peeking at the returned
+stream yields data straight from the OS file cache, and so does reading text from it using
+lofty::io::text::make_istream(). Files that can’t be mapped (e.g. pipes) are read and buffered as usual.
+
+@param path
+   Path to the file.
+@return
+   Pointer to a buffered binary input stream for the file.
+*/
+inline _std::_LOFTY_PUBNS shared_ptr<buffered_istream> open_mapped_istream(
+   os::_LOFTY_PUBNS path const & path
+) {
+   return buffer_istream(_std::_pub::dynamic_pointer_cast<istream>(
+      open(path, io::_LOFTY_PUBNS access_mode::read_mapped)
+   ));
+}
+
 /*! Opens a file for binary writing.
 
 @param path
@@ -804,6 +890,7 @@ LOFTY_SYM _std::_LOFTY_PUBNS shared_ptr<_LOFTY_PUBNS ostream> make_stdout();
    using _pub::make_ostream;
    using _pub::open;
    using _pub::open_istream;
+   using _pub::open_mapped_istream;
    using _pub::open_ostream;
    using _pub::open_iostream;
    using _pub::ostream;
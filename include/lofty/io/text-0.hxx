@@ -95,7 +95,7 @@ _LOFTY_PUBNS_BEGIN
 //! Interface for text (character-based) input.
 class LOFTY_SYM istream : public virtual stream {
 public:
-   //! Proxy class that allows to iterate over lines of text.
+   //! Proxy class that allows to iterate over lines of text, either as copies or as views.
    class LOFTY_SYM _lines_proxy {
    private:
       friend class istream;
@@ -113,6 +113,7 @@ public:
          //! Default constructor.
          iterator() :
             istream(nullptr),
+            views(false),
             eof(true) {
          }
 
@@ -140,7 +141,7 @@ public:
             *this after it’s moved to the next line in the source.
          */
          iterator & operator++() {
-            eof = !istream->read_line(&last_read_line);
+            eof = !fetch_line();
             return *this;
          }
 
@@ -183,13 +184,25 @@ public:
 
          @param istream_
             See istream.
+         @param views_
+            See views.
          @param eof_
             See eof.
          */
-         iterator(class istream * istream_, bool eof_) :
+         iterator(class istream * istream_, bool views_, bool eof_) :
             istream(istream_),
+            views(views_),
             // If not already at EOF, fetch a new line. This may make *this == end(), which is desirable.
-            eof(eof_ || !istream->read_line(&last_read_line)) {
+            eof(eof_ || !fetch_line()) {
+         }
+
+         /*! Reads the next line into last_read_line.
+
+         @return
+            true if a line could be read, or false if the end of the stream was reached.
+         */
+         bool fetch_line() {
+            return views ? istream->read_line_view(&last_read_line) : istream->read_line(&last_read_line);
          }
 
       private:
@@ -197,6 +210,8 @@ public:
          class istream * const istream;
          //! Current line, or last line read before EOF.
          lofty::text::_LOFTY_PUBNS str mutable last_read_line;
+         //! If true, lines are read with read_line_view() instead of read_line().
+         bool views:1;
          //! If true, the iterator is at the end() of its container.
          bool eof:1;
       };
@@ -209,7 +224,7 @@ public:
       */
       iterator begin() const {
          // TODO: maybe istream should cache its EOF status and pass it here?
-         return iterator(istream, false);
+         return iterator(istream, views, false);
       }
 
       /*! Returns an iterator to the end of the source.
@@ -218,7 +233,7 @@ public:
          Line beyond the last in the source: EOF.
       */
       iterator end() const {
-         return iterator(istream, true);
+         return iterator(istream, views, true);
       }
 
    private:
@@ -226,14 +241,19 @@ public:
 
       @param istream_
          See istream.
+      @param views_
+         See views.
       */
-      explicit _lines_proxy(class istream * istream_) :
-         istream(istream_) {
+      _lines_proxy(class istream * istream_, bool views_) :
+         istream(istream_),
+         views(views_) {
       }
 
    private:
       //! Pointer to the container from which lines are read.
       class istream * istream;
+      //! If true, lines are views of the internal read buffer instead of copies.
+      bool views;
    };
 
 public:
@@ -251,7 +271,17 @@ public:
       Accessor to the lines in the source.
    */
    _lines_proxy lines() {
-      return _lines_proxy(this);
+      return _lines_proxy(this, false);
+   }
+
+   /*! Returns a pseudo-object that allows to iterate over lines of text without copying them; see
+   read_line_view(). Each line is only valid until the iterator is moved to the next one.
+
+   @return
+      Accessor to the lines in the source.
+   */
+   _lines_proxy line_views() {
+      return _lines_proxy(this, true);
    }
 
    /*! Returns a view of the internal read buffer. The string may initially use an external buffer provided by
@@ -297,6 +327,20 @@ public:
     */
    virtual bool read_line(lofty::text::_LOFTY_PUBNS str * dst);
 
+   /*! Reads a whole line, discarding the line terminator, like read_line(); instead of copying the line, the
+   string will be a view of the internal read buffer, only valid until the next call to any method of *this.
+
+   The default implementation relies on peek_chars()/consume_chars(), asking for more characters until a
+   whole line is available in the returned buffer.
+
+   @param dst
+      Pointer to the string that will receive a view of the read line, or an empty string if EOF is reached
+      before any characters could be read.
+   @return
+      true if a line could be read, or false if the end of the stream was reached.
+   */
+   virtual bool read_line_view(lofty::text::_LOFTY_PUBNS str * dst);
+
    /*! Reads multiple values at once, separating them according to the specified format.
 
    Conceptually this is the same as matching against a group-capturing regular expression; however, unlike a
@@ -390,6 +434,26 @@ protected:
    //! Default constructor.
    istream();
 
+private:
+   /*! Searches a range of characters for the first line terminator, as selected by lterm.
+
+   @param begin
+      Pointer to the first character to search.
+   @param end
+      Pointer to beyond the last character to search.
+   @param line_begin
+      Pointer to the first character of the line, which may precede begin; used to check if the character
+      preceding a LF is a CR.
+   @param lterm_end
+      Pointer to a variable that will receive a pointer to beyond the line terminator, if one is found.
+   @return
+      Pointer to the first character of the line terminator, or nullptr if none was found.
+   */
+   lofty::text::_LOFTY_PUBNS char_t const * find_line_terminator(
+      lofty::text::_LOFTY_PUBNS char_t const * begin, lofty::text::_LOFTY_PUBNS char_t const * end,
+      lofty::text::_LOFTY_PUBNS char_t const * line_begin, lofty::text::_LOFTY_PUBNS char_t const ** lterm_end
+   );
+
 protected:
    /*! If true, and lterm is line_terminator::any, and the next read operation encounters an initial ‘\n’,
    that character will not be considered as a line terminator; this way, even if a “\r\n” was broken into
@@ -1623,6 +1687,178 @@ _LOFTY_PUBNS_END
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+//! @cond
+namespace lofty { namespace io { namespace text { namespace _pvt {
+
+//! Template-free implementation of lofty::io::text::prepared_format.
+class LOFTY_SYM prepared_format_impl : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   //! Functions to handle a to_text_ostream specialization for one argument type.
+   struct arg_type {
+      /*! Creates a to_text_ostream instance, and sets its format.
+
+      @param format_spec
+         Format specification from a replacement field.
+      @return
+         Pointer to the new to_text_ostream instance.
+      */
+      void * (* new_ttos)(lofty::text::_LOFTY_PUBNS str const & format_spec);
+      /*! Destructs and deallocates a to_text_ostream instance returned by new_ttos.
+
+      @param ttos
+         Pointer to the to_text_ostream instance.
+      */
+      void (* delete_ttos)(void * ttos);
+      /*! Writes an argument with a to_text_ostream instance returned by new_ttos.
+
+      @param ttos
+         Pointer to the to_text_ostream instance.
+      @param arg
+         Pointer to the argument to write.
+      @param dst
+         Pointer to the stream to output to.
+      */
+      void (* write)(void * ttos, void const * arg, _LOFTY_PUBNS ostream * dst);
+   };
+
+protected:
+   /*! Constructor.
+
+   @param format
+      Format string to parse for replacements.
+   @param arg_types_
+      Pointer to an array of functions to handle each argument type.
+   @param arg_types_size
+      Count of arguments.
+   */
+   prepared_format_impl(
+      lofty::text::_LOFTY_PUBNS str const & format, arg_type const * arg_types_, unsigned arg_types_size
+   );
+
+   //! Destructor.
+   ~prepared_format_impl();
+
+   /*! Writes the format string, replacing each replacement field with the corresponding argument.
+
+   @param dst
+      Pointer to the stream to output to.
+   @param args
+      Pointer to an array of pointers to the arguments.
+   */
+   void print(_LOFTY_PUBNS ostream * dst, void const * const * args) const;
+
+private:
+   //! Literal characters followed by a replacement field.
+   struct segment;
+
+   //! Functions to handle each argument type.
+   arg_type const * arg_types;
+   //! Literal parts of the format string, each followed by a replacement (except for the last one).
+   _std::_LOFTY_PUBNS unique_ptr<segment[]> segments;
+   //! Count of elements in segments.
+   std::size_t segments_size;
+};
+
+//! Implementation of prepared_format_impl::arg_type for type T.
+template <typename T>
+class prepared_format_arg {
+public:
+   //! See prepared_format_impl::arg_type::new_ttos.
+   static void * new_ttos(lofty::text::_LOFTY_PUBNS str const & format_spec) {
+      _std::_LOFTY_PUBNS unique_ptr<to_text_ostream<T>> ttos(new to_text_ostream<T>());
+      ttos->set_format(format_spec);
+      return ttos.release();
+   }
+
+   //! See prepared_format_impl::arg_type::delete_ttos.
+   static void delete_ttos(void * ttos) {
+      delete static_cast<to_text_ostream<T> *>(ttos);
+   }
+
+   //! See prepared_format_impl::arg_type::write.
+   static void write(void * ttos, void const * arg, _LOFTY_PUBNS ostream * dst) {
+      static_cast<to_text_ostream<T> *>(ttos)->write(*static_cast<T const *>(arg), dst);
+   }
+
+public:
+   //! Functions for T.
+   static prepared_format_impl::arg_type const type;
+};
+
+template <typename T>
+/*static*/ prepared_format_impl::arg_type const prepared_format_arg<T>::type = {
+   &prepared_format_arg<T>::new_ttos, &prepared_format_arg<T>::delete_ttos, &prepared_format_arg<T>::write
+};
+
+}}}} //namespace lofty::io::text::_pvt
+//! @endcond
+
+namespace lofty { namespace io { namespace text {
+_LOFTY_PUBNS_BEGIN
+
+/*! Format string for ostream::print(), parsed ahead of time for a fixed list of argument types.
+
+ostream::print() parses its format string, and the format specification of each replacement field, every time
+it’s called; a prepared_format does that only once, when it’s constructed, splitting the format string into
+literal segments and a to_text_ostream instance for each replacement field, already configured with its format
+specification. Any errors in the format string are therefore reported by the constructor.
+
+This is meant to be a static variable for formats used in hot paths:
+
+   @code
+   static io::text::prepared_format<int, text::str> const fmt(LOFTY_SL("{} = {:5}\n"));
+   fmt.print(io::text::stdout.get(), 42, name);
+   @endcode
+
+The to_text_ostream instances are shared by all calls to print(), so concurrent calls from multiple threads
+are only safe if the to_text_ostream specializations involved don’t change their state in write(), like all
+the ones provided by Lofty.
+*/
+template <typename... Ts>
+class prepared_format : public _pvt::prepared_format_impl {
+public:
+   /*! Constructor.
+
+   @param format
+      Format string to parse for replacements; see ostream::print() for its syntax.
+   */
+   explicit prepared_format(lofty::text::_LOFTY_PUBNS str const & format) :
+      _pvt::prepared_format_impl(format, arg_types, sizeof...(Ts)) {
+   }
+
+   /*! Writes the format string to a stream, replacing each replacement field with the corresponding argument.
+
+   @param dst
+      Pointer to the stream to output to.
+   @param ts
+      Replacement values.
+   */
+   void print(_LOFTY_PUBNS ostream * dst, Ts const &... ts) const {
+      // The trailing nullptr avoids a zero-sized array when Ts is empty.
+      void const * const args[] = { &ts ..., nullptr };
+      _pvt::prepared_format_impl::print(dst, args);
+   }
+
+private:
+   //! Functions to handle each argument type; the trailing nullptrs avoid a zero-sized array.
+   static arg_type const arg_types[sizeof...(Ts) + 1];
+};
+
+template <typename... Ts>
+/*static*/ _pvt::prepared_format_impl::arg_type const
+prepared_format<Ts ...>::arg_types[sizeof...(Ts) + 1] = {
+   _pvt::prepared_format_arg<Ts>::type ..., { nullptr, nullptr, nullptr }
+};
+
+_LOFTY_PUBNS_END
+}}} //namespace lofty::io::text
+
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #endif //ifndef _LOFTY_IO_TEXT_0_HXX_NOPUB
 
 #ifdef _LOFTY_IO_TEXT_0_HXX
@@ -1632,6 +1868,9 @@ _LOFTY_PUBNS_END
 
    using _pub::istream;
    using _pub::ostream;
+   #ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+   using _pub::prepared_format;
+   #endif
    using _pub::stream;
 
    }}}
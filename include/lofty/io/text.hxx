@@ -137,6 +137,9 @@ public:
    //! See istream::read_line().
    virtual bool read_line(lofty::text::_LOFTY_PUBNS str * dst) override;
 
+   //! See istream::read_line_view().
+   virtual bool read_line_view(lofty::text::_LOFTY_PUBNS str * dst) override;
+
    //! See istream::unconsume_chars().
    virtual void unconsume_chars(lofty::text::_LOFTY_PUBNS str const & s) override;
 
@@ -170,6 +173,11 @@ private:
    this index have already been consumed, but are kept in it to avoid having to shift its contents on every
    call to consume_chars(). */
    std::size_t peek_buf_char_offset;
+   /*! Count of characters returned by the last call to peek_chars() as a view directly into the buffer of
+   buf_bin_istream, bypassing peek_buf; this happens if the source is valid text in the host encoding, and
+   peek_buf has no unconsumed characters. Consuming these characters consumes bytes from buf_bin_istream; any
+   that are left are known to be valid, so the next call to peek_chars() only validates what follows them. */
+   std::size_t passthrough_char_size;
    //! true if a past call to peek_chars() got to EOF.
    bool eof:1;
 };
@@ -22,48 +22,140 @@ more details.
 #ifndef _LOFTY_KEYED_DEMUX_HXX_NOPUB
 #define _LOFTY_KEYED_DEMUX_HXX_NOPUB
 
-#include <lofty/collections/hash_map.hxx>
 #include <lofty/coroutine.hxx>
-#include <lofty/event.hxx>
+#include <lofty/noncopyable.hxx>
 #include <lofty/_std/functional.hxx>
-#include <lofty/_std/mutex.hxx>
+#include <lofty/_std/memory.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/thread.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace _pvt {
+
+/*! Non-template implementation of lofty::keyed_demux. Keeps the outstanding get() calls in a hash table split
+into independently locked shards, so that get() calls on different keys rarely contend for the same lock, and
+hands values directly to the waiting coroutines and threads. */
+class LOFTY_SYM keyed_demux_impl : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   /*! Type of the function used to compare keys.
+
+   @param key1
+      Pointer to the first key.
+   @param key2
+      Pointer to the second key.
+   @return
+      true if the keys are equal, or false otherwise.
+   */
+   typedef bool (* key_equal_fn)(void const * key1, void const * key2);
+
+   /*! Type of the function used to pass a value to a get() call.
+
+   @param dst
+      Pointer to the value to assign to.
+   @param src
+      Pointer to the value to move from.
+   */
+   typedef void (* value_move_fn)(void * dst, void * src);
+
+public:
+   /*! Constructor.
+
+   @param key_equal_
+      Function to compare keys.
+   @param value_move_
+      Function to pass values to get() calls.
+   */
+   keyed_demux_impl(key_equal_fn key_equal_, value_move_fn value_move_);
+
+   //! Destructor.
+   ~keyed_demux_impl();
+
+   /*! Passes a value to the oldest get() call waiting on its key, and schedules that call to resume. The
+   caller keeps running, so that a burst of values can be delivered before any of the receivers resume.
+
+   @param key_hash
+      Hash of *key.
+   @param key
+      Pointer to the value’s key.
+   @param value
+      Pointer to the value, which will be moved from.
+   @return
+      true if a get() call was waiting for the value, or false otherwise.
+   */
+   bool deliver(std::size_t key_hash, void const * key, void * value);
+
+   /*! Resumes all waiting get() calls without a value, and makes any future get() calls return immediately.
+   Called when the source runs out of values. */
+   void end();
+
+   /*! Waits for a value with the given key to be delivered.
+
+   @param key_hash
+      Hash of *key.
+   @param key
+      Pointer to the key to wait for.
+   @param value
+      Pointer to the storage for the delivered value.
+   @param timeout_millisecs
+      Timeout for the wait, in milliseconds, or 0 to wait indefinitely. If the timeout expires, an exception
+      of type io::timeout will be thrown.
+   @return
+      true if a value was delivered, or false if the source has ended.
+   */
+   bool wait(std::size_t key_hash, void const * key, void * value, unsigned timeout_millisecs);
+
+private:
+   //! Independently locked portion of the hash table.
+   struct shard;
+   //! Coroutine or thread blocked in wait().
+   struct waiter;
+
+private:
+   /*! Returns the shard that tracks waiters for keys with the given hash.
+
+   @param key_hash
+      Hash of the key.
+   @return
+      Reference to the shard.
+   */
+   shard & shard_for(std::size_t key_hash) const;
+
+private:
+   //! Function to compare keys.
+   key_equal_fn const key_equal;
+   //! Function to pass values to get() calls.
+   value_move_fn const value_move;
+   //! Shards of the hash table of waiters.
+   _std::_LOFTY_PUBNS unique_ptr<shard[]> shards;
+};
+
+}} //namespace lofty::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty {
 _LOFTY_PUBNS_BEGIN
 
 /*! Dispatches values from a source, according to keys provided with the source. It allows for multiple
 clients to wait on different keys, only unblocking one of them when a value with a matching key is returned by
-the source. */
-template <typename TKey, typename TValue>
-class keyed_demux : public noncopyable {
-private:
-   //! Tracks a single outstanding get() call.
-   struct outstanding_get_t {
-      /*! Pointer to the event used to block the coroutine performing the get() call. Needs to be a pointer so
-      that the caller of wait() won’t be affected by outstanding_gets being resized (and event being moved
-      from allocation to allocation) while it’s waiting. */
-      _LOFTY_PUBNS event * event;
-      //! Storage to transfer data from the source coroutine to a get() call.
-      TValue value;
-
-      /*! Constructor.
-
-      @param event_
-         Pointer to the event.
-      */
-      explicit outstanding_get_t(_LOFTY_PUBNS event * event_) :
-         event(event_),
-         value() {
-      }
-   };
+the source.
 
+Each value is handed directly to the matching get() caller, which is scheduled to resume without the source
+yielding, so that a burst of values from the source is delivered to all its receivers in one go. Outstanding
+get() calls are tracked in a hash table split into shards with their own locks, so that callers on different
+keys don’t contend for a single lock. */
+template <
+   typename TKey,
+   typename TValue,
+   typename THasher = _std::_LOFTY_PUBNS hash<TKey>,
+   typename TKeyEqual = _std::_LOFTY_PUBNS equal_to<TKey>
+>
+class keyed_demux : public noncopyable {
 public:
    //! Default constructor.
-   keyed_demux() {
+   keyed_demux() :
+      impl(&key_equal, &value_move) {
    }
 
    ~keyed_demux() {
@@ -93,30 +185,15 @@ public:
          TKey key;
          try {
             while (auto value = source_fn(&key)) {
-               {
-                  _std::_pub::unique_lock<_std::_pub::mutex> lock(outstanding_gets_mutex);
-                  auto itr(outstanding_gets.find(key));
-                  if (itr == outstanding_gets.cend()) {
-                     // TODO: this is a client bug; log it or maybe invoke some client-provided callback.
-                     continue;
-                  }
-                  itr->value.value = _std::_pub::move(value);
-                  itr->value.event->trigger();
+               if (!impl.deliver(THasher()(key), &key, &value)) {
+                  // TODO: this is a client bug; log it or maybe invoke some client-provided callback.
                }
-               // TODO: allow this class to schedule directly the get() call that is waiting on the event.
-               this_coroutine::_pub::sleep_for_ms(1);
             }
          } catch (execution_interruption const &) {
             // source_fn() was interrupted; proceed with releasing all get() callers.
          }
-         /* On end of source, all get() callers are unblocked and get a default-constructed value (delayed to
-         the end of this coroutine due to scheduling) . */
-         /* Need to acquire the mutex because the .remove() in get() will break looping if running in another
-         thread, or if an unblocked coroutine resumes executing in another thread. */
-         _std::_pub::unique_lock<_std::_pub::mutex> lock(outstanding_gets_mutex);
-         LOFTY_FOR_EACH(auto kv, outstanding_gets) {
-            kv.value.event->trigger();
-         }
+         // On end of source, all get() callers are unblocked and get a default-constructed value.
+         impl.end();
       });
       if (this_thread::_pub::coroutine_scheduler()) {
          source_coroutine = coroutine(_std::_pub::move(source_loop));
@@ -137,33 +214,39 @@ public:
       function returned a value evaluating to false.
    */
    TValue get(TKey const & key, unsigned timeout_millisecs = 0) {
-      event get_event;
-      {
-         _std::_pub::unique_lock<_std::_pub::mutex> lock(outstanding_gets_mutex);
-         outstanding_gets.add_or_assign(key, outstanding_get_t(&get_event));
-      }
-      try {
-         get_event.wait(timeout_millisecs);
-      } catch (io::_LOFTY_PUBNS timeout const &) {
-         // The event is dead to us.
-         _std::_pub::unique_lock<_std::_pub::mutex> lock(outstanding_gets_mutex);
-         outstanding_gets.remove(key);
-         throw;
-      }
-
-      // Re-retrieve the key/value, since outstanding_gets might have changed in the meantime.
-      _std::_pub::unique_lock<_std::_pub::mutex> lock(outstanding_gets_mutex);
-      auto itr(outstanding_gets.find(key));
-      TValue ret(_std::_pub::move(itr->value.value));
-      outstanding_gets.remove(itr);
+      TValue ret = TValue();
+      impl.wait(THasher()(key), &key, &ret, timeout_millisecs);
       return _std::_pub::move(ret);
    }
 
 private:
-   //! Tracks all outstanding waits, so that the source coroutine can trigger the associated events as needed.
-   collections::_LOFTY_PUBNS hash_map<TKey, outstanding_get_t> outstanding_gets;
-   //! Guards concurrent access to outstanding_gets.
-   _std::_LOFTY_PUBNS mutex outstanding_gets_mutex;
+   /*! Compares two keys; used by impl.
+
+   @param key1
+      Pointer to the first key.
+   @param key2
+      Pointer to the second key.
+   @return
+      true if the keys are equal, or false otherwise.
+   */
+   static bool key_equal(void const * key1, void const * key2) {
+      return TKeyEqual()(*static_cast<TKey const *>(key1), *static_cast<TKey const *>(key2));
+   }
+
+   /*! Moves a value from the source loop to a get() call; used by impl.
+
+   @param dst
+      Pointer to the get() call’s value.
+   @param src
+      Pointer to the value returned by the source function.
+   */
+   static void value_move(void * dst, void * src) {
+      *static_cast<TValue *>(dst) = _std::_pub::move(*static_cast<TValue *>(src));
+   }
+
+private:
+   //! Tracks all outstanding get() calls, and passes values to them.
+   _pvt::keyed_demux_impl impl;
    //! Source thread (thread mode-only) to join on termination.
    thread source_thread;
    //! Source coroutine (coroutine mode-only) to join on termination.
@@ -30,6 +30,13 @@ Logging and stack tracing infrastructure. */
 #include <lofty/exception.hxx>
 #include <lofty/io/text/str.hxx>
 #include <lofty/noncopyable.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/to_str.hxx>
+#include <lofty/try_finally.hxx>
+#include <lofty/_std/atomic.hxx>
+#include <lofty/_std/new.hxx>
+#include <lofty/_std/type_traits.hxx>
+#include <lofty/_std/utility.hxx>
 
 /*! @page stack-tracing Stack tracing
 Automatic generation of stack traces whenever an exception occurs.
@@ -219,13 +226,440 @@ LOFTY_ENUM(level,
    (dbg,     3)
 );
 
+//! Behavior of LOFTY_LOG() when the calling thread’s buffer of records waiting to be written is full.
+LOFTY_ENUM(overflow_policy,
+   //! Discard the record. The count of discarded records is periodically written to the log.
+   (drop,  0),
+   //! Wait for the log writer thread to make room in the buffer.
+   (block, 1)
+);
+
+/*! Waits for all the records logged so far to be written. Records logged by other threads while this is
+waiting may or may not be written before this returns. */
+LOFTY_SYM void flush();
+
+/*! Returns a stream to write to the log synchronously, if messages of the specified level are to be logged.
+
+@param level_
+   Level of the message to be written.
+@return
+   Pointer to the log stream, or nullptr if messages of level level_ are not to be logged.
+*/
 LOFTY_SYM io::text::_LOFTY_PUBNS ostream * get_ostream_if(level level_);
 
+/*! Returns the application-wide logging level. Messages above this level are discarded by LOFTY_LOG()
+without evaluating its arguments. The default is level::info.
+
+@return
+   Current logging level.
+*/
+LOFTY_SYM level max_level();
+
+/*! Changes the application-wide logging level. See max_level().
+
+@param level_
+   New logging level.
+*/
+LOFTY_SYM void set_max_level(level level_);
+
+/*! Changes the behavior of LOFTY_LOG() when a thread logs records faster than they can be written. The
+default is overflow_policy::block.
+
+@param policy
+   New overflow policy.
+*/
+LOFTY_SYM void set_overflow_policy(overflow_policy policy);
+
 _LOFTY_PUBNS_END
 }} //namespace lofty::logging
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace logging { namespace _pvt {
+
+/*! Stores records from LOFTY_LOG() in per-thread ring buffers, and writes them to the log from a separate
+thread. Each ring buffer has a single producer (its thread), and a single consumer (the writer thread), so
+they don’t need any locking. */
+class LOFTY_SYM async_writer : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   /*! Type of the function that writes a record, and then destructs it.
+
+   @param record
+      Pointer to the record.
+   @param dst
+      Pointer to the stream to output to.
+   */
+   typedef void (* write_fn)(void * record, io::text::_LOFTY_PUBNS ostream * dst);
+
+public:
+   /*! Publishes the record for which storage was obtained with reserve(), making it available to the writer
+   thread.
+
+   @param write
+      Function that will write and destruct the record.
+   */
+   static void commit(write_fn write);
+
+   /*! Returns true if messages of the specified level are to be logged.
+
+   @param level_
+      Level of the message to be written.
+   @return
+      true if the message should be logged, or false otherwise.
+   */
+   static bool enabled(_LOFTY_PUBNS level::enum_type level_) {
+      return static_cast<int>(level_) <= max_level_value.load();
+   }
+
+   /*! Obtains storage for a record in the calling thread’s ring buffer. The record must then be constructed
+   in it and passed to commit(), without yielding to other coroutines in between.
+
+   @param size
+      Size of the record, in bytes.
+   @param sync
+      Pointer to a variable that will be set to true if the record can’t be deferred (e.g. because the writer
+      thread is not running), in which case the caller should write it synchronously.
+   @return
+      Pointer to the storage for the record, or nullptr if the record was not deferred, or was dropped due to
+      overflow_policy::drop.
+   */
+   static void * reserve(std::size_t size, bool * sync);
+
+   /*! Starts the writer thread. Until this is called, LOFTY_LOG() writes records synchronously. Called by
+   lofty::app before main(). */
+   static void start();
+
+   /*! Writes all the pending records, then stops the writer thread. Called by lofty::app after main()
+   returns. */
+   static void stop();
+
+public:
+   //! Application-wide logging level; see lofty::logging::max_level().
+   static _std::_LOFTY_PUBNS atomic<int> max_level_value;
+};
+
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+/*! Argument of LOFTY_LOG(), captured so that it can be formatted later by the writer thread. By default,
+arguments are copied; specializations handle arrays and types that can’t be copied. */
+template <typename T, bool copyable = _std::_LOFTY_PUBNS is_copy_constructible<T>::value>
+class deferred_arg {
+public:
+   /*! Constructor.
+
+   @param t
+      Argument to capture.
+   */
+   explicit deferred_arg(T const & t) :
+      value(t) {
+   }
+
+   /*! Returns the argument to format.
+
+   @return
+      Reference to the captured argument.
+   */
+   T const & get() const {
+      return value;
+   }
+
+private:
+   //! Copy of the argument.
+   T value;
+};
+
+// Specialization for arguments that can’t be copied: format them right away, with the default format.
+template <typename T>
+class deferred_arg<T, false> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(T const & t) :
+      value(lofty::_LOFTY_PUBNS to_str(t)) {
+   }
+
+   //! See deferred_arg<T, true>::get().
+   text::_LOFTY_PUBNS str const & get() const {
+      return value;
+   }
+
+private:
+   //! Argument, already formatted.
+   text::_LOFTY_PUBNS str value;
+};
+
+/* Specialization for pointers, including C strings: format them right away, with the default format, since
+the memory they point to may be gone by the time the writer thread gets to them. */
+template <typename T>
+class deferred_arg<T *, true> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(T * t) :
+      value(lofty::_LOFTY_PUBNS to_str(t)) {
+   }
+
+   //! See deferred_arg<T, true>::get().
+   text::_LOFTY_PUBNS str const & get() const {
+      return value;
+   }
+
+private:
+   //! Argument, already formatted.
+   text::_LOFTY_PUBNS str value;
+};
+
+/* Specialization for strings: copy their characters. Copying a str would share any buffer it doesn’t own,
+such as one wrapped with external_buffer (e.g. by io::text::istream::read_line_view()), which may be
+overwritten before the writer thread gets to it. */
+template <>
+class deferred_arg<text::_LOFTY_PUBNS str, true> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(text::_LOFTY_PUBNS str const & t) :
+      value(t.data(), t.data_end()) {
+   }
+
+   //! See deferred_arg<T, true>::get().
+   text::_LOFTY_PUBNS str const & get() const {
+      return value;
+   }
+
+private:
+   //! Copy of the characters of the argument.
+   text::_LOFTY_PUBNS str value;
+};
+
+// Specialization for strings with an embedded array: same as for str.
+template <std::size_t embedded_char_capacity>
+class deferred_arg<text::_LOFTY_PUBNS sstr<embedded_char_capacity>, true> :
+   public deferred_arg<text::_LOFTY_PUBNS str, true> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(text::_LOFTY_PUBNS sstr<embedded_char_capacity> const & t) :
+      deferred_arg<text::_LOFTY_PUBNS str, true>(t.str()) {
+   }
+};
+
+// Specialization for strings with an embedded array: same as for str.
+template <std::size_t embedded_char_capacity>
+class deferred_arg<text::_LOFTY_PUBNS sstr<embedded_char_capacity>, false> :
+   public deferred_arg<text::_LOFTY_PUBNS str, true> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(text::_LOFTY_PUBNS sstr<embedded_char_capacity> const & t) :
+      deferred_arg<text::_LOFTY_PUBNS str, true>(t.str()) {
+   }
+};
+
+// Specialization for arrays, such as string literals: copy their elements.
+template <typename T, std::size_t t_size>
+class deferred_arg<T[t_size], false> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(T const (& t)[t_size]) {
+      for (std::size_t i = 0; i < t_size; ++i) {
+         value[i] = t[i];
+      }
+   }
+
+   //! See deferred_arg<T, true>::get().
+   T const (& get() const)[t_size] {
+      return value;
+   }
+
+private:
+   //! Copy of the array.
+   T value[t_size];
+};
+
+// Specialization for std::type_info, as returned by typeid: it lives as long as the program.
+template <>
+class deferred_arg<_std::_LOFTY_PUBNS type_info, false> {
+public:
+   //! See deferred_arg<T, true>::deferred_arg().
+   explicit deferred_arg(_std::_LOFTY_PUBNS type_info const & t) :
+      value(&t) {
+   }
+
+   //! See deferred_arg<T, true>::get().
+   _std::_LOFTY_PUBNS type_info const & get() const {
+      return *value;
+   }
+
+private:
+   //! Pointer to the argument.
+   _std::_LOFTY_PUBNS type_info const * value;
+};
+
+//! Format string and arguments of a LOFTY_LOG() call, stored in a ring buffer of async_writer.
+template <typename... Ts>
+class deferred_record;
+
+// Base recursion step: no arguments.
+template <>
+class deferred_record<> {
+public:
+   /*! Constructor.
+
+   @param format_
+      Format string; must not share a buffer that may change before the record is written.
+   */
+   explicit deferred_record(text::_LOFTY_PUBNS str && format_) :
+      format(_std::_LOFTY_PUBNS move(format_)) {
+   }
+
+   /*! Writes the record, using the arguments collected by the outer recursion levels.
+
+   @param dst
+      Pointer to the stream to output to.
+   @param ts
+      Replacement values.
+   */
+   template <typename... Us>
+   void print(io::text::_LOFTY_PUBNS ostream * dst, Us const &... us) const {
+      dst->print(format, us ...);
+   }
+
+   /*! Writes a record, then destructs it. Used as async_writer::write_fn.
+
+   @param p
+      Pointer to the record.
+   @param dst
+      Pointer to the stream to output to.
+   */
+   static void write_and_destruct(void * p, io::text::_LOFTY_PUBNS ostream * dst) {
+      auto record = static_cast<deferred_record *>(p);
+      LOFTY_TRY {
+         record->print(dst);
+      } LOFTY_FINALLY {
+         record->~deferred_record();
+      };
+   }
+
+private:
+   //! Format string. For string literals, this doesn’t copy the characters.
+   text::_LOFTY_PUBNS str format;
+};
+
+// Recursion step: store one argument, recurse with the rest.
+template <typename T0, typename... Ts>
+class deferred_record<T0, Ts ...> {
+public:
+   /*! Constructor.
+
+   @param format
+      Format string; see deferred_record<>::deferred_record().
+   @param t0_
+      First replacement value.
+   @param ts
+      Remaining replacement values.
+   */
+   deferred_record(text::_LOFTY_PUBNS str && format, T0 const & t0_, Ts const &... ts) :
+      rest(_std::_LOFTY_PUBNS move(format), ts ...),
+      t0(t0_) {
+   }
+
+   //! See deferred_record<>::print().
+   template <typename... Us>
+   void print(io::text::_LOFTY_PUBNS ostream * dst, Us const &... us) const {
+      rest.print(dst, us ..., t0.get());
+   }
+
+   //! See deferred_record<>::write_and_destruct().
+   static void write_and_destruct(void * p, io::text::_LOFTY_PUBNS ostream * dst) {
+      auto record = static_cast<deferred_record *>(p);
+      LOFTY_TRY {
+         record->print(dst);
+      } LOFTY_FINALLY {
+         record->~deferred_record();
+      };
+   }
+
+private:
+   //! Record without the first argument.
+   deferred_record<Ts ...> rest;
+   //! First argument.
+   deferred_arg<T0> t0;
+};
+
+/*! Stores a record in the calling thread’s ring buffer, to be formatted and written by the writer thread.
+
+@param level_
+   Level of the message.
+@param format
+   Format string to parse for replacements.
+@param copy_format
+   If true, the characters of format will be copied into the record; if false, the record will share them.
+@param ts
+   Replacement values.
+*/
+template <typename... Ts>
+inline void log_deferred(
+   _LOFTY_PUBNS level::enum_type level_, text::_LOFTY_PUBNS str const & format, bool copy_format,
+   Ts const &... ts
+) {
+   typedef deferred_record<Ts ...> record_type;
+   bool sync;
+   if (void * p = async_writer::reserve(sizeof(record_type), &sync)) {
+      if (copy_format) {
+         ::new(p) record_type(text::_LOFTY_PUBNS str(format.data(), format.data_end()), ts ...);
+      } else {
+         ::new(p) record_type(text::_LOFTY_PUBNS str(format), ts ...);
+      }
+      async_writer::commit(&record_type::write_and_destruct);
+   } else if (sync) {
+      if (auto dst = _LOFTY_PUBNS get_ostream_if(level_)) {
+         dst->print(format, ts ...);
+      }
+   }
+}
+
+/*! Implementation of LOFTY_LOG(): stores the format string and arguments in the calling thread’s ring buffer,
+to be formatted and written by the writer thread.
+
+@param level_
+   Level of the message.
+@param format
+   Format string to parse for replacements. Its characters are copied, since they may change before the
+   record is written.
+@param ts
+   Replacement values.
+*/
+template <typename... Ts>
+inline void log(
+   _LOFTY_PUBNS level::enum_type level_, text::_LOFTY_PUBNS str const & format, Ts const &... ts
+) {
+   log_deferred(level_, format, true, ts ...);
+}
+
+/*! Implementation of LOFTY_LOG() for literal format strings, which are shared instead of copied.
+
+@param level_
+   Level of the message.
+@param format
+   Format string literal to parse for replacements.
+@param ts
+   Replacement values.
+*/
+template <std::size_t format_size, typename... Ts>
+inline void log(
+   _LOFTY_PUBNS level::enum_type level_, text::_LOFTY_PUBNS char_t const (& format)[format_size],
+   Ts const &... ts
+) {
+   log_deferred(level_, text::_LOFTY_PUBNS str(format), false, ts ...);
+}
+
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+}}} //namespace lofty::logging::_pvt
+
 /*! Outputs a message to the application’s log.
 
+The level is checked before any arguments are evaluated. The arguments are then captured, and formatted and
+written by a separate thread, so that the caller doesn’t block on output. Arguments are copied, except for
+strings (their characters are copied, even if they don’t own them), arrays (copied element by element),
+std::type_info (referenced, since it lives as long as the program), and pointers and non-copyable types,
+which are formatted right away with the default format.
+
 @param level
    The message will only be output if the current application-wide logging level is at least the specified
    value.
@@ -234,14 +668,25 @@ _LOFTY_PUBNS_END
 @param ...
    Replacement values.
 */
-#define LOFTY_LOG(level_, ...) \
-   do { \
-      if (auto __log = ::lofty::logging::_pub::get_ostream_if( \
-         ::lofty::logging::_pub::level::enum_type::level_ \
-      )) { \
-         __log->print(__VA_ARGS__); \
-      } \
-   } while (false)
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+   #define LOFTY_LOG(level_, ...) \
+      do { \
+         if (::lofty::logging::_pvt::async_writer::enabled( \
+            ::lofty::logging::_pub::level::enum_type::level_ \
+         )) { \
+            ::lofty::logging::_pvt::log(::lofty::logging::_pub::level::enum_type::level_, __VA_ARGS__); \
+         } \
+      } while (false)
+#else
+   #define LOFTY_LOG(level_, ...) \
+      do { \
+         if (auto __log = ::lofty::logging::_pub::get_ostream_if( \
+            ::lofty::logging::_pub::level::enum_type::level_ \
+         )) { \
+            __log->print(__VA_ARGS__); \
+         } \
+      } while (false)
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -252,8 +697,13 @@ _LOFTY_PUBNS_END
 
    namespace lofty { namespace logging {
 
+   using _pub::flush;
    using _pub::get_ostream_if;
    using _pub::level;
+   using _pub::max_level;
+   using _pub::overflow_policy;
+   using _pub::set_max_level;
+   using _pub::set_overflow_policy;
 
    }}
 
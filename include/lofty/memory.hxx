@@ -686,6 +686,46 @@ _LOFTY_PUBNS_END
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace memory {
+_LOFTY_PUBNS_BEGIN
+
+//! A coroutine used up its stack, and accessed the guard region beneath it.
+class LOFTY_SYM stack_overflow : public bad_pointer {
+public:
+   /*! Constructor.
+
+   @param ptr
+      Address in the guard region that was accessed.
+   @param err
+      OS-defined error number associated to the exception.
+   */
+   explicit stack_overflow(void const * ptr, lofty::_LOFTY_PUBNS errint_t err = 0);
+
+   /*! Copy constructor.
+
+   @param src
+      Source object.
+   */
+   stack_overflow(stack_overflow const & src);
+
+   //! Destructor.
+   virtual ~stack_overflow() LOFTY_STL_NOEXCEPT_TRUE();
+
+   /*! Copy-assignment operator.
+
+   @param src
+      Source object.
+   @return
+      *this.
+   */
+   stack_overflow & operator=(stack_overflow const & src);
+};
+
+_LOFTY_PUBNS_END
+}} //namespace lofty::memory
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #endif //ifndef _LOFTY_MEMORY_HXX_NOPUB
 
 #ifdef _LOFTY_MEMORY_HXX
@@ -711,6 +751,7 @@ _LOFTY_PUBNS_END
       using _pub::realloc_bytes;
       using _pub::realloc_unique;
       using _pub::set;
+      using _pub::stack_overflow;
    }}
 
    #ifdef LOFTY_CXX_PRAGMA_ONCE
@@ -39,7 +39,12 @@ exception being thrown by lock(), try_lock() and unlock().
 
 If a coroutine scheduler is attached to the thread that calls create(), the mutex will become a coroutine
 mutex, meaning it can only be locked/unlocked by a coroutine. If no coroutine scheduler is present, the mutex
-will become a thread mutex, meaning it can only be locked/unlocked by a thread (not running coroutines). */
+will become a thread mutex, meaning it can only be locked/unlocked by a thread (not running coroutines).
+
+A coroutine mutex doesn’t allocate anything to block a coroutine: waiting coroutines are queued in their own
+stack frames, and unlock() hands the mutex directly to the first of them. If the scheduler is run by more
+than one thread, lock() spins briefly before blocking, since the owner may be about to unlock the mutex on
+another thread. */
 class LOFTY_SYM mutex : public support_explicit_operator_bool<mutex>, public noncopyable {
 public:
    //! Coroutine mode implementation data.
@@ -84,7 +89,7 @@ public:
       true if create() has been invoked, or false otherwise.
    */
    LOFTY_EXPLICIT_OPERATOR_BOOL() const {
-      return thread_mutex != nullptr;
+      return thread_mutex || coro_mode;
    }
 
    //! Creates the mutex, allowing for lock(), try_lock() and unlock() to be invoked on it.
@@ -100,6 +105,15 @@ public:
    */
    bool try_lock();
 
+   /*! Attempts to acquire the mutex, blocking for up to the specified time.
+
+   @param timeout_millisecs
+      Maximum time to wait for the mutex, in milliseconds.
+   @return
+      true if the mutex was locked and is now owned by the caller, or false if the time ran out.
+   */
+   bool try_lock_for(unsigned timeout_millisecs);
+
    //! Releases the mutex.
    void unlock();
 
@@ -109,12 +123,79 @@ public:
    static manual_create_t const manual_create;
 
 private:
-   //! Underlying mutex for thread mode, or controls access to coro_mode in coroutine mode.
+   //! Underlying mutex for thread mode.
    _std::_LOFTY_PUBNS unique_ptr<_std::_LOFTY_PUBNS mutex> thread_mutex;
-   //! Pointer to the implementation instance.
+   //! Pointer to the implementation instance for coroutine mode.
    _std::_LOFTY_PUBNS unique_ptr<coro_mode_t> coro_mode;
 };
 
+/*! Reader/writer mutex that can be locked for exclusive ownership (lock()) by a single thread or coroutine,
+or for shared ownership (lock_shared()) by any number of threads and coroutines.
+
+Unlike lofty::mutex, a shared_mutex can be used by coroutines and threads alike. Waiters are queued in
+first-in, first-out order, and a thread or coroutine trying to get shared ownership will queue behind any
+waiting for exclusive ownership, so that writers can’t be starved by a steady stream of readers. */
+class LOFTY_SYM shared_mutex : public noncopyable {
+public:
+   //! Implementation data.
+   struct impl;
+
+public:
+   //! Default constructor.
+   shared_mutex();
+
+   //! Destructor.
+   ~shared_mutex();
+
+   //! Acquires exclusive ownership of the mutex, blocking if necessary.
+   void lock();
+
+   //! Acquires shared ownership of the mutex, blocking if necessary.
+   void lock_shared();
+
+   /*! Attempts to acquire exclusive ownership of the mutex, returning immediately if that’s not possible.
+
+   @return
+      true if the mutex is now exclusively owned by the caller, or false otherwise.
+   */
+   bool try_lock();
+
+   /*! Attempts to acquire exclusive ownership of the mutex, blocking for up to the specified time.
+
+   @param timeout_millisecs
+      Maximum time to wait for the mutex, in milliseconds.
+   @return
+      true if the mutex is now exclusively owned by the caller, or false if the time ran out.
+   */
+   bool try_lock_for(unsigned timeout_millisecs);
+
+   /*! Attempts to acquire shared ownership of the mutex, returning immediately if that’s not possible.
+
+   @return
+      true if the mutex is now owned by the caller (and possibly others), or false otherwise.
+   */
+   bool try_lock_shared();
+
+   /*! Attempts to acquire shared ownership of the mutex, blocking for up to the specified time.
+
+   @param timeout_millisecs
+      Maximum time to wait for the mutex, in milliseconds.
+   @return
+      true if the mutex is now owned by the caller (and possibly others), or false if the time ran out.
+   */
+   bool try_lock_shared_for(unsigned timeout_millisecs);
+
+   //! Releases exclusive ownership of the mutex.
+   void unlock();
+
+   //! Releases shared ownership of the mutex.
+   void unlock_shared();
+
+private:
+   //! Pointer to the implementation instance.
+   _std::_LOFTY_PUBNS unique_ptr<impl> pimpl;
+};
+
 _LOFTY_PUBNS_END
 } //namespace lofty
 
@@ -128,6 +209,7 @@ _LOFTY_PUBNS_END
    namespace lofty {
 
    using _pub::mutex;
+   using _pub::shared_mutex;
 
    }
 
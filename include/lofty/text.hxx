@@ -64,6 +64,21 @@ if lterm is line_terminator::any.
 */
 LOFTY_SYM str get_line_terminator_str(line_terminator lterm);
 
+/*! Returns the size of the longest prefix of a buffer that consists of complete, valid UTF-8 sequences.
+
+Runs of ASCII characters are skipped using vector instructions where available, so validating mostly-ASCII
+text costs little more than scanning it. Overlong sequences and sequences decoding into invalid code points
+terminate the prefix, as does a sequence cut short by the end of the buffer.
+
+@param src
+   Pointer to the buffer to validate.
+@param src_byte_size
+   Size of the buffer pointed to by src, in bytes.
+@return
+   Size of the valid prefix, in bytes. If equal to src_byte_size, the whole buffer is valid UTF-8.
+*/
+LOFTY_SYM std::size_t get_valid_utf8_prefix_size(void const * src, std::size_t src_byte_size);
+
 /*! Tries to guess the encoding of a sequence of bytes, optionally also taking into account the total number
 of bytes in the source of which the buffer is the beginning.
 
@@ -416,6 +431,7 @@ _LOFTY_PUBNS_END
    using _pub::error;
    using _pub::get_encoding_size;
    using _pub::get_line_terminator_str;
+   using _pub::get_valid_utf8_prefix_size;
    using _pub::guess_encoding;
    using _pub::guess_line_terminator;
    using _pub::is_codepoint_valid;
@@ -1178,6 +1178,29 @@ public:
    */
    const_iterator find(str const & substr, const_iterator whence) const;
 
+   /*! Searches for and returns the first occurrence of a substring prepared for repeated searches.
+
+   @param searcher
+      Substring to search for.
+   @return
+      Iterator to the first occurrence of the substring, or cend() when no matches are found.
+   */
+   const_iterator find(str_searcher const & searcher) const {
+      return find(searcher, cbegin());
+   }
+
+   /*! Searches for and returns the first occurrence after whence of a substring prepared for repeated
+   searches.
+
+   @param searcher
+      Substring to search for.
+   @param whence
+      Iterator to the first character whence the search should start.
+   @return
+      Iterator to the first occurrence of the substring, or cend() when no matches are found.
+   */
+   const_iterator find(str_searcher const & searcher, const_iterator whence) const;
+
    /*! Searches for and returns the last occurrence of the specified character.
 
    @param ch
@@ -2322,6 +2345,85 @@ inline str operator+(char32_t left, sstr<right_embedded_capacity> const & right)
    );
 }
 
+/*! Immutable string that calculates its hash value once, on construction. As the key type of a
+lofty::collections::hash_map, it allows repeated lookups with the same key to skip hashing it, and keys with
+different hash values to be told apart without comparing their characters. Constructing one from a string
+literal doesn’t copy it. */
+class hashed_str {
+public:
+   //! Default constructor.
+   hashed_str() :
+      hash_value(str_traits::hash(nullptr, nullptr)) {
+   }
+
+   /*! Constructor.
+
+   @param s_
+      Source string.
+   */
+   hashed_str(str s_) :
+      s(_std::_pub::move(s_)),
+      hash_value(str_traits::hash(s.data(), s.data_end())) {
+   }
+
+   /*! Constructor from string literals.
+
+   @param src
+      Source NUL-terminated string literal.
+   */
+   template <std::size_t src_size>
+   hashed_str(char_t const (& src)[src_size]) :
+      s(src),
+      hash_value(str_traits::hash(s.data(), s.data_end())) {
+   }
+
+   /*! Equality relational operator.
+
+   @param right
+      Right comparand.
+   @return
+      true if *this has the same characters as right, or false otherwise.
+   */
+   bool operator==(hashed_str const & right) const {
+      return hash_value == right.hash_value && s == right.s;
+   }
+
+   /*! Inequality relational operator.
+
+   @param right
+      Right comparand.
+   @return
+      true if *this has different characters than right, or false otherwise.
+   */
+   bool operator!=(hashed_str const & right) const {
+      return !operator==(right);
+   }
+
+   /*! Returns the string.
+
+   @return
+      Reference to the string.
+   */
+   str const & get() const {
+      return s;
+   }
+
+   /*! Returns the hash value of the string, as calculated by str_traits::hash().
+
+   @return
+      Hash value.
+   */
+   std::size_t hash() const {
+      return hash_value;
+   }
+
+private:
+   //! String.
+   str s;
+   //! Hash value of s.
+   std::size_t hash_value;
+};
+
 _LOFTY_PUBNS_END
 }} //namespace lofty::text
 
@@ -2337,6 +2439,13 @@ template <std::size_t embedded_capacity>
 struct hash<lofty::text::_LOFTY_PUBNS sstr<embedded_capacity>> : public hash<lofty::text::_LOFTY_PUBNS str> {
 };
 
+template <>
+struct hash<lofty::text::_LOFTY_PUBNS hashed_str> {
+   std::size_t operator()(lofty::text::_LOFTY_PUBNS hashed_str const & s) const {
+      return s.hash();
+   }
+};
+
 } //namespace std
 //! @endcond
 
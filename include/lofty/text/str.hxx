@@ -147,6 +147,7 @@ _LOFTY_PUBNS_END
 
    namespace lofty { namespace text {
 
+   using _pub::hashed_str;
    using _pub::str;
    using _pub::sstr;
 
@@ -23,6 +23,7 @@ more details.
 #define _LOFTY_TEXT_STR_TRAITS_HXX_NOPUB
 
 #include <lofty/collections/vector-0.hxx>
+#include <lofty/noncopyable.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -48,7 +49,7 @@ public:
       │ Substr index     │ 0 │ 0 1 │ 0 1 │ 0 1 2 │ 0 1 2 │ 0 1 2 3 4 5 6 │ 0 1 2 3 4 5 │
       ├──────────────────┼───┼─────┼─────┼───────┼───────┼───────────────┼─────────────┤
       │ substr_begin-end │ A │ A A │ A B │ A A A │ A A B │ A B A A B A C │ A B A B C D │
-      │ failure_restarts │ 0 │ 0 0 │ 0 0 │ 0 0 0 │ 0 0 0 │ 0 0 0 0 1 2 3 │ 0 0 0 1 2 0 │
+      │ failure_restarts │ 0 │ 0 0 │ 0 0 │ 0 0 1 │ 0 0 1 │ 0 0 0 1 1 2 3 │ 0 0 0 1 2 0 │
       └──────────────────┴───┴─────┴─────┴───────┴───────┴───────────────┴─────────────┘
       @endverbatim
    */
@@ -90,14 +91,7 @@ public:
       Pointer to the beginning of the first match, in the string to be searched, of the code point to search
       for, or nullptr if no matches are found.
    */
-   static char_t const * find_char(char_t const * str_begin, char_t const * str_end, char_t ch) {
-      for (auto s = str_begin; s < str_end; ++s) {
-         if (*s == ch) {
-            return s;
-         }
-      }
-      return str_end;
-   }
+   static char_t const * find_char(char_t const * str_begin, char_t const * str_end, char_t ch);
 
    /*! Returns a pointer to the first occurrence of a code point in a string, or str_end if no matches are
    found.
@@ -143,14 +137,7 @@ public:
       Pointer to the beginning of the last match, in the string to be searched, of the character to search
       for, or nullptr if no matches are found.
    */
-   static char_t const * find_char_last(char_t const * str_begin, char_t const * str_end, char_t cp_chars) {
-      for (auto s = str_end; s > str_begin; ) {
-         if (*--s == cp_chars) {
-            return s;
-         }
-      }
-      return str_begin;
-   }
+   static char_t const * find_char_last(char_t const * str_begin, char_t const * str_end, char_t cp_chars);
 
    /*! Returns a pointer to the last occurrence of a code point in a string, or str_begin if no matches are
    found.
@@ -167,6 +154,24 @@ public:
    */
    static char_t const * find_char_last(char_t const * str_begin, char_t const * str_end, char32_t cp);
 
+   /*! Returns a pointer to the first occurrence of either of two characters in a string, or str_end if
+   neither is found. Useful to search for delimiters, such as line terminators.
+
+   @param str_begin
+      Pointer to the first character of the string to be searched.
+   @param str_end
+      Pointer to beyond the last character of the string to be searched.
+   @param ch1
+      First character to search for.
+   @param ch2
+      Second character to search for.
+   @return
+      Pointer to the first match, in the string to be searched, of either character.
+   */
+   static char_t const * find_either_char(
+      char_t const * str_begin, char_t const * str_end, char_t ch1, char_t ch2
+   );
+
    /*! Returns the character index of the first occurrence of a string into another.
 
    @param str_begin
@@ -203,6 +208,19 @@ public:
       char_t const * str_begin, char_t const * str_end, char_t const * substr_begin, char_t const * substr_end
    );
 
+   /*! Calculates a hash value for a string. The hash is computed on the encoded characters, several bytes at
+   a time, and is seeded with a value chosen randomly when the process starts, so that hash values can’t be
+   predicted by other processes (e.g. to cause collisions in a hash map on purpose).
+
+   @param begin
+      Pointer to the first character of the string.
+   @param end
+      Pointer to beyond the last character of the string.
+   @return
+      Hash value of the string; equal strings always have equal hash values in the same process.
+   */
+   static std::size_t hash(char_t const * begin, char_t const * end);
+
    /*! Returns count of code points in a string.
 
    @param begin
@@ -229,6 +247,50 @@ public:
    static bool validate(char_t const * begin, char_t const * end, bool throw_on_errors = false);
 };
 
+/*! Substring prepared for repeated searches; it keeps a copy of the substring and the tables that
+str_traits::find_substr() would otherwise have to build on each call. */
+class LOFTY_SYM str_searcher : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   /*! Constructor.
+
+   @param substr_begin
+      Pointer to the first character of the string to search for.
+   @param substr_end
+      Pointer to beyond the last character of the string to search for.
+   */
+   str_searcher(char_t const * substr_begin, char_t const * substr_end);
+
+   //! Destructor.
+   ~str_searcher();
+
+   /*! Returns a pointer to the first occurrence of the substring in a string, or str_end if no matches are
+   found.
+
+   @param str_begin
+      Pointer to the first character of the string to be searched.
+   @param str_end
+      Pointer to beyond the last character of the string to be searched.
+   @return
+      Pointer to the beginning of the first match, or str_end if no matches are found.
+   */
+   char_t const * find(char_t const * str_begin, char_t const * str_end) const;
+
+   /*! Returns the size of the substring, in characters.
+
+   @return
+      Size of the substring, in characters.
+   */
+   std::size_t size_in_chars() const {
+      return substr.size();
+   }
+
+private:
+   //! Copy of the substring.
+   collections::_LOFTY_PUBNS vector<char_t> substr;
+   //! Failure restart table for the substring; see str_traits::_build_find_failure_restart_table().
+   collections::_LOFTY_PUBNS vector<std::size_t> failure_restarts;
+};
+
 _LOFTY_PUBNS_END
 }} //namespace lofty::text
 
@@ -241,6 +303,7 @@ _LOFTY_PUBNS_END
 
    namespace lofty { namespace text {
 
+   using _pub::str_searcher;
    using _pub::str_traits;
 
    }}
@@ -218,6 +218,21 @@ LOFTY_SYM _std::_LOFTY_PUBNS shared_ptr<
    _std::_LOFTY_PUBNS shared_ptr<lofty::_LOFTY_PUBNS coroutine::scheduler> coro_sched = nullptr
 );
 
+/*! Creates a new coroutine scheduler with the specified options, and attaches it to the current thread. The
+current thread must not already have a coroutine scheduler.
+
+@param coro_sched_opts
+   Options for the new scheduler.
+@return
+   Coroutine scheduler associated to this thread. The same scheduler can be attached to other threads by
+   passing this to the other overload of attach_coroutine_scheduler().
+*/
+LOFTY_SYM _std::_LOFTY_PUBNS shared_ptr<
+   lofty::_LOFTY_PUBNS coroutine::scheduler
+> const & attach_coroutine_scheduler(
+   lofty::_LOFTY_PUBNS coroutine::scheduler_options const & coro_sched_opts
+);
+
 /*! Returns the coroutine scheduler associated to the current thread, if any.
 
 @return
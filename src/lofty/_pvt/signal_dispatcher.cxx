@@ -17,6 +17,7 @@ more details.
 #include <lofty/_std/mutex.hxx>
 #include <lofty/thread.hxx>
 #include "signal_dispatcher.hxx"
+#include "../coroutine-scheduler.hxx"
 #include "../thread-impl.hxx"
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -256,7 +257,9 @@ signal_dispatcher::signal_dispatcher() :
    ::pthread_attr_setstacksize(&thread_attrs, PTHREAD_STACK_MIN);
    ::pthread_create(&exception_handler_thread, &thread_attrs, &signal_dispatcher::exception_handler, this);
 #elif LOFTY_HOST_API_POSIX
-   // Setup fault signal handlers.
+   /* Setup fault signal handlers. They run on the alternate signal stack, if the thread has one, so that they
+   can handle a coroutine overflowing its stack (see coroutine::scheduler::run()). */
+   sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
    sa.sa_sigaction = &fault_signal_handler;
    LOFTY_FOR_EACH(int signal, fault_signals) {
       ::sigaction(signal, &sa, nullptr);
@@ -438,7 +441,11 @@ signal_dispatcher::~signal_dispatcher() {
             break;
 
          case SIGSEGV:
-            x_type = exception::common_type::memory_bad_pointer;
+            if (_pub::coroutine::scheduler::handle_stack_guard_fault(si->si_addr)) {
+               x_type = exception::common_type::memory_stack_overflow;
+            } else {
+               x_type = exception::common_type::memory_bad_pointer;
+            }
             arg0 = reinterpret_cast<std::intptr_t>(si->si_addr);
             break;
       }
@@ -18,6 +18,7 @@ more details.
 #include <lofty/io.hxx>
 #include <lofty/io/text.hxx>
 #include <lofty/io/binary.hxx>
+#include <lofty/logging.hxx>
 #include <lofty/_std/exception.hxx>
 #include <lofty/text/str.hxx>
 #include "_pvt/signal_dispatcher.hxx"
@@ -160,6 +161,7 @@ app::app() {
       exception::common_type caught_x_type = exception::common_type::process_exit;
       try {
          sig_disp.main_thread_started();
+         logging::_pvt::async_writer::start();
          ret = instantiate_app_and_call_main_fn(args);
       } catch (_std::exception const & x) {
          try {
@@ -178,6 +180,12 @@ app::app() {
          ret = 123;
          caught_x_type = exception::execution_interruption_to_common_type();
       }
+      try {
+         // Write any log records still pending, before other threads are terminated.
+         logging::_pvt::async_writer::stop();
+      } catch (...) {
+         // FIXME: EXC-SWALLOW
+      }
       sig_disp.main_thread_terminated(caught_x_type);
       if (!deinitialize_stdio()) {
          ret = 124;
@@ -0,0 +1,385 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/collections.hxx>
+#include <lofty/collections/_pvt/flat_hash_map_impl.hxx>
+#include <lofty/memory.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/utility.hxx>
+#include <lofty/type_void_adapter.hxx>
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+   #include <emmintrin.h> // _mm_*()
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace collections { namespace _pvt {
+
+/* Group matching functions return a bit mask with bit i set if the control byte of the i-th slot in the group
+matches; groups are always group_size (16) slots long. */
+
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+/*! Loads the control bytes of a group into a vector.
+
+@param group
+   Pointer to the first control byte of the group.
+@return
+   Vector containing the control bytes.
+*/
+static __m128i group_load(std::int8_t const * group) {
+   return _mm_loadu_si128(reinterpret_cast<__m128i const *>(group));
+}
+
+/*! Returns a mask of the slots in a group whose control byte is the specified one.
+
+@param group
+   Pointer to the first control byte of the group.
+@param ctrl
+   Control byte to look for.
+@return
+   Bit mask of matching slots.
+*/
+static unsigned group_match(std::int8_t const * group, std::int8_t ctrl) {
+   return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(group_load(group), _mm_set1_epi8(ctrl))));
+}
+
+/*! Returns a mask of the unused (empty or deleted) slots in a group. Both kinds of unused slots have a
+control byte with the most significant bit set.
+
+@param group
+   Pointer to the first control byte of the group.
+@return
+   Bit mask of unused slots.
+*/
+static unsigned group_match_unused(std::int8_t const * group) {
+   return static_cast<unsigned>(_mm_movemask_epi8(group_load(group)));
+}
+#else
+// See the vector implementation of group_match().
+static unsigned group_match(std::int8_t const * group, std::int8_t ctrl) {
+   unsigned mask = 0;
+   for (unsigned i = 0; i < 16; ++i) {
+      if (group[i] == ctrl) {
+         mask |= 1u << i;
+      }
+   }
+   return mask;
+}
+
+// See the vector implementation of group_match_unused().
+static unsigned group_match_unused(std::int8_t const * group) {
+   unsigned mask = 0;
+   for (unsigned i = 0; i < 16; ++i) {
+      if (group[i] < 0) {
+         mask |= 1u << i;
+      }
+   }
+   return mask;
+}
+#endif
+
+/*! Returns the index of the least significant bit set in a non-zero mask.
+
+@param mask
+   Bit mask.
+@return
+   Index of the first bit set.
+*/
+static unsigned first_bit_index(unsigned mask) {
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+   unsigned i = 0;
+   for (; !(mask & 1u); mask >>= 1) {
+      ++i;
+   }
+   return i;
+#endif
+}
+
+/*! Scrambles a hash, so that both its high bits (used to select the first group to probe) and its low bits
+(stored in control bytes) depend on all of its bits. Unlike hash_map, which can tolerate hashes that are only
+distinct in their low bits, a group-probed table needs this: sequential hashes (e.g. from std::hash<int>,
+which returns its argument unchanged) would otherwise fill whole runs of groups, making every miss in them
+probe until the end of the run.
+
+@param key_hash
+   Hash to mix.
+@return
+   Mixed hash.
+*/
+static std::size_t mix_hash(std::size_t key_hash) {
+#if LOFTY_HOST_WORD_SIZE == 64
+   key_hash *= static_cast<std::size_t>(0x9e3779b97f4a7c15ull);
+   return key_hash ^ (key_hash >> 32);
+#else
+   key_hash *= static_cast<std::size_t>(0x9e3779b9u);
+   return key_hash ^ (key_hash >> 16);
+#endif
+}
+
+/*! Returns the control byte for a used slot containing a key with the specified mixed hash.
+
+@param mixed_hash
+   Mixed hash of the key.
+@return
+   Control byte.
+*/
+static std::int8_t hash_ctrl(std::size_t mixed_hash) {
+   return static_cast<std::int8_t>(mixed_hash & 0x7f);
+}
+
+/*! Returns the maximum number of slots that can be used in a table before it needs to grow, corresponding to
+a maximum load factor of 7/8.
+
+@param total_slots
+   Slot count.
+@return
+   Maximum used slot count.
+*/
+static std::size_t max_used_slots(std::size_t total_slots) {
+   return total_slots - total_slots / 8;
+}
+
+
+flat_hash_map_impl::flat_hash_map_impl(std::size_t slot_size_, std::size_t value_offset_) :
+   total_slots(0),
+   used_slots(0),
+   growth_left(0),
+   slot_size(slot_size_),
+   value_offset(value_offset_),
+   rev(0) {
+}
+flat_hash_map_impl::flat_hash_map_impl(flat_hash_map_impl && src) :
+   ctrls(_std::move(src.ctrls)),
+   slots(_std::move(src.slots)),
+   total_slots(src.total_slots),
+   used_slots(src.used_slots),
+   growth_left(src.growth_left),
+   slot_size(src.slot_size),
+   value_offset(src.value_offset),
+   rev(0) {
+   src.total_slots = 0;
+   src.used_slots = 0;
+   src.growth_left = 0;
+   // Invalidate all iterators for src.
+   ++src.rev;
+}
+
+flat_hash_map_impl::~flat_hash_map_impl() {
+}
+
+flat_hash_map_impl & flat_hash_map_impl::operator=(flat_hash_map_impl && src) {
+   ctrls = _std::move(src.ctrls);
+   slots = _std::move(src.slots);
+   total_slots = src.total_slots;
+   src.total_slots = 0;
+   used_slots = src.used_slots;
+   src.used_slots = 0;
+   growth_left = src.growth_left;
+   src.growth_left = 0;
+   // Invalidate all iterators for *this and for src.
+   ++rev;
+   ++src.rev;
+   return *this;
+}
+
+flat_hash_map_impl::add_or_assign_impl_ret flat_hash_map_impl::add_or_assign(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, keys_equal_fn_type keys_equal_fn,
+   key_hash_fn_type key_hash_fn, void * key, std::size_t key_hash, void * value, unsigned move
+) {
+   std::size_t slot = lookup_key(keys_equal_fn, key, key_hash);
+   if (slot != null_index) {
+      // The key is already in the map, so overwrite its value with the value argument.
+      void * dst = slot_value(slot);
+      value_type.destruct(dst);
+      if (move & 2) {
+         value_type.move_construct(dst, value);
+      } else {
+         value_type.copy_construct(dst, value);
+      }
+      ++rev;
+      return add_or_assign_impl_ret(slot, false);
+   }
+
+   std::size_t mixed_hash = mix_hash(key_hash);
+   if (total_slots == 0) {
+      resize(key_type, value_type, key_hash_fn, group_size);
+   }
+   slot = find_unused_slot(mixed_hash);
+   if (growth_left == 0 && ctrls[slot] == ctrl_empty) {
+      /* Using this slot would exceed the maximum load factor. If deleted slots make up for most of the load,
+      get rid of them by rehashing the table in place; otherwise, make the table larger. */
+      resize(
+         key_type, value_type, key_hash_fn,
+         used_slots < max_used_slots(total_slots) / 2 ? total_slots : total_slots * 2
+      );
+      slot = find_unused_slot(mixed_hash);
+   }
+   if (ctrls[slot] == ctrl_empty) {
+      --growth_left;
+   }
+   void * dst = slot_key(slot);
+   if (move & 1) {
+      key_type.move_construct(dst, key);
+   } else {
+      key_type.copy_construct(dst, key);
+   }
+   dst = slot_value(slot);
+   if (move & 2) {
+      value_type.move_construct(dst, value);
+   } else {
+      value_type.copy_construct(dst, value);
+   }
+   ctrls[slot] = hash_ctrl(mixed_hash);
+   ++used_slots;
+   ++rev;
+   return add_or_assign_impl_ret(slot, true);
+}
+
+void flat_hash_map_impl::clear(type_void_adapter const & key_type, type_void_adapter const & value_type) {
+   for (std::size_t slot = 0; slot < total_slots; ++slot) {
+      if (ctrls[slot] >= 0) {
+         key_type  .destruct(slot_key(slot));
+         value_type.destruct(slot_value(slot));
+      }
+      ctrls[slot] = ctrl_empty;
+   }
+   used_slots = 0;
+   growth_left = max_used_slots(total_slots);
+   ++rev;
+}
+
+void flat_hash_map_impl::empty_slot(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, std::size_t slot
+) {
+   key_type  .destruct(slot_key(slot));
+   value_type.destruct(slot_value(slot));
+   /* Lookups stop at the first group containing an empty slot. If this slot’s group has one, no lookup ever
+   probed past it, so the slot can be marked as empty instead of deleted. */
+   auto group = ctrls.get() + (slot & ~(group_size - 1));
+   if (group_match(group, ctrl_empty)) {
+      ctrls[slot] = ctrl_empty;
+      ++growth_left;
+   } else {
+      ctrls[slot] = ctrl_deleted;
+   }
+   --used_slots;
+   /* We could avoid incrementing rev and invalidating every iterator, since nothing other slot was affected,
+   but that would mean that an iterator to the removed pair could still be dereferenced. */
+   ++rev;
+}
+
+std::size_t flat_hash_map_impl::find_first_used_slot(std::size_t skip /*= 0*/) const {
+   for (std::size_t slot = skip; slot < total_slots; ++slot) {
+      if (ctrls[slot] >= 0) {
+         return slot;
+      }
+   }
+   return null_index;
+}
+
+std::size_t flat_hash_map_impl::find_unused_slot(std::size_t mixed_hash) const {
+   // Probe groups in triangular sequence, which is guaranteed to visit every group once.
+   std::size_t group_mask = total_slots / group_size - 1;
+   std::size_t group_index = (mixed_hash >> 7) & group_mask;
+   for (std::size_t probe = 1; ; ++probe) {
+      std::size_t group_slot = group_index * group_size;
+      if (unsigned mask = group_match_unused(ctrls.get() + group_slot)) {
+         return group_slot + first_bit_index(mask);
+      }
+      group_index = (group_index + probe) & group_mask;
+   }
+}
+
+std::size_t flat_hash_map_impl::lookup_key(
+   keys_equal_fn_type keys_equal_fn, void const * key, std::size_t key_hash
+) const {
+   if (used_slots == 0) {
+      return null_index;
+   }
+   std::size_t mixed_hash = mix_hash(key_hash);
+   std::int8_t ctrl = hash_ctrl(mixed_hash);
+   std::size_t group_mask = total_slots / group_size - 1;
+   std::size_t group_index = (mixed_hash >> 7) & group_mask;
+   /* The load factor guarantees that the table contains empty slots, so the search will end at the first
+   group having one, if no slot matches. */
+   for (std::size_t probe = 1; ; ++probe) {
+      std::size_t group_slot = group_index * group_size;
+      std::int8_t const * group = ctrls.get() + group_slot;
+      for (unsigned mask = group_match(group, ctrl); mask; mask &= mask - 1) {
+         std::size_t slot = group_slot + first_bit_index(mask);
+         if (keys_equal_fn(this, slot_key(slot), key)) {
+            return slot;
+         }
+      }
+      if (group_match(group, ctrl_empty)) {
+         return null_index;
+      }
+      group_index = (group_index + probe) & group_mask;
+   }
+}
+
+void flat_hash_map_impl::resize(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, key_hash_fn_type key_hash_fn,
+   std::size_t new_total_slots
+) {
+   // The “old” names of these three variables will make sense in a moment…
+   std::size_t old_total_slots = new_total_slots;
+   _std::unique_ptr<std::int8_t[]> old_ctrls(new std::int8_t[old_total_slots]);
+   auto old_slots(memory::alloc_bytes_unique(slot_size * old_total_slots));
+   // At this point we’re safe from exceptions, so we can update the member variables.
+   _std::swap(total_slots, old_total_slots);
+   _std::swap(ctrls, old_ctrls);
+   _std::swap(slots, old_slots);
+   // Now the names of these variables make sense :)
+
+   std::int8_t const empty_ctrl = ctrl_empty;
+   memory::set(ctrls.get(), empty_ctrl, total_slots);
+   growth_left = max_used_slots(total_slots) - used_slots;
+   // Move each key/value pair from the old arrays to the new ones.
+   auto old_slot_ptr = static_cast<std::int8_t *>(old_slots.get());
+   for (std::size_t old_slot = 0; old_slot < old_total_slots; ++old_slot, old_slot_ptr += slot_size) {
+      if (old_ctrls[old_slot] >= 0) {
+         std::size_t mixed_hash = mix_hash(key_hash_fn(this, old_slot_ptr));
+         // The new table contains no deleted slots, so this will always return an empty slot.
+         std::size_t new_slot = find_unused_slot(mixed_hash);
+         key_type  .move_construct(slot_key  (new_slot), old_slot_ptr);
+         value_type.move_construct(slot_value(new_slot), old_slot_ptr + value_offset);
+         key_type  .destruct(old_slot_ptr);
+         value_type.destruct(old_slot_ptr + value_offset);
+         ctrls[new_slot] = hash_ctrl(mixed_hash);
+      }
+   }
+}
+
+
+flat_hash_map_impl::iterator_base::iterator_base() :
+   owner_map(nullptr),
+   slot(null_index) {
+}
+
+flat_hash_map_impl::iterator_base::iterator_base(flat_hash_map_impl const * owner_map_, std::size_t slot_) :
+   owner_map(owner_map_),
+   slot(slot_),
+   rev(owner_map->rev) {
+}
+
+void flat_hash_map_impl::iterator_base::validate() const {
+   if (slot == null_index || rev != owner_map->rev) {
+      LOFTY_THROW(out_of_range, ());
+   }
+}
+
+}}} //namespace lofty::collections::_pvt
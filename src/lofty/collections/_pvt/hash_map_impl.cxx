@@ -14,6 +14,7 @@ more details.
 
 #include <lofty/collections.hxx>
 #include <lofty/collections/_pvt/hash_map_impl.hxx>
+#include <lofty/exception.hxx>
 #include <lofty/memory.hxx>
 #include <lofty/range.hxx>
 #include <lofty/_std/memory.hxx>
@@ -27,11 +28,16 @@ more details.
 namespace lofty { namespace collections { namespace _pvt {
 
 std::size_t const hash_map_impl::ideal_neighborhood_size = sizeof(std::size_t) * CHAR_BIT / 8;
+std::size_t const hash_map_impl::max_widened_neighborhood_size =
+   hash_map_impl::ideal_neighborhood_size * hash_map_impl::neighborhood_growth_factor;
 
 hash_map_impl::hash_map_impl() :
    total_buckets(0),
    used_buckets(0),
    neighborhood_size_(0),
+   table_growth_factor_(default_table_growth_factor),
+   max_load_percent_(default_max_load_percent),
+   widen_neighborhoods(false),
    rev(0) {
 }
 hash_map_impl::hash_map_impl(hash_map_impl && src) :
@@ -41,6 +47,9 @@ hash_map_impl::hash_map_impl(hash_map_impl && src) :
    total_buckets(src.total_buckets),
    used_buckets(src.used_buckets),
    neighborhood_size_(src.neighborhood_size_),
+   table_growth_factor_(src.table_growth_factor_),
+   max_load_percent_(src.max_load_percent_),
+   widen_neighborhoods(src.widen_neighborhoods),
    rev(0) {
    src.total_buckets = 0;
    src.used_buckets = 0;
@@ -62,6 +71,9 @@ hash_map_impl & hash_map_impl::operator=(hash_map_impl && src) {
    src.used_buckets = 0;
    neighborhood_size_ = src.neighborhood_size_;
    src.neighborhood_size_ = 0;
+   table_growth_factor_ = src.table_growth_factor_;
+   max_load_percent_ = src.max_load_percent_;
+   widen_neighborhoods = src.widen_neighborhoods;
    // Invalidate all iterators for *this and for src.
    ++rev;
    ++src.rev;
@@ -78,10 +90,17 @@ hash_map_impl::add_or_assign_impl_ret hash_map_impl::add_or_assign(
    /* Repeatedly resize the table until we’re able to find a bucket for the key. This should typically loop at
    most once, but need_larger_neighborhoods may need more. */
    std::size_t bucket;
-   while ((bucket = get_existing_or_empty_bucket_for_key(
-      key_type, value_type, keys_equal_fn, key, key_hash
-   )) >= first_special_index) {
-      if (bucket == need_larger_neighborhoods) {
+   for (;;) {
+      bucket = get_existing_or_empty_bucket_for_key(key_type, value_type, keys_equal_fn, key, key_hash);
+      if (bucket < first_special_index) {
+         if (hashes[bucket] != empty_bucket_hash || used_buckets < max_load_buckets(total_buckets)) {
+            break;
+         }
+         // Adding a key/value pair would exceed the maximum load.
+         grow_table(key_type, value_type);
+      } else if (
+         bucket == need_larger_neighborhoods || can_widen_neighborhoods(total_buckets, neighborhood_size_)
+      ) {
          grow_neighborhoods();
       } else {
          grow_table(key_type, value_type);
@@ -94,11 +113,11 @@ hash_map_impl::add_or_assign_impl_ret hash_map_impl::add_or_assign(
       // The bucket is currently empty, so initialize it with hash/key/value.
       set_bucket_key_value(key_type, value_type, bucket, key, value, move);
       *hash_ptr = key_hash;
+      ++used_buckets;
    } else {
       // The bucket already has a value, so overwrite that with the value argument.
       set_bucket_key_value(key_type, value_type, bucket, nullptr, value, move);
    }
-   ++used_buckets;
    ++rev;
    return add_or_assign_impl_ret(bucket, add);
 }
@@ -135,25 +154,19 @@ std::size_t hash_map_impl::find_bucket_movable_to_empty(std::size_t empty_bucket
    /* Minimum number of buckets on the right of empty_bucket_ that we need in order to have a full
    neighborhood to scan. */
    std::size_t buckets_right_of_empty = neighborhood_size_ - 1;
-   /* Ensure that the heighborhood ending with empty_bucket_ doesn’t wrap. Always having empty_bucket_ on the
-   right of any of the buckets we’re going to check simplifies the calculation of hash_ptr and the range
-   checks in the loop. */
-   if (empty_bucket_ < buckets_right_of_empty) {
-      empty_bucket_ += total_buckets;
-   }
-   // Calculate the bucket index range of the neighborhood that ends with empty_bucket_.
-   auto hash_ptr   = hashes.get() + empty_bucket_ - buckets_right_of_empty;
+   // Calculate the first bucket index of the neighborhood that ends with empty_bucket_, wrapping if needed.
+   auto hash_ptr   = hashes.get() + ((empty_bucket_ - buckets_right_of_empty) & (total_buckets - 1));
    auto hashes_end = hashes.get() + total_buckets;
    // Prepare to track the count of collisions (identical hashes) in the selected neighborhood.
    std::size_t sample_hash = *hash_ptr, collisions = 0;
    /* The neighborhood may wrap, so we can only test for inequality and rely on the wrap-around logic at the
    end of the loop body. */
    while (hash_ptr != empty_hash_ptr) {
-      /* Get the end of the original neighborhood for the key in this bucket; if the empty bucket is within
-      that index, the contents of this bucket can be moved to the empty one. */
-      std::size_t curr_nh_end = hash_neighborhood_index(*hash_ptr) + neighborhood_size_;
-      // Both indices are allowed to be >total_buckets (see above if), so this comparison is always valid.
-      if (empty_bucket_ < curr_nh_end) {
+      /* If the empty bucket is within the neighborhood of the key in this bucket, the contents of this bucket
+      can be moved to the empty one. Either may have wrapped, so compare their distance. */
+      std::size_t empty_nh_offset = (empty_bucket_ - hash_neighborhood_index(*hash_ptr)) &
+         (total_buckets - 1);
+      if (*hash_ptr != empty_bucket_hash && empty_nh_offset < neighborhood_size_) {
          return static_cast<std::size_t>(hash_ptr - hashes.get());
       }
 
@@ -223,14 +236,17 @@ std::size_t hash_map_impl::find_empty_bucket_outside_neighborhood(
          need to be resized. */
          return movable_bucket;
       }
-      // Move the contents of movable_bucket to empty_bucket_.
+      /* Move the contents of movable_bucket to empty_bucket_, then leave movable_bucket truly empty, so that
+      a resize triggered by a later iteration won’t find a moved-from key in it. */
+      auto movable_key   = static_cast<std::int8_t *>(keys  .get()) + key_type  .size() * movable_bucket;
+      auto movable_value = static_cast<std::int8_t *>(values.get()) + value_type.size() * movable_bucket;
       set_bucket_key_value(
-         key_type, value_type, empty_bucket_,
-         static_cast<std::int8_t *>(keys  .get()) + key_type  .size() * movable_bucket,
-         static_cast<std::int8_t *>(values.get()) + value_type.size() * movable_bucket,
-         1 | 2 /*move both key and value*/
+         key_type, value_type, empty_bucket_, movable_key, movable_value, 1 | 2 /*move both key and value*/
       );
       hashes[empty_bucket_] = hashes[movable_bucket];
+      hashes[movable_bucket] = empty_bucket_hash;
+      key_type  .destruct(movable_key);
+      value_type.destruct(movable_value);
       empty_bucket_ = movable_bucket;
    }
    return empty_bucket_;
@@ -246,18 +262,6 @@ std::size_t hash_map_impl::find_first_used_bucket(std::size_t skip /*= 0*/) cons
    return null_index;
 }
 
-std::size_t hash_map_impl::get_empty_bucket_for_key(
-   type_void_adapter const & key_type, type_void_adapter const & value_type, std::size_t key_hash
-) {
-   auto nh_range(hash_neighborhood_range(key_hash));
-   // Search for an empty bucket in the neighborhood.
-   std::size_t bucket = find_empty_bucket(*nh_range.begin(), *nh_range.end());
-   if (bucket != null_index) {
-      return bucket;
-   }
-   return find_empty_bucket_outside_neighborhood(key_type, value_type, *nh_range.begin(), *nh_range.end());
-}
-
 std::size_t hash_map_impl::get_existing_or_empty_bucket_for_key(
    type_void_adapter const & key_type, type_void_adapter const & value_type, keys_equal_fn_type keys_equal_fn,
    void const * key, std::size_t key_hash
@@ -271,62 +275,6 @@ std::size_t hash_map_impl::get_existing_or_empty_bucket_for_key(
    return find_empty_bucket_outside_neighborhood(key_type, value_type, *nh_range.begin(), *nh_range.end());
 }
 
-void hash_map_impl::grow_table(type_void_adapter const & key_type, type_void_adapter const & value_type) {
-   // The “old” names of these four variables will make sense in a moment…
-   std::size_t old_total_buckets = total_buckets ? total_buckets * growth_factor : min_buckets;
-   _std::unique_ptr<std::size_t[]> old_hashes(new std::size_t[old_total_buckets]);
-   auto old_keys  (memory::alloc_bytes_unique(  key_type.size() * old_total_buckets));
-   auto old_values(memory::alloc_bytes_unique(value_type.size() * old_total_buckets));
-   // At this point we’re safe from exceptions, so we can update the member variables.
-   _std::swap(total_buckets, old_total_buckets);
-   _std::swap(hashes, old_hashes);
-   _std::swap(keys,   old_keys);
-   _std::swap(values, old_values);
-   // Now the names of these variables make sense :)
-
-   /* Recalculate the neighborhood size. The (missing) “else” to this “if” is for when the actual neighborhood
-   size is greater than the ideal, which can happen when dealing with a subpar hash function that resulted in
-   more collisions than ideal_neighborhood_size. In that scenario, the table size increase doesn’t change
-   anything, since the fix has already been applied with a change in neighborhood_size_ which happened before
-   this method was called. */
-   if (neighborhood_size_ < ideal_neighborhood_size) {
-      if (total_buckets < ideal_neighborhood_size) {
-         /* neighborhood_size_ has not yet reached ideal_neighborhood_size, but it can’t exceed total_buckets,
-         so set it to the latter. */
-         neighborhood_size_ = total_buckets;
-      } else {
-         // Fix neighborhood_size_ to its ideal value.
-         neighborhood_size_ = ideal_neighborhood_size;
-      }
-   }
-
-   // Initialize hashes[i] with empty_bucket_hash.
-   memory::clear(hashes.get(), total_buckets);
-   // Re-insert each hash/key/value triplet to move it from the old arrays to the new ones.
-   auto old_hash_ptr  = old_hashes.get(), old_hashes_end = old_hash_ptr + old_total_buckets;
-   auto old_key_ptr   = static_cast<std::int8_t *>(old_keys  .get());
-   auto old_value_ptr = static_cast<std::int8_t *>(old_values.get());
-   for (
-      ;
-      old_hash_ptr < old_hashes_end;
-      ++old_hash_ptr, old_key_ptr += key_type.size(), old_value_ptr += value_type.size()
-   ) {
-      if (*old_hash_ptr != empty_bucket_hash) {
-         std::size_t new_bucket = get_empty_bucket_for_key(key_type, value_type, *old_hash_ptr);
-         LOFTY_ASSERT(new_bucket < first_special_index,
-            LOFTY_SL("failed to find empty bucket while growing hash table; ")
-            LOFTY_SL("if it could be found before, why not now when there are more buckets?")
-         );
-
-         // Move hash/key/value to the new bucket.
-         set_bucket_key_value(key_type, value_type, new_bucket, old_key_ptr, old_value_ptr, 1 | 2);
-         hashes[new_bucket] = *old_hash_ptr;
-         key_type  .destruct(old_key_ptr);
-         value_type.destruct(old_value_ptr);
-      }
-   }
-}
-
 std::size_t hash_map_impl::lookup_key_or_find_empty_bucket(
    type_void_adapter const & key_type, keys_equal_fn_type keys_equal_fn, void const * key,
    std::size_t key_hash, range<std::size_t> nh_range
@@ -334,23 +282,27 @@ std::size_t hash_map_impl::lookup_key_or_find_empty_bucket(
    auto hash_ptr      = hashes.get() + *nh_range.begin();
    auto hashes_nh_end = hashes.get() + *nh_range.end();
    auto hashes_end    = hashes.get() + total_buckets;
+   /* Removals can leave empty buckets before the key in its neighborhood, so the key must be searched for in
+   the whole neighborhood before settling for the first empty bucket. */
+   std::size_t empty_bucket_ = null_index;
    /* nh_range may be a wrapping range, so we can only test for inequality and rely on the wrap-around logic
    at the end of the loop body. Also, we need to iterate at least once, otherwise we won’t enter the loop at
    all if the start condition is the same as the end condition, which is the case for
    neighborhood_size_ == total_buckets. */
    do {
-      if (
-         *hash_ptr == empty_bucket_hash ||
+      if (*hash_ptr == empty_bucket_hash) {
+         if (empty_bucket_ == null_index) {
+            empty_bucket_ = static_cast<std::size_t>(hash_ptr - hashes.get());
+         }
+      } else if (*hash_ptr == key_hash && keys_equal_fn(
          /* Multiple calculations of the second half of the && should be rare enough (exact key match or hash
          collision) to make recalculating the offset from keys cheaper than keeping a cursor over keys running
          in parallel to hash_ptr. */
-         (*hash_ptr == key_hash && keys_equal_fn(
-            this,
-            static_cast<std::int8_t const *>(keys.get()) +
-               key_type.size() * static_cast<std::size_t>(hash_ptr - hashes.get()),
-            key
-         ))
-      ) {
+         this,
+         static_cast<std::int8_t const *>(keys.get()) +
+            key_type.size() * static_cast<std::size_t>(hash_ptr - hashes.get()),
+         key
+      )) {
          return static_cast<std::size_t>(hash_ptr - hashes.get());
       }
 
@@ -359,7 +311,77 @@ std::size_t hash_map_impl::lookup_key_or_find_empty_bucket(
          hash_ptr = hashes.get();
       }
    } while (hash_ptr != hashes_nh_end);
-   return null_index;
+   return empty_bucket_;
+}
+
+std::size_t hash_map_impl::min_total_buckets_for(std::size_t capacity) const {
+   std::size_t ret = min_buckets;
+   while (max_load_buckets(ret) < capacity) {
+      ret <<= 1;
+   }
+   return ret;
+}
+
+std::size_t hash_map_impl::place_hash(
+   std::size_t key_hash, std::size_t * source_indices, std::size_t source_index
+) {
+   auto nh_range(hash_neighborhood_range(key_hash));
+   std::size_t nh_begin = *nh_range.begin(), nh_end = *nh_range.end();
+   std::size_t bucket = find_empty_bucket(nh_begin, nh_end);
+   if (bucket == null_index) {
+      // Same as find_empty_bucket_outside_neighborhood(), but moving source indices instead of keys/values.
+      bucket = find_empty_bucket(nh_end, nh_begin);
+      if (bucket == null_index) {
+         return need_larger_table;
+      }
+      while (nh_begin < nh_end
+         ? bucket >= nh_end || bucket < nh_begin // Non-wrapping: |---[begin end)---|
+         : bucket >= nh_end && bucket < nh_begin // Wrapping:     | end)-----[begin |
+      ) {
+         std::size_t movable_bucket = find_bucket_movable_to_empty(bucket);
+         if (movable_bucket >= first_special_index) {
+            return movable_bucket;
+         }
+         hashes[bucket] = hashes[movable_bucket];
+         source_indices[bucket] = source_indices[movable_bucket];
+         hashes[movable_bucket] = empty_bucket_hash;
+         bucket = movable_bucket;
+      }
+   }
+   hashes[bucket] = key_hash;
+   source_indices[bucket] = source_index;
+   return bucket;
+}
+
+bool hash_map_impl::rehash(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, std::size_t new_total_buckets,
+   std::size_t max_total_buckets
+) {
+   /* Bring the neighborhood size to its ideal value. If it’s already larger, it’s because a subpar hash
+   function resulted in more collisions than ideal_neighborhood_size, and that fix needs to be preserved. */
+   std::size_t new_neighborhood_size = neighborhood_size_;
+   if (new_neighborhood_size < ideal_neighborhood_size) {
+      new_neighborhood_size = ideal_neighborhood_size;
+   }
+   for (;;) {
+      // The neighborhood size can’t exceed the table size.
+      if (new_neighborhood_size > new_total_buckets) {
+         new_neighborhood_size = new_total_buckets;
+      }
+      std::size_t ret = try_rehash(key_type, value_type, new_total_buckets, new_neighborhood_size);
+      if (ret == 0) {
+         return true;
+      } else if (
+         ret == need_larger_neighborhoods || can_widen_neighborhoods(new_total_buckets, new_neighborhood_size)
+      ) {
+         new_neighborhood_size *= neighborhood_growth_factor;
+      } else {
+         new_total_buckets *= table_growth_factor_;
+         if (new_total_buckets >= max_total_buckets) {
+            return false;
+         }
+      }
+   }
 }
 
 void hash_map_impl::set_bucket_key_value(
@@ -384,6 +406,132 @@ void hash_map_impl::set_bucket_key_value(
    }
 }
 
+void hash_map_impl::set_capacity(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, std::size_t new_capacity_min
+) {
+   std::size_t new_total_buckets = min_total_buckets_for(new_capacity_min);
+   if (new_total_buckets > total_buckets) {
+      rehash(key_type, value_type, new_total_buckets, null_index);
+   }
+}
+
+void hash_map_impl::set_growth_policy(
+   std::size_t new_table_growth_factor, unsigned new_max_load_percent, bool new_widen_neighborhoods
+) {
+   if (
+      new_table_growth_factor < 2 || (new_table_growth_factor & (new_table_growth_factor - 1)) != 0 ||
+      new_max_load_percent < 1 || new_max_load_percent > 100
+   ) {
+      LOFTY_THROW(argument_error, ());
+   }
+   table_growth_factor_ = new_table_growth_factor;
+   max_load_percent_ = new_max_load_percent;
+   widen_neighborhoods = new_widen_neighborhoods;
+}
+
+void hash_map_impl::shrink_to_fit(type_void_adapter const & key_type, type_void_adapter const & value_type) {
+   if (used_buckets == 0) {
+      hashes.reset();
+      keys.reset();
+      values.reset();
+      total_buckets = 0;
+      neighborhood_size_ = 0;
+      ++rev;
+      return;
+   }
+   std::size_t new_total_buckets = min_total_buckets_for(used_buckets);
+   if (new_total_buckets < total_buckets) {
+      // If the contents only fit in a table as large as the current one, keep the latter.
+      rehash(key_type, value_type, new_total_buckets, total_buckets);
+   }
+}
+
+hash_map_impl::hashed_index * hash_map_impl::sort_by_bucket(
+   hashed_index * entries, hashed_index * scratch, std::size_t size
+) const {
+   /* LSD radix sort on the bucket index, digit_bits at a time; this is linear in size, and being stable, it
+   preserves the relative order of duplicate keys. 2^11 counters fit comfortably in the L1 cache. */
+   static unsigned const digit_bits = 11;
+   static std::size_t const digit_values = std::size_t(1) << digit_bits;
+   std::size_t counts[digit_values];
+   for (unsigned shift = 0; (total_buckets - 1) >> shift; shift += digit_bits) {
+      memory::clear(counts, digit_values);
+      for (std::size_t i = 0; i < size; ++i) {
+         ++counts[(hash_neighborhood_index(entries[i].hash) >> shift) & (digit_values - 1)];
+      }
+      // Convert counts into starting offsets.
+      for (std::size_t digit = 0, offset = 0; digit < digit_values; ++digit) {
+         std::size_t count = counts[digit];
+         counts[digit] = offset;
+         offset += count;
+      }
+      for (std::size_t i = 0; i < size; ++i) {
+         scratch[counts[(hash_neighborhood_index(entries[i].hash) >> shift) & (digit_values - 1)]++] =
+            entries[i];
+      }
+      _std::swap(entries, scratch);
+   }
+   return entries;
+}
+
+std::size_t hash_map_impl::try_rehash(
+   type_void_adapter const & key_type, type_void_adapter const & value_type, std::size_t new_total_buckets,
+   std::size_t new_neighborhood_size
+) {
+   _std::unique_ptr<std::size_t[]> new_hashes(new std::size_t[new_total_buckets]);
+   _std::unique_ptr<std::size_t[]> source_indices(new std::size_t[new_total_buckets]);
+   auto new_keys  (memory::alloc_bytes_unique(  key_type.size() * new_total_buckets));
+   auto new_values(memory::alloc_bytes_unique(value_type.size() * new_total_buckets));
+   // Initialize new_hashes[i] with empty_bucket_hash.
+   memory::clear(new_hashes.get(), new_total_buckets);
+
+   /* Switch to the new hashes array, so that place_hash() and the functions it uses will operate on it. From
+   here on, nothing can throw until all the hashes have been placed. */
+   auto & old_hashes = new_hashes;
+   std::size_t old_total_buckets = total_buckets, old_neighborhood_size = neighborhood_size_;
+   _std::swap(hashes, old_hashes);
+   total_buckets = new_total_buckets;
+   neighborhood_size_ = new_neighborhood_size;
+   for (std::size_t old_bucket = 0; old_bucket < old_total_buckets; ++old_bucket) {
+      std::size_t key_hash = old_hashes[old_bucket];
+      if (key_hash != empty_bucket_hash) {
+         std::size_t bucket = place_hash(key_hash, source_indices.get(), old_bucket);
+         if (bucket >= first_special_index) {
+            // Roll back to the old hashes array, which still matches keys and values.
+            _std::swap(hashes, old_hashes);
+            total_buckets = old_total_buckets;
+            neighborhood_size_ = old_neighborhood_size;
+            return bucket;
+         }
+      }
+   }
+
+   // Move each key/value from its old bucket to its new one.
+   auto old_keys   = static_cast<std::int8_t *>(keys  .get());
+   auto old_values = static_cast<std::int8_t *>(values.get());
+   auto new_key_ptr   = static_cast<std::int8_t *>(new_keys  .get());
+   auto new_value_ptr = static_cast<std::int8_t *>(new_values.get());
+   for (
+      std::size_t bucket = 0;
+      bucket < total_buckets;
+      ++bucket, new_key_ptr += key_type.size(), new_value_ptr += value_type.size()
+   ) {
+      if (hashes[bucket] != empty_bucket_hash) {
+         std::size_t old_bucket = source_indices[bucket];
+         void * old_key_ptr   = old_keys   + key_type  .size() * old_bucket;
+         void * old_value_ptr = old_values + value_type.size() * old_bucket;
+         key_type  .move_construct(new_key_ptr,   old_key_ptr);
+         value_type.move_construct(new_value_ptr, old_value_ptr);
+         key_type  .destruct(old_key_ptr);
+         value_type.destruct(old_value_ptr);
+      }
+   }
+   _std::swap(keys,   new_keys);
+   _std::swap(values, new_values);
+   ++rev;
+   return 0;
+}
+
 
 hash_map_impl::iterator_base::iterator_base() :
    owner_map(nullptr),
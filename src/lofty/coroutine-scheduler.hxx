@@ -24,8 +24,7 @@ more details.
 
 #include <lofty/coroutine.hxx>
 #include <lofty/collections/hash_map.hxx>
-#include <lofty/collections/queue.hxx>
-#include <lofty/collections/trie_ordered_multimap.hxx>
+#include <lofty/collections/vector.hxx>
 #include <lofty/event.hxx>
 #include <lofty/io.hxx>
 #include <lofty/_std/atomic.hxx>
@@ -35,6 +34,23 @@ more details.
 #if LOFTY_HOST_API_POSIX
    #include <ucontext.h>
 #endif
+#if LOFTY_HOST_API_LINUX
+   #include <linux/io_uring.h>
+#endif
+
+/*! If 1, coroutine contexts are switched by Lofty’s own assembly routines, which only save and restore the
+registers that the ABI requires to be preserved across a function call; if 0, they are switched by
+::swapcontext(), which also makes a system call to save and restore the signal mask. Can be defined to 0
+before building Lofty to force using ::swapcontext(). */
+#ifndef LOFTY_COROUTINE_ASM_CONTEXT
+   #if LOFTY_HOST_API_POSIX && !LOFTY_HOST_API_DARWIN && (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && ( \
+      LOFTY_HOST_ARCH_ARM64 || LOFTY_HOST_ARCH_X86_64 \
+   )
+      #define LOFTY_COROUTINE_ASM_CONTEXT 1
+   #else
+      #define LOFTY_COROUTINE_ASM_CONTEXT 0
+   #endif
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -53,8 +69,182 @@ public:
    typedef std::uint32_t time_duration_t;
    //! Integer type large enough to represent a point in time with resolution of one millisecond.
    typedef std::uint64_t time_point_t;
+#if LOFTY_COROUTINE_ASM_CONTEXT
+   /*! Suspended execution context. Only the stack pointer is stored here, since all the registers are saved
+   on the stack itself. */
+   typedef void * context_t;
+#elif LOFTY_HOST_API_POSIX
+   //! Suspended execution context.
+   typedef ::ucontext_t context_t;
+#endif
+
+   //! Upper limit for scheduler_options::max_events_per_wait.
+   static unsigned const max_events_per_wait_limit = 256;
+
+   /*! Tracks a coroutine suspended by park_active(), until unpark() is called on it. Meant to be linked into
+   wait lists owned by synchronization objects, so that blocking on them doesn’t need a scheduler event. */
+   struct parked_coroutine {
+      //! Coroutine to resume; set by park_active().
+      impl * coro_pimpl;
+      //! true if unpark() has been called.
+      bool unparked;
+   };
+
+#if LOFTY_HOST_API_POSIX
+   /*! Memory mapped for use as a coroutine’s stack, preceded by an inaccessible guard region so that a stack
+   overflow causes a fault instead of overwriting other memory. */
+   class stack : public noncopyable {
+   public:
+      //! Default constructor.
+      stack() :
+         ptr(nullptr),
+         byte_size(0),
+         guard_byte_size(0),
+         guard_breached(false) {
+      }
+
+      /*! Constructor.
+
+      @param byte_size
+         Size of the stack, in bytes. Will be rounded up to a multiple of the memory page size.
+      @param lazy_commit
+         If false, all the pages of the stack will be committed before the constructor returns.
+      */
+      stack(std::size_t byte_size, bool lazy_commit);
+
+      /*! Move constructor.
+
+      @param src
+         Source object.
+      */
+      stack(stack && src);
+
+      //! Destructor.
+      ~stack();
+
+      /*! Move-assignment operator.
+
+      @param src
+         Source object.
+      @return
+         *this.
+      */
+      stack & operator=(stack && src);
+
+      /*! Checks whether an address that caused a memory access fault is in the guard region; if so, and the
+      guard region has not been breached before, makes all but its lowest page accessible, so that the fault
+      can be turned into an exception using it as stack space. Called from a signal handler.
+
+      @param addr
+         Address that could not be accessed.
+      @return
+         true if addr is in the guard region and the stack can still be used to throw an exception, or false
+         otherwise.
+      */
+      bool breach_guard(void const * addr);
+
+      /*! Returns a pointer to the lowest usable address of the stack.
+
+      @return
+         Pointer to the start of the stack.
+      */
+      void * get() const {
+         return ptr;
+      }
+
+      /*! Returns true if the stack can be used by another coroutine, which is only the case if its guard
+      region is still intact.
+
+      @return
+         true if breach_guard() never gave up part of the guard region, or false otherwise.
+      */
+      bool reusable() const {
+         return !guard_breached;
+      }
+
+      /*! Returns the usable size of the stack.
+
+      @return
+         Size of the stack, in bytes.
+      */
+      std::size_t size() const {
+         return byte_size;
+      }
+
+   private:
+      /*! Size of the portion of the guard region that breach_guard() makes accessible, which must be enough
+      to throw an exception. The guard region is one page larger than this. */
+      static std::size_t const guard_spare_byte_size = 32 * 1024;
+
+      //! Pointer to the lowest usable address of the stack; the guard region lies just below it.
+      void * ptr;
+      //! Usable size of the stack, in bytes.
+      std::size_t byte_size;
+      //! Size of the guard region, in bytes.
+      std::size_t guard_byte_size;
+      //! true if breach_guard() made part of the guard region accessible.
+      bool guard_breached;
+   };
+#endif
 
 private:
+   /*! Maximum count of threads running the same scheduler that can have their own queue of ready coroutines;
+   any additional threads will only use ready_coros_queue. */
+   static std::size_t const max_workers = 64;
+#if LOFTY_HOST_API_LINUX
+   /*! Maximum count of coroutines that can be activated while uring operations are waiting to be submitted;
+   bounds the delay that batching submissions adds to each operation. */
+   static std::size_t const max_uring_deferred_activations = 64;
+   //! Size of the uring submission queue.
+   static unsigned const uring_sq_size = 256;
+   /*! Size of the uring completion queue. Larger than the submission queue, since the operations of every
+   blocked coroutine can be pending at the same time. */
+   static unsigned const uring_cq_size = 4096;
+#endif
+
+   //! State of a thread running the scheduler, including its queue of ready coroutines.
+   class worker;
+
+   /*! FIFO queue of coroutines, linked through a member of coroutine::impl so that adding a coroutine never
+   allocates memory. A coroutine can only be in one such queue at a time. */
+   class impl_queue : public noncopyable {
+   public:
+      //! Default constructor.
+      impl_queue() :
+         first(nullptr),
+         last(nullptr) {
+      }
+
+      /*! Returns true if the queue contains no coroutines.
+
+      @return
+         true if the queue is empty, or false otherwise.
+      */
+      bool empty() const {
+         return first == nullptr;
+      }
+
+      /*! Removes the first coroutine from the queue.
+
+      @return
+         Removed coroutine, or nullptr if the queue is empty.
+      */
+      impl * pop_front();
+
+      /*! Adds a coroutine at the end of the queue.
+
+      @param coro_pimpl
+         Coroutine to add.
+      */
+      void push_back(impl * coro_pimpl);
+
+   private:
+      //! First coroutine in the queue.
+      impl * first;
+      //! Last coroutine in the queue.
+      impl * last;
+   };
+
    union fd_io_key {
 #if LOFTY_HOST_API_BSD
       typedef void * pack_t;
@@ -70,20 +260,351 @@ private:
       pack_t pack;
    };
 
+#if LOFTY_HOST_API_LINUX
+   //! Readiness cache for a file descriptor registered with engine_fd.
+   struct fd_readiness {
+      //! true if the fd became readable while no coroutine was waiting to read from it.
+      bool read;
+      //! true if the fd became writable while no coroutine was waiting to write to it.
+      bool write;
+   };
+#endif
+
+#if LOFTY_HOST_API_LINUX
+   /*! io_uring instance, set up and driven via raw system calls. Submission queue entries obtained with
+   get_sqe() are only handed to the OS by the next submit(), so several of them can be submitted at once. Not
+   thread-safe: the scheduler serializes access to it with uring_mutex. */
+   class uring : public noncopyable {
+   public:
+      //! Default constructor. Does not set up an io_uring; see open().
+      uring();
+
+      //! Destructor.
+      ~uring();
+
+      /*! Discards the oldest completion queue entry, returned by peek_cqe(). */
+      void advance_cq() {
+         __atomic_store_n(cq_head, *cq_head + 1, __ATOMIC_RELEASE);
+      }
+
+      /*! Returns true if the OS had to hold back completions because the completion queue was full; in that
+      case, flush_cq_overflow() needs to be called once the completion queue has been drained.
+
+      @return
+         true if completions were held back, or false otherwise.
+      */
+      bool cq_overflowed() const {
+         return (__atomic_load_n(sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) != 0;
+      }
+
+      /*! Returns the file descriptor of the io_uring, which becomes readable when there are completions.
+
+      @return
+         File descriptor of the io_uring.
+      */
+      io::_LOFTY_PUBNS filedesc const & fd() const {
+         return ring_fd;
+      }
+
+      //! Moves any completions held back by the OS into the completion queue.
+      void flush_cq_overflow();
+
+      /*! Returns a new submission queue entry, initialized to zero.
+
+      @return
+         Pointer to the entry, or nullptr if the submission queue is full.
+      */
+      ::io_uring_sqe * get_sqe();
+
+      /*! Sets up the io_uring.
+
+      @param sq_size
+         Size of the submission queue.
+      @param cq_size
+         Size of the completion queue.
+      @return
+         true if the io_uring was set up, or false if the OS doesn’t support it or the features it needs.
+      */
+      bool open(unsigned sq_size, unsigned cq_size);
+
+      /*! Returns the oldest completion queue entry.
+
+      @return
+         Pointer to the entry, or nullptr if the completion queue is empty.
+      */
+      ::io_uring_cqe * peek_cqe() const {
+         unsigned head = *cq_head;
+         if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            return nullptr;
+         }
+         return &cqes[head & *cq_mask];
+      }
+
+      /*! Returns the count of submission queue entries that can be obtained with get_sqe() before having to
+      call submit().
+
+      @return
+         Count of free submission queue entries.
+      */
+      unsigned sq_available() const {
+         return sq_size - (sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE));
+      }
+
+      /*! Hands to the OS all the submission queue entries obtained with get_sqe() since the last call.
+
+      @return
+         Count of entries submitted.
+      */
+      unsigned submit();
+
+      /*! Returns the count of submission queue entries obtained with get_sqe() that have not been submitted
+      yet.
+
+      @return
+         Count of pending entries.
+      */
+      unsigned unsubmitted_size() const {
+         return sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+      }
+
+   private:
+      //! File descriptor of the io_uring.
+      io::_LOFTY_PUBNS filedesc ring_fd;
+      //! Memory shared with the OS for the submission queue ring.
+      void * sq_ring;
+      //! Size of sq_ring, in bytes.
+      std::size_t sq_ring_byte_size;
+      //! Memory shared with the OS for the completion queue ring.
+      void * cq_ring;
+      //! Size of cq_ring, in bytes.
+      std::size_t cq_ring_byte_size;
+      //! Submission queue entries.
+      ::io_uring_sqe * sqes;
+      //! Index of the first entry in the submission queue not yet consumed by the OS.
+      unsigned * sq_head;
+      //! Index past the last entry in the submission queue made visible to the OS.
+      unsigned * sq_tail;
+      //! Flags set by the OS, such as IORING_SQ_CQ_OVERFLOW.
+      unsigned * sq_flags;
+      //! Count of entries in the submission queue.
+      unsigned sq_size;
+      //! Index past the last entry returned by get_sqe().
+      unsigned sqe_tail;
+      //! Index of the first entry in the completion queue not yet consumed.
+      unsigned * cq_head;
+      //! Index past the last entry in the completion queue.
+      unsigned * cq_tail;
+      //! Mask to turn a completion queue index into an index in cqes.
+      unsigned * cq_mask;
+      //! Completion queue entries.
+      ::io_uring_cqe * cqes;
+   };
+
+   //! Operation submitted to the uring by a coroutine that’s waiting for its completion.
+   struct uring_wait {
+      //! Previous pending operation.
+      uring_wait * prev;
+      //! Next pending operation.
+      uring_wait * next;
+      //! Operation to perform.
+      io::_LOFTY_PUBNS uring_op * op;
+      //! Coroutine waiting for the operation to complete.
+      impl * coro_pimpl;
+      //! Set to true once the completion of op has been received.
+      _std::_LOFTY_PUBNS atomic<bool> completed;
+      //! Timeout for op, if any; must stay valid until it’s submitted.
+      ::__kernel_timespec timeout;
+   };
+#endif
+
+#if LOFTY_HOST_API_POSIX
+   //! Function queued by a coroutine for a blocking I/O thread to run, while the coroutine waits for it.
+   struct blocking_io_job {
+      //! Next job in the queue.
+      blocking_io_job * next;
+      //! Function to run.
+      _std::_LOFTY_PUBNS function<void ()> const * fn;
+      //! Coroutine waiting for fn to return.
+      impl * coro_pimpl;
+      //! Value of errno when fn returned.
+      int err;
+      //! Set to true once fn has returned.
+      _std::_LOFTY_PUBNS atomic<bool> completed;
+   };
+
+   //! Coroutine waiting in run_blocking_io() for the queue of blocking I/O jobs to have room for its job.
+   struct blocking_io_space_waiter {
+      //! Previous waiter in the list.
+      blocking_io_space_waiter * prev;
+      //! Next waiter in the list.
+      blocking_io_space_waiter * next;
+      //! Suspended coroutine.
+      parked_coroutine parked;
+   };
+#endif
+
+#if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
+   /*! Hierarchical timer wheel tracking the timed waits that timer_fd is responsible for. Level 0 has one
+   slot per millisecond, and each slot in a higher level spans as much time as a whole lower level; timers are
+   linked into the slot matching their deadline in the lowest level that can hold it, and are moved to lower
+   levels as time advances, until they expire together with every other timer in their level 0 slot. This
+   makes adding and removing a timer O(1), regardless of how many timers there are. */
+   class timer_wheel : public noncopyable {
+   public:
+      //! Timed wait; the wheel only links it into its slots, so it must outlive its stay in the wheel.
+      struct timer {
+         //! Previous timer in the same slot.
+         timer * prev;
+         //! Next timer in the same slot, or in the list of timers returned by advance().
+         timer * next;
+         //! Time at which the timer expires.
+         time_point_t deadline;
+         //! Coroutine waiting for the timer.
+         impl * coro_pimpl;
+         //! Level of the wheel the timer is in.
+         unsigned level;
+      };
+
+      //! Returned by next_deadline() when there are no timers.
+      static time_point_t const never = ~time_point_t(0);
+
+   public:
+      //! Default constructor.
+      timer_wheel();
+
+      /*! Adds a timer to the wheel.
+
+      @param t
+         Timer to add. Its deadline must have been set already.
+      @param now
+         Current time.
+      */
+      void add(timer * t, time_point_t now);
+
+      /*! Removes every timer that expired by the specified time.
+
+      @param now
+         Current time.
+      @return
+         List of expired timers, linked through their next member, in order of expiration; nullptr if no
+         timers expired.
+      */
+      timer * advance(time_point_t now);
+
+      /*! Returns the earliest time at which advance() can have something to do: either the deadline of the
+      timer that will expire first, or an earlier time at which timers need to be moved to a lower level.
+
+      @return
+         Time at which advance() should be called next, or never if the wheel is empty.
+      */
+      time_point_t next_deadline() const;
+
+      /*! Removes an arbitrary timer from the wheel.
+
+      @return
+         Removed timer, or nullptr if the wheel is empty.
+      */
+      timer * pop();
+
+      /*! Removes a timer from the wheel.
+
+      @param t
+         Timer to remove. Must be in the wheel.
+      */
+      void remove(timer * t);
+
+      /*! Returns the count of timers in the wheel.
+
+      @return
+         Count of timers.
+      */
+      std::size_t size() const {
+         return timers_size;
+      }
+
+   private:
+      /*! Moves the timers in the slots of higher levels that start at current_tick to lower levels. Only
+      called when current_tick is a multiple of slots_per_level. */
+      void cascade();
+
+      /*! Links a timer into the slot for its deadline, in the lowest level that can hold it.
+
+      @param t
+         Timer to link.
+      */
+      void link(timer * t);
+
+      /*! Returns the index of the slot holding timers with the specified deadline in a level.
+
+      @param level
+         Level of the wheel.
+      @param deadline
+         Deadline of the timers.
+      @return
+         Index of the slot in the level.
+      */
+      static std::size_t slot_index(unsigned level, time_point_t deadline) {
+         return static_cast<std::size_t>(deadline >> (level * slot_bits)) & (slots_per_level - 1);
+      }
+
+   private:
+      //! Log2 of slots_per_level.
+      static unsigned const slot_bits = 6;
+      //! Count of slots in each level.
+      static std::size_t const slots_per_level = std::size_t(1) << slot_bits;
+      //! Count of levels; enough for the wheel to span any time_duration_t.
+      static unsigned const levels = 6;
+
+      //! First timer of each slot.
+      timer * slots[levels][slots_per_level];
+      //! Count of timers in each level.
+      std::size_t level_timers_size[levels];
+      //! Count of timers in the wheel.
+      std::size_t timers_size;
+      //! Earliest time that advance() has not processed yet.
+      time_point_t current_tick;
+   };
+#endif
+
 public:
-   //! Constructor.
-   scheduler();
+   /*! Constructor.
+
+   @param opts
+      Tuning parameters.
+   */
+   explicit scheduler(scheduler_options const & opts = scheduler_options());
 
    //! Destructor.
    ~scheduler();
 
+   /*! Adds a new coroutine to those managed by the scheduler, making it ready to run. The scheduler keeps a
+   strong reference to the coroutine until it terminates, so every other scheduler structure only needs to
+   hold a raw pointer to it.
+
+   @param coro_pimpl
+      Pointer to a coroutine (implementation) that’s ready to execute.
+   */
+   void add_new(_std::_LOFTY_PUBNS shared_ptr<impl> coro_pimpl);
+
    /*! Adds a coroutine to those ready to run. Ready coroutines take precedence over coroutines that were
    known to be blocked but might be ready on the next find_coroutine_to_activate() invocation.
 
+   Adding a coroutine that’s already ready has no effect; adding a coroutine that’s still running will make it
+   ready again as soon as it switches back to the scheduler.
+
    @param coro_pimpl
       Pointer to a coroutine (implementation) that’s ready to execute.
    */
-   void add_ready(_std::_LOFTY_PUBNS shared_ptr<impl> coro_pimpl);
+   void add_ready(impl * coro_pimpl);
+
+#if LOFTY_HOST_API_POSIX
+   /*! Returns a stack for a new coroutine, reusing the stack of a terminated coroutine if possible.
+
+   @return
+      Stack of stack_byte_size bytes.
+   */
+   stack acquire_stack();
+#endif
 
    /*! Allows other coroutines to run while a delay and/or an asynchronous I/O operation completes, as an
    alternative to blocking while waiting for its completion.
@@ -124,6 +645,69 @@ public:
    */
    void discard_event(event_id_t event_id);
 
+   /*! Makes every scheduler forget any state associated to a file descriptor that is about to be closed or
+   released, removing it from their internal epoll (Linux) if it was registered with it. Called by
+   lofty::io::filedesc::close() and lofty::io::filedesc::release(), so that a file descriptor reusing the same
+   number will be registered anew, even by a scheduler other than the one of the thread closing it.
+
+   @param fd
+      File descriptor being closed or released.
+   */
+   static void discard_fd(io::_LOFTY_PUBNS filedesc_t fd);
+
+#if LOFTY_HOST_API_POSIX
+   /*! Called by the fault signal handler to check whether a memory access fault was caused by the active
+   coroutine overflowing its stack. If it was, part of the stack’s guard region is made accessible, so that an
+   exception can be thrown on the stack. See stack::breach_guard().
+
+   @param addr
+      Address that could not be accessed.
+   @return
+      true if the fault should be turned into a lofty::memory::stack_overflow exception, or false otherwise.
+   */
+   static bool handle_stack_guard_fault(void const * addr);
+#endif
+
+   /*! Returns true if more than one thread has run the scheduler, in which case another coroutine may be
+   running in parallel with the active one.
+
+   @return
+      true if the scheduler may be running coroutines on multiple threads, or false otherwise.
+   */
+   bool multithreaded() const {
+      return workers_size.load() > 1;
+   }
+
+   /*! Suspends the active coroutine until unpark() is called on *parked, releasing *lock in the meantime.
+
+   The coroutine is also resumed if it’s interrupted; in that case no exception is thrown, so that the caller
+   can remove *parked from its wait list before calling this_coroutine::interruption_point().
+
+   @param parked
+      Wait to track. The caller must make it reachable by unpark() callers before calling this method.
+   @param lock
+      Lock guarding *parked. Released while the coroutine is suspended, and locked again before returning.
+   @return
+      true if unpark() was called on *parked, or false if the coroutine was interrupted.
+   */
+   bool park_active(
+      parked_coroutine * parked, _std::_LOFTY_PUBNS unique_lock<_std::_LOFTY_PUBNS mutex> * lock
+   );
+
+#if LOFTY_HOST_API_LINUX
+   /*! Implementation of lofty::this_coroutine::perform_uring_op() for the active coroutine.
+
+   @param op
+      Operation to perform.
+   @param timeout_millisecs
+      Time after which the operation will be cancelled, or 0 for no timeout.
+   @return
+      true if the operation was performed, or false if the scheduler has no io_uring or no coroutine is
+      active.
+   */
+   bool perform_uring_op(io::_LOFTY_PUBNS uring_op * op, unsigned timeout_millisecs);
+#endif
+
 #if LOFTY_HOST_API_WIN32
    /*! Returns the internal IOCP.
 
@@ -147,6 +731,27 @@ public:
    added with add_coroutine() returns. */
    void run();
 
+#if LOFTY_HOST_API_POSIX
+   /*! Implementation of lofty::this_coroutine::run_blocking_io() for the active coroutine.
+
+   @param fn
+      Function to run.
+   @return
+      true if fn was run by a blocking I/O thread, or false if the caller should run it instead because no
+      coroutine is active or blocking I/O threads are disabled.
+   */
+   bool run_blocking_io(_std::_LOFTY_PUBNS function<void ()> const & fn);
+#endif
+
+   /*! Returns the size of the stack of each coroutine.
+
+   @return
+      Size of a coroutine stack, in bytes.
+   */
+   std::size_t stack_size() const {
+      return stack_byte_size;
+   }
+
    /*! Coroutine-based implementation of lofty::event::trigger().
 
    @param event_id
@@ -154,6 +759,14 @@ public:
    */
    void trigger_event(event_id_t event_id);
 
+   /*! Ends a wait started by park_active(), making the coroutine ready. Must be called while holding the lock
+   that was passed to park_active().
+
+   @param parked
+      Wait to end.
+   */
+   void unpark(parked_coroutine * parked);
+
 private:
 #if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
    /*! Arms the internal timer responsible for all time-based waits.
@@ -165,8 +778,33 @@ private:
 
    /*! Arms the internal timer so that it fires as requested by the next sleeping coroutine. If there are no
    sleeping coroutines, the timer will be disabled. */
-   void arm_timer_for_next_sleep_end() const;
+   void arm_timer_for_next_sleep_end();
+
+   /*! Arms the internal timer so that it fires at the specified time, unless it’s already armed for that
+   time.
+
+   @param sleep_end
+      Time at which the timer should fire, or timer_wheel::never to disable the timer.
+   */
+   void arm_timer_for_sleep_end(time_point_t sleep_end);
+#endif
+
+#if LOFTY_HOST_API_POSIX
+   /*! Runs the jobs queued by run_blocking_io() as they come, until stop_blocking_io_threads is set. Assumes
+   that blocking_io_mutex is not locked by the caller. */
+   void blocking_io_thread();
+
+   /*! Invokes coro_sched->blocking_io_thread().
+
+   @param coro_sched
+      this.
+   @return
+      nullptr.
+   */
+   static void * blocking_io_thread_static(void * coro_sched);
+#endif
 
+#if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
    /*! Returns the current time.
 
    @return
@@ -195,7 +833,23 @@ private:
    @return
       Pointer to a coroutine (implementation) that’s ready to execute.
    */
-   _std::_LOFTY_PUBNS shared_ptr<impl> find_coroutine_to_activate();
+   impl * find_coroutine_to_activate();
+
+   /*! Claims a worker for the current thread, allocating a new one if necessary.
+
+   @return
+      Pointer to the claimed worker, or nullptr if max_workers threads are already running the scheduler.
+   */
+   worker * claim_worker();
+
+   /*! Queues a coroutine that’s been marked as ready. If called by a thread running the scheduler, the
+   coroutine is added to that thread’s own queue; otherwise it’s added to ready_coros_queue. Either way, an
+   idle thread will be woken up to run it, if there are any.
+
+   @param coro_pimpl
+      Pointer to the coroutine (implementation) to queue.
+   */
+   void enqueue_ready(impl * coro_pimpl);
 
    /*! Repeatedly finds and runs coroutines that are ready to execute.
 
@@ -216,39 +870,184 @@ private:
    */
    void interrupt_all(exception::common_type reason_x_type);
 
+   /*! Removes and returns the next coroutine to run on the current thread: first from the thread’s own queue,
+   then from ready_coros_queue, and finally from other threads’ queues.
+
+   @return
+      Pointer to the coroutine’s impl, or nullptr if no coroutines are ready.
+   */
+   impl * pop_ready();
+
+   /*! Removes and returns the first coroutine in ready_coros_queue.
+
+   @return
+      Pointer to the coroutine’s impl, or nullptr if ready_coros_queue is empty.
+   */
+   impl * pop_ready_global();
+
+   /*! Gives up a worker claimed with claim_worker(), moving any coroutines left in its queue to
+   ready_coros_queue.
+
+   @param w
+      Worker to release.
+   */
+   void release_worker(worker * w);
+
+#if LOFTY_HOST_API_LINUX
+   /*! Registers with engine_fd a file descriptor that’s not in registered_fds yet, and adds it to
+   registered_fds. Assumes that coros_add_remove_mutex is locked by the caller.
+
+   @param fd
+      File descriptor to register.
+   */
+   void register_fd(io::_LOFTY_PUBNS filedesc_t fd);
+
+   /*! Implementation of discard_fd() for a single scheduler.
+
+   @param fd
+      File descriptor being closed or released.
+   */
+   void forget_fd(io::_LOFTY_PUBNS filedesc_t fd);
+
+   /*! Removes a coroutine from the coroutines waiting for some I/O on a file descriptor. Assumes that
+   coros_add_remove_mutex is locked by the caller.
+
+   @param fdiok
+      File descriptor and I/O direction the coroutine is waiting for.
+   @param coro_pimpl
+      Pointer to the coroutine to remove.
+   */
+   void remove_blocked_by_fd(fd_io_key fdiok, impl * coro_pimpl);
+#endif
+
+#if LOFTY_HOST_API_LINUX
+   /*! Records the completion of every uring operation in the completion queue, moving the coroutines waiting
+   for them to ready_coros_queue. Assumes that uring_mutex is locked by the caller. */
+   void reap_uring_completions();
+#endif
+
 #if LOFTY_HOST_API_WIN32
    //! Initializes the infrastructure for generating non-IOCP events.
    void setup_non_iocp_events();
 #endif
 
+#if LOFTY_HOST_API_LINUX
+   /*! Submits the uring operations that coroutines have queued since the last submission, if any, then
+   reaps any completions. Unless forced to, this defers submission until a few coroutines have been activated,
+   so that operations queued by different coroutines in the same scheduling round are submitted together.
+
+   @param force
+      If true, pending operations will be submitted immediately.
+   */
+   void submit_uring_ops(bool force);
+#endif
+
    /*! Switches context from the coroutine context pointed to by last_active_coro_pimpl to the current
    thread’s own context.
 
    @param last_active_coro_pimpl
       Pointer to the coroutine (implementation) that is being inactivated.
+   @param interruptible
+      If true, any interruption pending when the coroutine is resumed will be delivered by throwing; if
+      false, the caller is responsible for calling interruption_point() after cleaning up.
    */
-   void switch_to_scheduler(impl * last_active_coro_pimpl);
+   void switch_to_scheduler(impl * last_active_coro_pimpl, bool interruptible = true);
+
+#if LOFTY_HOST_API_POSIX
+   /*! Keeps the stack of a terminated coroutine in stacks_pool for reuse, or releases it if it can’t be
+   reused or the pool is full.
+
+   @param s
+      Stack to recycle.
+   */
+   void recycle_stack(stack s);
+#endif
 
 #if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-   /*! Unblocks the first coroutine blocked by an event. Assumes that coros_add_remove_mutex is locked by the
-   caller.
+   /*! Moves to ready_coros_queue every coroutine whose timer wait has ended, then rearms the timer if
+   necessary. Assumes that coros_add_remove_mutex is locked by the caller. */
+   void unblock_by_expired_timers();
+#endif
 
+   /*! Moves to ready_coros_queue the coroutines waiting for I/O on the file descriptor in the specified key,
+   if any. Assumes that coros_add_remove_mutex is locked by the caller.
+
+   @param fdiok
+      File descriptor and I/O direction that became ready.
    @return
-      Pointer to the coroutine’s impl, or nullptr if no coroutines could be unblocked.
+      true if any coroutines were unblocked, or false if none was waiting for fdiok.
    */
-   _std::_LOFTY_PUBNS shared_ptr<impl> unblock_by_first_event();
+   bool unblock_by_fd(fd_io_key fdiok);
+
+#if LOFTY_HOST_API_LINUX
+   /*! Moves to ready_coros_queue the coroutines waiting for the I/O directions of a registered file
+   descriptor that became ready, and records the readiness of the directions nobody was waiting for. Assumes
+   that coros_add_remove_mutex is locked by the caller.
+
+   @param fd
+      File descriptor that became ready.
+   @param events
+      Events reported by epoll for fd.
+   */
+   void unblock_by_fd_events(io::_LOFTY_PUBNS filedesc_t fd, std::uint32_t events);
 #endif
 
+   /*! Wakes up one of the threads waiting for notifications from engine_fd, if any, so it can look for ready
+   coroutines, including those in other threads’ queues. */
+   void wake_idle_worker();
+
+   /*! Returns the worker claimed by the current thread for this scheduler, if any.
+
+   @return
+      Pointer to the current thread’s worker, or nullptr if the current thread is not running this scheduler
+      with its own queue.
+   */
+   worker * this_worker() const;
+
 private:
    //! File descriptor of the internal kqueue (BSD) / epoll (Linux) / IOCP (Win32).
    io::_LOFTY_PUBNS filedesc engine_fd;
+   //! Maximum count of notifications to collect from engine_fd with each wait.
+   unsigned max_events_per_wait;
+   //! Size of the stack of each coroutine, in bytes.
+   std::size_t stack_byte_size;
+#if LOFTY_HOST_API_POSIX
+   //! Maximum count of elements in stacks_pool.
+   std::size_t max_pooled_stacks;
+   //! If false, every new stack is fully committed by acquire_stack().
+   bool lazy_stack_commit;
+   //! Stacks of terminated coroutines, available for new ones. The last one is the most recently used.
+   collections::_LOFTY_PUBNS vector<stack> stacks_pool;
+   //! Governs access to stacks_pool.
+   _std::_LOFTY_PUBNS mutex stacks_pool_mutex;
+   //! Maximum count of elements in blocking_io_threads.
+   std::size_t max_blocking_io_threads;
+   //! Maximum count of jobs queued for blocking_io_threads; see run_blocking_io().
+   std::size_t max_blocking_io_jobs;
+   //! Threads running blocking_io_thread(); started as needed.
+   collections::_LOFTY_PUBNS vector< ::pthread_t> blocking_io_threads;
+   //! Count of elements in blocking_io_threads waiting for a job.
+   std::size_t idle_blocking_io_threads_size;
+   //! First of the jobs waiting for a blocking I/O thread.
+   blocking_io_job * first_blocking_io_job;
+   //! Last of the jobs waiting for a blocking I/O thread.
+   blocking_io_job * last_blocking_io_job;
+   //! Count of jobs waiting for a blocking I/O thread.
+   std::size_t blocking_io_jobs_size;
+   //! First of the coroutines waiting for blocking_io_jobs_size to drop below max_blocking_io_jobs.
+   blocking_io_space_waiter * first_blocking_io_space_waiter;
+   //! Last of the coroutines waiting for blocking_io_jobs_size to drop below max_blocking_io_jobs.
+   blocking_io_space_waiter * last_blocking_io_space_waiter;
+   //! If true, blocking_io_threads will return instead of waiting for more jobs.
+   bool stop_blocking_io_threads;
+   //! Governs access to all the blocking I/O members above.
+   _std::_LOFTY_PUBNS mutex blocking_io_mutex;
+   //! Signaled when a job is queued, or when stop_blocking_io_threads is set; used with blocking_io_mutex.
+   ::pthread_cond_t blocking_io_cond;
+#endif
 #if LOFTY_HOST_API_BSD
-   /*! Coroutines that are blocked on a timer wait. The keys are the same as the values, but this can’t be
-   changed into a set<shared_ptr<impl>> because we need it to hold a strong reference to the coroutine
-   implementation while allowing lookups without having a shared_ptr. */
-   collections::_LOFTY_PUBNS hash_map<
-      std::uintptr_t, _std::_LOFTY_PUBNS shared_ptr<impl>
-   > coros_blocked_by_timer_ke;
+   //! Coroutines that are blocked on a timer wait. The keys are the same as the values.
+   collections::_LOFTY_PUBNS hash_map<std::uintptr_t, impl *> coros_blocked_by_timer_ke;
 #elif LOFTY_HOST_API_WIN32
    //! Thread that translates events from event_semaphore_fd and timer_fd into IOCP completions.
    ::HANDLE non_iocp_events_thread_handle;
@@ -256,32 +1055,77 @@ private:
    _std::_LOFTY_PUBNS atomic<bool> stop_non_iocp_events_thread;
 #endif
 #if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-   //! List of events that need to be processed on the next time the event semaphore unblocks a thread.
-   collections::_LOFTY_PUBNS queue<event_id_t> ready_events_queue;
+   /*! Coroutines made ready by trigger_event(), to be moved to a run queue the next time the event semaphore
+   unblocks a thread. Linked via impl::next_queued, so triggering an event never allocates. */
+   impl_queue ready_events_queue;
    /*! Events that have been triggered with nobody waiting for them. We collect them here, so that if a waiter
    comes up, it can skip waiting at all. */
    // TODO: should be a collections::set<event_id_t> .
    collections::_LOFTY_PUBNS hash_map<event_id_t, bool> unwaited_events;
-   //! Map of timeouts, in milliseconds, and their associated coroutines.
-   collections::_LOFTY_PUBNS trie_ordered_multimap<
-      time_point_t, _std::_LOFTY_PUBNS shared_ptr<impl>
-   > coros_blocked_by_timer_fd;
+   //! Timeouts and their associated coroutines.
+   timer_wheel coros_blocked_by_timer_fd;
+   /*! Time at which timer_fd is armed to fire, or timer_wheel::never if it’s disarmed. Timers removed from
+   coros_blocked_by_timer_fd before expiring don’t change this, so timer_fd may fire with nothing to do. */
+   time_point_t timer_fd_sleep_end;
    //! Semaphore responsible for every event wait.
    io::_LOFTY_PUBNS filedesc event_semaphore_fd;
    //! Timer responsible for every timed wait.
    io::_LOFTY_PUBNS filedesc timer_fd;
 #endif
    //! Coroutines that are blocked on an event wait.
-   collections::_LOFTY_PUBNS hash_map<event_id_t, _std::_LOFTY_PUBNS shared_ptr<impl>> coros_blocked_by_event;
+   collections::_LOFTY_PUBNS hash_map<event_id_t, impl *> coros_blocked_by_event;
    //! Coroutines that are blocked on a fd wait.
-   collections::_LOFTY_PUBNS hash_map<
-      fd_io_key::pack_t, _std::_LOFTY_PUBNS shared_ptr<impl>
-   > coros_blocked_by_fd;
+   collections::_LOFTY_PUBNS hash_map<fd_io_key::pack_t, impl *> coros_blocked_by_fd;
+#if LOFTY_HOST_API_LINUX
+   /*! File descriptors registered with engine_fd. Each fd is registered in edge-triggered mode for both
+   reading and writing the first time a coroutine waits on it, and stays registered until it’s closed; edges
+   that arrive while no coroutine is waiting are recorded here, so that the next wait in the same direction
+   can return immediately. */
+   collections::_LOFTY_PUBNS hash_map<io::_LOFTY_PUBNS filedesc_t, fd_readiness> registered_fds;
+   //! Previous scheduler in the list of live schedulers.
+   scheduler * prev_live_sched;
+   //! Next scheduler in the list of live schedulers.
+   scheduler * next_live_sched;
+   //! First scheduler in the list of live schedulers, which discard_fd() walks.
+   static scheduler * first_live_sched;
+   //! Governs access to first_live_sched and to every scheduler’s prev_live_sched and next_live_sched.
+   static _std::_LOFTY_PUBNS mutex live_scheds_mutex;
+#endif
    /*! List of coroutines that are ready to run. Includes coroutines that have been scheduled, but have not
    been started yet. */
-   collections::_LOFTY_PUBNS queue<_std::_LOFTY_PUBNS shared_ptr<impl>> ready_coros_queue;
-   //! Governs access to ready_coros_queue, coros_blocked_by_fd and other “blocked by” maps/sets.
+   impl_queue ready_coros_queue;
+   //! Governs access to coros_blocked_by_fd and other “blocked by” maps/sets.
    _std::_LOFTY_PUBNS mutex coros_add_remove_mutex;
+   //! Governs access to ready_coros_queue. Lock after coros_add_remove_mutex if both are needed.
+   _std::_LOFTY_PUBNS mutex ready_coros_queue_mutex;
+   //! Count of elements in ready_coros_queue; allows checking it for emptiness without locking it.
+   _std::_LOFTY_PUBNS atomic<std::size_t> ready_coros_queue_size;
+   //! Workers of the threads that are or were running the scheduler; they can steal from each other.
+   _std::_LOFTY_PUBNS atomic<worker *> workers[max_workers];
+   //! Count of elements at the start of workers that may be non-nullptr.
+   _std::_LOFTY_PUBNS atomic<std::size_t> workers_size;
+   //! Count of threads waiting for notifications from engine_fd.
+   _std::_LOFTY_PUBNS atomic<std::size_t> idle_workers_size;
+   /*! true if a thread waiting for notifications from engine_fd has been woken up, but has not yet received
+   the wakeup notification. Avoids waking up more than one thread at a time. */
+   _std::_LOFTY_PUBNS atomic<bool> wakeup_pending;
+#if LOFTY_HOST_API_LINUX
+   //! Used to wake up one thread waiting for notifications from engine_fd.
+   io::_LOFTY_PUBNS filedesc wakeup_fd;
+   //! Completion-based I/O engine; only set up if scheduler_options::use_io_uring was true.
+   uring ring;
+   //! First of the operations submitted to ring that have not completed yet.
+   uring_wait * first_uring_wait;
+   //! Count of operations queued in ring, but not yet submitted; allows checking it without locking it.
+   _std::_LOFTY_PUBNS atomic<std::size_t> unsubmitted_uring_ops_size;
+   //! Count of coroutines activated since operations were queued in ring without being submitted.
+   _std::_LOFTY_PUBNS atomic<std::size_t> uring_deferred_activations;
+   //! Governs access to ring and first_uring_wait. Lock after coros_add_remove_mutex if both are needed.
+   _std::_LOFTY_PUBNS mutex uring_mutex;
+#endif
+   /*! Count of coroutines added to the scheduler that have not terminated yet, whether they’re ready,
+   blocked or running. */
+   _std::_LOFTY_PUBNS atomic<std::size_t> coros_size;
    //! Id of the last event created.
    event_id_t last_created_event_id;
    /*! Set to anything other than exception::common_type::none if a coroutine leaks an uncaught exception, or
@@ -290,10 +1134,12 @@ private:
    _std::_LOFTY_PUBNS atomic<exception::common_type::enum_type> interruption_reason_x_type;
 
    //! Pointer to the active (current) coroutine, or nullptr if none is active.
-   static thread_local_value<_std::_LOFTY_PUBNS shared_ptr<impl>> active_coro_pimpl;
+   static thread_local_value<impl *> active_coro_pimpl;
+   //! Pointer to the worker claimed by the current thread, or nullptr if it’s not running a scheduler.
+   static thread_local_value<worker *> active_worker;
 #if LOFTY_HOST_API_POSIX
    //! Pointer to the original context of every thread running a coroutine scheduler.
-   static thread_local_value< ::ucontext_t *> default_return_uctx;
+   static thread_local_value<context_t *> default_return_ctx;
 #elif LOFTY_HOST_API_WIN32
    //! Handle to the original fiber of every thread running a coroutine scheduler.
    static thread_local_value<void *> return_fiber;
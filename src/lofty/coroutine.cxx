@@ -12,6 +12,7 @@ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Les
 more details.
 ------------------------------------------------------------------------------------------------------------*/
 
+#include <lofty/bitmanip.hxx>
 #include <lofty/coroutine.hxx>
 #include <lofty/exception.hxx>
 #include <lofty/io.hxx>
@@ -32,8 +33,9 @@ more details.
 #include <lofty/try_finally.hxx>
 #include "coroutine-scheduler.hxx"
 #if LOFTY_HOST_API_POSIX
-   #include <errno.h> // EINTR errno
-   #include <signal.h> // SIGSTKSZ
+   #include <errno.h> // EINTR ENOMEM errno
+   #include <signal.h> // SIGSTKSZ pthread_sigmask() sigaltstack()
+   #include <sys/mman.h> // mmap() mprotect() munmap()
    #include <ucontext.h>
    #if LOFTY_HOST_API_BSD
       #include <sys/types.h>
@@ -42,8 +44,9 @@ more details.
    #elif LOFTY_HOST_API_LINUX
       #include <sys/epoll.h>
       #include <sys/eventfd.h>
+      #include <sys/syscall.h> // __NR_io_uring_*
       #include <sys/timerfd.h>
-      #include <unistd.h> // read() write()
+      #include <unistd.h> // read() syscall() write()
    #endif
 #endif
 #ifdef COMPLEMAKE_USING_VALGRIND
@@ -52,21 +55,169 @@ more details.
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#if LOFTY_COROUTINE_ASM_CONTEXT
+
+extern "C" {
+
+/*! Saves the registers that the ABI requires a function to preserve on the current stack, and the resulting
+stack pointer in *save_ctx; then switches to the stack pointer in *load_ctx, restores the registers saved on
+that stack, and returns to the code that last called this function with *load_ctx as its save_ctx argument.
+
+@param save_ctx
+   Pointer to where the current context will be saved.
+@param load_ctx
+   Pointer to the context to resume.
+*/
+void lofty_coroutine_switch_context(void ** save_ctx, void * const * load_ctx);
+
+/*! Initial return address of a new coroutine context, prepared by coroutine::impl::impl(). Calls the function
+whose address was left in a callee-saved register by the initial stack frame, passing it the argument left in
+another callee-saved register. The function must never return. */
+void lofty_coroutine_context_entry();
+
+} //extern "C"
+
+/* The stack frame saved by lofty_coroutine_switch_context() must match the initial frame prepared in
+coroutine::impl::impl(). */
+#if LOFTY_HOST_ARCH_ARM64
+   /* Frame (176 bytes, from the saved stack pointer up): x19-x28, x29 (fp), x30 (lr), d8-d15, 16 bytes of
+   padding to keep the stack aligned to 16 bytes. */
+   __asm__(
+      ".text\n"
+      ".p2align 4\n"
+      ".globl lofty_coroutine_switch_context\n"
+      ".hidden lofty_coroutine_switch_context\n"
+      ".type lofty_coroutine_switch_context, %function\n"
+   "lofty_coroutine_switch_context:\n"
+      "sub sp, sp, #176\n"
+      "stp x19, x20, [sp, #0]\n"
+      "stp x21, x22, [sp, #16]\n"
+      "stp x23, x24, [sp, #32]\n"
+      "stp x25, x26, [sp, #48]\n"
+      "stp x27, x28, [sp, #64]\n"
+      "stp x29, x30, [sp, #80]\n"
+      "stp d8, d9, [sp, #96]\n"
+      "stp d10, d11, [sp, #112]\n"
+      "stp d12, d13, [sp, #128]\n"
+      "stp d14, d15, [sp, #144]\n"
+      "mov x9, sp\n"
+      "str x9, [x0]\n"
+      "ldr x9, [x1]\n"
+      "mov sp, x9\n"
+      "ldp x19, x20, [sp, #0]\n"
+      "ldp x21, x22, [sp, #16]\n"
+      "ldp x23, x24, [sp, #32]\n"
+      "ldp x25, x26, [sp, #48]\n"
+      "ldp x27, x28, [sp, #64]\n"
+      "ldp x29, x30, [sp, #80]\n"
+      "ldp d8, d9, [sp, #96]\n"
+      "ldp d10, d11, [sp, #112]\n"
+      "ldp d12, d13, [sp, #128]\n"
+      "ldp d14, d15, [sp, #144]\n"
+      "add sp, sp, #176\n"
+      "ret\n"
+      ".size lofty_coroutine_switch_context, .-lofty_coroutine_switch_context\n"
+
+      ".p2align 4\n"
+      ".globl lofty_coroutine_context_entry\n"
+      ".hidden lofty_coroutine_context_entry\n"
+      ".type lofty_coroutine_context_entry, %function\n"
+   "lofty_coroutine_context_entry:\n"
+      ".cfi_startproc\n"
+      // Mark this as the outermost frame for debuggers and unwinders.
+      ".cfi_undefined x30\n"
+      "mov x0, x19\n"
+      "blr x20\n"
+      "brk #0\n"
+      ".cfi_endproc\n"
+      ".size lofty_coroutine_context_entry, .-lofty_coroutine_context_entry\n"
+   );
+#elif LOFTY_HOST_ARCH_X86_64
+   /* Frame (64 bytes, from the saved stack pointer up): MXCSR (4 bytes), x87 control word (2 bytes), 2 bytes
+   of padding, r15, r14, r13, r12, rbx, rbp, return address. */
+   __asm__(
+      ".text\n"
+      ".p2align 4\n"
+      ".globl lofty_coroutine_switch_context\n"
+      ".hidden lofty_coroutine_switch_context\n"
+      ".type lofty_coroutine_switch_context, @function\n"
+   "lofty_coroutine_switch_context:\n"
+      "pushq %rbp\n"
+      "pushq %rbx\n"
+      "pushq %r12\n"
+      "pushq %r13\n"
+      "pushq %r14\n"
+      "pushq %r15\n"
+      "subq $8, %rsp\n"
+      "stmxcsr (%rsp)\n"
+      "fnstcw 4(%rsp)\n"
+      "movq %rsp, (%rdi)\n"
+      "movq (%rsi), %rsp\n"
+      "ldmxcsr (%rsp)\n"
+      "fldcw 4(%rsp)\n"
+      "addq $8, %rsp\n"
+      "popq %r15\n"
+      "popq %r14\n"
+      "popq %r13\n"
+      "popq %r12\n"
+      "popq %rbx\n"
+      "popq %rbp\n"
+      "ret\n"
+      ".size lofty_coroutine_switch_context, .-lofty_coroutine_switch_context\n"
+
+      ".p2align 4\n"
+      ".globl lofty_coroutine_context_entry\n"
+      ".hidden lofty_coroutine_context_entry\n"
+      ".type lofty_coroutine_context_entry, @function\n"
+   "lofty_coroutine_context_entry:\n"
+      ".cfi_startproc\n"
+      // Mark this as the outermost frame for debuggers and unwinders.
+      ".cfi_undefined rip\n"
+      "movq %rbx, %rdi\n"
+      "callq *%r12\n"
+      "ud2\n"
+      ".cfi_endproc\n"
+      ".size lofty_coroutine_context_entry, .-lofty_coroutine_context_entry\n"
+   );
+#else
+   #error "TODO: HOST_ARCH"
+#endif
+
+#endif //if LOFTY_COROUTINE_ASM_CONTEXT
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty {
 
 class coroutine::impl : public noncopyable {
 private:
    friend class coroutine;
 
+   //! Scheduling states of a coroutine.
+   enum state_type {
+      //! Queued to run; will be resumed by the first thread to find it.
+      state_ready,
+      //! Running, or switching back to the scheduler.
+      state_running,
+      //! Running, and has been made ready again since it last resumed; see notify().
+      state_notified,
+      //! Switched back to the scheduler, waiting to be made ready.
+      state_blocked,
+      //! Returned from its main function.
+      state_terminated
+   };
+
 public:
    /*! Constructor
 
    @param main_fn
       Initial value for inner_main_fn.
+   @param coro_sched
+      Scheduler that will run the coroutine.
    */
-   impl(_std::function<void ()> main_fn) :
+   impl(_std::function<void ()> main_fn, scheduler * coro_sched) :
 #if LOFTY_HOST_API_POSIX
-      stack(SIGSTKSZ),
+      stack(coro_sched->acquire_stack()),
 #elif LOFTY_HOST_API_WIN32
       fiber_(nullptr),
       blocking_ovl(nullptr),
@@ -80,33 +231,60 @@ public:
       blocking_fd(io::filedesc_t_null),
       blocking_time_millisecs(0),
       pending_x_type(exception::common_type::none),
+      state(state_ready),
+      next_queued(nullptr),
+      next_blocked_by_fd(nullptr),
       join_event_ptr(nullptr),
       inner_main_fn(_std::move(main_fn)) {
-#if LOFTY_HOST_API_POSIX
-      // TODO: use ::mprotect() to setup a guard page for the stack.
+#if LOFTY_COROUTINE_ASM_CONTEXT
+      /* Prepare a frame for lofty_coroutine_switch_context() to “return” to lofty_coroutine_context_entry()
+      with the callee-saved registers set up to call outer_main(this). The frame is placed leaving 16 bytes at
+      the top of the stack, aligned so that outer_main() will be entered with the stack alignment required by
+      the ABI. */
+      auto stack_end = reinterpret_cast<std::uintptr_t>(stack.get()) + stack.size();
+      auto frame = reinterpret_cast<std::uintptr_t *>((stack_end & ~std::uintptr_t(0xf)) - 16);
+   #if LOFTY_HOST_ARCH_ARM64
+      frame -= 22;
+      memory::clear(frame, 22);
+      frame[0] /*x19*/ = reinterpret_cast<std::uintptr_t>(this);
+      frame[1] /*x20*/ = reinterpret_cast<std::uintptr_t>(&outer_main);
+      frame[11] /*x30*/ = reinterpret_cast<std::uintptr_t>(&lofty_coroutine_context_entry);
+   #elif LOFTY_HOST_ARCH_X86_64
+      frame -= 8;
+      memory::clear(frame, 8);
+      // Default values for MXCSR (all exceptions masked) and the x87 control word (same, extended precision).
+      frame[0] = (std::uintptr_t(0x037f) << 32) | 0x1f80;
+      frame[4] /*r12*/ = reinterpret_cast<std::uintptr_t>(&outer_main);
+      frame[5] /*rbx*/ = reinterpret_cast<std::uintptr_t>(this);
+      frame[7] /*return address*/ = reinterpret_cast<std::uintptr_t>(&lofty_coroutine_context_entry);
+   #endif
+      ctx = frame;
+#elif LOFTY_HOST_API_POSIX
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wdeprecated-declarations"
    #endif
-      if (::getcontext(&uctx) < 0) {
+      if (::getcontext(&ctx) < 0) {
          exception::throw_os_error();
       }
-      uctx.uc_stack.ss_sp = static_cast<char *>(stack.get());
-      uctx.uc_stack.ss_size = stack.size();
-      uctx.uc_link = nullptr;
-      ::makecontext(&uctx, reinterpret_cast<void (*)()>(&outer_main), 1, this);
+      ctx.uc_stack.ss_sp = static_cast<char *>(stack.get());
+      ctx.uc_stack.ss_size = stack.size();
+      ctx.uc_link = nullptr;
+      ::makecontext(&ctx, reinterpret_cast<void (*)()>(&outer_main), 1, this);
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic pop
    #endif
 #elif LOFTY_HOST_API_WIN32
-      fiber_ = ::CreateFiber(0, &outer_main, this);
+      fiber_ = ::CreateFiber(coro_sched->stack_size(), &outer_main, this);
 #endif
    }
 
    //! Destructor.
    ~impl() {
 #ifdef COMPLEMAKE_USING_VALGRIND
-      VALGRIND_STACK_DEREGISTER(valgrind_stack_id);
+      if (stack.get()) {
+         VALGRIND_STACK_DEREGISTER(valgrind_stack_id);
+      }
 #endif
 #if LOFTY_HOST_API_WIN32
       if (fiber_) {
@@ -128,12 +306,10 @@ public:
 
    /*! Injects the requested type of exception in the coroutine.
 
-   @param this_pimpl
-      Shared pointer to *this.
    @param x_type
       Type of exception to inject.
    */
-   void inject_exception(_std::shared_ptr<impl> const & this_pimpl, exception::common_type x_type) {
+   void inject_exception(exception::common_type x_type) {
       /* Avoid interrupting the coroutine if there’s already a pending interruption (expected_x_type != none).
       This is not meant to prevent multiple concurrent interruptions (@see interruption-points); this is
       analogous to lofty::thread::interrupt() not trying to prevent multiple concurrent interruptions. In this
@@ -143,9 +319,8 @@ public:
       auto expected_x_type = exception::common_type::none;
       if (pending_x_type.compare_exchange_strong(expected_x_type, x_type.base())) {
          /* Mark this coroutine as ready, so it will be scheduler before the scheduler tries to wait for it to
-         be unblocked. */
-         // TODO: sanity check to avoid scheduling a coroutine twice!
-         this_thread::coroutine_scheduler()->add_ready(this_pimpl);
+         be unblocked. add_ready() will not schedule it a second time if it’s already ready. */
+         this_thread::coroutine_scheduler()->add_ready(this);
       }
    }
 
@@ -173,6 +348,71 @@ public:
       reason, this means the coroutine has already been joined, so it’s okay to just not block. */
    }
 
+   /*! Discards any notification received while the coroutine was running (see notify()). Used after the
+   coroutine resumes from a wait that could’ve been ended by more than one source, to ignore the late ones. */
+   void discard_notification() {
+      auto expected_state = state_notified;
+      state.compare_exchange_strong(expected_state, state_running);
+   }
+
+   /*! Makes the coroutine ready, if it’s blocked; if it’s running instead, it will become ready again as soon
+   as it switches back to the scheduler (see park()).
+
+   @return
+      true if the caller must queue the coroutine to be resumed, or false otherwise.
+   */
+   bool notify() {
+      for (;;) {
+         auto curr_state = state.load();
+         if (curr_state == state_blocked) {
+            if (state.compare_exchange_strong(curr_state, state_ready)) {
+               return true;
+            }
+         } else if (curr_state == state_running) {
+            if (state.compare_exchange_strong(curr_state, state_notified)) {
+               return false;
+            }
+         } else {
+            // Already ready, notified or terminated.
+            return false;
+         }
+      }
+   }
+
+   /*! Called by the scheduler after the coroutine switched back to it, to mark it as blocked. Doing this
+   only after the switch ensures that no thread will try to resume the coroutine while its context is still
+   being saved.
+
+   @return
+      true if the coroutine was notified while running, and must be queued again to be resumed, or false if
+      it’s now blocked or terminated.
+   */
+   bool park() {
+      auto expected_state = state_running;
+      if (state.compare_exchange_strong(expected_state, state_blocked)) {
+         return false;
+      } else if (expected_state == state_notified) {
+         state.store(state_ready);
+         return true;
+      } else {
+         return false;
+      }
+   }
+
+   //! Called by the scheduler right before resuming the coroutine.
+   void set_running() {
+      state.store(state_running);
+   }
+
+   /*! Returns true if the coroutine has returned from its main function.
+
+   @return
+      true if the coroutine has terminated, or false otherwise.
+   */
+   bool terminated() const {
+      return state.load() == state_terminated;
+   }
+
    /*! Returns a pointer to the coroutine’s coroutine_local_storage object.
 
    @return
@@ -188,8 +428,33 @@ public:
    @return
       Pointer to the context.
    */
-   ::ucontext_t * ucontext_ptr() {
-      return &uctx;
+   scheduler::context_t * context_ptr() {
+      return &ctx;
+   }
+
+   /*! See scheduler::stack::breach_guard().
+
+   @param addr
+      Address that could not be accessed.
+   @return
+      true if addr is in the guard region of the coroutine’s stack, and the stack overflow can be turned into
+      an exception.
+   */
+   bool breach_stack_guard(void const * addr) {
+      return stack.breach_guard(addr);
+   }
+
+   /*! Gives up the coroutine’s stack. Only valid after the coroutine has terminated and switched back to the
+   scheduler.
+
+   @return
+      The coroutine’s stack.
+   */
+   scheduler::stack detach_stack() {
+   #ifdef COMPLEMAKE_USING_VALGRIND
+      VALGRIND_STACK_DEREGISTER(valgrind_stack_id);
+   #endif
+      return _std::move(stack);
    }
 #endif
 
@@ -208,9 +473,9 @@ private:
 private:
 #if LOFTY_HOST_API_POSIX
    //! Context for the coroutine.
-   ::ucontext_t uctx;
-   //! Pointer to the memory chunk used as stack.
-   memory::pages_ptr stack;
+   scheduler::context_t ctx;
+   //! Memory used as stack.
+   scheduler::stack stack;
 #elif LOFTY_HOST_API_WIN32
    //! Fiber for the coroutine.
    void * fiber_;
@@ -232,6 +497,18 @@ private:
    /*! Every time the coroutine is scheduled or returns from an interruption point, this is checked for
    pending exceptions to be injected. */
    _std::atomic<exception::common_type::enum_type> pending_x_type;
+   /*! Scheduling state. Ensures that the coroutine is queued at most once, no matter how many threads try to
+   unblock it at the same time. */
+   _std::atomic<state_type> state;
+   /*! Strong reference to *this held on behalf of the scheduler, from scheduler::add_new() until the
+   coroutine terminates. This allows every scheduler structure to only hold raw pointers to the coroutine, so
+   blocking and unblocking it never touches a reference count. */
+   _std::shared_ptr<impl> scheduled_self_pimpl;
+   //! Next coroutine in the scheduler::impl_queue the coroutine is in, if any.
+   impl * next_queued;
+   /*! Next coroutine waiting for the same I/O on blocking_fd, if any. Only Linux lets more than one coroutine
+   wait for the same I/O on a fd. */
+   impl * next_blocked_by_fd;
    /*! Event triggered after inner_main_fn returns; only non-nullptr while join() is called, or == ~0 after
    the thread passes the point at which it could’ve triggered it (to avoid pointlessly waiting for it). Note
    that this uses the scheduler of the thread calling join(), not the scheduler running inner_main_fn. */
@@ -250,9 +527,10 @@ namespace lofty {
 
 coroutine::coroutine() {
 }
-/*explicit*/ coroutine::coroutine(_std::function<void ()> main_fn) :
-   pimpl(_std::make_shared<impl>(_std::move(main_fn))) {
-   this_thread::attach_coroutine_scheduler()->add_ready(pimpl);
+/*explicit*/ coroutine::coroutine(_std::function<void ()> main_fn) {
+   auto & coro_sched = this_thread::attach_coroutine_scheduler();
+   pimpl = _std::make_shared<impl>(_std::move(main_fn), coro_sched.get());
+   coro_sched->add_new(pimpl);
 }
 
 coroutine::~coroutine() {
@@ -263,7 +541,7 @@ coroutine::id_type coroutine::id() const {
 }
 
 void coroutine::interrupt() {
-   pimpl->inject_exception(pimpl, exception::common_type::execution_interruption);
+   pimpl->inject_exception(exception::common_type::execution_interruption);
 }
 
 void coroutine::join() {
@@ -282,6 +560,22 @@ void coroutine::join() {
 
 namespace lofty {
 
+coroutine::scheduler_options::scheduler_options() :
+   blocking_io_queue_depth(64),
+   blocking_io_threads(4),
+   max_events_per_wait(64),
+   stack_size(64 * 1024),
+   max_pooled_stacks(256),
+   lazy_stack_commit(true),
+   use_io_uring(false) {
+}
+
+} //namespace lofty
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty {
+
 void to_text_ostream<coroutine>::set_format(text::str const & format) {
    auto itr(format.cbegin());
 
@@ -305,14 +599,557 @@ void to_text_ostream<coroutine>::write(coroutine const & src, io::text::ostream
 
 namespace lofty {
 
-thread_local_value<_std::shared_ptr<coroutine::impl>> coroutine::scheduler::active_coro_pimpl;
+/*! Each thread running a scheduler claims one of these to hold the coroutines it makes ready. The owner
+thread adds and removes coroutines in FIFO order, and idle threads can steal half of them at once, so they
+never need to lock anything. */
+class coroutine::scheduler::worker : public noncopyable {
+public:
+   /*! Constructor.
+
+   @param owner_
+      Scheduler that the worker belongs to.
+   @param index_
+      Index of the worker in owner_->workers.
+   */
+   worker(scheduler * owner_, std::size_t index_) :
+      owner(owner_),
+      index(index_),
+      claimed(true),
+      head(0),
+      tail(0) {
+      LOFTY_FOR_EACH(auto & slot, ring) {
+         slot.store(nullptr);
+      }
+   }
+
+   /*! Claims the worker for the current thread.
+
+   @return
+      true if the worker was claimed, or false if it’s already claimed by another thread.
+   */
+   bool claim() {
+      bool expected = false;
+      return claimed.compare_exchange_strong(expected, true);
+   }
+
+   /*! Removes the first coroutine from the queue. Only the owner thread may call this.
+
+   @return
+      Removed coroutine, or nullptr if the queue is empty.
+   */
+   impl * pop() {
+      for (;;) {
+         std::size_t curr_head = head.load(), curr_tail = tail.load();
+         if (curr_head == curr_tail) {
+            return nullptr;
+         }
+         auto coro_pimpl = ring[curr_head % ring_size].load();
+         // Compete with thieves for the coroutine.
+         if (head.compare_exchange_strong(curr_head, curr_head + 1)) {
+            return coro_pimpl;
+         }
+      }
+   }
+
+   /*! Adds a coroutine at the end of the queue. Only the owner thread may call this.
+
+   @param coro_pimpl
+      Coroutine to add.
+   @return
+      true if the coroutine was added, or false if the queue is full.
+   */
+   bool push(impl * coro_pimpl) {
+      std::size_t curr_tail = tail.load();
+      if (curr_tail - head.load() >= ring_size) {
+         return false;
+      }
+      ring[curr_tail % ring_size].store(coro_pimpl);
+      tail.store(curr_tail + 1);
+      return true;
+   }
+
+   //! Gives up the worker, so that another thread can claim it.
+   void release() {
+      claimed.store(false);
+   }
+
+   /*! Moves the first half of this worker’s queue to another worker’s queue, except for the first coroutine,
+   which is returned instead. Only the thread owning dst may call this, and only if dst’s queue is empty.
+
+   @param dst
+      Worker that will receive the stolen coroutines.
+   @return
+      First stolen coroutine, or nullptr if there was nothing to steal.
+   */
+   impl * steal_into(worker * dst) {
+      impl * stolen[ring_size / 2];
+      for (;;) {
+         std::size_t curr_head = head.load(), curr_tail = tail.load();
+         std::size_t stolen_size = curr_tail - curr_head;
+         if (stolen_size == 0) {
+            return nullptr;
+         } else if (stolen_size > ring_size) {
+            // The owner moved head and tail between the two loads above; try again.
+            continue;
+         }
+         stolen_size -= stolen_size / 2;
+         /* A slot can only be overwritten after head moves past it, in which case the compare-and-swap below
+         will fail and the values read here will be discarded. */
+         for (std::size_t i = 0; i < stolen_size; ++i) {
+            stolen[i] = ring[(curr_head + i) % ring_size].load();
+         }
+         if (head.compare_exchange_strong(curr_head, curr_head + stolen_size)) {
+            for (std::size_t i = 1; i < stolen_size; ++i) {
+               dst->push(stolen[i]);
+            }
+            return stolen[0];
+         }
+      }
+   }
+
+public:
+   //! Scheduler that the worker belongs to.
+   scheduler * const owner;
+   //! Index of the worker in owner->workers.
+   std::size_t const index;
+
+private:
+   //! Capacity of the queue. Any more coroutines will go to scheduler::ready_coros_queue instead.
+   static std::size_t const ring_size = 256;
+
+   //! true while a thread is running the scheduler with this worker.
+   _std::atomic<bool> claimed;
+   //! Count of coroutines ever removed from ring; the first queued coroutine is at index head % ring_size.
+   _std::atomic<std::size_t> head;
+   //! Count of coroutines ever added to ring.
+   _std::atomic<std::size_t> tail;
+   //! Circular queue of coroutines.
+   _std::atomic<impl *> ring[ring_size];
+};
+
+coroutine::impl * coroutine::scheduler::impl_queue::pop_front() {
+   impl * coro_pimpl = first;
+   if (coro_pimpl) {
+      first = coro_pimpl->next_queued;
+      if (!first) {
+         last = nullptr;
+      }
+      coro_pimpl->next_queued = nullptr;
+   }
+   return coro_pimpl;
+}
+
+void coroutine::scheduler::impl_queue::push_back(impl * coro_pimpl) {
+   if (last) {
+      last->next_queued = coro_pimpl;
+   } else {
+      first = coro_pimpl;
+   }
+   last = coro_pimpl;
+}
+
 #if LOFTY_HOST_API_POSIX
-thread_local_value< ::ucontext_t *> coroutine::scheduler::default_return_uctx /*= nullptr*/;
+coroutine::scheduler::stack::stack(std::size_t byte_size_, bool lazy_commit) :
+   guard_breached(false) {
+   std::size_t page_byte_size = memory::page_size();
+   byte_size = bitmanip::ceiling_to_pow2_multiple(byte_size_, page_byte_size);
+   guard_byte_size = bitmanip::ceiling_to_pow2_multiple(guard_spare_byte_size, page_byte_size);
+   guard_byte_size += page_byte_size;
+   std::size_t total_byte_size = guard_byte_size + byte_size;
+   int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+   #ifdef MAP_STACK
+   flags |= MAP_STACK;
+   #endif
+   #ifdef MAP_NORESERVE
+   if (lazy_commit) {
+      // Don’t reserve swap space for pages that may never be touched.
+      flags |= MAP_NORESERVE;
+   }
+   #endif
+   void * mem = ::mmap(nullptr, total_byte_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+   if (mem == MAP_FAILED || ::mprotect(mem, guard_byte_size, PROT_NONE) < 0) {
+      auto err = errno;
+      if (mem != MAP_FAILED) {
+         ::munmap(mem, total_byte_size);
+      }
+      if (err == ENOMEM) {
+         LOFTY_THROW(memory::bad_alloc, (total_byte_size, err));
+      }
+      exception::throw_os_error(err);
+   }
+   ptr = static_cast<std::int8_t *>(mem) + guard_byte_size;
+   if (!lazy_commit) {
+      // Touch every page, so that the OS has to commit them right away.
+      auto end = static_cast<std::int8_t volatile *>(ptr) + byte_size;
+      for (auto p = static_cast<std::int8_t volatile *>(ptr); p < end; p += page_byte_size) {
+         *p = 0;
+      }
+   }
+}
+coroutine::scheduler::stack::stack(stack && src) :
+   ptr(src.ptr),
+   byte_size(src.byte_size),
+   guard_byte_size(src.guard_byte_size),
+   guard_breached(src.guard_breached) {
+   src.ptr = nullptr;
+   src.byte_size = 0;
+   src.guard_byte_size = 0;
+   src.guard_breached = false;
+}
+
+coroutine::scheduler::stack::~stack() {
+   if (ptr) {
+      ::munmap(static_cast<std::int8_t *>(ptr) - guard_byte_size, guard_byte_size + byte_size);
+   }
+}
+
+coroutine::scheduler::stack & coroutine::scheduler::stack::operator=(stack && src) {
+   stack old(_std::move(*this));
+   ptr = src.ptr;
+   src.ptr = nullptr;
+   byte_size = src.byte_size;
+   src.byte_size = 0;
+   guard_byte_size = src.guard_byte_size;
+   src.guard_byte_size = 0;
+   guard_breached = src.guard_breached;
+   src.guard_breached = false;
+   return *this;
+}
+
+bool coroutine::scheduler::stack::breach_guard(void const * addr) {
+   auto addr_int = reinterpret_cast<std::uintptr_t>(addr);
+   auto guard_begin = reinterpret_cast<std::uintptr_t>(ptr) - guard_byte_size;
+   if (guard_breached || addr_int < guard_begin || addr_int >= reinterpret_cast<std::uintptr_t>(ptr)) {
+      return false;
+   }
+   /* Keep the lowest page inaccessible, so that overflowing the stack again while throwing the exception will
+   be fatal, instead of corrupting whatever lies below. */
+   std::size_t page_byte_size = memory::page_size();
+   if (::mprotect(
+      reinterpret_cast<void *>(guard_begin + page_byte_size), guard_byte_size - page_byte_size,
+      PROT_READ | PROT_WRITE
+   ) < 0) {
+      return false;
+   }
+   guard_breached = true;
+   return true;
+}
+#endif
+
+#if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
+coroutine::scheduler::timer_wheel::timer_wheel() :
+   timers_size(0),
+   current_tick(0) {
+   LOFTY_FOR_EACH(auto & level_slots, slots) {
+      LOFTY_FOR_EACH(auto & slot, level_slots) {
+         slot = nullptr;
+      }
+   }
+   LOFTY_FOR_EACH(auto & level_timers_size_, level_timers_size) {
+      level_timers_size_ = 0;
+   }
+}
+
+void coroutine::scheduler::timer_wheel::add(timer * t, time_point_t now) {
+   if (timers_size == 0 && current_tick < now) {
+      // Nothing is waiting for the time in between, so skip it instead of having advance() step through it.
+      current_tick = now;
+   }
+   if (t->deadline < current_tick) {
+      t->deadline = current_tick;
+   }
+   link(t);
+}
+
+coroutine::scheduler::timer_wheel::timer * coroutine::scheduler::timer_wheel::advance(time_point_t now) {
+   timer * expired_first = nullptr, ** expired_last_next = &expired_first;
+   while (current_tick <= now) {
+      if (timers_size == 0) {
+         current_tick = now + 1;
+         break;
+      }
+      if (level_timers_size[0] == 0) {
+         /* Nothing can expire before the timers in the lowest non-empty level are cascaded, so jump straight
+         to the start of its next slot. */
+         unsigned level = 1;
+         while (level_timers_size[level] == 0) {
+            ++level;
+         }
+         unsigned shift = level * slot_bits;
+         time_point_t next_slot_tick = ((current_tick + (time_point_t(1) << shift) - 1) >> shift) << shift;
+         if (next_slot_tick > now) {
+            current_tick = now + 1;
+            break;
+         }
+         current_tick = next_slot_tick;
+      }
+      if (slot_index(0, current_tick) == 0) {
+         cascade();
+      }
+      // Every timer in this slot expires at current_tick; move them all at once to the expired list.
+      timer *& slot = slots[0][slot_index(0, current_tick)];
+      if (slot) {
+         *expired_last_next = slot;
+         timer * t = slot;
+         for (;;) {
+            --level_timers_size[0];
+            --timers_size;
+            if (!t->next) {
+               break;
+            }
+            t = t->next;
+         }
+         expired_last_next = &t->next;
+         slot = nullptr;
+      }
+      ++current_tick;
+   }
+   return expired_first;
+}
+
+void coroutine::scheduler::timer_wheel::cascade() {
+   for (unsigned level = 1; level < levels; ++level) {
+      std::size_t index = slot_index(level, current_tick);
+      timer * t = slots[level][index];
+      slots[level][index] = nullptr;
+      while (t) {
+         timer * next = t->next;
+         --level_timers_size[level];
+         --timers_size;
+         link(t);
+         t = next;
+      }
+      if (index != 0) {
+         // The next level’s current slot only needs cascading when this level wraps around.
+         break;
+      }
+   }
+}
+
+void coroutine::scheduler::timer_wheel::link(timer * t) {
+   time_point_t delta = t->deadline - current_tick;
+   unsigned level = 0;
+   while (level < levels - 1 && (delta >> ((level + 1) * slot_bits)) != 0) {
+      ++level;
+   }
+   timer *& slot = slots[level][slot_index(level, t->deadline)];
+   t->level = level;
+   t->prev = nullptr;
+   t->next = slot;
+   if (slot) {
+      slot->prev = t;
+   }
+   slot = t;
+   ++level_timers_size[level];
+   ++timers_size;
+}
+
+coroutine::scheduler::time_point_t coroutine::scheduler::timer_wheel::next_deadline() const {
+   time_point_t deadline = never;
+   for (unsigned level = 0; level < levels; ++level) {
+      if (level_timers_size[level] == 0) {
+         continue;
+      }
+      /* The timers in this level are in the slots that advance() has not reached yet, starting from the
+      first one that starts at or after current_tick, up to a full revolution later. */
+      unsigned shift = level * slot_bits;
+      time_point_t first_slot = (current_tick + (time_point_t(1) << shift) - 1) >> shift;
+      for (std::size_t i = 0; i < slots_per_level; ++i) {
+         time_point_t slot_tick = (first_slot + i) << shift;
+         if (slot_tick >= deadline) {
+            break;
+         }
+         if (slots[level][slot_index(level, slot_tick)]) {
+            deadline = slot_tick;
+            break;
+         }
+      }
+   }
+   return deadline;
+}
+
+coroutine::scheduler::timer_wheel::timer * coroutine::scheduler::timer_wheel::pop() {
+   if (timers_size) {
+      for (unsigned level = 0; level < levels; ++level) {
+         if (level_timers_size[level] == 0) {
+            continue;
+         }
+         LOFTY_FOR_EACH(auto t, slots[level]) {
+            if (t) {
+               remove(t);
+               return t;
+            }
+         }
+      }
+   }
+   return nullptr;
+}
+
+void coroutine::scheduler::timer_wheel::remove(timer * t) {
+   if (t->prev) {
+      t->prev->next = t->next;
+   } else {
+      slots[t->level][slot_index(t->level, t->deadline)] = t->next;
+   }
+   if (t->next) {
+      t->next->prev = t->prev;
+   }
+   --level_timers_size[t->level];
+   --timers_size;
+}
+#endif
+
+#if LOFTY_HOST_API_LINUX
+coroutine::scheduler::uring::uring() :
+   sq_ring(nullptr),
+   sq_ring_byte_size(0),
+   cq_ring(nullptr),
+   cq_ring_byte_size(0),
+   sqes(nullptr),
+   sq_size(0),
+   sqe_tail(0) {
+}
+
+coroutine::scheduler::uring::~uring() {
+   if (sqes) {
+      ::munmap(sqes, sq_size * sizeof(::io_uring_sqe));
+   }
+   if (cq_ring) {
+      ::munmap(cq_ring, cq_ring_byte_size);
+   }
+   if (sq_ring) {
+      ::munmap(sq_ring, sq_ring_byte_size);
+   }
+}
+
+void coroutine::scheduler::uring::flush_cq_overflow() {
+   while (::syscall(__NR_io_uring_enter, ring_fd.get(), 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+      int err = errno;
+      if (err != EINTR) {
+         exception::throw_os_error(err);
+      }
+   }
+}
+
+::io_uring_sqe * coroutine::scheduler::uring::get_sqe() {
+   if (sq_available() == 0) {
+      return nullptr;
+   }
+   auto sqe = &sqes[sqe_tail & (sq_size - 1)];
+   ++sqe_tail;
+   memory::clear(sqe);
+   return sqe;
+}
+
+bool coroutine::scheduler::uring::open(unsigned sq_size_, unsigned cq_size) {
+   ::io_uring_params params;
+   memory::clear(&params);
+   params.flags = IORING_SETUP_CQSIZE;
+   params.cq_entries = cq_size;
+   ring_fd = io::filedesc(static_cast<io::filedesc_t>(::syscall(__NR_io_uring_setup, sq_size_, &params)));
+   if (!ring_fd) {
+      int err = errno;
+      switch (err) {
+         case EINVAL: // Unsupported flags or sizes.
+         case ENOSYS: // No io_uring in the kernel.
+         case EPERM: // io_uring disabled by the administrator or a sandbox.
+            return false;
+         default:
+            exception::throw_os_error(err);
+      }
+   }
+   // Completions must not be dropped, and reads/writes must be able to use the current file offset.
+   if ((params.features & (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS)) !=
+      (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS)
+   ) {
+      ring_fd.close();
+      return false;
+   }
+   /* Map the two rings separately, which also works on kernels that don’t support mapping them with a
+   single ::mmap() (IORING_FEAT_SINGLE_MMAP). */
+   sq_ring_byte_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   sq_ring = ::mmap(
+      nullptr, sq_ring_byte_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd.get(),
+      IORING_OFF_SQ_RING
+   );
+   if (sq_ring == MAP_FAILED) {
+      sq_ring = nullptr;
+      exception::throw_os_error();
+   }
+   cq_ring_byte_size = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+   cq_ring = ::mmap(
+      nullptr, cq_ring_byte_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd.get(),
+      IORING_OFF_CQ_RING
+   );
+   if (cq_ring == MAP_FAILED) {
+      cq_ring = nullptr;
+      exception::throw_os_error();
+   }
+   void * sqes_ptr = ::mmap(
+      nullptr, params.sq_entries * sizeof(::io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      ring_fd.get(), IORING_OFF_SQES
+   );
+   if (sqes_ptr == MAP_FAILED) {
+      exception::throw_os_error();
+   }
+   sqes = static_cast< ::io_uring_sqe *>(sqes_ptr);
+   sq_size = params.sq_entries;
+   auto sq_bytes = static_cast<std::int8_t *>(sq_ring);
+   sq_head = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.head);
+   sq_tail = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.tail);
+   sq_flags = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.flags);
+   sqe_tail = *sq_tail;
+   /* Entries are always submitted in the order they’re obtained, so the indirection array can be set up once
+   to map each slot to the entry with the same index. */
+   auto sq_array = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.array);
+   for (unsigned i = 0; i < sq_size; ++i) {
+      sq_array[i] = i;
+   }
+   auto cq_bytes = static_cast<std::int8_t *>(cq_ring);
+   cq_head = reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.head);
+   cq_tail = reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.tail);
+   cq_mask = reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.ring_mask);
+   cqes = reinterpret_cast< ::io_uring_cqe *>(cq_bytes + params.cq_off.cqes);
+   return true;
+}
+
+unsigned coroutine::scheduler::uring::submit() {
+   // Make the new entries visible to the OS; it will only read them during ::io_uring_enter().
+   __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+   unsigned to_submit = unsubmitted_size();
+   if (to_submit == 0) {
+      return 0;
+   }
+   long submitted;
+   while ((submitted = ::syscall(__NR_io_uring_enter, ring_fd.get(), to_submit, 0, 0, nullptr, 0)) < 0) {
+      int err = errno;
+      switch (err) {
+         case EINTR:
+            break;
+         case EAGAIN: // Out of resources; the entries will be submitted again later.
+         case EBUSY: // Too many completions held back; the entries will be submitted again later.
+            return 0;
+         default:
+            exception::throw_os_error(err);
+      }
+   }
+   return static_cast<unsigned>(submitted);
+}
+#endif
+
+thread_local_value<coroutine::impl *> coroutine::scheduler::active_coro_pimpl /*= nullptr*/;
+thread_local_value<coroutine::scheduler::worker *> coroutine::scheduler::active_worker /*= nullptr*/;
+#if LOFTY_HOST_API_POSIX
+thread_local_value<coroutine::scheduler::context_t *> coroutine::scheduler::default_return_ctx /*= nullptr*/;
 #elif LOFTY_HOST_API_WIN32
 thread_local_value<void *> coroutine::scheduler::return_fiber /*= nullptr*/;
 #endif
+#if LOFTY_HOST_API_LINUX
+coroutine::scheduler * coroutine::scheduler::first_live_sched /*= nullptr*/;
+_std::mutex coroutine::scheduler::live_scheds_mutex;
+#endif
 
-coroutine::scheduler::scheduler() :
+/*explicit*/ coroutine::scheduler::scheduler(scheduler_options const & opts /*= scheduler_options()*/) :
 #if LOFTY_HOST_API_BSD
    // CLOEXEC behavior is implicit.
    engine_fd(::kqueue()),
@@ -323,15 +1160,125 @@ coroutine::scheduler::scheduler() :
    non_iocp_events_thread_handle(nullptr),
    stop_non_iocp_events_thread(false),
 #endif
+#if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
+   timer_fd_sleep_end(timer_wheel::never),
+#endif
+   ready_coros_queue_size(0),
+   workers_size(0),
+   idle_workers_size(0),
+   wakeup_pending(false),
+#if LOFTY_HOST_API_LINUX
+   first_uring_wait(nullptr),
+   unsubmitted_uring_ops_size(0),
+   uring_deferred_activations(0),
+#endif
+   coros_size(0),
    last_created_event_id(0),
    interruption_reason_x_type(exception::common_type::none) {
    if (!engine_fd) {
       exception::throw_os_error();
    }
+   if (opts.max_events_per_wait == 0 || opts.stack_size == 0) {
+      LOFTY_THROW(argument_error, ());
+   }
+   max_events_per_wait = opts.max_events_per_wait < max_events_per_wait_limit
+      ? opts.max_events_per_wait : max_events_per_wait_limit;
+   stack_byte_size = opts.stack_size;
+#if LOFTY_HOST_API_POSIX
+   max_pooled_stacks = opts.max_pooled_stacks;
+   lazy_stack_commit = opts.lazy_stack_commit;
+#endif
+   LOFTY_FOR_EACH(auto & w, workers) {
+      w.store(nullptr);
+   }
+   // Set up the notification used by wake_idle_worker().
+#if LOFTY_HOST_API_BSD
+   // Event ids are assigned starting from 1, so 0 is free to use.
+   struct ::kevent ke;
+   ke.ident = 0;
+   ke.filter = EVFILT_USER;
+   ke.flags = EV_ADD | EV_DISABLE;
+   ke.fflags = 0;
+   if (::kevent(engine_fd.get(), &ke, 1, nullptr, 0, nullptr) < 0) {
+      exception::throw_os_error();
+   }
+#elif LOFTY_HOST_API_LINUX
+   wakeup_fd = io::filedesc(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+   if (!wakeup_fd) {
+      exception::throw_os_error();
+   }
+   ::epoll_event ee;
+   memory::clear(&ee.data);
+   ee.data.fd = wakeup_fd.get();
+   // Use EPOLLET so that each wakeup only wakes up a single thread.
+   ee.events = EPOLLET | EPOLLIN;
+   if (::epoll_ctl(engine_fd.get(), EPOLL_CTL_ADD, wakeup_fd.get(), &ee) < 0) {
+      exception::throw_os_error();
+   }
+   if (opts.use_io_uring && ring.open(uring_sq_size, uring_cq_size)) {
+      /* The io_uring becomes readable whenever it posts a completion; use EPOLLET so that each batch of
+      completions only wakes up a single thread, which will reap all of them. */
+      ee.data.fd = ring.fd().get();
+      ee.events = EPOLLET | EPOLLIN;
+      if (::epoll_ctl(engine_fd.get(), EPOLL_CTL_ADD, ring.fd().get(), &ee) < 0) {
+         exception::throw_os_error();
+      }
+   }
+#endif
+#if LOFTY_HOST_API_POSIX
+   max_blocking_io_threads = opts.blocking_io_threads;
+   max_blocking_io_jobs = opts.blocking_io_queue_depth;
+   idle_blocking_io_threads_size = 0;
+   first_blocking_io_job = nullptr;
+   last_blocking_io_job = nullptr;
+   blocking_io_jobs_size = 0;
+   first_blocking_io_space_waiter = nullptr;
+   last_blocking_io_space_waiter = nullptr;
+   stop_blocking_io_threads = false;
+   // Do this last, since nothing would destroy blocking_io_cond if the constructor threw after this.
+   if (int err = ::pthread_cond_init(&blocking_io_cond, nullptr)) {
+      exception::throw_os_error(err);
+   }
+#endif
+#if LOFTY_HOST_API_LINUX
+   // Now that nothing can throw, make *this reachable by discard_fd().
+   _std::lock_guard<_std::mutex> lock(live_scheds_mutex);
+   prev_live_sched = nullptr;
+   next_live_sched = first_live_sched;
+   if (first_live_sched) {
+      first_live_sched->prev_live_sched = this;
+   }
+   first_live_sched = this;
+#endif
 }
 
 coroutine::scheduler::~scheduler() {
    // TODO: verify that ready_coros_queue and coros_blocked_by_* are empty.
+#if LOFTY_HOST_API_LINUX
+   {
+      _std::lock_guard<_std::mutex> lock(live_scheds_mutex);
+      if (prev_live_sched) {
+         prev_live_sched->next_live_sched = next_live_sched;
+      } else {
+         first_live_sched = next_live_sched;
+      }
+      if (next_live_sched) {
+         next_live_sched->prev_live_sched = prev_live_sched;
+      }
+   }
+#endif
+#if LOFTY_HOST_API_POSIX
+   {
+      _std::lock_guard<_std::mutex> lock(blocking_io_mutex);
+      stop_blocking_io_threads = true;
+   }
+   // Wake up every idle thread, so it can see that it’s over.
+   ::pthread_cond_broadcast(&blocking_io_cond);
+   LOFTY_FOR_EACH(auto thread, blocking_io_threads) {
+      ::pthread_join(thread, nullptr);
+   }
+   ::pthread_cond_destroy(&blocking_io_cond);
+#endif
 #if LOFTY_HOST_API_WIN32
    if (non_iocp_events_thread_handle) {
       stop_non_iocp_events_thread.store(true);
@@ -342,13 +1289,44 @@ coroutine::scheduler::~scheduler() {
       ::CloseHandle(non_iocp_events_thread_handle);
    }
 #endif
+   // Workers are empty once released, so there are no queued coroutines to release here.
+   LOFTY_FOR_EACH(auto & w, workers) {
+      delete w.load();
+   }
+   // Release the coroutines that were scheduled but never got to run to completion.
+   while (impl * coro_pimpl = ready_coros_queue.pop_front()) {
+      coro_pimpl->scheduled_self_pimpl.reset();
+   }
 }
 
-void coroutine::scheduler::add_ready(_std::shared_ptr<impl> coro_pimpl) {
-   _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-   ready_coros_queue.push_back(_std::move(coro_pimpl));
+void coroutine::scheduler::add_new(_std::shared_ptr<impl> coro_pimpl) {
+   coros_size.fetch_add(1);
+   impl * coro_pimpl_ptr = coro_pimpl.get();
+   // Released by coroutine_scheduling_loop() once the coroutine terminates.
+   coro_pimpl_ptr->scheduled_self_pimpl = _std::move(coro_pimpl);
+   // New coroutines start in the ready state.
+   enqueue_ready(coro_pimpl_ptr);
 }
 
+void coroutine::scheduler::add_ready(impl * coro_pimpl) {
+   if (coro_pimpl->notify()) {
+      enqueue_ready(coro_pimpl);
+   }
+}
+
+#if LOFTY_HOST_API_POSIX
+coroutine::scheduler::stack coroutine::scheduler::acquire_stack() {
+   {
+      _std::lock_guard<_std::mutex> lock(stacks_pool_mutex);
+      if (stacks_pool) {
+         // Reuse the most recently used stack, which is the most likely to still be in cache.
+         return stacks_pool.pop_back();
+      }
+   }
+   return stack(stack_byte_size, lazy_stack_commit);
+}
+#endif
+
 #if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
 void coroutine::scheduler::arm_timer(time_duration_t millisecs) const {
    /* Since setting the timeout to 0 disables the timer, we’ll set it to the smallest delay possible instead.
@@ -386,10 +1364,18 @@ void coroutine::scheduler::arm_timer(time_duration_t millisecs) const {
    #endif
 }
 
-void coroutine::scheduler::arm_timer_for_next_sleep_end() const {
-   if (coros_blocked_by_timer_fd) {
-      // Calculate the time at which the earliest sleep end should occur.
-      time_point_t now = current_time(), sleep_end = coros_blocked_by_timer_fd.front().key;
+void coroutine::scheduler::arm_timer_for_next_sleep_end() {
+   arm_timer_for_sleep_end(coros_blocked_by_timer_fd.next_deadline());
+}
+
+void coroutine::scheduler::arm_timer_for_sleep_end(time_point_t sleep_end) {
+   if (sleep_end == timer_fd_sleep_end) {
+      // Already armed for that time (or already disarmed); save a system call.
+      return;
+   }
+   timer_fd_sleep_end = sleep_end;
+   if (sleep_end != timer_wheel::never) {
+      time_point_t now = current_time();
       time_duration_t sleep;
       if (now < sleep_end) {
          sleep = static_cast<time_duration_t>(sleep_end - now);
@@ -401,9 +1387,9 @@ void coroutine::scheduler::arm_timer_for_next_sleep_end() const {
    } else {
       // Stop the timer.
    #if LOFTY_HOST_API_LINUX
-      ::itimerspec sleep_end;
-      memory::clear(&sleep_end);
-      if (::timerfd_settime(timer_fd.get(), 0, &sleep_end, nullptr) < 0) {
+      ::itimerspec disarm;
+      memory::clear(&disarm);
+      if (::timerfd_settime(timer_fd.get(), 0, &disarm, nullptr) < 0) {
          exception::throw_os_error();
       }
    #elif LOFTY_HOST_API_WIN32
@@ -415,17 +1401,70 @@ void coroutine::scheduler::arm_timer_for_next_sleep_end() const {
 }
 #endif
 
+#if LOFTY_HOST_API_POSIX
+void coroutine::scheduler::blocking_io_thread() {
+   _std::unique_lock<_std::mutex> lock(blocking_io_mutex);
+   for (;;) {
+      if (blocking_io_job * job = first_blocking_io_job) {
+         first_blocking_io_job = job->next;
+         if (!first_blocking_io_job) {
+            last_blocking_io_job = nullptr;
+         }
+         --blocking_io_jobs_size;
+         if (blocking_io_space_waiter * waiter = first_blocking_io_space_waiter) {
+            // Let the longest waiting coroutine queue its job in the room just made.
+            first_blocking_io_space_waiter = waiter->next;
+            if (first_blocking_io_space_waiter) {
+               first_blocking_io_space_waiter->prev = nullptr;
+            } else {
+               last_blocking_io_space_waiter = nullptr;
+            }
+            unpark(&waiter->parked);
+         }
+         lock.unlock();
+         (*job->fn)();
+         int err = errno;
+         lock.lock();
+         /* Complete the job while holding the lock, so that the coroutine can make sure that the notification
+         has been delivered before moving on. Once completed is set, the coroutine may discard *job, so don’t
+         access it after that. */
+         impl * coro_pimpl = job->coro_pimpl;
+         job->err = err;
+         job->completed.store(true);
+         add_ready(coro_pimpl);
+      } else if (stop_blocking_io_threads) {
+         break;
+      } else {
+         ++idle_blocking_io_threads_size;
+         // blocking_io_mutex wraps a pthread mutex, so it can be used with a pthread condition variable.
+         ::pthread_cond_wait(&blocking_io_cond, lock.mutex()->native_handle());
+         --idle_blocking_io_threads_size;
+      }
+   }
+}
+
+/*static*/ void * coroutine::scheduler::blocking_io_thread_static(void * coro_sched) {
+   static_cast<scheduler *>(coro_sched)->blocking_io_thread();
+   return nullptr;
+}
+#endif
+
 void coroutine::scheduler::block_active(
    unsigned millisecs, event_id_t event_id, io::filedesc_t fd, bool write
 #if LOFTY_HOST_API_WIN32
    , io::overlapped * ovl
 #endif
 ) {
-   // TODO: handle (millisecs == 0 && fd == io::filedesc_t_null) as a timer-less yield.
-   /* TODO: when adding both an event/fd and a timer, there’s a race condition when multiple threads share the
-   same scheduler: if the timeout lapses and the coroutine is activated before the fd is removed from the
-   waited-on pool, a different thread might wake up to serve the fd becoming ready, resuming the coroutine a
-   second time. This can be avoided with an atomic “being activated” flag in coroutine::impl. */
+   impl * coro_pimpl = active_coro_pimpl;
+   // Deliver any interruptions that arrived while the coroutine was running, instead of blocking.
+   coro_pimpl->interruption_point();
+   if (millisecs == 0 && !event_id && fd == io::filedesc_t_null) {
+      // Nothing to wait for: yield to other ready coroutines, and get back in line behind them.
+      add_ready(coro_pimpl);
+      active_coro_pimpl = nullptr;
+      switch_to_scheduler(coro_pimpl);
+      return;
+   }
    fd_io_key fdiok;
    fdiok.pack = 0;
    fdiok.s.fd = fd;
@@ -433,10 +1472,9 @@ void coroutine::scheduler::block_active(
 #if LOFTY_HOST_API_BSD
    struct ::kevent fd_ke, timer_ke;
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-   decltype(coros_blocked_by_timer_fd)::iterator timer_block_itr;
+   timer_wheel::timer timeout_timer;
 #endif
    bool event_set = false, fd_set = false, timeout_set = false;
-   _std::shared_ptr<impl> coro_pimpl(active_coro_pimpl);
    LOFTY_TRY {
       if (event_id) {
          {
@@ -449,9 +1487,11 @@ void coroutine::scheduler::block_active(
                return;
             }
 #endif
+            /* Set this while holding the lock, so that a thread unblocking the coroutine will find it already
+            set. The same applies to the other blocking_* members below. */
+            coro_pimpl->blocking_event_id = event_id;
             coros_blocked_by_event.add_or_assign(event_id, coro_pimpl);
          }
-         coro_pimpl->blocking_event_id = event_id;
          event_set = true;
       }
 #if LOFTY_HOST_API_BSD
@@ -466,13 +1506,13 @@ void coroutine::scheduler::block_active(
          }
          {
             _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+            coro_pimpl->blocking_fd = fd;
             coros_blocked_by_fd.add_or_assign(fdiok.pack, coro_pimpl);
          }
-         coro_pimpl->blocking_fd = fd;
          fd_set = true;
       }
       if (millisecs) {
-         timer_ke.ident = reinterpret_cast<std::uintptr_t>(coro_pimpl.get());
+         timer_ke.ident = reinterpret_cast<std::uintptr_t>(coro_pimpl);
          timer_ke.filter = EVFILT_TIMER;
          // Use EV_ONESHOT to avoid waking up multiple threads for this timer becoming ready.
          timer_ke.flags = EV_ADD | EV_ONESHOT;
@@ -484,38 +1524,55 @@ void coroutine::scheduler::block_active(
          }
          {
             _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+            coro_pimpl->blocking_time_millisecs = millisecs;
             coros_blocked_by_timer_ke.add_or_assign(timer_ke.ident, coro_pimpl);
          }
-         coro_pimpl->blocking_time_millisecs = millisecs;
          timeout_set = true;
       }
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
       if (fd != io::filedesc_t_null) {
-   #if LOFTY_HOST_API_LINUX
-         ::epoll_event ee;
-         ee.data.u64 = fdiok.pack;
-         /* Use EPOLLONESHOT to avoid waking up multiple threads for this fd becoming ready. This means we’d
-         need to then rearm it in find_coroutine_to_activate() when it becomes ready, but we’ll remove it
-         instead. */
-         ee.events = EPOLLONESHOT | EPOLLPRI | (write ? EPOLLOUT : EPOLLIN);
-         if (::epoll_ctl(engine_fd.get(), EPOLL_CTL_ADD, fd, &ee) < 0) {
-            exception::throw_os_error();
-         }
-   #elif LOFTY_HOST_API_WIN32
+   #if LOFTY_HOST_API_WIN32
          /* TODO: ensure bind_to_this_coroutine_scheduler_iocp() has been called on fd. There’s nothing we can
          do about that here, since it’s a non-repeatable operation. */
    #endif
          {
             _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-            coros_blocked_by_fd.add_or_assign(fdiok.pack, coro_pimpl);
-         }
-         coro_pimpl->blocking_fd = fd;
+   #if LOFTY_HOST_API_LINUX
+            auto registered_fd_itr(registered_fds.find(fd));
+            if (registered_fd_itr == registered_fds.cend()) {
+               register_fd(fd);
+            } else {
+               /* If fd became ready since the last wait, don’t wait at all; the caller will retry the I/O
+               operation, and wait again if that still fails. */
+               bool & fd_ready = write ? registered_fd_itr->value.write : registered_fd_itr->value.read;
+               if (fd_ready) {
+                  fd_ready = false;
+                  return;
+               }
+            }
+   #endif
+            coro_pimpl->blocking_fd = fd;
    #if LOFTY_HOST_API_WIN32
-         coro_pimpl->blocking_ovl = ovl;
+            coro_pimpl->blocking_ovl = ovl;
+   #endif
+   #if LOFTY_HOST_API_LINUX
+            /* Other coroutines may already be waiting for the same I/O on fd; chain them after this one, so
+            they will all be made ready together. */
+            auto blocked_coro_itr(coros_blocked_by_fd.find(fdiok.pack));
+            if (blocked_coro_itr != coros_blocked_by_fd.cend()) {
+               coro_pimpl->next_blocked_by_fd = blocked_coro_itr->value;
+               blocked_coro_itr->value = coro_pimpl;
+            } else {
+               coros_blocked_by_fd.add_or_assign(fdiok.pack, coro_pimpl);
+            }
+   #else
+            coros_blocked_by_fd.add_or_assign(fdiok.pack, coro_pimpl);
    #endif
+         }
          fd_set = true;
       }
       if (millisecs) {
+         _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
          if (!timer_fd) {
             // No timer infrastructure yet; set it up now.
    #if LOFTY_HOST_API_LINUX
@@ -538,14 +1595,16 @@ void coroutine::scheduler::block_active(
             setup_non_iocp_events();
    #endif
          }
-         {
-            _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-            /* Add the timeout to the timers map, then rearm the timer to ensure the new timeout is accounted
-            for. */
-            timer_block_itr = coros_blocked_by_timer_fd.add(current_time() + millisecs, coro_pimpl);
-            arm_timer_for_next_sleep_end();
-         }
+         /* Add the timeout to the timer wheel, then rearm the timer if the new timeout is the earliest one;
+         otherwise the timer is already armed to fire no later than the new timeout. */
          coro_pimpl->blocking_time_millisecs = millisecs;
+         auto now = current_time();
+         timeout_timer.deadline = now + millisecs;
+         timeout_timer.coro_pimpl = coro_pimpl;
+         coros_blocked_by_timer_fd.add(&timeout_timer, now);
+         if (timeout_timer.deadline < timer_fd_sleep_end) {
+            arm_timer_for_sleep_end(timeout_timer.deadline);
+         }
          timeout_set = true;
       }
 #else
@@ -554,8 +1613,8 @@ void coroutine::scheduler::block_active(
 
       /* Now that the coroutine is associated to the specified blockers, deactivate it, then switch back to
       the thread’s own context and have it wait for a ready coroutine. */
-      active_coro_pimpl.reset();
-      switch_to_scheduler(coro_pimpl.get());
+      active_coro_pimpl = nullptr;
+      switch_to_scheduler(coro_pimpl);
       // After returning from that, active_coro_pimpl == coro_pimpl again.
 
       if (timeout_set && coro_pimpl->blocking_time_millisecs == 0 && (
@@ -594,15 +1653,14 @@ void coroutine::scheduler::block_active(
       }
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
    #if LOFTY_HOST_API_LINUX
-      if (fd_set) {
-         // See comment on creation for why we unconditionally remove this.
-         ::epoll_ctl(engine_fd.get(), EPOLL_CTL_DEL, fd, nullptr);
-         /* If the coroutine still thinks it’s blocked upon resuming, the event is still active and must be
-         removed. */
+      /* If the coroutine still thinks it’s blocked upon resuming, it must be disconnected from the fd. The fd
+      itself stays registered until it’s closed. */
+      if (fd_set && coro_pimpl->blocking_fd != io::filedesc_t_null) {
+         _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+         // Check again, since the fd may have become ready while waiting for the lock.
          if (coro_pimpl->blocking_fd != io::filedesc_t_null) {
             coro_pimpl->blocking_fd = io::filedesc_t_null;
-            _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-            coros_blocked_by_fd.remove(fdiok.pack);
+            remove_blocked_by_fd(fdiok, coro_pimpl);
          }
       }
    #elif LOFTY_HOST_API_WIN32
@@ -619,43 +1677,83 @@ void coroutine::scheduler::block_active(
       }
    #endif
       /* If the coroutine still thinks it’s blocked upon resuming, the timer is still active and must be
-      removed. */
+      removed. timer_fd is left armed: if it fires for this timeout, it will just be rearmed for the next one,
+      which is cheaper than rearming it every time a timeout is cancelled. */
       if (timeout_set && coro_pimpl->blocking_time_millisecs != 0) {
-         coro_pimpl->blocking_time_millisecs = 0;
          _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-         coros_blocked_by_timer_fd.remove(timer_block_itr);
-         arm_timer_for_next_sleep_end();
+         // Check again, since the timer may have expired while waiting for the lock.
+         if (coro_pimpl->blocking_time_millisecs != 0) {
+            coro_pimpl->blocking_time_millisecs = 0;
+            coros_blocked_by_timer_fd.remove(&timeout_timer);
+         }
       }
 #endif
+      if (timeout_set && (event_set || fd_set)) {
+         /* With two wait sources, another thread might have removed the coroutine from the blocked maps for
+         the source that didn’t resume it, and be about to notify it. Since that happens while holding
+         coros_add_remove_mutex, locking it here ensures that any such notification has been delivered, so it
+         can be discarded before the coroutine moves on. */
+         _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+         coro_pimpl->discard_notification();
+      }
    };
 }
 
+coroutine::scheduler::worker * coroutine::scheduler::claim_worker() {
+   // Reuse a worker released by a thread that stopped running the scheduler, if possible.
+   std::size_t curr_workers_size = workers_size.load();
+   if (curr_workers_size > max_workers) {
+      curr_workers_size = max_workers;
+   }
+   for (std::size_t i = 0; i < curr_workers_size; ++i) {
+      worker * w = workers[i].load();
+      if (w && w->claim()) {
+         return w;
+      }
+   }
+   std::size_t index = workers_size.fetch_add(1);
+   if (index >= max_workers) {
+      // Too many threads; this one will have to make do with ready_coros_queue.
+      return nullptr;
+   }
+   worker * w = new worker(this, index);
+   workers[index].store(w);
+   return w;
+}
+
 void coroutine::scheduler::coroutine_scheduling_loop(bool interrupting_all /*= false*/) {
-   _std::shared_ptr<impl> & active_coro_pimpl_ = active_coro_pimpl;
+   impl *& active_coro_pimpl_ = active_coro_pimpl;
    _pvt::coroutine_local_storage * default_crls, ** current_crls;
    _pvt::coroutine_local_storage::get_default_and_current_pointers(&default_crls, &current_crls);
 #if LOFTY_HOST_API_POSIX
-   ::ucontext_t * return_uctx = default_return_uctx.get();
+   context_t * return_ctx = default_return_ctx.get();
 #endif
-   while ((active_coro_pimpl_ = find_coroutine_to_activate())) {
+   /* Once the coroutine switches back to this thread, another thread might unblock and run it as soon as
+   park() is called, so it must not be accessed after that. */
+   impl * coro_pimpl;
+   while ((coro_pimpl = find_coroutine_to_activate())) {
+      coro_pimpl->set_running();
+      active_coro_pimpl_ = coro_pimpl;
       // Swap the coroutine_local_storage pointer for this thread with that of the active coroutine.
-      *current_crls = active_coro_pimpl_->local_storage_ptr();
-#if LOFTY_HOST_API_POSIX
+      *current_crls = coro_pimpl->local_storage_ptr();
+#if !LOFTY_COROUTINE_ASM_CONTEXT && LOFTY_HOST_API_POSIX
       int ret;
 #endif
       LOFTY_TRY {
          // Switch the current thread’s context to the active coroutine’s.
-#if LOFTY_HOST_API_POSIX
+#if LOFTY_COROUTINE_ASM_CONTEXT
+         lofty_coroutine_switch_context(return_ctx, coro_pimpl->context_ptr());
+#elif LOFTY_HOST_API_POSIX
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wdeprecated-declarations"
    #endif
-         ret = ::swapcontext(return_uctx, active_coro_pimpl_->ucontext_ptr());
+         ret = ::swapcontext(return_ctx, coro_pimpl->context_ptr());
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic pop
    #endif
 #elif LOFTY_HOST_API_WIN32
-         ::SwitchToFiber(active_coro_pimpl_->fiber());
+         ::SwitchToFiber(coro_pimpl->fiber());
 #else
    #error "TODO: HOST_API"
 #endif
@@ -663,12 +1761,28 @@ void coroutine::scheduler::coroutine_scheduling_loop(bool interrupting_all /*= f
          // Restore the coroutine_local_storage pointer for this thread.
          *current_crls = default_crls;
       };
-#if LOFTY_HOST_API_POSIX
+#if !LOFTY_COROUTINE_ASM_CONTEXT && LOFTY_HOST_API_POSIX
       if (ret < 0) {
          /* TODO: only a stack-related ENOMEM is possible, so throw a stack overflow exception
-         (*active_coro_pimpl has a problem, not return_uctx). */
+         (*active_coro_pimpl has a problem, not return_ctx). */
       }
 #endif
+      active_coro_pimpl_ = nullptr;
+      if (coro_pimpl->terminated()) {
+#if LOFTY_HOST_API_POSIX
+         // The coroutine will never run again, so its stack can be given to a new coroutine.
+         recycle_stack(coro_pimpl->detach_stack());
+#endif
+         // Release the scheduler’s reference to the coroutine, which might be the last one.
+         coro_pimpl->scheduled_self_pimpl.reset();
+         if (coros_size.fetch_sub(1) == 1) {
+            // That was the last coroutine; let any idle threads know that it’s time to return.
+            wake_idle_worker();
+         }
+      } else if (coro_pimpl->park()) {
+         // The coroutine was made ready again before it could finish switching back to this thread.
+         enqueue_ready(coro_pimpl);
+      }
       /* If a coroutine (in this or another thread) leaked an uncaught exception, terminate all coroutines and
       eventually this very thread. */
       if (!interrupting_all && interruption_reason_x_type.load() != exception::common_type::none) {
@@ -679,12 +1793,9 @@ void coroutine::scheduler::coroutine_scheduling_loop(bool interrupting_all /*= f
 }
 
 coroutine::scheduler::event_id_t coroutine::scheduler::create_event() {
-   event_id_t event_id;
-   {
-      _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-      // TODO: handle overflow of last_created_event_id.
-      event_id = ++last_created_event_id;
-   }
+   _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+   // TODO: handle overflow of last_created_event_id.
+   event_id_t event_id = ++last_created_event_id;
 #if LOFTY_HOST_API_BSD
    struct ::kevent ke;
    ke.ident = event_id;
@@ -764,44 +1875,93 @@ void coroutine::scheduler::discard_event(event_id_t event_id) {
 #endif
 }
 
-_std::shared_ptr<coroutine::impl> coroutine::scheduler::find_coroutine_to_activate() {
-   _std::shared_ptr<coroutine::impl> coro_pimpl;
-   // This loop will only repeat in case of EINTR from the blocking-wait API.
-   /* TODO: if the epoll/kqueue/IOCP is shared by several threads and one thread receives and removes the last
-   event source from it, what happens to the remaining threads?
-   a) We could send a no-op signal (SIGCONT?) to all threads using this scheduler, to make the wait function
-      return EINTR;
-   b) We could have a single event source for each scheduler with the semantics of “event sources changed”, in
-      edge-triggered mode so it wakes all waiting threads once, at once. */
-   for (;;) {
-      {
-         _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-         if (ready_coros_queue) {
-            // There are coroutines that are ready to run; remove and return the first.
-            coro_pimpl = ready_coros_queue.pop_front();
-            break;
-         } else if (
-            !coros_blocked_by_fd && !coros_blocked_by_event
+/*static*/ void coroutine::scheduler::discard_fd(io::filedesc_t fd) {
+#if LOFTY_HOST_API_LINUX
+   /* Any scheduler might have registered fd, not just the one of this thread, and a stale entry in its
+   registered_fds would make its next wait on a file descriptor reusing the same number last forever. */
+   _std::lock_guard<_std::mutex> lock(live_scheds_mutex);
+   for (auto coro_sched = first_live_sched; coro_sched; coro_sched = coro_sched->next_live_sched) {
+      coro_sched->forget_fd(fd);
+   }
+#else
+   // Nothing to do: fds are not registered with a persistent state.
+   LOFTY_UNUSED_ARG(fd);
+#endif
+}
+
+void coroutine::scheduler::enqueue_ready(impl * coro_pimpl) {
+   /* Only use the thread’s own queue while ready_coros_queue is empty: this keeps coroutines running in the
+   same order they were queued in, at least as long as only one thread is running the scheduler. */
+   worker * w = this_worker();
+   if (w && ready_coros_queue_size.load() == 0) {
+      if (w->push(coro_pimpl)) {
+         wake_idle_worker();
+         return;
+      }
+      // The worker’s queue is full.
+   }
+   {
+      _std::lock_guard<_std::mutex> lock(ready_coros_queue_mutex);
+      ready_coros_queue.push_back(coro_pimpl);
+      ready_coros_queue_size.fetch_add(1);
+   }
+   wake_idle_worker();
+}
+
+coroutine::impl * coroutine::scheduler::find_coroutine_to_activate() {
+   /* Buffer for the notifications collected by a single wait; max_events_per_wait caps how much of it is
+   actually used. */
 #if LOFTY_HOST_API_BSD
-            && !coros_blocked_by_timer_ke
-#elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-            && !coros_blocked_by_timer_fd
+   struct ::kevent kes[max_events_per_wait_limit];
+#elif LOFTY_HOST_API_LINUX
+   ::epoll_event ees[max_events_per_wait_limit];
 #endif
-         ) {
-            this_thread::interruption_point();
-            // No coroutines.
-            coro_pimpl = nullptr;
-            break;
+   // true if this thread was woken up by wake_idle_worker().
+   bool woken = false;
+   /* This loop will only repeat in case of EINTR from the blocking-wait API, or if no coroutines were
+   unblocked. */
+   for (;;) {
+      if (auto coro_pimpl = pop_ready()) {
+#if LOFTY_HOST_API_LINUX
+         submit_uring_ops(false);
+#endif
+         if (woken) {
+            /* This thread was woken up because there was work to do, and found some; pass the baton to
+            another idle thread, in case there’s more. */
+            wake_idle_worker();
          }
+         return coro_pimpl;
+      } else if (coros_size.load() == 0) {
+         this_thread::interruption_point();
+         // No coroutines left; any other idle threads must return as well.
+         wake_idle_worker();
+         return nullptr;
+      }
+
+#if LOFTY_HOST_API_LINUX
+      /* No coroutines are ready, which ends the scheduling round: submit the uring operations queued during
+      it before waiting. Any that complete right away will make their coroutines ready. */
+      submit_uring_ops(true);
+#endif
+      /* Let other threads know that this one is about to wait, then check again: anything they did before
+      seeing this thread as idle would otherwise go unnoticed. */
+      idle_workers_size.fetch_add(1);
+      if (auto coro_pimpl = pop_ready()) {
+         idle_workers_size.fetch_sub(1);
+         return coro_pimpl;
+      } else if (coros_size.load() == 0) {
+         idle_workers_size.fetch_sub(1);
+         continue;
       }
-      /* TODO: FIXME: coros_add_remove_mutex does not protect against race conditions for the “any coroutines
-      left?” case. */
 
-      // There are blocked coroutines; wait for the first one to become ready again.
-      fd_io_key fdiok;
+      /* There are blocked coroutines; wait for at least one of them to become ready again, then resolve every
+      collected notification while holding the lock only once, queueing all the unblocked coroutines. */
 #if LOFTY_HOST_API_BSD
-      struct ::kevent ke;
-      if (::kevent(engine_fd.get(), nullptr, 0, &ke, 1, nullptr) < 0) {
+      int kes_size = ::kevent(
+         engine_fd.get(), nullptr, 0, kes, static_cast<int>(max_events_per_wait), nullptr
+      );
+      idle_workers_size.fetch_sub(1);
+      if (kes_size < 0) {
          int err = errno;
          /* TODO: EINTR is not a reliable way to interrupt a thread’s ::kevent() call when multiple threads
          share the same coroutine::scheduler. */
@@ -811,43 +1971,58 @@ _std::shared_ptr<coroutine::impl> coroutine::scheduler::find_coroutine_to_activa
          }
          exception::throw_os_error(err);
       }
-      // TODO: understand how EV_ERROR works.
-      /*if (ke.flags & EV_ERROR) {
-         exception::throw_os_error(ke.data);
-      }*/
       _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-      if (ke.filter == EVFILT_TIMER) {
-         coro_pimpl = coros_blocked_by_timer_ke.pop(ke.ident);
-         // Make the coroutine aware that it’s no longer waiting for the timer.
-         coro_pimpl->blocking_time_millisecs = 0;
-         break;
-      } else if (ke.filter == EVFILT_USER) {
-         /* Un-trigger the event. EV_DISPATCH should’ve taken care of this, but that doesn’t seem to work with
-         EVFILT_USER. Note that this would be a race condition because a coroutine on a different thread (but
-         same scheduler) could begin waiting on this event between the kevent() calls in this thread, and be
-         released by the still-triggered event; however, that can’t happen because the coroutine will not be
-         able to wait on the event because we haven’t yet removed the event id from coros_blocked_by_event. */
-         ke.flags = EV_DISABLE;
-         ke.fflags = 0;
-         ::kevent(engine_fd.get(), &ke, 1, nullptr, 0, nullptr);
-
-         auto blocked_coro_itr(coros_blocked_by_event.find(ke.ident));
-         if (blocked_coro_itr == coros_blocked_by_event.cend()) {
-            // The event must’ve been triggered with no coroutines waiting for it.
-            continue;
+      for (auto ke = kes, kes_end = kes + kes_size; ke < kes_end; ++ke) {
+         // TODO: understand how EV_ERROR works.
+         /*if (ke->flags & EV_ERROR) {
+            exception::throw_os_error(ke->data);
+         }*/
+         if (ke->filter == EVFILT_TIMER) {
+            auto coro_pimpl(coros_blocked_by_timer_ke.pop(ke->ident));
+            // Make the coroutine aware that it’s no longer waiting for the timer.
+            coro_pimpl->blocking_time_millisecs = 0;
+            add_ready(coro_pimpl);
+         } else if (ke->filter == EVFILT_USER && ke->ident == 0) {
+            // Sent by wake_idle_worker(); see the comment below about disabling EVFILT_USER events.
+            struct ::kevent ke_disable(*ke);
+            ke_disable.flags = EV_DISABLE;
+            ke_disable.fflags = 0;
+            ::kevent(engine_fd.get(), &ke_disable, 1, nullptr, 0, nullptr);
+            wakeup_pending.store(false);
+            woken = true;
+         } else if (ke->filter == EVFILT_USER) {
+            /* Un-trigger the event. EV_DISPATCH should’ve taken care of this, but that doesn’t seem to work
+            with EVFILT_USER. Note that this would be a race condition because a coroutine on a different
+            thread (but same scheduler) could begin waiting on this event between the kevent() calls in this
+            thread, and be released by the still-triggered event; however, that can’t happen because the
+            coroutine will not be able to wait on the event because we haven’t yet removed the event id from
+            coros_blocked_by_event. */
+            struct ::kevent ke_disable(*ke);
+            ke_disable.flags = EV_DISABLE;
+            ke_disable.fflags = 0;
+            ::kevent(engine_fd.get(), &ke_disable, 1, nullptr, 0, nullptr);
+
+            auto blocked_coro_itr(coros_blocked_by_event.find(ke->ident));
+            if (blocked_coro_itr != coros_blocked_by_event.cend()) {
+               auto coro_pimpl = blocked_coro_itr->value;
+               coros_blocked_by_event.remove(blocked_coro_itr);
+               // Make the coroutine aware that it’s no longer waiting for the event.
+               coro_pimpl->blocking_event_id = 0;
+               add_ready(coro_pimpl);
+            }
+            // Else the event must’ve been triggered with no coroutines waiting for it.
+         } else {
+            // Otherwise it’s a file descriptor event.
+            fd_io_key fdiok;
+            fdiok.pack = ke->udata;
+            unblock_by_fd(fdiok);
          }
-         coro_pimpl = _std::move(blocked_coro_itr->value);
-         coros_blocked_by_event.remove(blocked_coro_itr);
-         // Make the coroutine aware that it’s no longer waiting for the event.
-         coro_pimpl->blocking_event_id = 0;
-         break;
       }
-      // Otherwise it’s a file descriptor event.
-      fdiok.pack = ke.udata;
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
    #if LOFTY_HOST_API_LINUX
-      ::epoll_event ee;
-      if (::epoll_wait(engine_fd.get(), &ee, 1, -1) < 0) {
+      int ees_size = ::epoll_wait(engine_fd.get(), ees, static_cast<int>(max_events_per_wait), -1);
+      idle_workers_size.fetch_sub(1);
+      if (ees_size < 0) {
          int err = errno;
          /* TODO: EINTR is not a reliable way to interrupt a thread’s ::epoll_wait() call when multiple
          threads share the same coroutine::scheduler. This is a problem for Win32 as well (see below), so it
@@ -858,13 +2033,17 @@ _std::shared_ptr<coroutine::impl> coroutine::scheduler::find_coroutine_to_activa
          }
          exception::throw_os_error(err);
       }
-      fdiok.pack = ee.data.u64;
    #elif LOFTY_HOST_API_WIN32
+      /* TODO: use ::GetQueuedCompletionStatusEx() to dequeue up to max_events_per_wait completions at once,
+      like the other implementations do. */
+      fd_io_key fdiok;
       ::DWORD transferred_byte_size;
       ::OVERLAPPED * ovl;
-      if (!::GetQueuedCompletionStatus(
+      ::BOOL dequeued = ::GetQueuedCompletionStatus(
          engine_fd.get(), &transferred_byte_size, &fdiok.pack, &ovl, INFINITE
-      )) {
+      );
+      idle_workers_size.fetch_sub(1);
+      if (!dequeued) {
          /* Distinguish between IOCP failures and I/O failures by also checking whether an OVERLAPPED pointer
          was returned. */
          if (!ovl) {
@@ -881,90 +2060,96 @@ _std::shared_ptr<coroutine::impl> coroutine::scheduler::find_coroutine_to_activa
       if (fdiok.s.fd == engine_fd.get()) {
          this_thread::interruption_point();
          continue;
+      } else if (fdiok.pack == reinterpret_cast< ::ULONG_PTR>(this)) {
+         // Sent by wake_idle_worker().
+         wakeup_pending.store(false);
+         woken = true;
+         continue;
       }
    #endif
       _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-      if (fdiok.s.fd == timer_fd.get()) {
-         // Pop the coroutine that should run now, and rearm the timer if necessary.
-         coro_pimpl = coros_blocked_by_timer_fd.pop_front().value;
-         if (coros_blocked_by_timer_fd) {
-            arm_timer_for_next_sleep_end();
-         }
-         // Make the coroutine aware that it’s no longer waiting for the timer.
-         coro_pimpl->blocking_time_millisecs = 0;
-         break;
-      } else if (fdiok.s.fd == event_semaphore_fd.get()) {
    #if LOFTY_HOST_API_LINUX
-         /* Reset the semaphore, tracking how many coroutines we need to unblock. This could’ve been made
-         easier by EFD_SEMAPHORE, but unfortunately that is broken with EPOLLET (see other comment in this
-         file). */
-         std::uint64_t unblock_count;
-         while (::read(event_semaphore_fd.get(), &unblock_count, sizeof unblock_count) < 0) {
-            int err = errno;
-            if (err != EINTR) {
-               /* This is probably bad, but there’s nothing we can do about it here. Maybe log it? At least we
-               make sure that unblock_count gets a known value. */
-               unblock_count = 0;
-               break;
-            }
-            this_thread::interruption_point();
-         }
-   #endif
-         coro_pimpl = unblock_by_first_event();
-         if (!coro_pimpl) {
+      for (auto ee = ees, ees_end = ees + ees_size; ee < ees_end; ++ee) {
+         io::filedesc_t fd = ee->data.fd;
+         if (fd == wakeup_fd.get()) {
+            // Sent by wake_idle_worker(); reset the eventfd, so the next wakeup will generate a new edge.
+            std::uint64_t wakeup_count;
+            ::read(wakeup_fd.get(), &wakeup_count, sizeof wakeup_count);
+            wakeup_pending.store(false);
+            woken = true;
+            continue;
+         } else if (fd == ring.fd().get()) {
+            _std::lock_guard<_std::mutex> uring_lock(uring_mutex);
+            reap_uring_completions();
             continue;
          }
+         if (fd == timer_fd.get()) {
+   #elif LOFTY_HOST_API_WIN32
+         if (fdiok.s.fd == timer_fd.get()) {
+   #endif
+            unblock_by_expired_timers();
    #if LOFTY_HOST_API_LINUX
-         // Move to ready all other coroutines that this thread was woken up for.
-         while (--unblock_count > 0) {
-            auto other_coro_pimpl(unblock_by_first_event());
-            if (!other_coro_pimpl) {
-               break;
+         } else if (fd == event_semaphore_fd.get()) {
+   #elif LOFTY_HOST_API_WIN32
+         } else if (fdiok.s.fd == event_semaphore_fd.get()) {
+   #endif
+   #if LOFTY_HOST_API_LINUX
+            /* Reset the semaphore, tracking how many coroutines we need to unblock. This could’ve been made
+            easier by EFD_SEMAPHORE, but unfortunately that is broken with EPOLLET (see other comment in this
+            file). */
+            std::uint64_t unblock_count;
+            while (::read(event_semaphore_fd.get(), &unblock_count, sizeof unblock_count) < 0) {
+               int err = errno;
+               if (err != EINTR) {
+                  /* This is probably bad, but there’s nothing we can do about it here. Maybe log it? At least
+                  we make sure that unblock_count gets a known value. */
+                  unblock_count = 0;
+                  break;
+               }
+               this_thread::interruption_point();
             }
-            ready_coros_queue.push_back(_std::move(other_coro_pimpl));
-         }
+   #elif LOFTY_HOST_API_WIN32
+            std::uint64_t unblock_count = 1;
    #endif
-         break;
+            /* Queue all the coroutines that this thread was woken up for. trigger_event() already made them
+            ready, so they only need to be moved to a run queue. */
+            for (; unblock_count > 0; --unblock_count) {
+               if (auto coro_pimpl = ready_events_queue.pop_front()) {
+                  enqueue_ready(coro_pimpl);
+               }
+            }
+         } else {
+   #if LOFTY_HOST_API_LINUX
+            unblock_by_fd_events(fd, ee->events);
+   #elif LOFTY_HOST_API_WIN32
+            unblock_by_fd(fdiok);
+   #endif
+         }
+   #if LOFTY_HOST_API_LINUX
       }
+   #endif
 #else
    #error "TODO: HOST_API"
 #endif
-      // Remove and return the coroutine that was waiting for this file descriptor.
-      auto blocked_coro_itr(coros_blocked_by_fd.find(fdiok.pack));
-      if (blocked_coro_itr != coros_blocked_by_fd.cend()) {
-         /* Note (WIN32 BUG?)
-         Empirical evidence shows that at this point ovl might not be a valid pointer, even if the completion
-         key (fd) returned was a valid Lofty-owned handle. I could not find any explanation for this, but as a
-         workaround, each coroutine carries a pointer to the OVERLAPPED it’s waiting on, and we can check
-         whether GetOverlappedResult() reports ERROR_IO_INCOMPLETE for it to avoid resuming the coroutine in
-         those cases.
-         Spurious notifications seem to occur only with sockets:
-         •  TCP: when after a completed overlapped read operation, a new overlapped read is requested and
-            ReadFile() returns ERROR_IO_PENDING;
-         •  UDP: when WSASendTo() fails due to ICMP reporting that the remote server is gone, WSARecvFrom()
-            will fail for several different reasons. */
-#if LOFTY_HOST_API_WIN32
-         if (blocked_coro_itr->value->blocking_ovl.load()->get_result() == ERROR_IO_INCOMPLETE) {
-            continue;
-         }
-#endif
-         coro_pimpl = coros_blocked_by_fd.pop(blocked_coro_itr);
-         // Make the coroutine aware that it’s no longer waiting for I/O.
-         coro_pimpl->blocking_fd = io::filedesc_t_null;
-#if LOFTY_HOST_API_WIN32
-         coro_pimpl->blocking_ovl = nullptr;
-#endif
-         break;
-      }
-      // Else ignore this notification for an event that nobody was waiting for.
-      /* TODO: in a Win32 multithreaded scenario, the IOCP notification might arrive to a thread before the
-      coroutine blocked itself (on another thread) for the event, due to associating the fd with the IOCP
-      before blocking, which is unavoidable and necessary. To address this, requeue the event so it gets
-      another chance at being processed. It may be necessary to keep a list of handles that should be held
-      until a coroutine blocks for them. */
+      // Go back to pick one of the coroutines just unblocked, if any; otherwise wait again.
+   }
+}
+
+#if LOFTY_HOST_API_POSIX
+/*static*/ bool coroutine::scheduler::handle_stack_guard_fault(void const * addr) {
+   /* Only a thread running on its alternate signal stack can be handling a stack overflow; checking this
+   first also ensures that this is a thread running a scheduler (see run()), so it’s safe to access
+   active_coro_pimpl from a signal handler. */
+   ::stack_t ss;
+   if (::sigaltstack(nullptr, &ss) < 0 || !(ss.ss_flags & SS_ONSTACK)) {
+      return false;
+   }
+   if (impl * coro_pimpl = active_coro_pimpl) {
+      return coro_pimpl->breach_stack_guard(addr);
    }
-   return _std::move(coro_pimpl);
+   return false;
 }
+#endif
 
 void coroutine::scheduler::interrupt_all() {
    /* Interrupt all coroutines using pending_x_type.
@@ -977,18 +2162,23 @@ void coroutine::scheduler::interrupt_all() {
       _std::unique_lock<_std::mutex> lock(coros_add_remove_mutex);
       while (coros_blocked_by_fd) {
          auto coro_pimpl(coros_blocked_by_fd.pop().value);
-         // Make the coroutine aware that it’s no longer waiting for I/O.
-         coro_pimpl->blocking_fd = io::filedesc_t_null;
-         lock.unlock();
-         coro_pimpl->inject_exception(coro_pimpl, x_type);
-         lock.lock();
+         do {
+            auto next_coro_pimpl = coro_pimpl->next_blocked_by_fd;
+            coro_pimpl->next_blocked_by_fd = nullptr;
+            // Make the coroutine aware that it’s no longer waiting for I/O.
+            coro_pimpl->blocking_fd = io::filedesc_t_null;
+            lock.unlock();
+            coro_pimpl->inject_exception(x_type);
+            lock.lock();
+            coro_pimpl = next_coro_pimpl;
+         } while (coro_pimpl);
       }
       while (coros_blocked_by_event) {
-         auto coro_pimpl(coros_blocked_by_fd.pop().value);
+         auto coro_pimpl(coros_blocked_by_event.pop().value);
          // Make the coroutine aware that it’s no longer waiting for the event.
          coro_pimpl->blocking_event_id = 0;
          lock.unlock();
-         coro_pimpl->inject_exception(coro_pimpl, x_type);
+         coro_pimpl->inject_exception(x_type);
          lock.lock();
       }
 #if LOFTY_HOST_API_BSD
@@ -997,18 +2187,28 @@ void coroutine::scheduler::interrupt_all() {
          // Make the coroutine aware that it’s no longer waiting on a timeout.
          coro_pimpl->blocking_time_millisecs = 0;
          lock.unlock();
-         coro_pimpl->inject_exception(coro_pimpl, x_type);
+         coro_pimpl->inject_exception(x_type);
          lock.lock();
       }
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-      while (coros_blocked_by_timer_fd) {
-         auto coro_pimpl(coros_blocked_by_timer_fd.pop_front());
+      while (auto t = coros_blocked_by_timer_fd.pop()) {
+         auto coro_pimpl = t->coro_pimpl;
          // Make the coroutine aware that it’s no longer waiting on a timeout.
-         coro_pimpl.value->blocking_time_millisecs = 0;
+         coro_pimpl->blocking_time_millisecs = 0;
          lock.unlock();
-         coro_pimpl.value->inject_exception(coro_pimpl.value, x_type);
+         coro_pimpl->inject_exception(x_type);
          lock.lock();
       }
+#endif
+#if LOFTY_HOST_API_LINUX
+      {
+         /* Coroutines waiting for uring operations will cancel them, and wait for the cancellation to
+         complete, before handling the interruption. */
+         _std::lock_guard<_std::mutex> uring_lock(uring_mutex);
+         for (auto wait = first_uring_wait; wait; wait = wait->next) {
+            wait->coro_pimpl->inject_exception(x_type);
+         }
+      }
 #endif
       /* TODO: coroutines currently running on other threads associated to this scheduler won’t have been
       interrupted by the above loops; they need to be stopped by interrupting the threads that are running
@@ -1054,18 +2254,251 @@ void coroutine::scheduler::non_iocp_events_thread() {
 }
 #endif
 
+bool coroutine::scheduler::park_active(parked_coroutine * parked, _std::unique_lock<_std::mutex> * lock) {
+   impl * coro_pimpl = active_coro_pimpl;
+   parked->coro_pimpl = coro_pimpl;
+   parked->unparked = false;
+   for (;;) {
+      lock->unlock();
+      active_coro_pimpl = nullptr;
+      // Interruptions are delivered by the caller, after it unlinks *parked from its wait list.
+      switch_to_scheduler(coro_pimpl, false);
+      // After returning from that, active_coro_pimpl == coro_pimpl again.
+      lock->lock();
+      if (parked->unparked) {
+         /* If unpark() was called after the coroutine was resumed for a different reason, its notification is
+         now stale. unpark() can’t be called again while *lock is held, so it’s safe to discard it. */
+         coro_pimpl->discard_notification();
+         return true;
+      }
+      if (coro_pimpl->pending_x_type.load() != exception::common_type::none) {
+         return false;
+      }
+      // Resumed by a stale notification from a previous wait; keep waiting.
+   }
+}
+
+#if LOFTY_HOST_API_LINUX
+bool coroutine::scheduler::perform_uring_op(io::uring_op * op, unsigned timeout_millisecs) {
+   impl * coro_pimpl = active_coro_pimpl;
+   if (!ring.fd() || !coro_pimpl) {
+      return false;
+   }
+   // Deliver any interruptions that arrived while the coroutine was running, instead of blocking.
+   coro_pimpl->interruption_point();
+   uring_wait wait;
+   wait.prev = nullptr;
+   wait.op = op;
+   wait.coro_pimpl = coro_pimpl;
+   wait.completed.store(false);
+   {
+      _std::lock_guard<_std::mutex> lock(uring_mutex);
+      // The operation and its timeout must be queued together; make room for both if necessary.
+      if (ring.sq_available() < 2) {
+         ring.submit();
+         if (ring.sq_available() < 2) {
+            // The OS is not accepting more operations right now; let the caller wait for readiness instead.
+            return false;
+         }
+      }
+      auto sqe = ring.get_sqe();
+      sqe->opcode = op->opcode;
+      sqe->fd = op->fd;
+      sqe->addr = reinterpret_cast<std::uintptr_t>(op->addr);
+      sqe->len = op->len;
+      sqe->off = op->off;
+      // All the operation-specific flags (accept_flags, msg_flags, …) share the same storage.
+      sqe->rw_flags = static_cast<decltype(sqe->rw_flags)>(op->op_flags);
+      sqe->user_data = reinterpret_cast<std::uintptr_t>(&wait);
+      if (timeout_millisecs) {
+         // Have the OS cancel the operation if it doesn’t complete in time.
+         sqe->flags |= IOSQE_IO_LINK;
+         wait.timeout.tv_sec = timeout_millisecs / 1000;
+         wait.timeout.tv_nsec = static_cast<long long>(timeout_millisecs % 1000) * 1000000;
+         auto timeout_sqe = ring.get_sqe();
+         timeout_sqe->opcode = IORING_OP_LINK_TIMEOUT;
+         timeout_sqe->fd = -1;
+         timeout_sqe->addr = reinterpret_cast<std::uintptr_t>(&wait.timeout);
+         timeout_sqe->len = 1;
+         // Leave user_data == 0, so that the completion of the timeout itself will be ignored.
+      }
+      wait.next = first_uring_wait;
+      if (first_uring_wait) {
+         first_uring_wait->prev = &wait;
+      }
+      first_uring_wait = &wait;
+      unsubmitted_uring_ops_size.store(ring.unsubmitted_size());
+   }
+
+   /* Wait for the completion. The operation will be submitted by the scheduler, together with those queued by
+   other coroutines in the same scheduling round. */
+   bool woken_early = false, cancelled = false;
+   for (;;) {
+      active_coro_pimpl = nullptr;
+      /* Don’t let an interruption throw out of here while the OS may still write to *op; it will be
+      delivered below, once the operation is over. */
+      switch_to_scheduler(coro_pimpl, false);
+      // After returning from that, active_coro_pimpl == coro_pimpl again.
+      if (wait.completed.load()) {
+         break;
+      }
+      woken_early = true;
+      if (!cancelled && coro_pimpl->pending_x_type.load() != exception::common_type::none) {
+         /* The coroutine was interrupted. The operation still refers to memory owned by the caller, so it
+         must be cancelled, and its completion (likely with ECANCELED) awaited, before the interruption can be
+         delivered. */
+         _std::lock_guard<_std::mutex> lock(uring_mutex);
+         auto sqe = ring.get_sqe();
+         if (!sqe) {
+            ring.submit();
+            sqe = ring.get_sqe();
+         }
+         if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = reinterpret_cast<std::uintptr_t>(&wait);
+            ring.submit();
+            unsubmitted_uring_ops_size.store(ring.unsubmitted_size());
+            reap_uring_completions();
+            cancelled = true;
+         }
+         // Else try again the next time the coroutine is woken up.
+         if (wait.completed.load()) {
+            break;
+         }
+      }
+   }
+   if (woken_early) {
+      /* The completion might have arrived while the coroutine was running after being woken up for a
+      different reason. Since that happens while holding uring_mutex, locking it here ensures that any such
+      notification has been delivered, so it can be discarded before the coroutine moves on. */
+      _std::lock_guard<_std::mutex> lock(uring_mutex);
+      coro_pimpl->discard_notification();
+   }
+   // If the operation was cancelled because of an interruption, this will throw.
+   coro_pimpl->interruption_point();
+   if (timeout_millisecs && op->result == -ECANCELED) {
+      // The linked timeout expired before the operation could complete.
+      LOFTY_THROW(io::timeout, ());
+   }
+   return true;
+}
+#endif
+
+coroutine::impl * coroutine::scheduler::pop_ready() {
+   worker * w = this_worker();
+   if (w) {
+      if (impl * coro_pimpl = w->pop()) {
+         return coro_pimpl;
+      }
+   }
+   if (impl * coro_pimpl = pop_ready_global()) {
+      return coro_pimpl;
+   }
+   if (w) {
+      // Try to steal from other threads, starting from the next one to spread thefts across all of them.
+      std::size_t curr_workers_size = workers_size.load();
+      if (curr_workers_size > max_workers) {
+         curr_workers_size = max_workers;
+      }
+      for (std::size_t i = 1; i < curr_workers_size; ++i) {
+         worker * victim = workers[(w->index + i) % curr_workers_size].load();
+         if (victim) {
+            if (impl * coro_pimpl = victim->steal_into(w)) {
+               return coro_pimpl;
+            }
+         }
+      }
+   }
+   return nullptr;
+}
+
+coroutine::impl * coroutine::scheduler::pop_ready_global() {
+   if (ready_coros_queue_size.load() == 0) {
+      return nullptr;
+   }
+   _std::lock_guard<_std::mutex> lock(ready_coros_queue_mutex);
+   if (ready_coros_queue.empty()) {
+      return nullptr;
+   }
+   ready_coros_queue_size.fetch_sub(1);
+   return ready_coros_queue.pop_front();
+}
+
+#if LOFTY_HOST_API_LINUX
+void coroutine::scheduler::reap_uring_completions() {
+   for (;;) {
+      while (auto cqe = ring.peek_cqe()) {
+         if (auto wait = reinterpret_cast<uring_wait *>(cqe->user_data)) {
+            wait->op->result = cqe->res;
+            if (wait->prev) {
+               wait->prev->next = wait->next;
+            } else {
+               first_uring_wait = wait->next;
+            }
+            if (wait->next) {
+               wait->next->prev = wait->prev;
+            }
+            // Once completed is set, the coroutine may discard *wait, so don’t access it after that.
+            impl * coro_pimpl = wait->coro_pimpl;
+            wait->completed.store(true);
+            add_ready(coro_pimpl);
+         }
+         // Else it’s the completion of a timeout or a cancellation, which is reflected in its target’s.
+         ring.advance_cq();
+      }
+      if (!ring.cq_overflowed()) {
+         break;
+      }
+      // Now that there’s room in the completion queue, have the OS move any completions it held back there.
+      ring.flush_cq_overflow();
+   }
+}
+#endif
+
+#if LOFTY_HOST_API_POSIX
+void coroutine::scheduler::recycle_stack(stack s) {
+   if (s.reusable()) {
+      _std::lock_guard<_std::mutex> lock(stacks_pool_mutex);
+      if (stacks_pool.size() < max_pooled_stacks) {
+         stacks_pool.push_back(_std::move(s));
+      }
+   }
+   // If s was not moved to stacks_pool, it will be unmapped now, outside of the lock.
+}
+#endif
+
+void coroutine::scheduler::release_worker(worker * w) {
+   // Hand over any coroutines left in the worker’s queue to the threads still running.
+   if (impl * coro_pimpl = w->pop()) {
+      {
+         _std::lock_guard<_std::mutex> lock(ready_coros_queue_mutex);
+         do {
+            ready_coros_queue.push_back(coro_pimpl);
+            ready_coros_queue_size.fetch_add(1);
+         } while ((coro_pimpl = w->pop()));
+      }
+      wake_idle_worker();
+   }
+   w->release();
+}
+
 void coroutine::scheduler::return_to_scheduler(exception::common_type x_type) {
    /* Only the first uncaught exception in a coroutine can succeed at triggering termination of all
    coroutines. */
    auto expected_x_type = exception::common_type::none;
    interruption_reason_x_type.compare_exchange_strong(expected_x_type, x_type.base());
 
-#if LOFTY_HOST_API_POSIX
+#if LOFTY_COROUTINE_ASM_CONTEXT
+   // The terminated coroutine’s context will never be resumed, so it doesn’t matter where it’s saved.
+   context_t terminated_ctx;
+   lofty_coroutine_switch_context(&terminated_ctx, default_return_ctx.get());
+#elif LOFTY_HOST_API_POSIX
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wdeprecated-declarations"
    #endif
-   ::setcontext(default_return_uctx.get());
+   ::setcontext(default_return_ctx.get());
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic pop
    #endif
@@ -1079,10 +2512,29 @@ void coroutine::scheduler::return_to_scheduler(exception::common_type x_type) {
 }
 
 void coroutine::scheduler::run() {
+#if LOFTY_HOST_API_POSIX
+   /* Unless the thread already has one, give it an alternate stack for signal handlers, so that the fault
+   caused by a coroutine overflowing its stack can be handled (see handle_stack_guard_fault()). */
+   memory::pages_ptr signal_stack;
+   {
+      ::stack_t ss;
+      if (::sigaltstack(nullptr, &ss) == 0 && (ss.ss_flags & SS_DISABLE)) {
+         signal_stack = memory::pages_ptr(static_cast<std::size_t>(SIGSTKSZ));
+         ss.ss_sp = signal_stack.get();
+         ss.ss_size = signal_stack.size();
+         ss.ss_flags = 0;
+         if (::sigaltstack(&ss, nullptr) < 0) {
+            exception::throw_os_error();
+         }
+      }
+   }
+#endif
+   worker * w = claim_worker();
+   active_worker = w;
    LOFTY_TRY {
 #if LOFTY_HOST_API_POSIX
-      ::ucontext_t thread_uctx;
-      default_return_uctx = &thread_uctx;
+      context_t thread_ctx;
+      default_return_ctx = &thread_ctx;
 #elif LOFTY_HOST_API_WIN32
       void * pfbr = ::ConvertThreadToFiber(nullptr);
       if (!pfbr) {
@@ -1103,13 +2555,123 @@ void coroutine::scheduler::run() {
       }
    } LOFTY_FINALLY {
 #if LOFTY_HOST_API_POSIX
-      default_return_uctx = nullptr;
+      default_return_ctx = nullptr;
+      if (signal_stack.get()) {
+         ::stack_t ss;
+         memory::clear(&ss);
+         ss.ss_flags = SS_DISABLE;
+         ::sigaltstack(&ss, nullptr);
+      }
 #elif LOFTY_HOST_API_WIN32
       ::ConvertFiberToThread();
 #endif
+      active_worker = nullptr;
+      if (w) {
+         release_worker(w);
+      }
    };
 }
 
+#if LOFTY_HOST_API_POSIX
+bool coroutine::scheduler::run_blocking_io(_std::function<void ()> const & fn) {
+   impl * coro_pimpl = active_coro_pimpl;
+   if (!coro_pimpl || max_blocking_io_threads == 0) {
+      return false;
+   }
+   // Deliver any interruptions that arrived while the coroutine was running, instead of blocking.
+   coro_pimpl->interruption_point();
+   blocking_io_job job;
+   job.next = nullptr;
+   job.fn = &fn;
+   job.coro_pimpl = coro_pimpl;
+   job.completed.store(false);
+   {
+      _std::unique_lock<_std::mutex> lock(blocking_io_mutex);
+      while (blocking_io_jobs_size >= max_blocking_io_jobs) {
+         /* The threads are not keeping up; wait for one of them to dequeue a job. This slows down the
+         coroutines that keep queuing jobs, without stalling every other coroutine on this thread. */
+         blocking_io_space_waiter waiter;
+         waiter.prev = last_blocking_io_space_waiter;
+         waiter.next = nullptr;
+         if (waiter.prev) {
+            waiter.prev->next = &waiter;
+         } else {
+            first_blocking_io_space_waiter = &waiter;
+         }
+         last_blocking_io_space_waiter = &waiter;
+         if (!park_active(&waiter.parked, &lock)) {
+            // Interrupted; blocking_io_thread() didn’t unlink waiter, so do it here.
+            if (waiter.prev) {
+               waiter.prev->next = waiter.next;
+            } else {
+               first_blocking_io_space_waiter = waiter.next;
+            }
+            if (waiter.next) {
+               waiter.next->prev = waiter.prev;
+            } else {
+               last_blocking_io_space_waiter = waiter.prev;
+            }
+            coro_pimpl->interruption_point();
+         }
+      }
+      if (
+         idle_blocking_io_threads_size <= blocking_io_jobs_size &&
+         blocking_io_threads.size() < max_blocking_io_threads
+      ) {
+         // No idle thread will be left to pick up this job, so start a new one.
+         blocking_io_threads.push_back(::pthread_t());
+         /* Block the signals reserved for the main thread while the new thread inherits the signal mask of
+         this one, then restore them back. */
+         ::sigset_t blocked_sigset, orig_sigset;
+         sigemptyset(&blocked_sigset);
+         sigaddset(&blocked_sigset, SIGINT);
+         sigaddset(&blocked_sigset, SIGTERM);
+         ::pthread_sigmask(SIG_BLOCK, &blocked_sigset, &orig_sigset);
+         int err = ::pthread_create(
+            &blocking_io_threads.back(), nullptr, &blocking_io_thread_static, this
+         );
+         ::pthread_sigmask(SIG_SETMASK, &orig_sigset, nullptr);
+         if (err) {
+            blocking_io_threads.pop_back();
+            // Any threads started earlier will still run the job.
+            if (blocking_io_threads.size() == 0) {
+               exception::throw_os_error(err);
+            }
+         }
+      }
+      if (last_blocking_io_job) {
+         last_blocking_io_job->next = &job;
+      } else {
+         first_blocking_io_job = &job;
+      }
+      last_blocking_io_job = &job;
+      ++blocking_io_jobs_size;
+   }
+   ::pthread_cond_signal(&blocking_io_cond);
+
+   /* Wait for the job to complete. Since fn may refer to memory owned by the caller, this can’t be cut short
+   by an interruption, which will only be delivered afterwards. */
+   bool woken_early = false;
+   for (;;) {
+      active_coro_pimpl = nullptr;
+      switch_to_scheduler(coro_pimpl, false);
+      // After returning from that, active_coro_pimpl == coro_pimpl again.
+      if (job.completed.load()) {
+         break;
+      }
+      woken_early = true;
+   }
+   if (woken_early) {
+      // See the similar code in perform_uring_op().
+      _std::lock_guard<_std::mutex> lock(blocking_io_mutex);
+      coro_pimpl->discard_notification();
+   }
+   coro_pimpl->interruption_point();
+   errno = job.err;
+   return true;
+}
+#endif
+
 #if LOFTY_HOST_API_WIN32
 void coroutine::scheduler::setup_non_iocp_events() {
    event_semaphore_fd = io::filedesc(::CreateSemaphore(nullptr, 0, numeric::max< ::LONG>::value, nullptr));
@@ -1131,18 +2693,37 @@ void coroutine::scheduler::setup_non_iocp_events() {
 }
 #endif
 
-void coroutine::scheduler::switch_to_scheduler(impl * last_active_coro_pimpl) {
-#if LOFTY_HOST_API_POSIX
+#if LOFTY_HOST_API_LINUX
+void coroutine::scheduler::submit_uring_ops(bool force) {
+   if (unsubmitted_uring_ops_size.load() == 0) {
+      return;
+   }
+   if (!force && uring_deferred_activations.fetch_add(1) + 1 < max_uring_deferred_activations) {
+      return;
+   }
+   _std::lock_guard<_std::mutex> lock(uring_mutex);
+   uring_deferred_activations.store(0);
+   ring.submit();
+   unsubmitted_uring_ops_size.store(ring.unsubmitted_size());
+   // Operations that could be completed right away already have their completions posted.
+   reap_uring_completions();
+}
+#endif
+
+void coroutine::scheduler::switch_to_scheduler(impl * last_active_coro_pimpl, bool interruptible) {
+#if LOFTY_COROUTINE_ASM_CONTEXT
+   lofty_coroutine_switch_context(last_active_coro_pimpl->context_ptr(), default_return_ctx.get());
+#elif LOFTY_HOST_API_POSIX
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wdeprecated-declarations"
    #endif
-   if (::swapcontext(last_active_coro_pimpl->ucontext_ptr(), default_return_uctx.get()) < 0) {
+   if (::swapcontext(last_active_coro_pimpl->context_ptr(), default_return_ctx.get()) < 0) {
    #if LOFTY_HOST_API_DARWIN && LOFTY_HOST_CXX_CLANG
       #pragma clang diagnostic pop
    #endif
       /* TODO: only a stack-related ENOMEM is possible, so throw a stack overflow exception
-      (*default_return_uctx has a problem, not *active_coro_pimpl). */
+      (*default_return_ctx has a problem, not *active_coro_pimpl). */
    }
 #elif LOFTY_HOST_API_WIN32
    ::SwitchToFiber(return_fiber.get());
@@ -1150,7 +2731,14 @@ void coroutine::scheduler::switch_to_scheduler(impl * last_active_coro_pimpl) {
    #error "TODO: HOST_API"
 #endif
    // Now that we’re back to the coroutine, check for any pending interruptions.
-   last_active_coro_pimpl->interruption_point();
+   if (interruptible) {
+      last_active_coro_pimpl->interruption_point();
+   }
+}
+
+coroutine::scheduler::worker * coroutine::scheduler::this_worker() const {
+   worker * w = active_worker;
+   return w && w->owner == this ? w : nullptr;
 }
 
 void coroutine::scheduler::trigger_event(event_id_t event_id) {
@@ -1171,7 +2759,22 @@ void coroutine::scheduler::trigger_event(event_id_t event_id) {
 #elif LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
    {
       _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
-      ready_events_queue.push_back(event_id);
+      auto blocked_coro_itr(coros_blocked_by_event.find(event_id));
+      if (blocked_coro_itr == coros_blocked_by_event.cend()) {
+         // Nobody is waiting for the event yet; let the first waiter skip waiting.
+         unwaited_events.add_or_assign(event_id, true);
+         return;
+      }
+      impl * coro_pimpl = blocked_coro_itr->value;
+      coros_blocked_by_event.remove(blocked_coro_itr);
+      // Make the coroutine aware that it’s no longer waiting for the event.
+      coro_pimpl->blocking_event_id = 0;
+      /* Only a coroutine that this makes ready can be linked into ready_events_queue; otherwise it’s already
+      queued, or it’s still running and will be queued again by park(). */
+      if (!coro_pimpl->notify()) {
+         return;
+      }
+      ready_events_queue.push_back(coro_pimpl);
    }
    #if LOFTY_HOST_API_LINUX
       std::uint64_t one = 1;
@@ -1185,26 +2788,180 @@ void coroutine::scheduler::trigger_event(event_id_t event_id) {
 }
 
 #if LOFTY_HOST_API_LINUX || LOFTY_HOST_API_WIN32
-_std::shared_ptr<coroutine::impl> coroutine::scheduler::unblock_by_first_event() {
-   if (!ready_events_queue) {
-      // This is probably bad, but there’s nothing we can do about it here. Maybe log it?
-      return nullptr;
+void coroutine::scheduler::unblock_by_expired_timers() {
+   /* The timer may fire more than once for the same sleep end, or fire after the coroutines it was armed for
+   have been unblocked by other means, so check which sleeps have actually ended instead of assuming that
+   any did. */
+   timer_fd_sleep_end = timer_wheel::never;
+   auto t = coros_blocked_by_timer_fd.advance(current_time());
+   while (t) {
+      /* Each timer lives in the stack frame of its coroutine, which may resume as soon as add_ready() is
+      called, so take everything needed from the timer before that. */
+      auto next_t = t->next;
+      auto coro_pimpl = t->coro_pimpl;
+      // Make the coroutine aware that it’s no longer waiting for the timer.
+      coro_pimpl->blocking_time_millisecs = 0;
+      add_ready(coro_pimpl);
+      t = next_t;
    }
-   auto event_id = ready_events_queue.pop_front();
-   auto blocked_coro_itr(coros_blocked_by_event.find(event_id));
-   if (blocked_coro_itr == coros_blocked_by_event.cend()) {
-      // The event must’ve been triggered with no coroutines waiting for it.
-      unwaited_events.add_or_assign(event_id, true);
-      return nullptr;
+   arm_timer_for_next_sleep_end();
+}
+#endif
+
+bool coroutine::scheduler::unblock_by_fd(fd_io_key fdiok) {
+   // Remove the coroutine that was waiting for this file descriptor.
+   auto blocked_coro_itr(coros_blocked_by_fd.find(fdiok.pack));
+   if (blocked_coro_itr == coros_blocked_by_fd.cend()) {
+      // Ignore this notification for an event that nobody was waiting for.
+      /* TODO: in a Win32 multithreaded scenario, the IOCP notification might arrive to a thread before the
+      coroutine blocked itself (on another thread) for the event, due to associating the fd with the IOCP
+      before blocking, which is unavoidable and necessary. To address this, requeue the event so it gets
+      another chance at being processed. It may be necessary to keep a list of handles that should be held
+      until a coroutine blocks for them. */
+      return false;
+   }
+   /* Note (WIN32 BUG?)
+   Empirical evidence shows that at this point ovl might not be a valid pointer, even if the completion key
+   (fd) returned was a valid Lofty-owned handle. I could not find any explanation for this, but as a
+   workaround, each coroutine carries a pointer to the OVERLAPPED it’s waiting on, and we can check whether
+   GetOverlappedResult() reports ERROR_IO_INCOMPLETE for it to avoid resuming the coroutine in those cases.
+   Spurious notifications seem to occur only with sockets:
+   •  TCP: when after a completed overlapped read operation, a new overlapped read is requested and
+      ReadFile() returns ERROR_IO_PENDING;
+   •  UDP: when WSASendTo() fails due to ICMP reporting that the remote server is gone, WSARecvFrom() will
+      fail for several different reasons. */
+#if LOFTY_HOST_API_WIN32
+   if (blocked_coro_itr->value->blocking_ovl.load()->get_result() == ERROR_IO_INCOMPLETE) {
+      return false;
+   }
+#endif
+   // Make ready every coroutine that was waiting for this I/O.
+   auto coro_pimpl(coros_blocked_by_fd.pop(blocked_coro_itr));
+   do {
+      auto next_coro_pimpl = coro_pimpl->next_blocked_by_fd;
+      coro_pimpl->next_blocked_by_fd = nullptr;
+      // Make the coroutine aware that it’s no longer waiting for I/O.
+      coro_pimpl->blocking_fd = io::filedesc_t_null;
+#if LOFTY_HOST_API_WIN32
+      coro_pimpl->blocking_ovl = nullptr;
+#endif
+      add_ready(coro_pimpl);
+      coro_pimpl = next_coro_pimpl;
+   } while (coro_pimpl);
+   return true;
+}
+
+#if LOFTY_HOST_API_LINUX
+void coroutine::scheduler::forget_fd(io::filedesc_t fd) {
+   _std::lock_guard<_std::mutex> lock(coros_add_remove_mutex);
+   if (registered_fds.remove_if_found(fd)) {
+      /* Closing fd would remove it from the epoll anyway, but only if it’s the last file descriptor referring
+      to the underlying file. */
+      ::epoll_ctl(engine_fd.get(), EPOLL_CTL_DEL, fd, nullptr);
+   }
+}
+
+void coroutine::scheduler::register_fd(io::filedesc_t fd) {
+   /* First wait on fd: register it for both directions, so that later waits won’t need any syscalls. Use
+   EPOLLET to avoid waking up multiple threads for each time fd becomes ready; if fd is already ready, this
+   will immediately generate an edge. */
+   ::epoll_event ee;
+   memory::clear(&ee.data);
+   ee.data.fd = fd;
+   ee.events = EPOLLET | EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP;
+   if (::epoll_ctl(engine_fd.get(), EPOLL_CTL_ADD, fd, &ee) < 0) {
+      /* EEXIST means that fd was discarded while engine_fd kept it registered, which happens if another file
+      descriptor still refers to the same file. Modifying the registration will generate an edge the same way
+      adding it would. */
+      if (errno != EEXIST || ::epoll_ctl(engine_fd.get(), EPOLL_CTL_MOD, fd, &ee) < 0) {
+         exception::throw_os_error();
+      }
+   }
+   fd_readiness fd_ready;
+   fd_ready.read = false;
+   fd_ready.write = false;
+   registered_fds.add_or_assign(fd, fd_ready);
+}
+
+void coroutine::scheduler::remove_blocked_by_fd(fd_io_key fdiok, impl * coro_pimpl) {
+   auto blocked_coro_itr(coros_blocked_by_fd.find(fdiok.pack));
+   if (blocked_coro_itr == coros_blocked_by_fd.cend()) {
+      return;
+   }
+   if (blocked_coro_itr->value == coro_pimpl) {
+      if (coro_pimpl->next_blocked_by_fd) {
+         blocked_coro_itr->value = coro_pimpl->next_blocked_by_fd;
+      } else {
+         coros_blocked_by_fd.remove(blocked_coro_itr);
+      }
+   } else {
+      impl * prev_coro_pimpl = blocked_coro_itr->value;
+      while (prev_coro_pimpl->next_blocked_by_fd && prev_coro_pimpl->next_blocked_by_fd != coro_pimpl) {
+         prev_coro_pimpl = prev_coro_pimpl->next_blocked_by_fd;
+      }
+      prev_coro_pimpl->next_blocked_by_fd = coro_pimpl->next_blocked_by_fd;
+   }
+   coro_pimpl->next_blocked_by_fd = nullptr;
+}
+
+void coroutine::scheduler::unblock_by_fd_events(io::filedesc_t fd, std::uint32_t events) {
+   auto registered_fd_itr(registered_fds.find(fd));
+   if (registered_fd_itr == registered_fds.cend()) {
+      // The fd was closed after this notification was generated.
+      return;
+   }
+   fd_io_key fdiok;
+   fdiok.pack = 0;
+   fdiok.s.fd = fd;
+   // Errors and hang-ups must wake both readers and writers, so they can get an error from the I/O call.
+   if (events & (EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      fdiok.s.write = false;
+      if (!unblock_by_fd(fdiok)) {
+         registered_fd_itr->value.read = true;
+      }
+   }
+   if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+      fdiok.s.write = true;
+      if (!unblock_by_fd(fdiok)) {
+         registered_fd_itr->value.write = true;
+      }
    }
-   auto coro_pimpl(_std::move(blocked_coro_itr->value));
-   coros_blocked_by_event.remove(blocked_coro_itr);
-   // Make the coroutine aware that it’s no longer waiting for the event.
-   coro_pimpl->blocking_event_id = 0;
-   return _std::move(coro_pimpl);
 }
 #endif
 
+void coroutine::scheduler::unpark(parked_coroutine * parked) {
+   parked->unparked = true;
+   add_ready(parked->coro_pimpl);
+}
+
+void coroutine::scheduler::wake_idle_worker() {
+   if (idle_workers_size.load() == 0) {
+      return;
+   }
+   bool expected = false;
+   if (!wakeup_pending.compare_exchange_strong(expected, true)) {
+      // Another thread is already being woken up; it will wake up the next one if necessary.
+      return;
+   }
+#if LOFTY_HOST_API_BSD
+   struct ::kevent ke;
+   ke.ident = 0;
+   ke.filter = EVFILT_USER;
+   // See comments in trigger_event().
+   ke.flags = EV_ENABLE;
+   ke.fflags = NOTE_TRIGGER;
+   ::kevent(engine_fd.get(), &ke, 1, nullptr, 0, nullptr);
+#elif LOFTY_HOST_API_LINUX
+   std::uint64_t one = 1;
+   ::write(wakeup_fd.get(), &one, sizeof one);
+#elif LOFTY_HOST_API_WIN32
+   // Use *this as the completion key, since it can’t be confused with any handle.
+   ::PostQueuedCompletionStatus(engine_fd.get(), 0, reinterpret_cast< ::ULONG_PTR>(this), nullptr);
+#else
+   #error "TODO: HOST_API"
+#endif
+}
+
 // Now this can be defined.
 
 /*static*/ void coroutine::impl::outer_main(void * p) {
@@ -1230,6 +2987,7 @@ _std::shared_ptr<coroutine::impl> coroutine::scheduler::unblock_by_first_event()
       curr_join_event_ptr->trigger();
    }
 
+   this_pimpl->state.store(state_terminated);
    this_thread::coroutine_scheduler()->return_to_scheduler(x_type);
 }
 
@@ -1244,14 +3002,34 @@ coroutine::id_type id() {
 }
 
 void interruption_point() {
-   if (
-      _std::shared_ptr<coroutine::impl> const & active_coro_pimpl_ = coroutine::scheduler::active_coro_pimpl
-   ) {
+   if (coroutine::impl * active_coro_pimpl_ = coroutine::scheduler::active_coro_pimpl) {
       active_coro_pimpl_->interruption_point();
    }
    this_thread::interruption_point();
 }
 
+#if LOFTY_HOST_API_LINUX
+bool perform_uring_op(io::uring_op * op, unsigned timeout_millisecs) {
+   if (auto & coro_sched = this_thread::coroutine_scheduler()) {
+      return coro_sched->perform_uring_op(op, timeout_millisecs);
+   } else {
+      return false;
+   }
+}
+#endif
+
+void run_blocking_io(_std::function<void ()> const & fn) {
+#if LOFTY_HOST_API_POSIX
+   if (auto & coro_sched = this_thread::coroutine_scheduler()) {
+      if (coro_sched->run_blocking_io(fn)) {
+         return;
+      }
+   }
+#endif
+   // Win32 coroutines perform file I/O asynchronously via the IOCP, so there’s no need for other threads.
+   fn();
+}
+
 void sleep_for_ms(unsigned millisecs) {
    if (auto & coro_sched = this_thread::coroutine_scheduler()) {
       coro_sched->block_active(
@@ -219,6 +219,12 @@ void exception::_before_throw(source_file_address const & source_file_addr_) {
          reg_t & code_ptr_reg = ucontext.arm_pc, & stack_ptr_reg = ucontext.arm_sp, & lr = ucontext.arm_lr;
          reg_t & r0 = ucontext.arm_r0, & r1 = ucontext.arm_r1, & r2 = ucontext.arm_r2;
       #endif
+   #elif LOFTY_HOST_ARCH_ARM64
+      #if LOFTY_HOST_API_LINUX
+         typedef unsigned long long reg_t;
+         reg_t & code_ptr_reg = ucontext.pc, & stack_ptr_reg = ucontext.sp, & lr = ucontext.regs[30];
+         reg_t & x0 = ucontext.regs[0], & x1 = ucontext.regs[1], & x2 = ucontext.regs[2];
+      #endif
    #elif LOFTY_HOST_ARCH_I386
       #if LOFTY_HOST_API_LINUX
          typedef int reg_t;
@@ -256,6 +262,13 @@ void exception::_before_throw(source_file_address const & source_file_addr_) {
    r2 = static_cast<reg_t>(arg1);
    *--stack_ptr = lr;
    lr = code_ptr_reg;
+#elif LOFTY_HOST_ARCH_ARM64
+   /* Load the arguments into x0-2, replace lr with the address of the current instruction. Unlike on ARM,
+   lr can’t be pushed because the stack must stay 16-byte aligned; throw_common_type() won’t return anyway. */
+   x0 = static_cast<reg_t>(x_type.base());
+   x1 = static_cast<reg_t>(arg0);
+   x2 = static_cast<reg_t>(arg1);
+   lr = code_ptr_reg;
 #elif LOFTY_HOST_ARCH_I386
    // Push the arguments onto the stack, push the address of the current instruction.
    *--stack_ptr = static_cast<reg_t>(arg1);
@@ -329,6 +342,10 @@ void exception::_before_throw(source_file_address const & source_file_addr_) {
          LOFTY_THROW_FROM(
             os_source_file_addr, memory::bad_pointer_alignment, (reinterpret_cast<void const *>(arg0))
          );
+      case common_type::memory_stack_overflow:
+         LOFTY_THROW_FROM(
+            os_source_file_addr, memory::stack_overflow, (reinterpret_cast<void const *>(arg0))
+         );
       default:
          // Unexpected exception type. Should never happen.
          std::abort();
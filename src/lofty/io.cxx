@@ -12,6 +12,7 @@ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Les
 more details.
 ------------------------------------------------------------------------------------------------------------*/
 
+#include <lofty/coroutine.hxx>
 #include <lofty/exception.hxx>
 #include <lofty/io.hxx>
 #include <lofty/logging.hxx>
@@ -91,6 +92,8 @@ void filedesc::bind_to_this_coroutine_scheduler_iocp() {
 #endif
 
 void filedesc::close() {
+   // Let coroutine schedulers forget about fd before the OS can reuse its number.
+   coroutine::scheduler::discard_fd(fd);
    errint_t err = 0;
 #if LOFTY_HOST_API_POSIX
    if (::close(fd)) {
@@ -119,6 +122,13 @@ void filedesc::close() {
    }
 }
 
+filedesc_t filedesc::release() {
+   coroutine::scheduler::discard_fd(fd);
+   auto old_fd = fd;
+   fd = filedesc_t_null;
+   return old_fd;
+}
+
 #if LOFTY_HOST_API_POSIX
 
 void filedesc::set_nonblocking(bool b) {
@@ -184,6 +194,22 @@ namespace lofty { namespace io {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#if LOFTY_HOST_API_LINUX
+namespace lofty { namespace io {
+
+long uring_op::syscall_result() const {
+   if (result >= 0) {
+      return result;
+   }
+   errno = -result;
+   return -1;
+}
+
+}} //namespace lofty::io
+#endif //if LOFTY_HOST_API_LINUX
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty { namespace io {
 
 /*explicit*/ error::error(errint_t err_ /*= 0*/) :
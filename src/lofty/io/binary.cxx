@@ -25,9 +25,11 @@ more details.
 #include <lofty/os.hxx>
 #include <lofty/os/path.hxx>
 #include <lofty/_std/algorithm.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/memory.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/thread.hxx>
+#include <lofty/try_finally.hxx>
 #include "binary/default_buffered.hxx"
 #include "binary/file-subclasses.hxx"
 #include "binary/_pvt/file_init_data.hxx"
@@ -35,7 +37,11 @@ more details.
    #include <errno.h> // E* errno
    #include <fcntl.h> // F_* fcntl()
    #include <sys/stat.h> // S_* stat()
+   #include <sys/uio.h> // iovec writev()
    #include <unistd.h> // *_FILENO isatty() open() pipe()
+   #if LOFTY_HOST_API_LINUX
+      #include <linux/io_uring.h> // IORING_OP_*
+   #endif
 #elif LOFTY_HOST_API_WIN32
    #include <lofty/text/str.hxx>
 #endif
@@ -68,6 +74,8 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
       switch (init_data->mode.base()) {
          case access_mode::read:
             return _std::make_shared<regular_file_istream>(init_data);
+         case access_mode::read_mapped:
+            return _std::make_shared<mapped_file_istream>(init_data);
          case access_mode::write:
          case access_mode::write_append:
             return _std::make_shared<regular_file_ostream>(init_data);
@@ -78,6 +86,7 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
    if (S_ISCHR(init_data->stat.st_mode) && ::isatty(init_data->fd.get())) {
       switch (init_data->mode.base()) {
          case access_mode::read:
+         case access_mode::read_mapped:
             return _std::make_shared<tty_istream>(init_data);
          case access_mode::write:
             return _std::make_shared<tty_ostream>(init_data);
@@ -91,6 +100,7 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
    if (S_ISFIFO(init_data->stat.st_mode) || S_ISSOCK(init_data->stat.st_mode)) {
       switch (init_data->mode.base()) {
          case access_mode::read:
+         case access_mode::read_mapped:
             return _std::make_shared<pipe_istream>(init_data);
          case access_mode::write:
             return _std::make_shared<pipe_ostream>(init_data);
@@ -116,6 +126,7 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
          if (::GetConsoleMode(init_data->fd.get(), &console_mode)) {
             switch (init_data->mode.base()) {
                case access_mode::read:
+               case access_mode::read_mapped:
                   return _std::make_shared<tty_istream>(init_data);
                case access_mode::write:
                   return _std::make_shared<tty_ostream>(init_data);
@@ -133,6 +144,8 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
          switch (init_data->mode.base()) {
             case access_mode::read:
                return _std::make_shared<regular_file_istream>(init_data);
+            case access_mode::read_mapped:
+               return _std::make_shared<mapped_file_istream>(init_data);
             case access_mode::write:
             case access_mode::write_append:
                return _std::make_shared<regular_file_ostream>(init_data);
@@ -145,6 +158,7 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
          // Socket or pipe.
          switch (init_data->mode.base()) {
             case access_mode::read:
+            case access_mode::read_mapped:
                return _std::make_shared<pipe_istream>(init_data);
             case access_mode::write:
                return _std::make_shared<pipe_ostream>(init_data);
@@ -172,6 +186,7 @@ static _std::shared_ptr<file_stream> _construct(_pvt::file_init_data * init_data
    // If a file object was not returned in the code above, return a generic file.
    switch (init_data->mode.base()) {
       case access_mode::read:
+      case access_mode::read_mapped:
          return _std::make_shared<file_istream>(init_data);
       case access_mode::write:
          return _std::make_shared<file_ostream>(init_data);
@@ -203,23 +218,27 @@ static _std::shared_ptr<file_stream> _attach(filedesc && fd, access_mode mode) {
 
 _LOFTY_PUBNS_BEGIN
 
-LOFTY_SYM _std::shared_ptr<buffered_istream> buffer_istream(_std::shared_ptr<istream> bin_istream) {
+LOFTY_SYM _std::shared_ptr<buffered_istream> buffer_istream(
+   _std::shared_ptr<istream> bin_istream, std::size_t buf_size /*= 0*/
+) {
    // See if *bin_istream is also a binary::buffered_istream.
    if (auto buf_bin_istream = _std::dynamic_pointer_cast<buffered_istream>(bin_istream)) {
       return _std::move(buf_bin_istream);
    } else {
       // Add a buffering wrapper to *bin_istream.
-      return _std::make_shared<default_buffered_istream>(_std::move(bin_istream));
+      return _std::make_shared<default_buffered_istream>(_std::move(bin_istream), buf_size);
    }
 }
 
-LOFTY_SYM _std::shared_ptr<buffered_ostream> buffer_ostream(_std::shared_ptr<ostream> bin_ostream) {
+LOFTY_SYM _std::shared_ptr<buffered_ostream> buffer_ostream(
+   _std::shared_ptr<ostream> bin_ostream, std::size_t buf_size /*= 0*/
+) {
    // See if *bin_ostream is also a binary::buffered_ostream.
    if (auto buf_bin_ostream = _std::dynamic_pointer_cast<buffered_ostream>(bin_ostream)) {
       return _std::move(buf_bin_ostream);
    } else {
       // Add a buffering wrapper to *bin_ostream.
-      return _std::make_shared<default_buffered_ostream>(_std::move(bin_ostream));
+      return _std::make_shared<default_buffered_ostream>(_std::move(bin_ostream), buf_size);
    }
 }
 
@@ -254,6 +273,7 @@ _std::shared_ptr<file_stream> open(os::path const & path, access_mode mode, bool
    int flags;
    switch (mode.base()) {
       case access_mode::read:
+      case access_mode::read_mapped:
          flags = O_RDONLY;
          break;
       case access_mode::read_write:
@@ -275,8 +295,19 @@ _std::shared_ptr<file_stream> open(os::path const & path, access_mode mode, bool
          flags |= O_DIRECT;
       }
    #endif
-   // Note: this does not compare the new fd against 0; instead it calls init_data.fd.operator bool().
-   while (!(init_data.fd = filedesc(::open(path.os_str().c_str(), flags, 0666)))) {
+   auto os_path(path.os_str().c_str());
+   filedesc_t new_fd;
+   /* Opening a file may require the OS to read from a slow disk; if possible, let a blocking I/O thread wait
+   for it instead of this one. */
+   _std::function<void ()> open_fn([&os_path, flags, &new_fd] () {
+      new_fd = ::open(os_path, flags, 0666);
+   });
+   for (;;) {
+      this_coroutine::run_blocking_io(open_fn);
+      // Note: this does not compare the new fd against 0; instead it calls init_data.fd.operator bool().
+      if ((init_data.fd = filedesc(new_fd))) {
+         break;
+      }
       int err = errno;
       switch (err) {
          case EINTR:
@@ -307,6 +338,7 @@ _std::shared_ptr<file_stream> open(os::path const & path, access_mode mode, bool
    ::DWORD access, sharing, action, flags = FILE_ATTRIBUTE_NORMAL;
    switch (mode.base()) {
       case access_mode::read:
+      case access_mode::read_mapped:
          access = GENERIC_READ;
          sharing = FILE_SHARE_READ | FILE_SHARE_WRITE;
          action = OPEN_EXISTING;
@@ -456,6 +488,16 @@ ostream::ostream() {
 /*virtual*/ ostream::~ostream() {
 }
 
+/*virtual*/ std::size_t ostream::write_vectored(
+   buffer_range<void const> const * ranges, std::size_t ranges_size
+) {
+   std::size_t written_size = 0;
+   for (; ranges_size; ++ranges, --ranges_size) {
+      written_size += write_bytes(ranges->ptr, ranges->size);
+   }
+   return written_size;
+}
+
 }}} //namespace lofty::io::binary
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -523,6 +565,19 @@ buffered_ostream::buffered_ostream() {
    return src_size;
 }
 
+/*virtual*/ void buffered_ostream::write_bytes_by_ref(
+   void const * src, std::size_t src_size, _std::function<void ()> written_fn
+) {
+   LOFTY_TRY {
+      write_bytes(src, src_size);
+   } LOFTY_FINALLY {
+      // The bytes have been copied into the buffer, so src is no longer needed.
+      if (written_fn) {
+         written_fn();
+      }
+   };
+}
+
 }}} //namespace lofty::io::binary
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -559,9 +614,14 @@ file_istream::file_istream(_pvt::file_init_data * init_data) :
 #if LOFTY_HOST_API_POSIX
    // This may repeat in case of EINTR.
    for (;;) {
-      ::ssize_t bytes_read = ::read(
-         fd.get(), dst, _std::min<std::size_t>(dst_max, numeric::max< ::ssize_t>::value)
-      );
+      std::size_t bytes_to_read = _std::min<std::size_t>(dst_max, numeric::max< ::ssize_t>::value);
+   #if LOFTY_HOST_API_LINUX
+      io::uring_op op(IORING_OP_READ, fd.get(), dst, bytes_to_read);
+      ::ssize_t bytes_read = this_coroutine::perform_uring_op(&op, 0 /*TODO: timeout*/)
+         ? op.syscall_result() : ::read(fd.get(), dst, bytes_to_read);
+   #else
+      ::ssize_t bytes_read = ::read(fd.get(), dst, bytes_to_read);
+   #endif
       if (bytes_read >= 0) {
          this_coroutine::interruption_point();
          return static_cast<std::size_t>(bytes_read);
@@ -693,7 +753,13 @@ file_ostream::file_ostream(_pvt::file_init_data * init_data) :
    // This may repeat in case of EINTR or in case ::write() couldn’t write all the bytes.
    for (;;) {
       std::size_t bytes_to_write = _std::min<std::size_t>(src_size, numeric::max< ::ssize_t>::value);
+   #if LOFTY_HOST_API_LINUX
+      io::uring_op op(IORING_OP_WRITE, fd.get(), const_cast<std::int8_t *>(src_bytes), bytes_to_write);
+      ::ssize_t bytes_written = this_coroutine::perform_uring_op(&op, 0 /*TODO: timeout*/)
+         ? op.syscall_result() : ::write(fd.get(), src_bytes, bytes_to_write);
+   #else
       ::ssize_t bytes_written = ::write(fd.get(), src_bytes, bytes_to_write);
+   #endif
       if (bytes_written >= 0) {
          src_bytes += bytes_written;
          src_size -= static_cast<std::size_t>(bytes_written);
@@ -757,6 +823,95 @@ file_ostream::file_ostream(_pvt::file_init_data * init_data) :
    return static_cast<std::size_t>(src_bytes - static_cast<std::int8_t const *>(src));
 }
 
+/*virtual*/ std::size_t file_ostream::write_vectored(
+   buffer_range<void const> const * ranges, std::size_t ranges_size
+) /*override*/ {
+#if LOFTY_HOST_API_POSIX
+   return writev_ranges(ranges, ranges_size, false);
+#elif LOFTY_HOST_API_WIN32
+   /* ::WriteFileGather() requires unbuffered I/O and page-sized, page-aligned buffers, so it can’t be used
+   for arbitrary ranges. */
+   return ostream::write_vectored(ranges, ranges_size);
+#else
+   #error "TODO: HOST_API"
+#endif
+}
+
+#if LOFTY_HOST_API_POSIX
+std::size_t file_ostream::writev_ranges(
+   buffer_range<void const> const * ranges, std::size_t ranges_size, bool blocking
+) {
+   // POSIX only guarantees IOV_MAX >= 16, but all supported hosts allow at least 1024 ::iovec’s per call.
+   static std::size_t const iovs_max = 64;
+   ::iovec iovs[iovs_max];
+   ::iovec * iov;
+   std::size_t iovs_size;
+   ::ssize_t bytes_written;
+   _std::function<void ()> writev_fn([this, &iov, &iovs_size, &bytes_written] () {
+      bytes_written = ::writev(fd.get(), iov, static_cast<int>(iovs_size));
+   });
+   std::size_t written_size = 0;
+   while (ranges_size) {
+      // Load the next batch of ranges, skipping empty ones.
+      iovs_size = 0;
+      for (; ranges_size && iovs_size < iovs_max; ++ranges, --ranges_size) {
+         if (ranges->size) {
+            iovs[iovs_size].iov_base = const_cast<void *>(ranges->ptr);
+            iovs[iovs_size].iov_len = ranges->size;
+            ++iovs_size;
+         }
+      }
+      iov = iovs;
+      // This may repeat in case of EINTR or in case ::writev() couldn’t write all the bytes.
+      while (iovs_size) {
+   #if LOFTY_HOST_API_LINUX
+         io::uring_op op(IORING_OP_WRITEV, fd.get(), iov, iovs_size);
+         if (this_coroutine::perform_uring_op(&op, 0 /*TODO: timeout*/)) {
+            bytes_written = op.syscall_result();
+         } else
+   #endif
+         if (blocking) {
+            // ::writev() never fails with EAGAIN on a regular file, so this is the only way to not block.
+            this_coroutine::run_blocking_io(writev_fn);
+         } else {
+            writev_fn();
+         }
+         if (bytes_written >= 0) {
+            written_size += static_cast<std::size_t>(bytes_written);
+            // Skip the ranges that were written completely, and shorten the one that was written partially.
+            std::size_t iov_written_size = static_cast<std::size_t>(bytes_written);
+            while (iovs_size && iov_written_size >= iov->iov_len) {
+               iov_written_size -= iov->iov_len;
+               ++iov;
+               --iovs_size;
+            }
+            if (iov_written_size) {
+               iov->iov_base = static_cast<std::int8_t *>(iov->iov_base) + iov_written_size;
+               iov->iov_len -= iov_written_size;
+            }
+         } else {
+            int err = errno;
+            switch (err) {
+               case EINTR:
+                  this_coroutine::interruption_point();
+                  break;
+               case EAGAIN:
+   #if EWOULDBLOCK != EAGAIN
+               case EWOULDBLOCK:
+   #endif
+                  this_coroutine::sleep_until_fd_ready(fd.get(), true /*write*/, 0 /*TODO: timeout*/);
+                  break;
+               default:
+                  exception::throw_os_error(err);
+            }
+         }
+      }
+   }
+   this_coroutine::interruption_point();
+   return written_size;
+}
+#endif
+
 }}} //namespace lofty::io::binary
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,10 +13,15 @@ more details.
 ------------------------------------------------------------------------------------------------------------*/
 
 #include <lofty/bitmanip.hxx>
+#include <lofty/collections/vector.hxx>
 #include <lofty/exception.hxx>
 #include <lofty/io/binary.hxx>
+#include <lofty/io/binary/buffer.hxx>
 #include <lofty/logging.hxx>
+#include <lofty/_std/algorithm.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/try_finally.hxx>
 #include "default_buffered.hxx"
@@ -24,13 +29,119 @@ more details.
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace io { namespace binary { namespace _pvt {
+
+std::size_t const adaptive_buffer_size::max_size;
+unsigned const adaptive_buffer_size::saturated_transfers_before_growth;
+
+adaptive_buffer_size::adaptive_buffer_size(stream const * bin_stream, std::size_t fixed_size) :
+   size(fixed_size),
+   saturated_transfers(0),
+   adaptive(fixed_size == 0) {
+   if (adaptive) {
+      if (dynamic_cast<tty_file_stream const *>(bin_stream)) {
+         size = 0x1000;
+      } else if (
+         dynamic_cast<pipe_istream const *>(bin_stream) || dynamic_cast<pipe_ostream const *>(bin_stream)
+      ) {
+         size = 0x10000;
+      } else if (auto reg_file_stream = dynamic_cast<regular_file_stream const *>(bin_stream)) {
+         size = _std::min(
+            bitmanip::ceiling_to_pow2(_std::max<std::size_t>(0x10000, reg_file_stream->preferred_io_size())),
+            max_size
+         );
+      } else {
+         // Unknown stream type; start small, and let the size adapt.
+         size = 0x1000;
+      }
+   }
+}
+
+bool adaptive_buffer_size::record_transfer(bool saturated) {
+   if (!saturated) {
+      saturated_transfers = 0;
+      return false;
+   }
+   if (!adaptive || size >= max_size || ++saturated_transfers < saturated_transfers_before_growth) {
+      return false;
+   }
+   size = _std::min(size * 2, max_size);
+   saturated_transfers = 0;
+   return true;
+}
+
+}}}} //namespace lofty::io::binary::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace binary { namespace _pvt {
+
+std::size_t const buffer_pool::min_size;
+buffer buffer_pool::buffers[buffer_pool::size_classes][buffer_pool::max_buffers_per_class];
+unsigned buffer_pool::buffers_sizes[buffer_pool::size_classes];
+_std::mutex buffer_pool::mutex;
+
+/*static*/ buffer buffer_pool::acquire(std::size_t size) {
+   if (size < min_size) {
+      size = min_size;
+   } else if (size <= adaptive_buffer_size::max_size) {
+      size = bitmanip::ceiling_to_pow2(size);
+   }
+   unsigned size_class = size_class_index(size);
+   if (size_class < size_classes) {
+      _std::lock_guard<_std::mutex> lock(mutex);
+      if (unsigned & class_buffers_size = buffers_sizes[size_class]) {
+         // Reuse the most recently pooled buffer, which is the most likely to still be in cache.
+         return _std::move(buffers[size_class][--class_buffers_size]);
+      }
+   }
+   return buffer(size);
+}
+
+/*static*/ void buffer_pool::recycle(buffer && buf) {
+   unsigned size_class = size_class_index(buf.size());
+   if (size_class < size_classes) {
+      // Discard the contents of the buffer.
+      buf.mark_as_unused(buf.used_size());
+      buf.make_unused_available();
+      _std::lock_guard<_std::mutex> lock(mutex);
+      unsigned & class_buffers_size = buffers_sizes[size_class];
+      if (class_buffers_size < max_buffers_per_class) {
+         buffers[size_class][class_buffers_size++] = _std::move(buf);
+      }
+   }
+   // If buf was not moved to buffers, it will be released by its owner.
+}
+
+/*static*/ unsigned buffer_pool::size_class_index(std::size_t size) {
+   unsigned size_class = 0;
+   for (std::size_t class_size = min_size; class_size < size; class_size <<= 1) {
+      ++size_class;
+   }
+   if (size_class >= size_classes || (min_size << size_class) != size) {
+      // Not a pooled size.
+      return size_classes;
+   }
+   return size_class;
+}
+
+}}}} //namespace lofty::io::binary::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty { namespace io { namespace binary {
 
-default_buffered_istream::default_buffered_istream(_std::shared_ptr<istream> bin_istream_) :
-   bin_istream(_std::move(bin_istream_)) {
+std::size_t const default_buffered_istream::read_buf_increment_size;
+
+default_buffered_istream::default_buffered_istream(
+   _std::shared_ptr<istream> bin_istream_, std::size_t buf_size /*= 0*/
+) :
+   bin_istream(_std::move(bin_istream_)),
+   read_buf_size(bin_istream.get(), buf_size) {
 }
 
 /*virtual*/ default_buffered_istream::~default_buffered_istream() {
+   _pvt::buffer_pool::recycle(_std::move(read_buf));
 }
 
 /*virtual*/ void default_buffered_istream::consume_bytes(std::size_t count) /*override*/ {
@@ -48,24 +159,33 @@ default_buffered_istream::default_buffered_istream(_std::shared_ptr<istream> bin
       // The caller wants more data than what’s currently in the buffer: try to load more.
       std::size_t read_byte_size_min = count - read_buf.used_size();
       if (read_byte_size_min > read_buf.available_size()) {
-         /* The buffer doesn’t have enough available space to hold the data that needs to be read; see if
-         compacting it would create enough room. */
-         if (read_buf.unused_size() + read_buf.available_size() >= read_byte_size_min) {
-            read_buf.make_unused_available();
+         std::size_t new_read_buf_size = _std::max(
+            read_buf_size.get(), bitmanip::ceiling_to_pow2_multiple(count, read_buf_increment_size)
+         );
+         if (read_buf.size() == 0) {
+            read_buf = _pvt::buffer_pool::acquire(new_read_buf_size);
          } else {
-            // Not enough room; the buffer needs to be enlarged.
-            std::size_t read_buf_size = bitmanip::ceiling_to_pow2_multiple(count, read_buf_default_size);
-            read_buf.expand_to(read_buf_size);
+            /* The buffer doesn’t have enough available space to hold the data that needs to be read; compact
+            it, and enlarge it if that doesn’t create enough room or if it’s due to grow. */
+            read_buf.make_unused_available();
+            if (read_buf.size() < new_read_buf_size) {
+               read_buf.expand_to(new_read_buf_size);
+            }
          }
       }
       // Try to fill the available part of the buffer.
-      std::size_t bytes_read = bin_istream->read_bytes(read_buf.get_available(), read_buf.available_size());
+      std::size_t available_size = read_buf.available_size();
+      std::size_t bytes_read = bin_istream->read_bytes(read_buf.get_available(), available_size);
       if (bytes_read == 0) {
          // No more data available (EOF).
          break;
       }
       // Account for the additional data read.
       read_buf.mark_as_used(bytes_read);
+      // Reads into a small leftover portion of the buffer say little about the stream; ignore them.
+      if (available_size >= read_buf.size() / 2) {
+         read_buf_size.record_transfer(bytes_read == available_size);
+      }
    }
    // Return the “used window” of the buffer.
    return buffer_range<void const>(read_buf.get_used(), read_buf.used_size());
@@ -81,8 +201,15 @@ default_buffered_istream::default_buffered_istream(_std::shared_ptr<istream> bin
 
 namespace lofty { namespace io { namespace binary {
 
-default_buffered_ostream::default_buffered_ostream(_std::shared_ptr<ostream> bin_ostream_) :
+std::size_t const default_buffered_ostream::write_buf_increment_size;
+std::size_t const default_buffered_ostream::queue_max_size;
+
+default_buffered_ostream::default_buffered_ostream(
+   _std::shared_ptr<ostream> bin_ostream_, std::size_t buf_size /*= 0*/
+) :
    bin_ostream(_std::move(bin_ostream_)),
+   queued_buf_size(0),
+   write_buf_size(bin_ostream.get(), buf_size),
    // Disable buffering for console (interactive) files.
    flush_after_commit(_std::dynamic_pointer_cast<tty_ostream>(bin_ostream) != nullptr) {
 }
@@ -90,12 +217,15 @@ default_buffered_ostream::default_buffered_ostream(_std::shared_ptr<ostream> bin
 /*virtual*/ default_buffered_ostream::~default_buffered_ostream() {
    /* Verify that the write buffer is empty. If that’s not the case, the caller neglected to verify that
    write_buf and the OS write buffer were flushed successfully. */
-   if (write_buf.used_size()) {
+   if (write_buf.used_size() || queue) {
       LOFTY_LOG(
          err, LOFTY_SL("instance of {} @ {} being destructed before close() was invoked on it\n"),
          typeid(*this), this
       );
+      // Let the owners of any queued bytes know that they’re no longer needed.
+      release_queue();
    }
+   _pvt::buffer_pool::recycle(_std::move(write_buf));
 }
 
 /*virtual*/ void default_buffered_ostream::commit_bytes(std::size_t count) /*override*/ {
@@ -138,12 +268,25 @@ default_buffered_ostream::default_buffered_ostream(_std::shared_ptr<ostream> bin
 }
 
 void default_buffered_ostream::flush_buffer() {
-   if (std::size_t buf_used_size = write_buf.used_size()) {
+   std::size_t buf_used_size = write_buf.used_size();
+   if (queue) {
+      write_queue();
+   } else if (buf_used_size) {
       /* TODO: if *bin_ostream expects writes of an integer multiple of its block size but the buffer is not
       100% full, do something – maybe truncate bin_ostream afterwards if possible? */
       std::size_t written_size = bin_ostream->write_bytes(write_buf.get_used(), buf_used_size);
       LOFTY_ASSERT(written_size == buf_used_size, LOFTY_SL("the entire buffer must have been written"));
       write_buf.mark_as_unused(written_size);
+   } else {
+      return;
+   }
+   if (
+      write_buf_size.record_transfer(buf_used_size >= write_buf.size() / 2) &&
+      write_buf.size() < write_buf_size.get()
+   ) {
+      // The buffer is now empty, so instead of enlarging it, just replace it with a larger one.
+      _pvt::buffer_pool::recycle(_std::move(write_buf));
+      write_buf = _pvt::buffer_pool::acquire(write_buf_size.get());
    }
 }
 
@@ -158,8 +301,14 @@ void default_buffered_ostream::flush_buffer() {
          flush_buffer();
          write_buf.make_unused_available();
          if (count > write_buf.available_size()) {
-            std::size_t write_buf_size = bitmanip::ceiling_to_pow2_multiple(count, write_buf_default_size);
-            write_buf.expand_to(write_buf_size);
+            std::size_t new_write_buf_size = _std::max(
+               write_buf_size.get(), bitmanip::ceiling_to_pow2_multiple(count, write_buf_increment_size)
+            );
+            if (write_buf.size() == 0) {
+               write_buf = _pvt::buffer_pool::acquire(new_write_buf_size);
+            } else {
+               write_buf.expand_to(new_write_buf_size);
+            }
          }
       }
    }
@@ -167,8 +316,84 @@ void default_buffered_ostream::flush_buffer() {
    return buffer_range<void>(write_buf.get_available(), write_buf.available_size());
 }
 
+void default_buffered_ostream::queue_bytes(
+   void const * src, std::size_t src_size, _std::function<void ()> written_fn
+) {
+   // Bytes already committed to write_buf must be written before src.
+   if (std::size_t unqueued_buf_size = write_buf.used_size() - queued_buf_size) {
+      queued_bytes buf_qb;
+      buf_qb.src = nullptr;
+      buf_qb.size = unqueued_buf_size;
+      queue.push_back(_std::move(buf_qb));
+      queued_buf_size += unqueued_buf_size;
+   }
+   queued_bytes qb;
+   qb.src = src;
+   qb.size = src_size;
+   qb.written_fn = _std::move(written_fn);
+   queue.push_back(_std::move(qb));
+}
+
+void default_buffered_ostream::release_queue() {
+   LOFTY_FOR_EACH(auto & qb, queue) {
+      if (qb.written_fn) {
+         qb.written_fn();
+      }
+   }
+   queue.clear();
+   queued_buf_size = 0;
+}
+
 /*virtual*/ _std::shared_ptr<stream> default_buffered_ostream::_unbuffered_stream() const /*override*/ {
    return _std::static_pointer_cast<stream>(bin_ostream);
 }
 
+/*virtual*/ std::size_t default_buffered_ostream::write_bytes(
+   void const * src, std::size_t src_size
+) /*override*/ {
+   if (src_size < write_buf_size.get()) {
+      return buffered_ostream::write_bytes(src, src_size);
+   }
+   // Copying src would take at least a whole buffer; write it right after the buffer contents instead.
+   queue_bytes(src, src_size, nullptr);
+   flush_buffer();
+   return src_size;
+}
+
+/*virtual*/ void default_buffered_ostream::write_bytes_by_ref(
+   void const * src, std::size_t src_size, _std::function<void ()> written_fn
+) /*override*/ {
+   queue_bytes(src, src_size, _std::move(written_fn));
+   if (flush_after_commit || queue.size() >= queue_max_size) {
+      flush_buffer();
+   }
+}
+
+void default_buffered_ostream::write_queue() {
+   // Translate the queue into byte ranges, taking the bytes in write_buf in order.
+   collections::vector<buffer_range<void const>, queue_max_size> ranges;
+   auto buf_bytes = write_buf.get_used();
+   LOFTY_FOR_EACH(auto const & qb, queue) {
+      if (qb.src) {
+         ranges.push_back(buffer_range<void const>(qb.src, qb.size));
+      } else {
+         ranges.push_back(buffer_range<void const>(buf_bytes, qb.size));
+         buf_bytes += qb.size;
+      }
+   }
+   if (std::size_t unqueued_buf_size = write_buf.used_size() - queued_buf_size) {
+      ranges.push_back(buffer_range<void const>(buf_bytes, unqueued_buf_size));
+   }
+   try {
+      bin_ostream->write_vectored(ranges.data(), ranges.size());
+   } catch (...) {
+      // Without the queued bytes, the contents of write_buf can’t be written in order; consider both lost.
+      write_buf.mark_as_unused(write_buf.used_size());
+      release_queue();
+      throw;
+   }
+   write_buf.mark_as_unused(write_buf.used_size());
+   release_queue();
+}
+
 }}} //namespace lofty::io::binary
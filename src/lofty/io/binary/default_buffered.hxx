@@ -22,10 +22,127 @@ more details.
 #ifndef _LOFTY_IO_BINARY_DEFAULT_BUFFERED_HXX_NOPUB
 #define _LOFTY_IO_BINARY_DEFAULT_BUFFERED_HXX_NOPUB
 
+#include <lofty/collections/vector.hxx>
 #include <lofty/io/binary.hxx>
 #include <lofty/io/binary/buffer.hxx>
 #include <lofty/noncopyable.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/memory.hxx>
+#include <lofty/_std/mutex.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace binary { namespace _pvt {
+
+/*! Size of the buffer of a default_buffered_istream or default_buffered_ostream.
+
+The initial size depends on the type of the stream being buffered: terminals get small buffers, since they’re
+interactive; pipes and sockets get buffers as large as the default Linux pipe capacity; regular files get
+buffers of at least the same size, rounded up to the preferred I/O size for the file system. After that, the
+size doubles (up to max_size) whenever several consecutive transfers with the underlying stream use the whole
+buffer, since that indicates that the stream could move more bytes per system call. */
+class adaptive_buffer_size {
+public:
+   //! Maximum size the buffer can grow to.
+   static std::size_t const max_size = 0x40000;
+   //! Count of consecutive saturated transfers after which the buffer will grow.
+   static unsigned const saturated_transfers_before_growth = 4;
+
+public:
+   /*! Constructor.
+
+   @param bin_stream
+      Stream being buffered.
+   @param fixed_size
+      Buffer size specified by the caller, or 0 to pick one based on the type of *bin_stream and adapt it to
+      the observed transfer sizes.
+   */
+   adaptive_buffer_size(_LOFTY_PUBNS stream const * bin_stream, std::size_t fixed_size);
+
+   /*! Returns the current buffer size.
+
+   @return
+      Size of the buffer, in bytes.
+   */
+   std::size_t get() const {
+      return size;
+   }
+
+   /*! Records the outcome of a transfer between the buffer and the underlying stream.
+
+   @param saturated
+      true if the transfer used the whole buffer (a read filled it, or a write emptied a full buffer), or
+      false otherwise.
+   @return
+      true if the buffer size was just increased, or false otherwise.
+   */
+   bool record_transfer(bool saturated);
+
+private:
+   //! Current buffer size.
+   std::size_t size;
+   //! Count of consecutive saturated transfers.
+   unsigned saturated_transfers;
+   //! If false, the buffer size was specified by the caller and will not change.
+   bool adaptive;
+};
+
+}}}} //namespace lofty::io::binary::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace binary { namespace _pvt {
+
+/*! Keeps the buffers of destructed default_buffered_istream and default_buffered_ostream instances for reuse,
+so that short-lived streams (such as those for a single network connection) don’t each need to allocate new
+buffers. Only buffers whose size is a power of 2 between min_size and adaptive_buffer_size::max_size are
+pooled, and only a few of each size. */
+class buffer_pool {
+public:
+   //! Size of the smallest pooled buffers.
+   static std::size_t const min_size = 0x1000;
+
+public:
+   /*! Returns a buffer of at least the requested size, reusing a pooled one if possible.
+
+   @param size
+      Minimum size of the buffer, in bytes.
+   @return
+      Empty buffer.
+   */
+   static _LOFTY_PUBNS buffer acquire(std::size_t size);
+
+   /*! Stores a buffer in the pool for reuse, or releases it if it can’t be pooled.
+
+   @param buf
+      Buffer to recycle; its contents will be discarded.
+   */
+   static void recycle(_LOFTY_PUBNS buffer && buf);
+
+private:
+   /*! Returns the index of the pool slots for a given buffer size.
+
+   @param size
+      Buffer size, in bytes.
+   @return
+      Index of the slots for the size, or size_classes if buffers of this size are not pooled.
+   */
+   static unsigned size_class_index(std::size_t size);
+
+private:
+   //! Count of pooled buffer sizes: powers of 2 from min_size to adaptive_buffer_size::max_size.
+   static unsigned const size_classes = 7;
+   //! Maximum count of pooled buffers of each size.
+   static unsigned const max_buffers_per_class = 4;
+   //! Pooled buffers, by size.
+   static _LOFTY_PUBNS buffer buffers[size_classes][max_buffers_per_class];
+   //! Count of pooled buffers of each size.
+   static unsigned buffers_sizes[size_classes];
+   //! Governs access to buffers and buffers_sizes.
+   static _std::_LOFTY_PUBNS mutex mutex;
+};
+
+}}}} //namespace lofty::io::binary::_pvt
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -38,8 +155,10 @@ public:
 
    @param bin_istream
       Pointer to a buffered istream to wrap.
+   @param buf_size
+      Size of the read buffer, or 0 to have it adapt to *bin_istream.
    */
-   default_buffered_istream(_std::_LOFTY_PUBNS shared_ptr<istream> bin_istream);
+   default_buffered_istream(_std::_LOFTY_PUBNS shared_ptr<istream> bin_istream, std::size_t buf_size = 0);
 
    //! Destructor.
    virtual ~default_buffered_istream();
@@ -59,9 +178,10 @@ protected:
    _std::_LOFTY_PUBNS shared_ptr<istream> bin_istream;
    //! Main read buffer.
    buffer read_buf;
-   //! Default/increment size of read_buf.
-   // TODO: tune this value.
-   static std::size_t const read_buf_default_size = 0x1000;
+   //! Size read_buf is allocated with.
+   _pvt::adaptive_buffer_size read_buf_size;
+   //! Increment size of read_buf, when a peek_bytes() call needs more than read_buf_size bytes.
+   static std::size_t const read_buf_increment_size = 0x1000;
 };
 
 }}}} //namespace lofty::io::binary::_pub
@@ -77,8 +197,10 @@ public:
 
    @param bin_ostream
       Pointer to a buffered output stream to wrap.
+   @param buf_size
+      Size of the write buffer, or 0 to have it adapt to *bin_ostream.
    */
-   default_buffered_ostream(_std::_LOFTY_PUBNS shared_ptr<ostream> bin_ostream);
+   default_buffered_ostream(_std::_LOFTY_PUBNS shared_ptr<ostream> bin_ostream, std::size_t buf_size = 0);
 
    //! Destructor.
    virtual ~default_buffered_ostream();
@@ -95,23 +217,69 @@ public:
    //! See buffered_ostream::get_buffer_bytes().
    virtual buffer_range<void> get_buffer_bytes(std::size_t count) override;
 
+   /*! See buffered_ostream::write_bytes(). Overridden to avoid copying arrays at least as large as the
+   buffer, writing them along with the buffer contents instead. */
+   virtual std::size_t write_bytes(void const * src, std::size_t src_size) override;
+
+   /*! See buffered_ostream::write_bytes_by_ref(). Overridden to queue the source buffer, so that the next
+   flush will write it along with the buffer contents, with a single vectored write. */
+   virtual void write_bytes_by_ref(
+      void const * src, std::size_t src_size, _std::_LOFTY_PUBNS function<void ()> written_fn
+   ) override;
+
+protected:
+   //! Array of bytes queued for writing by write_bytes_by_ref().
+   struct queued_bytes {
+      //! Pointer to the bytes, or nullptr for bytes in write_buf that must precede the next element.
+      void const * src;
+      //! Count of bytes.
+      std::size_t size;
+      //! Function to invoke once src is no longer needed.
+      _std::_LOFTY_PUBNS function<void ()> written_fn;
+   };
+
 protected:
-   //! Flushes the internal write buffer.
+   //! Flushes the internal write buffer, as well as any queued bytes.
    void flush_buffer();
 
+   /*! Adds an array of bytes to the queue, after any bytes in write_buf that are not yet queued.
+
+   @param src
+      Address of the source buffer.
+   @param src_size
+      Size of the source buffer, in bytes.
+   @param written_fn
+      Function to invoke once src is no longer needed.
+   */
+   void queue_bytes(void const * src, std::size_t src_size, _std::_LOFTY_PUBNS function<void ()> written_fn);
+
+   //! Empties the queue, invoking the function associated to each element.
+   void release_queue();
+
    //! See buffered_ostream::_unbuffered_stream().
    virtual _std::_LOFTY_PUBNS shared_ptr<stream> _unbuffered_stream() const override;
 
+   /*! Writes the queue and the rest of write_buf with a single vectored write, then releases the queue. If
+   the write fails, the contents of write_buf are discarded along with the queue. */
+   void write_queue();
+
 protected:
    //! Wrapped binary ostream.
    _std::_LOFTY_PUBNS shared_ptr<ostream> bin_ostream;
    //! Write buffer.
    buffer write_buf;
+   //! Arrays of bytes to be written on the next flush, in order, followed by the rest of write_buf.
+   collections::_LOFTY_PUBNS vector<queued_bytes> queue;
+   //! Count of bytes in write_buf that are covered by elements of queue.
+   std::size_t queued_buf_size;
+   //! Size write_buf is allocated with.
+   _pvt::adaptive_buffer_size write_buf_size;
    //! If true, every commit_bytes() call will flush the buffer.
    bool flush_after_commit:1;
-   //! Default/increment size of write_buf.
-   // TODO: tune this value.
-   static std::size_t const write_buf_default_size = 0x1000;
+   //! Increment size of write_buf, when a get_buffer_bytes() call needs more than write_buf_size bytes.
+   static std::size_t const write_buf_increment_size = 0x1000;
+   //! Count of elements in queue that causes write_bytes_by_ref() to flush, rather than wait for a flush.
+   static std::size_t const queue_max_size = 32;
 };
 
 }}}} //namespace lofty::io::binary::_pub
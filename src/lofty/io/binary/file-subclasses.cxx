@@ -16,15 +16,24 @@ more details.
 #include <lofty/exception.hxx>
 #include <lofty/io.hxx>
 #include <lofty/io/binary.hxx>
+#include <lofty/memory.hxx>
 #include <lofty/numeric.hxx>
 #include <lofty/text.hxx>
 #include <lofty/thread.hxx>
+#include <lofty/_std/memory.hxx>
 #include "_pvt/file_init_data.hxx"
 #include "file-subclasses.hxx"
 #include <climits> // CHAR_BIT
 #if LOFTY_HOST_API_POSIX
+   #include <lofty/_std/algorithm.hxx>
+   #include <lofty/_std/functional.hxx>
+   #include <errno.h> // EINTR EINVAL errno
+   #include <sys/mman.h> // madvise() mmap() munmap()
    #include <sys/stat.h> // stat fstat()
-   #include <unistd.h> // lseek()
+   #include <unistd.h> // fsync() lseek() read() write()
+   #if LOFTY_HOST_API_LINUX
+      #include <linux/io_uring.h> // IORING_OP_*
+   #endif
 #elif LOFTY_HOST_API_WIN32
    #include <lofty/_std/algorithm.hxx>
    #include <lofty/text/char_traits.hxx>
@@ -375,6 +384,14 @@ namespace lofty { namespace io { namespace binary {
 
 regular_file_stream::regular_file_stream(_pvt::file_init_data * init_data) :
    file_stream(init_data) {
+#if LOFTY_HOST_API_POSIX
+   preferred_io_size_ = static_cast<std::size_t>(init_data->stat.st_blksize);
+#elif LOFTY_HOST_API_WIN32
+   // Windows doesn’t report this; use the most commonly used cluster size.
+   preferred_io_size_ = 4096;
+#else
+   #error "TODO: HOST_API"
+#endif
 #if 0
 #if LOFTY_HOST_API_POSIX
    if (init_data->bypass_cache) {
@@ -510,6 +527,250 @@ regular_file_istream::regular_file_istream(_pvt::file_init_data * init_data) :
 /*virtual*/ regular_file_istream::~regular_file_istream() {
 }
 
+#if LOFTY_HOST_API_POSIX
+/*virtual*/ std::size_t regular_file_istream::read_bytes(void * dst, std::size_t dst_max) /*override*/ {
+   std::size_t bytes_to_read = _std::min<std::size_t>(dst_max, numeric::max< ::ssize_t>::value);
+   ::ssize_t bytes_read;
+   // ::read() never fails with EAGAIN on a regular file, so this is the only way to not block this thread.
+   _std::function<void ()> read_fn([this, dst, bytes_to_read, &bytes_read] () {
+      bytes_read = ::read(fd.get(), dst, bytes_to_read);
+   });
+   // This may repeat in case of EINTR.
+   for (;;) {
+   #if LOFTY_HOST_API_LINUX
+      // If the scheduler has an io_uring, the OS can read the file asynchronously, without another thread.
+      io::uring_op op(IORING_OP_READ, fd.get(), dst, bytes_to_read);
+      if (this_coroutine::perform_uring_op(&op, 0 /*TODO: timeout*/)) {
+         bytes_read = op.syscall_result();
+      } else
+   #endif
+      {
+         this_coroutine::run_blocking_io(read_fn);
+      }
+      if (bytes_read >= 0) {
+         this_coroutine::interruption_point();
+         return static_cast<std::size_t>(bytes_read);
+      }
+      int err = errno;
+      if (err != EINTR) {
+         exception::throw_os_error(err);
+      }
+      this_coroutine::interruption_point();
+   }
+}
+#endif
+
+}}} //namespace lofty::io::binary
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace binary {
+
+/*! Returns the alignment required for the file offset of a mapped window.
+
+@return
+   Mapping granularity, in bytes. Always a power of 2.
+*/
+static std::size_t get_map_granularity() {
+#if LOFTY_HOST_API_POSIX
+   return memory::page_size();
+#elif LOFTY_HOST_API_WIN32
+   // Views of a file mapping must start at a multiple of the allocation granularity, not just of a page.
+   ::SYSTEM_INFO si;
+   ::GetSystemInfo(&si);
+   return si.dwAllocationGranularity;
+#else
+   #error "TODO: HOST_API"
+#endif
+}
+
+std::size_t const mapped_file_istream::window_max_size;
+std::size_t const mapped_file_istream::prefetch_size;
+
+mapped_file_istream::mapped_file_istream(_pvt::file_init_data * init_data) :
+   file_stream(init_data),
+   regular_file_stream(init_data),
+#if LOFTY_HOST_API_WIN32
+   mapping(nullptr),
+#endif
+   window(nullptr),
+   window_size(0),
+   window_offset(0),
+   prefetched_offset(0),
+   offset(0),
+   file_size(regular_file_stream::size()) {
+#if LOFTY_HOST_API_WIN32
+   // Empty files can’t be mapped, but there would be nothing to map anyway.
+   if (file_size > 0) {
+      mapping = ::CreateFileMapping(fd.get(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mapping) {
+         exception::throw_os_error();
+      }
+   }
+#endif
+}
+
+/*virtual*/ mapped_file_istream::~mapped_file_istream() {
+   unmap_window();
+#if LOFTY_HOST_API_WIN32
+   if (mapping) {
+      ::CloseHandle(mapping);
+   }
+#endif
+}
+
+/*virtual*/ void mapped_file_istream::consume_bytes(std::size_t count) /*override*/ {
+   if (count > file_size - offset) {
+      // Can’t consume more bytes than are left in the file.
+      // TODO: use a better exception class.
+      LOFTY_THROW(argument_error, ());
+   }
+   // The bytes are already in memory, so there’s nothing to do other than moving past them.
+   offset += count;
+}
+
+void mapped_file_istream::map_window(std::size_t count) {
+   unmap_window();
+   // Windows must start at a multiple of the mapping granularity.
+   full_size_t new_window_offset = offset & ~static_cast<full_size_t>(get_map_granularity() - 1);
+   /* Make the window as large as allowed, to minimize remapping, but enough to include all the requested
+   bytes, and not past the end of the file. */
+   full_size_t new_window_size = _std::min<full_size_t>(
+      _std::max<full_size_t>(window_max_size, offset - new_window_offset + count),
+      file_size - new_window_offset
+   );
+   if (new_window_size > numeric::max<std::size_t>::value) {
+      // Only possible if std::size_t is narrower than full_size_t; the caller will get fewer bytes.
+      new_window_size = numeric::max<std::size_t>::value;
+   }
+   if (new_window_size > 0) {
+#if LOFTY_HOST_API_POSIX
+      void * ptr = ::mmap(
+         nullptr, static_cast<std::size_t>(new_window_size), PROT_READ, MAP_SHARED, fd.get(),
+         static_cast< ::off_t>(new_window_offset)
+      );
+      if (ptr == MAP_FAILED) {
+         exception::throw_os_error();
+      }
+      /* Let the OS know that the window will be read front to back, so it can read ahead more aggressively
+      and drop pages soon after they’ve been read. This is only a hint, so errors are irrelevant. */
+      ::madvise(ptr, static_cast<std::size_t>(new_window_size), MADV_SEQUENTIAL);
+#elif LOFTY_HOST_API_WIN32
+      ::LARGE_INTEGER li_offset;
+      li_offset.QuadPart = static_cast< ::LONGLONG>(new_window_offset);
+      void * ptr = ::MapViewOfFile(
+         mapping, FILE_MAP_READ, static_cast< ::DWORD>(li_offset.HighPart), li_offset.LowPart,
+         static_cast< ::SIZE_T>(new_window_size)
+      );
+      if (!ptr) {
+         exception::throw_os_error();
+      }
+#else
+   #error "TODO: HOST_API"
+#endif
+      window = static_cast<std::int8_t const *>(ptr);
+   }
+   window_offset = new_window_offset;
+   window_size = static_cast<std::size_t>(new_window_size);
+   prefetched_offset = offset;
+}
+
+/*virtual*/ buffer_range<void const> mapped_file_istream::peek_bytes(std::size_t count) /*override*/ {
+   full_size_t window_end = window_offset + window_size;
+   if (
+      offset < window_offset || offset > window_end ||
+      (count > window_end - offset && window_end < file_size)
+   ) {
+      // The read offset was moved out of the window, or the caller wants more than what’s left in it.
+      map_window(count);
+      window_end = window_offset + window_size;
+   }
+   if (window) {
+      prefetch();
+   }
+   return buffer_range<void const>(
+      window + (offset - window_offset), static_cast<std::size_t>(window_end - offset)
+   );
+}
+
+void mapped_file_istream::prefetch() {
+   full_size_t window_end = window_offset + window_size;
+   /* Ask for the next portion of the window once the read offset is within half a prefetch_size from the
+   end of the last one, so the OS has time to load it before it’s needed. */
+   if (prefetched_offset >= window_end || offset + prefetch_size / 2 < prefetched_offset) {
+      return;
+   }
+   full_size_t begin = _std::max(prefetched_offset, offset);
+   // The window starts at a page boundary, and so must the range.
+   begin -= (begin - window_offset) & (memory::page_size() - 1);
+   full_size_t end = _std::min<full_size_t>(begin + prefetch_size, window_end);
+   void * ptr = const_cast<std::int8_t *>(window + (begin - window_offset));
+   std::size_t size = static_cast<std::size_t>(end - begin);
+   // This is only a hint, so errors are irrelevant.
+#if LOFTY_HOST_API_POSIX
+   ::madvise(ptr, size, MADV_WILLNEED);
+#elif LOFTY_HOST_API_WIN32
+   #if _WIN32_WINNT >= 0x0602
+      ::WIN32_MEMORY_RANGE_ENTRY range;
+      range.VirtualAddress = ptr;
+      range.NumberOfBytes = size;
+      ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+   #else
+      LOFTY_UNUSED_ARG(ptr);
+      LOFTY_UNUSED_ARG(size);
+   #endif
+#else
+   #error "TODO: HOST_API"
+#endif
+   prefetched_offset = end;
+}
+
+/*virtual*/ offset_t mapped_file_istream::seek(offset_t offset_, seek_from whence) /*override*/ {
+   // Only the read offset moves; peek_bytes() will map a different window if necessary.
+   switch (whence.base()) {
+      case seek_from::start:
+         break;
+      case seek_from::current:
+         offset_ += static_cast<offset_t>(offset);
+         break;
+      case seek_from::end:
+         offset_ += static_cast<offset_t>(file_size);
+         break;
+   }
+   if (offset_ < 0 || offset_ > static_cast<offset_t>(file_size)) {
+      LOFTY_THROW(io::error, ());
+   }
+   offset = static_cast<full_size_t>(offset_);
+   return offset_;
+}
+
+/*virtual*/ full_size_t mapped_file_istream::size() const /*override*/ {
+   return file_size;
+}
+
+/*virtual*/ offset_t mapped_file_istream::tell() const /*override*/ {
+   return static_cast<offset_t>(offset);
+}
+
+void mapped_file_istream::unmap_window() {
+   if (window) {
+#if LOFTY_HOST_API_POSIX
+      ::munmap(const_cast<std::int8_t *>(window), window_size);
+#elif LOFTY_HOST_API_WIN32
+      ::UnmapViewOfFile(window);
+#else
+   #error "TODO: HOST_API"
+#endif
+      window = nullptr;
+      window_size = 0;
+   }
+}
+
+/*virtual*/ _std::shared_ptr<stream> mapped_file_istream::_unbuffered_stream() const /*override*/ {
+   // The mapping is the buffer, so there is no separate unbuffered stream.
+   return _std::const_pointer_cast<mapped_file_istream>(shared_from_this());
+}
+
 }}} //namespace lofty::io::binary
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -528,6 +789,85 @@ regular_file_ostream::regular_file_ostream(_pvt::file_init_data * init_data) :
 /*virtual*/ regular_file_ostream::~regular_file_ostream() {
 }
 
+#if LOFTY_HOST_API_POSIX
+/*virtual*/ void regular_file_ostream::flush() /*override*/ {
+   int ret;
+   _std::function<void ()> fsync_fn([this, &ret] () {
+      ret = ::fsync(fd.get());
+   });
+   // This may repeat in case of EINTR.
+   for (;;) {
+      this_coroutine::run_blocking_io(fsync_fn);
+      if (ret >= 0) {
+         break;
+      }
+      int err = errno;
+      if (err == EINTR) {
+         this_coroutine::interruption_point();
+      } else if (
+   #if LOFTY_HOST_API_DARWIN
+         err == ENOTSUP
+   #else
+         err == EINVAL
+   #endif
+      ) {
+         // fd.get() does not support fsync(3); ignore the error.
+         break;
+      } else {
+         exception::throw_os_error(err);
+      }
+   }
+   this_coroutine::interruption_point();
+}
+
+/*virtual*/ std::size_t regular_file_ostream::write_bytes(
+   void const * src, std::size_t src_size
+) /*override*/ {
+   std::int8_t const * src_bytes = static_cast<std::int8_t const *>(src);
+   std::size_t bytes_to_write;
+   ::ssize_t bytes_written;
+   // ::write() never fails with EAGAIN on a regular file, so this is the only way to not block this thread.
+   _std::function<void ()> write_fn([this, &src_bytes, &bytes_to_write, &bytes_written] () {
+      bytes_written = ::write(fd.get(), src_bytes, bytes_to_write);
+   });
+   // This may repeat in case of EINTR or in case ::write() couldn’t write all the bytes.
+   for (;;) {
+      bytes_to_write = _std::min<std::size_t>(src_size, numeric::max< ::ssize_t>::value);
+   #if LOFTY_HOST_API_LINUX
+      // If the scheduler has an io_uring, the OS can write the file asynchronously, without another thread.
+      io::uring_op op(IORING_OP_WRITE, fd.get(), const_cast<std::int8_t *>(src_bytes), bytes_to_write);
+      if (this_coroutine::perform_uring_op(&op, 0 /*TODO: timeout*/)) {
+         bytes_written = op.syscall_result();
+      } else
+   #endif
+      {
+         this_coroutine::run_blocking_io(write_fn);
+      }
+      if (bytes_written >= 0) {
+         src_bytes += bytes_written;
+         src_size -= static_cast<std::size_t>(bytes_written);
+         if (src_size == 0) {
+            break;
+         }
+      } else {
+         int err = errno;
+         if (err != EINTR) {
+            exception::throw_os_error(err);
+         }
+         this_coroutine::interruption_point();
+      }
+   }
+   this_coroutine::interruption_point();
+   return static_cast<std::size_t>(src_bytes - static_cast<std::int8_t const *>(src));
+}
+
+/*virtual*/ std::size_t regular_file_ostream::write_vectored(
+   buffer_range<void const> const * ranges, std::size_t ranges_size
+) /*override*/ {
+   return writev_ranges(ranges, ranges_size, true);
+}
+#endif
+
 #if LOFTY_HOST_API_WIN32
 /*virtual*/ std::size_t regular_file_ostream::write_bytes(
    void const * src, std::size_t src_size
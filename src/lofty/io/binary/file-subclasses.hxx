@@ -23,6 +23,7 @@ more details.
 #define _LOFTY_IO_BINARY_FILE_SUBCLASSES_HXX_NOPUB
 
 #include <lofty/io/binary.hxx>
+#include <lofty/_std/memory.hxx>
 #if LOFTY_HOST_API_WIN32
    #include <lofty/text/parsers/ansi_escape_sequences.hxx>
    #include <lofty/text/str.hxx>
@@ -229,6 +230,15 @@ public:
       io::_LOFTY_PUBNS offset_t offset, io::_LOFTY_PUBNS seek_from whence
    ) override;
 
+   /*! Returns the size of the I/O operations that the file system can perform most efficiently on the file.
+
+   @return
+      Preferred I/O size, in bytes.
+   */
+   std::size_t preferred_io_size() const {
+      return preferred_io_size_;
+   }
+
    //! See sized::size().
    virtual io::_LOFTY_PUBNS full_size_t size() const override;
 
@@ -240,6 +250,8 @@ protected:
    regular_file_stream(_pvt::file_init_data * init_data);
 
 protected:
+   //! Preferred size for I/O operations on the file, in bytes.
+   std::size_t preferred_io_size_;
 #if 0
    //! Physical alignment for unbuffered/direct disk access.
    unsigned physical_align;
@@ -260,6 +272,104 @@ public:
 
    //! Destructor.
    virtual ~regular_file_istream();
+
+#if LOFTY_HOST_API_POSIX
+   /*! See file_istream::read_bytes(). This override lets a blocking I/O thread wait for the OS to read from
+   the disk, since regular files can’t be waited for by the coroutine scheduler. */
+   virtual std::size_t read_bytes(void * dst, std::size_t dst_max) override;
+#endif
+};
+
+}}}}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace binary { namespace _pub {
+
+/*! Binary input stream for regular disk files, mapped in memory instead of being read into a buffer.
+
+Since the stream is buffered by the mapping itself, peek_bytes() returns ranges directly over the OS file
+cache, sparing a copy per byte and a system call per buffer. Files larger than window_max_size are mapped one
+window at a time. The size of the file is determined when the stream is created: data added to the file after
+that is not read, and truncating the file while it is mapped will cause accesses to it to fault.
+
+Unlike regular_file_istream::read_bytes(), waiting for the disk can’t be delegated to a blocking I/O thread:
+page faults on the mapping block the calling thread, coroutines included. Asking the OS to load the data ahead
+of the read offset makes this less likely. */
+class LOFTY_SYM mapped_file_istream :
+   public virtual regular_file_stream,
+   public buffered_istream,
+   public _std::_LOFTY_PUBNS enable_shared_from_this<mapped_file_istream> {
+public:
+   //! See regular_file_stream().
+   mapped_file_istream(_pvt::file_init_data * init_data);
+
+   //! Destructor.
+   virtual ~mapped_file_istream();
+
+   //! See buffered_istream::consume_bytes().
+   virtual void consume_bytes(std::size_t count) override;
+
+   //! See buffered_istream::peek_bytes().
+   virtual buffer_range<void const> peek_bytes(std::size_t count) override;
+
+   //! See regular_file_stream::seek().
+   virtual io::_LOFTY_PUBNS offset_t seek(
+      io::_LOFTY_PUBNS offset_t offset, io::_LOFTY_PUBNS seek_from whence
+   ) override;
+
+   //! See regular_file_stream::size().
+   virtual io::_LOFTY_PUBNS full_size_t size() const override;
+
+   //! See regular_file_stream::tell().
+   virtual io::_LOFTY_PUBNS offset_t tell() const override;
+
+protected:
+   //! See buffered_istream::_unbuffered_stream().
+   virtual _std::_LOFTY_PUBNS shared_ptr<stream> _unbuffered_stream() const override;
+
+private:
+   /*! Replaces the current window with one that starts at or before offset and includes at least count
+   bytes past it, or as many as the file has.
+
+   @param count
+      Count of bytes past offset that the window must include.
+   */
+   void map_window(std::size_t count);
+
+   /*! Asks the OS to start loading the portion of the window following the read offset, if it hasn’t been
+   asked already. */
+   void prefetch();
+
+   //! Releases the current window, if any.
+   void unmap_window();
+
+private:
+#if LOFTY_HOST_API_WIN32
+   //! File mapping object the windows are views of.
+   ::HANDLE mapping;
+#endif
+   //! Start of the current window; nullptr if no window is mapped.
+   std::int8_t const * window;
+   //! Size of the current window.
+   std::size_t window_size;
+   //! Offset in the file of the start of the current window.
+   io::_LOFTY_PUBNS full_size_t window_offset;
+   //! Offset in the file of the end of the portion of the window that prefetch() already covered.
+   io::_LOFTY_PUBNS full_size_t prefetched_offset;
+   //! Offset in the file of the next byte to be read.
+   io::_LOFTY_PUBNS full_size_t offset;
+   //! Size of the file at the time the stream was created.
+   io::_LOFTY_PUBNS full_size_t file_size;
+   //! Maximum size of a window, unless a single peek_bytes() call requests more.
+   static std::size_t const window_max_size =
+#if LOFTY_HOST_WORD_SIZE >= 64
+      0x40000000;
+#else
+      0x4000000;
+#endif
+   //! Size of the portion of the window that prefetch() asks the OS to load ahead of the read offset.
+   static std::size_t const prefetch_size = 0x400000;
 };
 
 }}}}
@@ -277,7 +387,20 @@ public:
    //! Destructor.
    virtual ~regular_file_ostream();
 
-#if LOFTY_HOST_API_WIN32
+#if LOFTY_HOST_API_POSIX
+   /*! See file_ostream::flush(). This override lets a blocking I/O thread wait for the OS to write to the
+   disk. */
+   virtual void flush() override;
+
+   /*! See file_ostream::write_bytes(). This override lets a blocking I/O thread wait for the OS to write to
+   the disk, since regular files can’t be waited for by the coroutine scheduler. */
+   virtual std::size_t write_bytes(void const * src, std::size_t src_size) override;
+
+   //! See file_ostream::write_vectored(). Overridden for the same reason as write_bytes().
+   virtual std::size_t write_vectored(
+      buffer_range<void const> const * ranges, std::size_t ranges_size
+   ) override;
+#elif LOFTY_HOST_API_WIN32
    //! See file_ostream::write_bytes(). This override is necessary to emulate O_APPEND under Win32.
    virtual std::size_t write_bytes(void const * src, std::size_t src_size) override;
 
@@ -326,6 +449,7 @@ public:
    using _pub::pipe_iostream;
    using _pub::regular_file_stream;
    using _pub::regular_file_istream;
+   using _pub::mapped_file_istream;
    using _pub::regular_file_ostream;
    using _pub::regular_file_iostream;
 
@@ -16,6 +16,7 @@ more details.
 #include <lofty/exception.hxx>
 #include <lofty/io/binary.hxx>
 #include <lofty/io/text.hxx>
+#include <lofty/memory.hxx>
 #include <lofty/os/path.hxx>
 #include <lofty/process.hxx>
 #include <lofty/_std/memory.hxx>
@@ -24,6 +25,7 @@ more details.
 #include <lofty/text/parsers/dynamic.hxx>
 #include <lofty/text/parsers/regex.hxx>
 #include <lofty/text/str.hxx>
+#include <lofty/text/str_traits.hxx>
 #include "binary/file-subclasses.hxx"
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -198,19 +200,69 @@ lofty::text::str istream::read_all() {
    }
 }
 
+lofty::text::char_t const * istream::find_line_terminator(
+   lofty::text::char_t const * begin, lofty::text::char_t const * end, lofty::text::char_t const * line_begin,
+   lofty::text::char_t const ** lterm_end
+) {
+   lofty::text::char_t const * lterm_begin;
+   switch (lterm.base()) {
+      case lofty::text::line_terminator::any:
+         lterm_begin = lofty::text::str_traits::find_either_char(begin, end, '\r' /*CR*/, '\n' /*LF*/);
+         if (lterm_begin == end) {
+            return nullptr;
+         }
+         *lterm_end = lterm_begin + 1;
+         if (*lterm_begin == '\r' /*CR*/) {
+            if (*lterm_end == end) {
+               // Can’t tell yet whether a LF follows; if it does, discard it on the next read.
+               discard_next_lf = true;
+            } else if (**lterm_end == '\n' /*LF*/) {
+               ++*lterm_end;
+            }
+         }
+         return lterm_begin;
+      case lofty::text::line_terminator::cr:
+         lterm_begin = lofty::text::str_traits::find_char(begin, end, lofty::text::char_t('\r' /*CR*/));
+         break;
+      case lofty::text::line_terminator::lf:
+         lterm_begin = lofty::text::str_traits::find_char(begin, end, lofty::text::char_t('\n' /*LF*/));
+         break;
+      case lofty::text::line_terminator::cr_lf:
+         // Look for LFs, ignoring those that are not preceded by a CR.
+         for (lterm_begin = begin; ; ++lterm_begin) {
+            lterm_begin = lofty::text::str_traits::find_char(
+               lterm_begin, end, lofty::text::char_t('\n' /*LF*/)
+            );
+            if (lterm_begin == end) {
+               return nullptr;
+            } else if (lterm_begin > line_begin && lterm_begin[-1] == '\r' /*CR*/) {
+               *lterm_end = lterm_begin + 1;
+               return lterm_begin - 1;
+            }
+         }
+      LOFTY_SWITCH_WITHOUT_DEFAULT
+   }
+   if (lterm_begin == end) {
+      return nullptr;
+   }
+   *lterm_end = lterm_begin + 1;
+   return lterm_begin;
+}
+
 /*virtual*/ bool istream::read_line(lofty::text::str * dst) {
    dst->clear();
    std::size_t consumed_total = 0, dst_char_size = 0;
    bool lterm_found = false;
-   lofty::text::str src;
-   // Just ask for 1 character; that’s sufficient to distinguish between EOF and non-EOF.
-   while (!lterm_found && (src = peek_chars(1))) {
-      // Resize *dst to accommodate, potentially, all of src.
-      dst->set_capacity(dst_char_size + src.size_in_chars(), true /*preserve*/);
-      // Copy characters from src to *dst, stopping at the first line terminator.
+   while (!lterm_found) {
+      /* Just ask for 1 character; that’s sufficient to distinguish between EOF and non-EOF. Use a new string
+      for each peek: assigning a view to a string that already views the same address would be treated as a
+      self-assignment, keeping the old size. */
+      lofty::text::str src(peek_chars(1));
+      if (!src) {
+         break;
+      }
       lofty::text::char_t const * src_chars = src.data(), * src_chars_end = src.data_end();
-      lofty::text::char_t * dst_chars = dst->data() + dst_char_size;
-      lofty::text::char_t const * dst_last_cr = nullptr;
+      lofty::text::char_t const * lterm_begin, * lterm_end;
       /* If the last character parsed by prior invocation of read_line() was a CR and this first character is
       a LF, skip past it. */
       if (discard_next_lf) {
@@ -219,59 +271,87 @@ lofty::text::str istream::read_all() {
             ++src_chars;
          }
       }
-      while (src_chars != src_chars_end) {
-         lofty::text::char_t src_ch = *src_chars++;
-         if (src_ch == '\r' /*CR*/) {
-            switch (lterm.base()) {
-               case lofty::text::line_terminator::any:
-                  // Make sure we’ll discard a possible following LF.
-                  discard_next_lf = true;
-                  // Fall through.
-               case lofty::text::line_terminator::cr:
-                  lterm_found = true;
-                  goto break_inner_while;
-               case lofty::text::line_terminator::cr_lf:
-                  /* Mark where we’re about to write the CR, so we can rewind to this - 1 if the next source
-                  character is LF. */
-                  dst_last_cr = dst_chars;
-                  break;
-               case lofty::text::line_terminator::lf:
-                  break;
-            }
-         } else if (src_ch == '\n' /*LF*/) {
-            switch (lterm.base()) {
-               case lofty::text::line_terminator::any:
-               case lofty::text::line_terminator::lf:
-                  lterm_found = true;
-                  goto break_inner_while;
-               case lofty::text::line_terminator::cr_lf: {
-                  /* If the previous character was a CR, dst_last_cr was set to it; in that case don’t write
-                  this LF and discard the already-written CR. */
-                  lofty::text::char_t * dst_prev_char = dst_chars - 1;
-                  if (dst_last_cr == dst_prev_char) {
-                     dst_chars = dst_prev_char;
-                     goto break_inner_while;
-                  }
-                  break;
-               }
-               case lofty::text::line_terminator::cr:
-                  break;
-            }
-         }
-         *dst_chars++ = src_ch;
+      if (
+         lterm.base() == lofty::text::line_terminator::cr_lf && src_chars != src_chars_end &&
+         *src_chars == '\n' /*LF*/ &&
+         dst_char_size > 0 && dst->data()[dst_char_size - 1] == '\r' /*CR*/
+      ) {
+         // The CR at the end of the previous peek buffer and this LF form the line terminator.
+         --dst_char_size;
+         lterm_begin = src_chars;
+         lterm_end = src_chars + 1;
+      } else {
+         lterm_begin = find_line_terminator(src_chars, src_chars_end, src_chars, &lterm_end);
+      }
+      if (lterm_begin) {
+         lterm_found = true;
+      } else {
+         lterm_begin = lterm_end = src_chars_end;
       }
-   break_inner_while:
-      if (std::size_t consumed_count = static_cast<std::size_t>(src_chars - src.data())) {
+      // Copy the line (or the portion of it in src) to *dst in one go.
+      if (std::size_t line_char_size = static_cast<std::size_t>(lterm_begin - src_chars)) {
+         dst->set_capacity(dst_char_size + line_char_size, true /*preserve*/);
+         memory::copy(dst->data() + dst_char_size, src_chars, line_char_size);
+         dst_char_size += line_char_size;
+      }
+      if (std::size_t consumed_count = static_cast<std::size_t>(lterm_end - src.data())) {
          consume_chars(consumed_count);
          consumed_total += consumed_count;
       }
-      // Save this, since the next iteration might reallocate *dst’s character array.
-      dst_char_size = static_cast<std::size_t>(dst_chars - dst->data());
    }
    dst->set_size_in_chars(dst_char_size);
    return consumed_total > 0;
 }
 
+/*virtual*/ bool istream::read_line_view(lofty::text::str * dst) {
+   std::size_t scanned_char_size = 0;
+   // Just ask for 1 character at first; that’s sufficient to distinguish between EOF and non-EOF.
+   for (std::size_t count_min = 1; ; ) {
+      /* Use a new string for each peek: assigning a view to a string that already views the same address
+      would be treated as a self-assignment, keeping the old size. */
+      lofty::text::str src(peek_chars(count_min));
+      if (!src) {
+         break;
+      }
+      lofty::text::char_t const * src_chars = src.data(), * src_chars_end = src.data_end();
+      if (discard_next_lf) {
+         discard_next_lf = false;
+         if (*src_chars == '\n' /*LF*/) {
+            // This LF completes a CR/LF pair that terminated the previous line.
+            consume_chars(1);
+            continue;
+         }
+      }
+      lofty::text::char_t const * lterm_end;
+      lofty::text::char_t const * lterm_begin = find_line_terminator(
+         src_chars + scanned_char_size, src_chars_end, src_chars, &lterm_end
+      );
+      std::size_t src_char_size = src.size_in_chars();
+      if (!lterm_begin) {
+         if (src_char_size >= count_min) {
+            /* No line terminator yet, but there might be more characters: peek again, asking for more than
+            what’s already available; when lterm is cr_lf, the last character is scanned again, since it
+            might be a CR followed by a LF. */
+            scanned_char_size = src_char_size;
+            if (lterm.base() == lofty::text::line_terminator::cr_lf) {
+               --scanned_char_size;
+            }
+            count_min = src_char_size + 1;
+            continue;
+         }
+         // EOF was reached, so the rest of the stream is the last line.
+         lterm_begin = lterm_end = src_chars_end;
+      }
+      // For the same reason, *dst must not be viewing the same address when the new view is assigned to it.
+      *dst = lofty::text::str();
+      *dst = lofty::text::str(external_buffer, src_chars, static_cast<std::size_t>(lterm_begin - src_chars));
+      consume_chars(static_cast<std::size_t>(lterm_end - src_chars));
+      return true;
+   }
+   dst->clear();
+   return false;
+}
+
 }}} //namespace lofty::io::text
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -502,3 +582,119 @@ void ostream_print_helper_impl::write_format_up_to(lofty::text::str::const_itera
 }
 
 }}}} //namespace lofty::io::text::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace io { namespace text { namespace _pvt {
+
+//! Gives prepared_format_impl access to the format string parser of ostream_print_helper_impl.
+class prepared_format_parser : public ostream_print_helper_impl {
+public:
+   //! See ostream_print_helper_impl::ostream_print_helper_impl().
+   prepared_format_parser(_pub::ostream * ostream_, lofty::text::str const & format_) :
+      ostream_print_helper_impl(ostream_, format_) {
+   }
+
+   /*! Returns the index of the argument for the replacement field found by write_format_up_to_next_repl().
+
+   @return
+      0-based argument index.
+   */
+   unsigned arg_index() const {
+      return last_used_arg_index;
+   }
+
+   /*! Returns a copy of the format specification of the replacement field found by
+   write_format_up_to_next_repl().
+
+   @return
+      Format specification.
+   */
+   lofty::text::str format_spec() const {
+      if (repl_format_spec_begin) {
+         return lofty::text::str(repl_format_spec_begin, repl_format_spec_end);
+      } else {
+         return lofty::text::str();
+      }
+   }
+
+   using ostream_print_helper_impl::throw_collections_out_of_range;
+   using ostream_print_helper_impl::write_format_up_to_next_repl;
+};
+
+struct prepared_format_impl::segment {
+   //! Characters to write before the replacement; “{{” and “}}” have already been converted.
+   lofty::text::str literal;
+   //! Index of the argument to write after literal, or no_arg for the last segment.
+   unsigned arg_index;
+   //! Instance of to_text_ostream for the argument, configured with the replacement field’s format.
+   void * ttos;
+
+   //! Value of arg_index for the last segment, which is not followed by a replacement.
+   static unsigned const no_arg = static_cast<unsigned>(-1);
+};
+
+prepared_format_impl::prepared_format_impl(
+   lofty::text::str const & format, arg_type const * arg_types_, unsigned arg_types_size
+) :
+   arg_types(arg_types_),
+   segments_size(0) {
+   // Let the parser write the literal characters between replacement fields to a string, one at a time.
+   _pub::str_ostream literal_ostream;
+   prepared_format_parser parser(&literal_ostream, format);
+   collections::_pub::vector<segment> parsed;
+   try {
+      bool more;
+      do {
+         more = parser.write_format_up_to_next_repl();
+         segment seg;
+         seg.literal = literal_ostream.release_content();
+         seg.arg_index = segment::no_arg;
+         seg.ttos = nullptr;
+         parsed.push_back(_std::move(seg));
+         if (more) {
+            unsigned arg_index = parser.arg_index();
+            if (arg_index >= arg_types_size) {
+               parser.throw_collections_out_of_range();
+            }
+            auto & last_seg = parsed.back();
+            last_seg.ttos = arg_types[arg_index].new_ttos(parser.format_spec());
+            last_seg.arg_index = arg_index;
+         }
+      } while (more);
+   } catch (...) {
+      LOFTY_FOR_EACH(auto & seg, parsed) {
+         if (seg.ttos) {
+            arg_types[seg.arg_index].delete_ttos(seg.ttos);
+         }
+      }
+      throw;
+   }
+   segments.reset(new segment[parsed.size()]);
+   LOFTY_FOR_EACH(auto & seg, parsed) {
+      segments[segments_size++] = _std::move(seg);
+   }
+}
+
+prepared_format_impl::~prepared_format_impl() {
+   for (std::size_t i = 0; i < segments_size; ++i) {
+      auto & seg = segments[i];
+      if (seg.ttos) {
+         arg_types[seg.arg_index].delete_ttos(seg.ttos);
+      }
+   }
+}
+
+void prepared_format_impl::print(_pub::ostream * dst, void const * const * args) const {
+   for (std::size_t i = 0; i < segments_size; ++i) {
+      auto const & seg = segments[i];
+      if (seg.literal) {
+         dst->write(seg.literal);
+      }
+      if (seg.ttos) {
+         arg_types[seg.arg_index].write(seg.ttos, args[seg.arg_index], dst);
+      }
+   }
+}
+
+}}}} //namespace lofty::io::text::_pvt
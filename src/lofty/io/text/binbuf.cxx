@@ -22,6 +22,7 @@ more details.
 #include <lofty/_std/memory.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/text.hxx>
+#include <lofty/text/char_traits.hxx>
 #include <lofty/text/str.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -55,6 +56,7 @@ binbuf_istream::binbuf_istream(
    istream(),
    buf_bin_istream(_std::move(buf_bin_istream_)),
    peek_buf_char_offset(0),
+   passthrough_char_size(0),
    eof(false) {
 }
 
@@ -67,6 +69,15 @@ binbuf_istream::binbuf_istream(
 }
 
 /*virtual*/ void binbuf_istream::consume_chars(std::size_t count) /*override*/ {
+   if (passthrough_char_size > 0) {
+      if (count > passthrough_char_size) {
+         // TODO: use a better exception class.
+         LOFTY_THROW(argument_error, ());
+      }
+      buf_bin_istream->consume<lofty::text::char_t>(count);
+      passthrough_char_size -= count;
+      return;
+   }
    if (count > peek_buf.size_in_chars() - peek_buf_char_offset) {
       // TODO: use a better exception class.
       LOFTY_THROW(argument_error, ());
@@ -96,12 +107,59 @@ std::size_t binbuf_istream::detect_encoding(std::uint8_t const * buf, std::size_
 }
 
 /*virtual*/ lofty::text::str binbuf_istream::peek_chars(std::size_t count_min) /*override*/ {
+#if LOFTY_HOST_UTF == 8
+   if (peek_buf_char_offset == peek_buf.size_in_chars() && !eof) {
+      /* Nothing is left in peek_buf, so if the source is valid UTF-8 there’s no need to transcode (i.e. copy)
+      it: just return a view of the binary buffer. */
+      std::size_t peek_byte_size = _std::max(count_min, std::size_t(1));
+      for (;;) {
+         auto src(buf_bin_istream->peek<std::uint8_t>(peek_byte_size));
+         if (src.size == 0) {
+            eof = true;
+            break;
+         }
+         if (default_enc == lofty::text::encoding::unknown) {
+            if (std::size_t bom_byte_size = detect_encoding(src.ptr, src.size)) {
+               // Consume the BOM that was read, then peek again.
+               buf_bin_istream->consume<std::uint8_t>(bom_byte_size);
+               continue;
+            }
+         }
+         if (default_enc != lofty::text::encoding::host) {
+            break;
+         }
+         /* Bytes handed out by the last call and not consumed yet have been validated already; this avoids
+         validating the whole buffer again for each line read. */
+         std::size_t valid_byte_size = passthrough_char_size + lofty::text::get_valid_utf8_prefix_size(
+            src.ptr + passthrough_char_size, src.size - passthrough_char_size
+         );
+         if (valid_byte_size > 0 && valid_byte_size >= count_min) {
+            passthrough_char_size = valid_byte_size;
+            return lofty::text::str(
+               external_buffer, reinterpret_cast<lofty::text::char_t const *>(src.ptr), valid_byte_size
+            );
+         }
+         /* If what follows the valid prefix might be a sequence cut short by the end of the buffer, peek more
+         bytes and try again; otherwise let transcode() deal with it (and report the error). */
+         if (
+            src.size < peek_byte_size ||
+            src.size - valid_byte_size >= lofty::text::utf8_char_traits::max_codepoint_length
+         ) {
+            break;
+         }
+         passthrough_char_size = valid_byte_size;
+         peek_byte_size = src.size + 1;
+      }
+      passthrough_char_size = 0;
+   }
+#endif
    // The peek buffer might already contain enough characters.
    std::size_t peek_buf_char_size = peek_buf.size_in_chars() - peek_buf_char_offset;
    if (peek_buf_char_size < count_min && !eof) {
-      /* Ensure the peek buffer is large enough to hold the requested count of characters or an arbitrary
-      minimum (chosen for efficiency). */
-      if (count_min > peek_buf.capacity() - peek_buf_char_offset) {
+      /* Ensure the peek buffer is large enough to hold the requested count of characters, with room for a
+      whole code point until that count is reached; otherwise transcode() could be unable to make progress. */
+      std::size_t needed_char_size = count_min + lofty::text::host_char_traits::max_codepoint_length - 1;
+      if (needed_char_size > peek_buf.capacity() - peek_buf_char_offset) {
          // If there’s any unused space in peek_buf, recover it now.
          /* TODO: might use a different strategy to decide if it’s more convenient to just allocate a bigger
          buffer based on peek_buf.capacity() vs. peek_buf_char_size, i.e. the cost of memory::realloc() vs.
@@ -114,7 +172,8 @@ std::size_t binbuf_istream::detect_encoding(std::uint8_t const * buf, std::size_
             peek_buf.set_size_in_chars(peek_buf_char_size, false /*don’t clear*/);
          }
          static std::size_t const peek_buf_char_size_min = 128;
-         std::size_t needed_capacity = _std::max(count_min, peek_buf_char_size_min);
+         // Also ensure an arbitrary minimum size, chosen for efficiency.
+         std::size_t needed_capacity = _std::max(needed_char_size, peek_buf_char_size_min);
          if (needed_capacity > peek_buf.capacity()) {
             peek_buf.set_capacity(needed_capacity, true /*preserve*/);
          }
@@ -181,10 +240,31 @@ std::size_t binbuf_istream::detect_encoding(std::uint8_t const * buf, std::size_
    }
 }
 
+/*virtual*/ bool binbuf_istream::read_line_view(lofty::text::str * dst) /*override*/ {
+   if (eof) {
+      dst->clear();
+      return false;
+   } else {
+      // This will result in calls to peek_chars(), which will set eof as appropriate.
+      istream::read_line_view(dst);
+      return true;
+   }
+}
+
 /*virtual*/ void binbuf_istream::unconsume_chars(lofty::text::str const & s) /*override*/ {
    if (std::size_t count = s.size_in_chars()) {
-      peek_buf.set_size_in_chars(count + peek_buf.size_in_chars(), false /*don’t clear*/);
-      memory::copy(peek_buf.data(), s.data(), count);
+      // Characters handed out by a passthrough peek_chars() are still in the binary buffer.
+      passthrough_char_size = 0;
+      if (count <= peek_buf_char_offset) {
+         // Reuse the space taken by characters already consumed.
+         peek_buf_char_offset -= count;
+      } else {
+         std::size_t peek_buf_char_size = peek_buf.size_in_chars() - peek_buf_char_offset;
+         peek_buf.set_size_in_chars(count + peek_buf_char_size, false /*don’t clear*/);
+         memory::move(peek_buf.data() + count, peek_buf.data() + peek_buf_char_offset, peek_buf_char_size);
+         peek_buf_char_offset = 0;
+      }
+      memory::copy(peek_buf.data() + peek_buf_char_offset, s.data(), count);
    }
 }
 
@@ -14,6 +14,8 @@ more details.
 
 #include <lofty/bitmanip.hxx>
 #include <lofty/byte_order.hxx>
+#include <lofty/channel.hxx>
+#include <lofty/collections/list.hxx>
 #include <lofty/collections/queue.hxx>
 #include <lofty/coroutine.hxx>
 #include <lofty/coroutine_local.hxx>
@@ -23,10 +25,13 @@ more details.
 #include <lofty/io.hxx>
 #include <lofty/io/text.hxx>
 #include <lofty/io/text/str.hxx>
+#include <lofty/keyed_demux.hxx>
 #include <lofty/logging.hxx>
 #include <lofty/math.hxx>
 #include <lofty/memory.hxx>
 #include <lofty/mutex.hxx>
+#include <lofty/numeric.hxx>
+#include <lofty/_std/atomic.hxx>
 #include <lofty/_std/exception.hxx>
 #include <lofty/_std/memory.hxx>
 #include <lofty/_std/mutex.hxx>
@@ -36,6 +41,7 @@ more details.
 #include <lofty/text/parsers/regex.hxx>
 #include <lofty/text/str.hxx>
 #include <lofty/thread.hxx>
+#include <lofty/thread_local.hxx>
 #include <lofty/to_text_ostream.hxx>
 #include <lofty/type_void_adapter.hxx>
 #include "coroutine-scheduler.hxx"
@@ -76,6 +82,188 @@ extern "C" ::BOOL WINAPI DllMain(::HINSTANCE hinst, ::DWORD reason, void * reser
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace _pvt {
+
+struct channel_impl::waiter {
+   //! Previous waiter in the list.
+   waiter * prev;
+   //! Next waiter in the list.
+   waiter * next;
+   //! Scheduler of the waiting coroutine, or nullptr if a thread is waiting.
+   coroutine::scheduler * coro_sched;
+   //! Tracks the waiting coroutine. Its unparked member is also used to track threads being woken up.
+   coroutine::scheduler::parked_coroutine parked;
+   //! Event the waiting thread is blocked on (thread mode only).
+   event * thread_event;
+};
+
+/*explicit*/ channel_impl::channel_impl(std::size_t max_size_) :
+   elements_capacity(0),
+   first_index(0),
+   elements_size(0),
+   max_size(max_size_),
+   closed_(false) {
+   receivers.first = receivers.last = nullptr;
+   senders.first = senders.last = nullptr;
+}
+
+channel_impl::~channel_impl() {
+}
+
+void channel_impl::close() {
+   _std::unique_lock<_std::mutex> lock(mutex);
+   closed_ = true;
+   wake(&receivers, numeric::max<std::size_t>::value);
+   wake(&senders, numeric::max<std::size_t>::value);
+}
+
+bool channel_impl::closed() const {
+   _std::unique_lock<_std::mutex> lock(mutex);
+   return closed_;
+}
+
+void channel_impl::destruct_elements(type_void_adapter const & type) {
+   auto ring = static_cast<std::int8_t *>(elements.get());
+   std::size_t mask = elements_capacity - 1;
+   for (std::size_t i = 0; i < elements_size; ++i) {
+      type.destruct(ring + ((first_index + i) & mask) * type.size());
+   }
+   elements_size = 0;
+}
+
+void channel_impl::grow(type_void_adapter const & type) {
+   std::size_t new_capacity;
+   if (elements_capacity) {
+      new_capacity = elements_capacity * 2;
+   } else {
+      // Start small; bounded channels will never need more than the smallest power of 2 >= max_size.
+      new_capacity = max_size && max_size < 16 ? bitmanip::ceiling_to_pow2(max_size) : 16;
+   }
+   auto new_elements(memory::alloc_bytes_unique(new_capacity * type.size()));
+   // Move the elements to the new buffer, unwrapping the ring so that the first element has index 0.
+   auto ring = static_cast<std::int8_t *>(elements.get());
+   auto new_ring = static_cast<std::int8_t *>(new_elements.get());
+   std::size_t mask = elements_capacity - 1;
+   for (std::size_t i = 0; i < elements_size; ++i) {
+      void * src = ring + ((first_index + i) & mask) * type.size();
+      type.move_construct(new_ring + i * type.size(), src);
+      type.destruct(src);
+   }
+   elements = _std::move(new_elements);
+   elements_capacity = new_capacity;
+   first_index = 0;
+}
+
+std::size_t channel_impl::size() const {
+   _std::unique_lock<_std::mutex> lock(mutex);
+   return elements_size;
+}
+
+/*static*/ void channel_impl::unlink(waiter_list * list, waiter * w) {
+   if (w->prev) {
+      w->prev->next = w->next;
+   } else {
+      list->first = w->next;
+   }
+   if (w->next) {
+      w->next->prev = w->prev;
+   } else {
+      list->last = w->prev;
+   }
+}
+
+void channel_impl::wait(waiter_list * list, _std::unique_lock<_std::mutex> * lock) {
+   // Deliver any pending interruptions before joining the list.
+   this_coroutine::interruption_point();
+   waiter w;
+   event thread_event(event::manual_create);
+   if (this_coroutine::id()) {
+      w.coro_sched = this_thread::coroutine_scheduler().get();
+      w.thread_event = nullptr;
+   } else {
+      // Create the event before joining the list, so that a failure won’t leave w in it.
+      w.coro_sched = nullptr;
+      thread_event.create();
+      w.thread_event = &thread_event;
+   }
+   w.prev = list->last;
+   w.next = nullptr;
+   w.parked.unparked = false;
+   if (list->last) {
+      list->last->next = &w;
+   } else {
+      list->first = &w;
+   }
+   list->last = &w;
+
+   if (w.coro_sched) {
+      if (!w.coro_sched->park_active(&w.parked, lock)) {
+         // The coroutine was interrupted while still in the list.
+         unlink(list, &w);
+         this_coroutine::interruption_point();
+      }
+   } else {
+      lock->unlock();
+      try {
+         thread_event.wait();
+      } catch (...) {
+         lock->lock();
+         if (w.parked.unparked) {
+            // This thread was woken up, but won’t act on it; pass the wakeup on to the next waiter.
+            wake(list, 1);
+         } else {
+            unlink(list, &w);
+         }
+         throw;
+      }
+      lock->lock();
+   }
+}
+
+bool channel_impl::wait_for_elements(_std::unique_lock<_std::mutex> * lock) {
+   while (elements_size == 0) {
+      if (closed_) {
+         return false;
+      }
+      wait(&receivers, lock);
+   }
+   return true;
+}
+
+bool channel_impl::wait_for_space(_std::unique_lock<_std::mutex> * lock) {
+   for (;;) {
+      if (closed_) {
+         return false;
+      }
+      if (max_size == 0 || elements_size < max_size) {
+         return true;
+      }
+      wait(&senders, lock);
+   }
+}
+
+/*static*/ void channel_impl::wake(waiter_list * list, std::size_t count) {
+   while (count-- && list->first) {
+      waiter * w = list->first;
+      list->first = w->next;
+      if (list->first) {
+         list->first->prev = nullptr;
+      } else {
+         list->last = nullptr;
+      }
+      if (w->coro_sched) {
+         w->coro_sched->unpark(&w->parked);
+      } else {
+         w->parked.unparked = true;
+         w->thread_event->trigger();
+      }
+   }
+}
+
+}} //namespace lofty::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty {
 
 event::manual_create_t const event::manual_create;
@@ -226,13 +414,564 @@ void event::wait(unsigned timeout_millisecs /*= 0*/) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace _pvt {
+
+struct keyed_demux_impl::waiter {
+   //! Next waiter in the same bucket.
+   waiter * next;
+   //! Hash of *key.
+   std::size_t key_hash;
+   //! Key being waited for.
+   void const * key;
+   //! Storage for the value, in the stack frame of the waiter.
+   void * value;
+   //! Scheduler of the waiting coroutine, or nullptr if a thread is waiting.
+   coroutine::scheduler * coro_sched;
+   //! Tracks the waiting coroutine. Its unparked member is also set when waking up wait_event’s waiter.
+   coroutine::scheduler::parked_coroutine parked;
+   //! Event the waiter is blocked on (timed waits and threads only), or nullptr if parked.
+   event * wait_event;
+   //! true if a value was moved to *value, or false if the waiter was woken up because the source ended.
+   bool delivered;
+};
+
+struct keyed_demux_impl::shard {
+   //! Count of shards in a keyed_demux_impl. Must be a power of 2.
+   static std::size_t const shards_size = 64;
+
+   //! Guards the other members.
+   _std::mutex mutex;
+   //! Chains of waiters, by key hash.
+   _std::unique_ptr<waiter *[]> buckets;
+   //! Count of elements in buckets. Always 0 or a power of 2.
+   std::size_t buckets_size;
+   //! Count of waiters linked in buckets.
+   std::size_t waiters_size;
+   //! true if the source has ended.
+   bool ended;
+
+   //! Default constructor.
+   shard() :
+      buckets_size(0),
+      waiters_size(0),
+      ended(false) {
+   }
+
+   /*! Returns the bucket for the given key hash.
+
+   @param key_hash
+      Hash of the key.
+   @return
+      Pointer to the head of the chain of waiters.
+   */
+   waiter ** bucket_for(std::size_t key_hash) {
+      // The lower bits of the hash were used to select the shard.
+      return &buckets[(key_hash / shards_size) & (buckets_size - 1)];
+   }
+
+   //! Doubles the count of buckets, moving each waiter to its new bucket.
+   void grow() {
+      std::size_t old_buckets_size = buckets_size;
+      _std::unique_ptr<waiter *[]> old_buckets(_std::move(buckets));
+      buckets_size = old_buckets_size ? old_buckets_size * 2 : 8;
+      buckets.reset(new waiter *[buckets_size]);
+      for (std::size_t i = 0; i < buckets_size; ++i) {
+         buckets[i] = nullptr;
+      }
+      for (std::size_t i = 0; i < old_buckets_size; ++i) {
+         while (waiter * w = old_buckets[i]) {
+            old_buckets[i] = w->next;
+            append(w);
+         }
+      }
+   }
+
+   /*! Adds a waiter to the shard. The waiter will be served after any older waiters for the same key.
+
+   @param w
+      Waiter to add.
+   */
+   void link(waiter * w) {
+      if (waiters_size >= buckets_size) {
+         grow();
+      }
+      append(w);
+      ++waiters_size;
+   }
+
+   /*! Removes a waiter from the shard.
+
+   @param w
+      Waiter to remove.
+   */
+   void unlink(waiter * w) {
+      for (waiter ** pw = bucket_for(w->key_hash); *pw; pw = &(*pw)->next) {
+         if (*pw == w) {
+            *pw = w->next;
+            --waiters_size;
+            return;
+         }
+      }
+   }
+
+   /*! Resumes a waiter that has been removed from the shard. Must be called while holding a lock on mutex.
+
+   @param w
+      Waiter to resume.
+   */
+   static void wake(waiter * w) {
+      if (w->wait_event) {
+         w->parked.unparked = true;
+         w->wait_event->trigger();
+      } else {
+         w->coro_sched->unpark(&w->parked);
+      }
+   }
+
+private:
+   /*! Appends a waiter to the end of its bucket’s chain.
+
+   @param w
+      Waiter to append.
+   */
+   void append(waiter * w) {
+      waiter ** pw = bucket_for(w->key_hash);
+      while (*pw) {
+         pw = &(*pw)->next;
+      }
+      w->next = nullptr;
+      *pw = w;
+   }
+};
+
+keyed_demux_impl::keyed_demux_impl(key_equal_fn key_equal_, value_move_fn value_move_) :
+   key_equal(key_equal_),
+   value_move(value_move_),
+   shards(new shard[shard::shards_size]) {
+}
+
+keyed_demux_impl::~keyed_demux_impl() {
+}
+
+bool keyed_demux_impl::deliver(std::size_t key_hash, void const * key, void * value) {
+   auto & s = shard_for(key_hash);
+   _std::unique_lock<_std::mutex> lock(s.mutex);
+   if (s.waiters_size == 0) {
+      return false;
+   }
+   for (waiter ** pw = s.bucket_for(key_hash); waiter * w = *pw; pw = &w->next) {
+      if (w->key_hash == key_hash && key_equal(w->key, key)) {
+         *pw = w->next;
+         --s.waiters_size;
+         value_move(w->value, value);
+         w->delivered = true;
+         shard::wake(w);
+         return true;
+      }
+   }
+   return false;
+}
+
+void keyed_demux_impl::end() {
+   for (std::size_t i = 0; i < shard::shards_size; ++i) {
+      auto & s = shards[i];
+      _std::unique_lock<_std::mutex> lock(s.mutex);
+      s.ended = true;
+      for (std::size_t j = 0; j < s.buckets_size; ++j) {
+         while (waiter * w = s.buckets[j]) {
+            s.buckets[j] = w->next;
+            shard::wake(w);
+         }
+      }
+      s.waiters_size = 0;
+   }
+}
+
+keyed_demux_impl::shard & keyed_demux_impl::shard_for(std::size_t key_hash) const {
+   return shards[key_hash & (shard::shards_size - 1)];
+}
+
+bool keyed_demux_impl::wait(
+   std::size_t key_hash, void const * key, void * value, unsigned timeout_millisecs
+) {
+   // Deliver any pending interruptions before joining the shard.
+   this_coroutine::interruption_point();
+   auto & s = shard_for(key_hash);
+   waiter w;
+   // Create the event before joining the shard, so that a failure won’t leave w in it.
+   event wait_event(event::manual_create);
+   w.coro_sched = nullptr;
+   if (this_coroutine::id()) {
+      w.coro_sched = this_thread::coroutine_scheduler().get();
+   }
+   if (!w.coro_sched || timeout_millisecs) {
+      wait_event.create();
+      w.wait_event = &wait_event;
+   } else {
+      w.wait_event = nullptr;
+   }
+   w.key_hash = key_hash;
+   w.key = key;
+   w.value = value;
+   w.parked.unparked = false;
+   w.delivered = false;
+   _std::unique_lock<_std::mutex> lock(s.mutex);
+   if (s.ended) {
+      return false;
+   }
+   s.link(&w);
+
+   if (!w.wait_event) {
+      if (!w.coro_sched->park_active(&w.parked, &lock)) {
+         // The coroutine was interrupted while still in the shard.
+         s.unlink(&w);
+         lock.unlock();
+         this_coroutine::interruption_point();
+         // Not expected to get here, but if the interruption was not delivered, just wait again.
+         return wait(key_hash, key, value, timeout_millisecs);
+      }
+      return w.delivered;
+   }
+   // A coroutine event may resume the waiter spuriously, so keep waiting until it’s woken up.
+   while (!w.parked.unparked) {
+      lock.unlock();
+      try {
+         wait_event.wait(timeout_millisecs);
+      } catch (io::timeout const &) {
+         lock.lock();
+         if (w.parked.unparked) {
+            // The value arrived just as the time ran out.
+            return w.delivered;
+         }
+         s.unlink(&w);
+         throw;
+      } catch (...) {
+         lock.lock();
+         // If a value was delivered, it will be lost along with the caller’s stack frame.
+         if (!w.parked.unparked) {
+            s.unlink(&w);
+         }
+         throw;
+      }
+      // Also ensures that deliver() is done with wait_event before it’s destructed.
+      lock.lock();
+   }
+   return w.delivered;
+}
+
+}} //namespace lofty::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace _pvt {
+
+/*! Lock that can be owned exclusively or shared, implementing lofty::shared_mutex and the coroutine mode of
+lofty::mutex. Waiters are queued in their own stack frames, and releasing the lock hands it directly to the
+first of them. */
+class parking_lock : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   //! Default constructor.
+   parking_lock() :
+      state(0),
+      waiters_size(0),
+      first_waiter(nullptr),
+      last_waiter(nullptr) {
+   }
+
+   /*! Acquires the lock, blocking if necessary.
+
+   @param shared
+      true to acquire shared ownership, or false to acquire exclusive ownership.
+   @param timeout_millisecs
+      Maximum time to wait for the lock, in milliseconds, or 0 to wait indefinitely.
+   @return
+      true if the lock was acquired, or false if the time ran out.
+   */
+   bool lock(bool shared, unsigned timeout_millisecs);
+
+   /*! Attempts to acquire the lock without blocking.
+
+   @param shared
+      true to acquire shared ownership, or false to acquire exclusive ownership.
+   @return
+      true if the lock was acquired, or false otherwise.
+   */
+   bool try_lock(bool shared) {
+      return try_acquire(shared, false);
+   }
+
+   /*! Releases the lock.
+
+   @param shared
+      true to release shared ownership, or false to release exclusive ownership.
+   */
+   void unlock(bool shared);
+
+private:
+   //! Coroutine or thread waiting for the lock.
+   struct waiter {
+      //! Previous waiter in the queue.
+      waiter * prev;
+      //! Next waiter in the queue.
+      waiter * next;
+      //! Scheduler of the waiting coroutine, or nullptr if a thread is waiting.
+      coroutine::scheduler * coro_sched;
+      //! Tracks the waiting coroutine. Its unparked member is set when the lock is granted to the waiter.
+      coroutine::scheduler::parked_coroutine parked;
+      //! Event the waiter is blocked on (timed waits and threads only), or nullptr if parked.
+      event * wait_event;
+      //! true if the waiter wants shared ownership.
+      bool shared;
+   };
+
+   //! Value of state while the lock is exclusively owned.
+   static std::uintptr_t const exclusive_state = 1;
+   //! Amount added to state for each shared owner.
+   static std::uintptr_t const shared_increment = 2;
+   //! Count of times lock() polls the lock before blocking, if the owner may be running on another thread.
+   static unsigned const spin_iterations = 100;
+
+private:
+   /*! Grants the lock to a waiter, after removing it from the queue. Must be called while holding
+   waiters_mutex.
+
+   @param w
+      Waiter to resume.
+   */
+   static void grant(waiter * w) {
+      w->parked.unparked = true;
+      if (w->wait_event) {
+         w->wait_event->trigger();
+      } else {
+         w->coro_sched->unpark(&w->parked);
+      }
+   }
+
+   /*! Grants the lock to as many waiters as possible, from the front of the queue. Must be called while
+   holding waiters_mutex. */
+   void grant_to_waiters();
+
+   /*! Attempts to acquire the lock.
+
+   @param shared
+      true to acquire shared ownership, or false to acquire exclusive ownership.
+   @param queued
+      If true, shared ownership will be acquired even if there are waiters, since they’re not ahead of the
+      caller.
+   @return
+      true if the lock was acquired, or false otherwise.
+   */
+   bool try_acquire(bool shared, bool queued);
+
+   /*! Removes a waiter from the queue. Must be called while holding waiters_mutex.
+
+   @param w
+      Waiter to remove.
+   */
+   void unlink(waiter * w);
+
+private:
+   //! exclusive_state if the lock is exclusively owned, or shared_increment times the count of shared owners.
+   _std::atomic<std::uintptr_t> state;
+   /*! Count of waiters in the queue, or about to join it. Allows lock() and unlock() to avoid waiters_mutex
+   unless there’s contention. */
+   _std::atomic<std::size_t> waiters_size;
+   //! Guards the queue of waiters.
+   _std::mutex waiters_mutex;
+   //! First (oldest) waiter.
+   waiter * first_waiter;
+   //! Last (newest) waiter.
+   waiter * last_waiter;
+};
+
+//! Hints the CPU that the calling thread is spinning, waiting for another thread.
+static void cpu_relax() {
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_I386 || LOFTY_HOST_ARCH_X86_64
+      __builtin_ia32_pause();
+   #elif LOFTY_HOST_ARCH_ARM64
+      __asm__ __volatile__("yield");
+   #endif
+#elif LOFTY_HOST_CXX_MSC
+   ::YieldProcessor();
+#endif
+}
+
+void parking_lock::grant_to_waiters() {
+   while (waiter * w = first_waiter) {
+      bool shared = w->shared;
+      if (!try_acquire(shared, true)) {
+         break;
+      }
+      unlink(w);
+      grant(w);
+      if (!shared) {
+         break;
+      }
+   }
+}
+
+bool parking_lock::lock(bool shared, unsigned timeout_millisecs) {
+   if (try_acquire(shared, false)) {
+      return true;
+   }
+   coroutine::scheduler * coro_sched = nullptr;
+   if (this_coroutine::id()) {
+      coro_sched = this_thread::coroutine_scheduler().get();
+   }
+   if (!coro_sched || coro_sched->multithreaded()) {
+      // The owner may be running on another thread, and about to release the lock.
+      for (unsigned i = 0; i < spin_iterations; ++i) {
+         cpu_relax();
+         if (try_acquire(shared, false)) {
+            return true;
+         }
+      }
+   }
+   // Deliver any pending interruptions before joining the queue.
+   this_coroutine::interruption_point();
+
+   waiter w;
+   // Create the event before joining the queue, so that a failure won’t leave w in it.
+   event wait_event(event::manual_create);
+   if (!coro_sched || timeout_millisecs) {
+      wait_event.create();
+      w.wait_event = &wait_event;
+   } else {
+      w.wait_event = nullptr;
+   }
+   w.coro_sched = coro_sched;
+   w.parked.unparked = false;
+   w.shared = shared;
+   _std::unique_lock<_std::mutex> waiters_lock(waiters_mutex);
+   // Once this is visible, unlock() will take waiters_mutex, and will therefore find w in the queue.
+   waiters_size.fetch_add(1);
+   if (!first_waiter && try_acquire(shared, true)) {
+      // The lock was released since the last attempt.
+      waiters_size.fetch_sub(1);
+      return true;
+   }
+   w.prev = last_waiter;
+   w.next = nullptr;
+   if (last_waiter) {
+      last_waiter->next = &w;
+   } else {
+      first_waiter = &w;
+   }
+   last_waiter = &w;
+
+   if (!w.wait_event) {
+      if (coro_sched->park_active(&w.parked, &waiters_lock)) {
+         // Ownership was handed to this coroutine by unlock().
+         return true;
+      }
+      // The coroutine was interrupted while still in the queue.
+      unlink(&w);
+      waiters_lock.unlock();
+      this_coroutine::interruption_point();
+      // Not expected to get here, but if the interruption was not delivered, just try again.
+      return lock(shared, timeout_millisecs);
+   }
+   // A coroutine event may resume the waiter spuriously, so keep waiting until the lock is granted.
+   while (!w.parked.unparked) {
+      waiters_lock.unlock();
+      try {
+         wait_event.wait(timeout_millisecs);
+      } catch (io::timeout const &) {
+         waiters_lock.lock();
+         if (w.parked.unparked) {
+            // The lock was granted just as the time ran out.
+            return true;
+         }
+         unlink(&w);
+         return false;
+      } catch (...) {
+         waiters_lock.lock();
+         if (w.parked.unparked) {
+            // The lock was granted, but the caller will never know it owns it; pass it on.
+            if (shared) {
+               state.fetch_sub(shared_increment);
+            } else {
+               state.store(0);
+            }
+            grant_to_waiters();
+         } else {
+            unlink(&w);
+         }
+         throw;
+      }
+      // Also ensures that unlock() is done with wait_event before it’s destructed.
+      waiters_lock.lock();
+   }
+   return true;
+}
+
+bool parking_lock::try_acquire(bool shared, bool queued) {
+   std::uintptr_t curr_state = state.load();
+   if (shared) {
+      for (;;) {
+         if (curr_state == exclusive_state || (!queued && waiters_size.load() != 0)) {
+            return false;
+         }
+         if (state.compare_exchange_weak(curr_state, curr_state + shared_increment)) {
+            return true;
+         }
+      }
+   } else {
+      return curr_state == 0 && state.compare_exchange_strong(curr_state, exclusive_state);
+   }
+}
+
+void parking_lock::unlink(waiter * w) {
+   if (w->prev) {
+      w->prev->next = w->next;
+   } else {
+      first_waiter = w->next;
+   }
+   if (w->next) {
+      w->next->prev = w->prev;
+   } else {
+      last_waiter = w->prev;
+   }
+   waiters_size.fetch_sub(1);
+}
+
+void parking_lock::unlock(bool shared) {
+   if (shared) {
+      if (state.fetch_sub(shared_increment) != shared_increment || waiters_size.load() == 0) {
+         // Other owners remain, or nobody is waiting.
+         return;
+      }
+   } else if (waiters_size.load() == 0) {
+      state.store(0);
+      // A waiter may have queued up right before the release; if so, it must be resumed.
+      if (waiters_size.load() == 0) {
+         return;
+      }
+   } else {
+      _std::unique_lock<_std::mutex> waiters_lock(waiters_mutex);
+      if (first_waiter && !first_waiter->shared) {
+         // Hand the lock directly to the first waiter, without releasing it.
+         waiter * w = first_waiter;
+         unlink(w);
+         grant(w);
+      } else {
+         state.store(0);
+         grant_to_waiters();
+      }
+      return;
+   }
+   _std::unique_lock<_std::mutex> waiters_lock(waiters_mutex);
+   grant_to_waiters();
+}
+
+}} //namespace lofty::_pvt
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 namespace lofty {
 
-struct mutex::coro_mode_t {
-   //! Scheduler that owns the mutex, if any. Always nullptr for a thread mutex.
-   _std::weak_ptr<coroutine::scheduler> coro_sched_w;
-   collections::queue<event::id_type> locks_queue;
-   bool locked;
+struct mutex::coro_mode_t : public _pvt::parking_lock {
 };
 
 mutex::manual_create_t const mutex::manual_create;
@@ -250,11 +989,6 @@ mutex::mutex(mutex && src) :
 }
 
 mutex::~mutex() {
-   if (coro_mode) {
-      if (coro_mode->locked) {
-         // TODO: uh-oh. Maybe we should try to trigger and delete the events?
-      }
-   }
 }
 
 mutex & mutex::operator=(mutex && src) {
@@ -264,96 +998,89 @@ mutex & mutex::operator=(mutex && src) {
 }
 
 mutex & mutex::create() {
-   if (thread_mutex) {
+   if (thread_mutex || coro_mode) {
       // TODO: use a better exception class.
       LOFTY_THROW(argument_error, ());
    }
-   thread_mutex.reset(new _std::mutex());
-   if (auto coro_sched = this_thread::coroutine_scheduler()) {
+   if (this_thread::coroutine_scheduler()) {
       coro_mode.reset(new coro_mode_t());
-      coro_mode->coro_sched_w = coro_sched;
-      coro_mode->locked = false;
+   } else {
+      thread_mutex.reset(new _std::mutex());
    }
    return *this;
 }
 
 void mutex::lock() {
-   if (!thread_mutex) {
-      // TODO: use a better exception class.
-      LOFTY_THROW(argument_error, ());
-   }
    if (coro_mode) {
-      _std::unique_lock<_std::mutex> thread_lock(*thread_mutex);
-      if (coro_mode->locked) {
-         /* Create and wait for an event that will be triggered when the mutex is unlocked and we’re at the
-         front() of the queue. */
-         // Will throw if coro_sched_w is expired.
-         _std::shared_ptr<coroutine::scheduler> coro_sched(coro_mode->coro_sched_w);
-         auto event_id = coro_sched->create_event();
-         coro_mode->locks_queue.push_back(event_id);
-         thread_lock.unlock();
-
-         coro_sched->block_active(
-            0 /*no timeout*/, event_id, io::filedesc_t_null, false /*read – N/A*/
-#if LOFTY_HOST_API_WIN32
-            , nullptr
-#endif
-         );
-
-         /* Now that the wait is over, event_id has already been popped out of locks_queue, and this
-         coroutine owns the lock. */
-         coro_sched->discard_event(event_id);
-      } else {
-         coro_mode->locked = true;
-      }
-   } else {
+      coro_mode->lock(false, 0);
+   } else if (thread_mutex) {
       thread_mutex->lock();
+   } else {
+      // TODO: use a better exception class.
+      LOFTY_THROW(argument_error, ());
    }
 }
 
 bool mutex::try_lock() {
-   if (!thread_mutex) {
+   if (coro_mode) {
+      return coro_mode->try_lock(false);
+   } else if (thread_mutex) {
+      return thread_mutex->try_lock();
+   } else {
       // TODO: use a better exception class.
       LOFTY_THROW(argument_error, ());
    }
+}
+
+bool mutex::try_lock_for(unsigned timeout_millisecs) {
    if (coro_mode) {
-      /* In coroutine mode, *thread_mutex is only locked for a short durations, so we’ll take a chance at
-      blocking even if this method is supposed not to. */
-      _std::unique_lock<_std::mutex> thread_lock(*thread_mutex);
-      if (coro_mode->locked) {
-         return false;
-      } else {
-         coro_mode->locked = true;
+      return coro_mode->lock(false, timeout_millisecs);
+   } else if (thread_mutex) {
+      if (thread_mutex->try_lock()) {
          return true;
       }
+#if LOFTY_HOST_API_POSIX && !LOFTY_HOST_API_DARWIN
+      ::timespec timeout_ts;
+      ::clock_gettime(CLOCK_REALTIME, &timeout_ts);
+      timeout_ts.tv_sec += static_cast< ::time_t>(timeout_millisecs / 1000u);
+      timeout_ts.tv_nsec += static_cast<long>(
+         static_cast<unsigned long>(timeout_millisecs % 1000u) * 1000000u
+      );
+      if (timeout_ts.tv_nsec >= 1000000000) {
+         timeout_ts.tv_nsec -= 1000000000;
+         ++timeout_ts.tv_sec;
+      }
+      int err = ::pthread_mutex_timedlock(thread_mutex->native_handle(), &timeout_ts);
+      if (err == ETIMEDOUT) {
+         return false;
+      } else if (err) {
+         exception::throw_os_error(err);
+      }
+      return true;
+#else
+      // No timed wait available for the underlying mutex; poll it instead.
+      for (unsigned waited_millisecs = 0; waited_millisecs < timeout_millisecs; ++waited_millisecs) {
+         this_thread::sleep_for_ms(1);
+         if (thread_mutex->try_lock()) {
+            return true;
+         }
+      }
+      return false;
+#endif
    } else {
-      return thread_mutex->try_lock();
+      // TODO: use a better exception class.
+      LOFTY_THROW(argument_error, ());
    }
 }
 
 void mutex::unlock() {
-   if (!thread_mutex) {
-      // TODO: use a better exception class.
-      LOFTY_THROW(argument_error, ());
-   }
    if (coro_mode) {
-      _std::unique_lock<_std::mutex> thread_lock(*thread_mutex);
-      if (!coro_mode->locked) {
-         // TODO: use a better exception class.
-         LOFTY_THROW(argument_error, ());
-      }
-      if (coro_mode->locks_queue) {
-         // Trigger the event at the front() of the queue, but keep the mutex locked.
-         // Will throw if coro_sched_w is expired.
-         _std::shared_ptr<coroutine::scheduler> coro_sched(coro_mode->coro_sched_w);
-         auto event_id = coro_mode->locks_queue.pop_front();
-         thread_lock.unlock();
-         coro_sched->trigger_event(event_id);
-      } else {
-         coro_mode->locked = false;
-      }
-   } else {
+      coro_mode->unlock(false);
+   } else if (thread_mutex) {
       thread_mutex->unlock();
+   } else {
+      // TODO: use a better exception class.
+      LOFTY_THROW(argument_error, ());
    }
 }
 
@@ -363,6 +1090,54 @@ void mutex::unlock() {
 
 namespace lofty {
 
+struct shared_mutex::impl : public _pvt::parking_lock {
+};
+
+shared_mutex::shared_mutex() :
+   pimpl(new impl()) {
+}
+
+shared_mutex::~shared_mutex() {
+}
+
+void shared_mutex::lock() {
+   pimpl->lock(false, 0);
+}
+
+void shared_mutex::lock_shared() {
+   pimpl->lock(true, 0);
+}
+
+bool shared_mutex::try_lock() {
+   return pimpl->try_lock(false);
+}
+
+bool shared_mutex::try_lock_for(unsigned timeout_millisecs) {
+   return pimpl->lock(false, timeout_millisecs);
+}
+
+bool shared_mutex::try_lock_shared() {
+   return pimpl->try_lock(true);
+}
+
+bool shared_mutex::try_lock_shared_for(unsigned timeout_millisecs) {
+   return pimpl->lock(true, timeout_millisecs);
+}
+
+void shared_mutex::unlock() {
+   pimpl->unlock(false);
+}
+
+void shared_mutex::unlock_shared() {
+   pimpl->unlock(true);
+}
+
+} //namespace lofty
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty {
+
 /*static*/ void type_void_adapter::copy_construct_trivial_impl(
    std::int8_t * dst_bytes_begin, std::int8_t * src_bytes_begin, std::int8_t * src_bytes_end
 ) {
@@ -668,12 +1443,519 @@ std::uint64_t bswap_64(std::uint64_t i) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace logging { namespace _pvt {
+
+/*! Ring buffer of records logged by a single thread, and written by the writer thread. Positions are counted
+in max_align_t units and only ever grow; the buffer index is obtained by wrapping them around its capacity. */
+class log_ring : public lofty::_LOFTY_PUBNS noncopyable {
+public:
+   //! Largest record that can be stored in a ring; larger ones are written synchronously.
+   static std::size_t const max_record_size = 16 * 1024;
+
+public:
+   //! Default constructor.
+   log_ring() :
+      units(new _std::max_align_t[capacity]),
+      head(0),
+      tail(0),
+      reserved_pos(0),
+      reserved_size(0) {
+   }
+
+   /*! Publishes the record whose storage was returned by the last call to reserve(). Only called by the
+   producer.
+
+   @param write
+      Function that will write and destruct the record.
+   */
+   void commit(async_writer::write_fn write) {
+      auto header = reinterpret_cast<record_header *>(&units[reserved_pos % capacity]);
+      header->size = reserved_size;
+      header->write = write;
+      tail.store(reserved_pos + reserved_size);
+   }
+
+   /*! Writes and destructs all the committed records. Only called by the consumer.
+
+   @param dst
+      Pointer to the stream to output to.
+   @return
+      true if any records were written, or false if the ring was empty.
+   */
+   bool drain(io::text::ostream * dst) {
+      std::size_t pos = head.load(), end = tail.load();
+      if (pos == end) {
+         return false;
+      }
+      while (pos != end) {
+         std::size_t i = pos % capacity;
+         if (capacity - i < header_size) {
+            // Not enough room left for a header: the producer skipped to the start of the buffer.
+            pos += capacity - i;
+            continue;
+         }
+         auto header = reinterpret_cast<record_header *>(&units[i]);
+         if (header->write) {
+            try {
+               header->write(&units[i + header_size], dst);
+            } catch (_std::exception const &) {
+               // A record that can’t be formatted must not prevent the following ones from being written.
+               // FIXME: EXC-SWALLOW
+            } catch (...) {
+               // FIXME: EXC-SWALLOW
+            }
+         }
+         pos += header->size;
+         // Release the space right away, to unblock the producer as early as possible.
+         head.store(pos);
+      }
+      return true;
+   }
+
+   /*! Returns true if there are no records waiting to be written.
+
+   @return
+      true if the ring is empty, or false otherwise.
+   */
+   bool empty() const {
+      return head.load() == tail.load();
+   }
+
+   /*! Obtains storage for a record of the specified size. Only called by the producer.
+
+   @param size
+      Size of the record, in bytes. Must not be greater than max_record_size.
+   @return
+      Pointer to the storage for the record, or nullptr if the ring is full.
+   */
+   void * reserve(std::size_t size) {
+      std::size_t record_size = header_size + LOFTY_ALIGNED_SIZE(size);
+      std::size_t pos = tail.load(), i = pos % capacity, free = capacity - (pos - head.load());
+      std::size_t contiguous = capacity - i;
+      if (contiguous < record_size) {
+         // The record must not wrap: skip the rest of the buffer, marking it as padding if possible.
+         if (free < contiguous + record_size) {
+            return nullptr;
+         }
+         if (contiguous >= header_size) {
+            auto header = reinterpret_cast<record_header *>(&units[i]);
+            header->size = contiguous;
+            header->write = nullptr;
+         }
+         pos += contiguous;
+         i = 0;
+      } else if (free < record_size) {
+         return nullptr;
+      }
+      reserved_pos = pos;
+      reserved_size = record_size;
+      return &units[i + header_size];
+   }
+
+private:
+   //! Stored in front of each record.
+   struct record_header {
+      //! Size of the record, including this header, in max_align_t units.
+      std::size_t size;
+      //! Function that writes and destructs the record, or nullptr if the record is just padding.
+      async_writer::write_fn write;
+   };
+
+private:
+   //! Capacity of the ring, in max_align_t units.
+   static std::size_t const capacity = 64 * 1024 / sizeof(_std::max_align_t);
+   //! Size of record_header, in max_align_t units.
+   static std::size_t const header_size = LOFTY_ALIGNED_SIZE(sizeof(record_header));
+
+   //! Storage for the records.
+   _std::unique_ptr<_std::max_align_t[]> units;
+   //! Position of the first record not yet written. Only changed by the consumer.
+   _std::atomic<std::size_t> head;
+   //! Position past the last committed record. Only changed by the producer.
+   _std::atomic<std::size_t> tail;
+   //! Position of the record returned by the last call to reserve(). Only used by the producer.
+   std::size_t reserved_pos;
+   //! Size of the record returned by the last call to reserve(), in max_align_t units.
+   std::size_t reserved_size;
+};
+
+//! State and main function of the thread that writes the records stored in the rings.
+class log_writer {
+public:
+   /*! Writes all the records stored in the registered rings, dropping the rings that have been abandoned by
+   their threads.
+
+   @param dst
+      Pointer to the stream to output to.
+   @return
+      true if any records were written, or false otherwise.
+   */
+   static bool drain_all(io::text::ostream * dst) {
+      bool wrote = false;
+      _std::unique_lock<_std::mutex> lock(rings_mutex);
+      for (auto itr(rings.begin()); itr != rings.end(); ) {
+         auto curr_itr(itr);
+         ++itr;
+         auto & ring = *curr_itr;
+         if (ring->drain(dst)) {
+            wrote = true;
+         } else if (ring.use_count() == 1) {
+            // The thread has terminated, and everything it logged has been written.
+            rings.remove_at(curr_itr);
+         }
+      }
+      return wrote;
+   }
+
+   //! Main function of the writer thread.
+   static void main_loop() {
+      thread_id.store(this_thread::id());
+      text::str batch;
+      io::text::str_ostream batch_ostream(external_buffer, &batch);
+      try {
+         for (;;) {
+            bool stopping = stop_requested.load();
+            if (!write_pass(&batch, &batch_ostream)) {
+               if (stopping) {
+                  break;
+               }
+               idle.store(true);
+               // Records committed before idle was set didn’t trigger wake_event, so check once more.
+               if (write_pass(&batch, &batch_ostream)) {
+                  idle.store(false);
+                  continue;
+               }
+               try {
+                  wake_event.wait(idle_timeout_millisecs);
+               } catch (io::timeout const &) {
+                  // Nothing was logged in a while; check anyway, in case a wake-up was missed.
+               }
+               idle.store(false);
+            }
+         }
+      } catch (execution_interruption const &) {
+         // The process is terminating.
+      }
+      thread_id.store(0);
+   }
+
+   /*! Returns the calling thread’s ring, creating and registering it if necessary.
+
+   @return
+      Pointer to the ring.
+   */
+   static log_ring * this_thread_ring_ptr() {
+      _std::shared_ptr<log_ring> & ring = this_thread_ring;
+      if (!ring) {
+         auto new_ring(_std::make_shared<log_ring>());
+         {
+            _std::unique_lock<_std::mutex> lock(rings_mutex);
+            rings.push_back(new_ring);
+         }
+         ring = _std::move(new_ring);
+      }
+      return ring.get();
+   }
+
+   /*! Blocks the calling thread or coroutine until the writer thread completes another pass over the rings,
+   or stops.
+
+   @param pass
+      Value of passes read by the caller before it decided to wait. If passes no longer has this value, this
+      method returns right away.
+   */
+   static void wait_for_pass(unsigned pass) {
+      // Deliver any pending interruptions before joining the list.
+      this_coroutine::interruption_point();
+      pass_waiter w;
+      event thread_event(event::manual_create);
+      if (this_coroutine::id()) {
+         w.coro_sched = this_thread::coroutine_scheduler().get();
+         w.thread_event = nullptr;
+      } else {
+         // Create the event before joining the list, so that a failure won’t leave w in it.
+         w.coro_sched = nullptr;
+         thread_event.create();
+         w.thread_event = &thread_event;
+      }
+      _std::unique_lock<_std::mutex> lock(waiters_mutex);
+      // wake_waiters() is only called after passes is incremented, so this check can’t miss a wake-up.
+      if (passes.load() != pass || !running.load()) {
+         return;
+      }
+      w.prev = last_waiter;
+      w.next = nullptr;
+      w.parked.unparked = false;
+      if (last_waiter) {
+         last_waiter->next = &w;
+      } else {
+         first_waiter = &w;
+      }
+      last_waiter = &w;
+
+      if (w.coro_sched) {
+         if (!w.coro_sched->park_active(&w.parked, &lock)) {
+            // The coroutine was interrupted while still in the list.
+            unlink_waiter(&w);
+            this_coroutine::interruption_point();
+         }
+      } else {
+         lock.unlock();
+         try {
+            thread_event.wait();
+         } catch (...) {
+            lock.lock();
+            if (!w.parked.unparked) {
+               unlink_waiter(&w);
+            }
+            throw;
+         }
+      }
+   }
+
+   //! Wakes the writer thread if it’s waiting for records to be logged.
+   static void wake() {
+      if (idle.load() && idle.exchange(false)) {
+         wake_event.trigger();
+      }
+   }
+
+   //! Resumes all the threads and coroutines blocked in wait_for_pass().
+   static void wake_waiters() {
+      _std::unique_lock<_std::mutex> lock(waiters_mutex);
+      while (pass_waiter * w = first_waiter) {
+         first_waiter = w->next;
+         if (w->coro_sched) {
+            w->coro_sched->unpark(&w->parked);
+         } else {
+            w->parked.unparked = true;
+            w->thread_event->trigger();
+         }
+      }
+      last_waiter = nullptr;
+   }
+
+   /*! Writes a batch with all the pending records, in a single call.
+
+   @param batch
+      Pointer to the string that batch_ostream writes to.
+   @param batch_ostream
+      Pointer to the stream used to accumulate the batch.
+   @return
+      true if any records were written, or false otherwise.
+   */
+   static bool write_pass(text::str * batch, io::text::str_ostream * batch_ostream) {
+      bool wrote;
+      try {
+         wrote = drain_all(batch_ostream);
+         if (auto dropped = dropped_records.exchange(0)) {
+            batch_ostream->print(LOFTY_SL("logging: {} records dropped\n"), dropped);
+            wrote = true;
+         }
+         if (wrote) {
+            io::text::stderr->write(*batch);
+            io::text::stderr->flush();
+         }
+      } catch (execution_interruption const &) {
+         throw;
+      } catch (_std::exception const &) {
+         // FIXME: EXC-SWALLOW
+         wrote = true;
+      } catch (...) {
+         // FIXME: EXC-SWALLOW
+         wrote = true;
+      }
+      batch_ostream->clear();
+      ++passes;
+      // Any space released by drain_all() is now available, and any flush() may be complete.
+      wake_waiters();
+      return wrote;
+   }
+
+private:
+   //! Thread or coroutine blocked in wait_for_pass().
+   struct pass_waiter {
+      //! Previous waiter in the list.
+      pass_waiter * prev;
+      //! Next waiter in the list.
+      pass_waiter * next;
+      //! Scheduler of the waiting coroutine, or nullptr if a thread is waiting.
+      coroutine::scheduler * coro_sched;
+      //! Tracks the waiting coroutine. Its unparked member is also used to track threads being woken up.
+      coroutine::scheduler::parked_coroutine parked;
+      //! Event the waiting thread is blocked on (thread mode only).
+      event * thread_event;
+   };
+
+   /*! Removes a waiter from the list. Must be called while holding a lock on waiters_mutex.
+
+   @param w
+      Waiter to remove.
+   */
+   static void unlink_waiter(pass_waiter * w) {
+      if (w->prev) {
+         w->prev->next = w->next;
+      } else {
+         first_waiter = w->next;
+      }
+      if (w->next) {
+         w->next->prev = w->prev;
+      } else {
+         last_waiter = w->prev;
+      }
+   }
+
+public:
+   //! Longest time the writer thread waits for wake_event before checking for new records anyway.
+   static unsigned const idle_timeout_millisecs = 100;
+
+   //! Count of records dropped due to overflow_policy::drop, since they were last reported.
+   static _std::atomic<std::size_t> dropped_records;
+   //! First (oldest) thread or coroutine blocked in wait_for_pass().
+   static pass_waiter * first_waiter;
+   //! true while the writer thread is waiting for wake_event.
+   static _std::atomic<bool> idle;
+   //! Current overflow policy.
+   static _std::atomic<int> overflow_policy_value;
+   //! Last (newest) thread or coroutine blocked in wait_for_pass().
+   static pass_waiter * last_waiter;
+   //! Incremented by the writer thread after each pass over the rings; see wait_for_pass().
+   static _std::atomic<unsigned> passes;
+   //! Rings of all the threads that have logged records not yet known to be written.
+   static collections::list<_std::shared_ptr<log_ring>> rings;
+   //! Governs access to rings.
+   static _std::mutex rings_mutex;
+   //! true while the writer thread accepts records.
+   static _std::atomic<bool> running;
+   //! Set to ask the writer thread to write any pending records, and then terminate.
+   static _std::atomic<bool> stop_requested;
+   //! Writer thread.
+   static thread writer_thread;
+   //! Id of the writer thread, or 0 if it’s not running.
+   static _std::atomic<thread::id_type> thread_id;
+   //! Ring of the current thread.
+   static thread_local_value<_std::shared_ptr<log_ring>> this_thread_ring;
+   //! Governs access to first_waiter and last_waiter.
+   static _std::mutex waiters_mutex;
+   //! Triggered to wake the writer thread while it’s idle.
+   static event wake_event;
+};
+
+_std::atomic<std::size_t> log_writer::dropped_records(0);
+log_writer::pass_waiter * log_writer::first_waiter = nullptr;
+_std::atomic<bool> log_writer::idle(false);
+_std::atomic<int> log_writer::overflow_policy_value(overflow_policy::block);
+log_writer::pass_waiter * log_writer::last_waiter = nullptr;
+_std::atomic<unsigned> log_writer::passes(0);
+collections::list<_std::shared_ptr<log_ring>> log_writer::rings;
+_std::mutex log_writer::rings_mutex;
+_std::atomic<bool> log_writer::running(false);
+_std::atomic<bool> log_writer::stop_requested(false);
+thread log_writer::writer_thread;
+_std::atomic<thread::id_type> log_writer::thread_id(0);
+thread_local_value<_std::shared_ptr<log_ring>> log_writer::this_thread_ring;
+_std::mutex log_writer::waiters_mutex;
+event log_writer::wake_event(event::manual_create);
+
+_std::atomic<int> async_writer::max_level_value(level::info);
+
+/*static*/ void async_writer::commit(write_fn write) {
+   log_writer::this_thread_ring.get()->commit(write);
+   log_writer::wake();
+}
+
+/*static*/ void * async_writer::reserve(std::size_t size, bool * sync) {
+   if (
+      !log_writer::running.load() || size > log_ring::max_record_size ||
+      this_thread::id() == log_writer::thread_id.load()
+   ) {
+      // Can’t defer this record; also avoid having the writer thread wait for itself.
+      *sync = true;
+      return nullptr;
+   }
+   *sync = false;
+   for (;;) {
+      unsigned pass = log_writer::passes.load();
+      // Get the ring every time, since a coroutine may be resumed on a different thread after waiting.
+      if (void * p = log_writer::this_thread_ring_ptr()->reserve(size)) {
+         return p;
+      }
+      if (log_writer::overflow_policy_value.load() == overflow_policy::drop) {
+         ++log_writer::dropped_records;
+         return nullptr;
+      }
+      // Wait for the writer thread to drain the ring.
+      log_writer::wake();
+      log_writer::wait_for_pass(pass);
+      if (!log_writer::running.load()) {
+         *sync = true;
+         return nullptr;
+      }
+   }
+}
+
+/*static*/ void async_writer::start() {
+   log_writer::stop_requested.store(false);
+   // Create the event now, in a thread without a coroutine scheduler, so it can be triggered from any thread.
+   log_writer::wake_event.create();
+   log_writer::writer_thread = thread(&log_writer::main_loop);
+   log_writer::running.store(true);
+}
+
+/*static*/ void async_writer::stop() {
+   if (!log_writer::running.exchange(false)) {
+      return;
+   }
+   log_writer::stop_requested.store(true);
+   log_writer::wake();
+   log_writer::writer_thread.join();
+   // Write anything that may have been committed after the writer thread’s last pass.
+   log_writer::drain_all(io::text::stderr.get());
+   // Release any threads or coroutines that started waiting after the writer thread’s last pass.
+   log_writer::wake_waiters();
+}
+
+}}} //namespace lofty::logging::_pvt
+
 namespace lofty { namespace logging {
 _LOFTY_PUBNS_BEGIN
 
+void flush() {
+   if (_pvt::log_writer::running.load() && this_thread::id() != _pvt::log_writer::thread_id.load()) {
+      /* Wait for two passes to complete: the first one may have started before the caller’s last record was
+      committed. */
+      unsigned target_passes = _pvt::log_writer::passes.load() + 2;
+      _pvt::log_writer::wake();
+      unsigned pass;
+      while (static_cast<int>((pass = _pvt::log_writer::passes.load()) - target_passes) < 0) {
+         if (!_pvt::log_writer::running.load()) {
+            break;
+         }
+         _pvt::log_writer::wait_for_pass(pass);
+      }
+   } else {
+      io::text::stderr->flush();
+   }
+}
+
 io::text::ostream * get_ostream_if(level level_) {
-   // TODO: actually check level_ against a global log level setting.
-   return io::text::stderr.get();
+   if (static_cast<int>(level_.base()) <= _pvt::async_writer::max_level_value.load()) {
+      return io::text::stderr.get();
+   } else {
+      return nullptr;
+   }
+}
+
+level max_level() {
+   return static_cast<level::enum_type>(_pvt::async_writer::max_level_value.load());
+}
+
+void set_max_level(level level_) {
+   _pvt::async_writer::max_level_value.store(static_cast<int>(level_.base()));
+}
+
+void set_overflow_policy(overflow_policy policy) {
+   _pvt::log_writer::overflow_policy_value.store(static_cast<int>(policy.base()));
 }
 
 _LOFTY_PUBNS_END
@@ -142,6 +142,29 @@ bad_pointer_alignment & bad_pointer_alignment::operator=(bad_pointer_alignment c
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace lofty { namespace memory {
+
+/*explicit*/ stack_overflow::stack_overflow(void const * ptr_, errint_t err_ /*= 0*/) :
+   bad_pointer(ptr_, err_) {
+   what_ostream().write(LOFTY_SL("stack overflow"));
+}
+
+stack_overflow::stack_overflow(stack_overflow const & src) :
+   bad_pointer(src) {
+}
+
+/*virtual*/ stack_overflow::~stack_overflow() LOFTY_STL_NOEXCEPT_TRUE() {
+}
+
+stack_overflow & stack_overflow::operator=(stack_overflow const & src) {
+   bad_pointer::operator=(src);
+   return *this;
+}
+
+}} //namespace lofty::memory
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #if LOFTY_HOST_CXX_MSC
    #pragma warning(push)
    // “'operator': exception specification does not match previous declaration”
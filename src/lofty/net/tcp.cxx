@@ -27,6 +27,9 @@ more details.
    #include <errno.h> // EINTR errno
    #include <netinet/in.h> // ntohs()
    #include <sys/socket.h> // accept4() getsockname()
+   #if LOFTY_HOST_API_LINUX
+      #include <linux/io_uring.h> // IORING_OP_*
+   #endif
 #elif LOFTY_HOST_API_WIN32
    #include <lofty/memory.hxx>
    #include <winsock2.h>
@@ -113,9 +116,20 @@ _std::shared_ptr<connection> server::accept() {
          // Using coroutines, so make the client socket non-blocking.
          flags |= SOCK_NONBLOCK;
       }
+      #if LOFTY_HOST_API_LINUX
+      io::uring_op op(
+         IORING_OP_ACCEPT, sock.get(), remote_sock_addr.sockaddr_ptr(), 0,
+         reinterpret_cast<std::uintptr_t>(remote_sock_addr.size_ptr()), static_cast<std::uint32_t>(flags)
+      );
+      conn_sock = socket(static_cast<io::filedesc_t>(
+         this_coroutine::perform_uring_op(&op, 0 /*no timeout*/) ? op.syscall_result() :
+            ::accept4(sock.get(), remote_sock_addr.sockaddr_ptr(), remote_sock_addr.size_ptr(), flags)
+      ));
+      #else
       conn_sock = socket(
          ::accept4(sock.get(), remote_sock_addr.sockaddr_ptr(), remote_sock_addr.size_ptr(), flags)
       );
+      #endif
    #endif
       if (conn_sock) {
          break;
@@ -14,8 +14,10 @@ more details.
 
 #include <lofty/coroutine.hxx>
 #include <lofty/exception.hxx>
+#include <lofty/io.hxx>
 #include <lofty/io/binary/buffer.hxx>
 #include <lofty/io/binary/memory.hxx>
+#include <lofty/memory.hxx>
 #include <lofty/net.hxx>
 #include <lofty/net/ip.hxx>
 #include <lofty/net/udp.hxx>
@@ -28,8 +30,11 @@ more details.
    #include <netinet/in.h> // ntohs()
    #include <sys/types.h> // ssize_t
    #include <sys/socket.h> // recvfrom() sendto()
+   #if LOFTY_HOST_API_LINUX
+      #include <linux/io_uring.h> // IORING_OP_*
+      #include <sys/uio.h> // iovec
+   #endif
 #elif LOFTY_HOST_API_WIN32
-   #include <lofty/io.hxx>
    #include <winsock2.h>
    #include <mswsock.h> // WSARecvFrom()
 #endif
@@ -77,10 +82,28 @@ void server::send(datagram const & dgram) {
    auto buf(dgram.data()->peek<std::int8_t>());
 #if LOFTY_HOST_API_POSIX
    ::ssize_t bytes_sent;
+   #if LOFTY_HOST_API_LINUX
+   ::iovec iov;
+   iov.iov_base = const_cast<std::int8_t *>(buf.ptr);
+   iov.iov_len = buf.size;
+   ::msghdr msg;
+   memory::clear(&msg);
+   msg.msg_name = server_sock_addr.sockaddr_ptr();
+   msg.msg_namelen = server_sock_addr.size();
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   #endif
    for (;;) {
+   #if LOFTY_HOST_API_LINUX
+      io::uring_op op(IORING_OP_SENDMSG, sock.get(), &msg, 1);
+      bytes_sent = this_coroutine::perform_uring_op(&op, 0 /*no timeout*/) ? op.syscall_result() : ::sendto(
+         sock.get(), buf.ptr, buf.size, 0, server_sock_addr.sockaddr_ptr(), server_sock_addr.size()
+      );
+   #else
       bytes_sent = ::sendto(
          sock.get(), buf.ptr, buf.size, 0, server_sock_addr.sockaddr_ptr(), server_sock_addr.size()
       );
+   #endif
       if (bytes_sent >= 0) {
          break;
       }
@@ -144,11 +167,35 @@ _std::shared_ptr<datagram> server::receive() {
    sender_sock_addr.set_size_from_ip_version(ip_version);
 #if LOFTY_HOST_API_POSIX
    ::ssize_t bytes_received;
+   #if LOFTY_HOST_API_LINUX
+   ::iovec iov;
+   iov.iov_base = buf.get_available();
+   iov.iov_len = buf.available_size();
+   ::msghdr msg;
+   memory::clear(&msg);
+   msg.msg_name = sender_sock_addr.sockaddr_ptr();
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   #endif
    for (;;) {
+   #if LOFTY_HOST_API_LINUX
+      msg.msg_namelen = *sender_sock_addr.size_ptr();
+      io::uring_op op(IORING_OP_RECVMSG, sock.get(), &msg, 1);
+      if (this_coroutine::perform_uring_op(&op, 0 /*no timeout*/)) {
+         bytes_received = op.syscall_result();
+         *sender_sock_addr.size_ptr() = msg.msg_namelen;
+      } else {
+         bytes_received = ::recvfrom(
+            sock.get(), buf.get_available(), buf.available_size(), 0,
+            sender_sock_addr.sockaddr_ptr(), sender_sock_addr.size_ptr()
+         );
+      }
+   #else
       bytes_received = ::recvfrom(
          sock.get(), buf.get_available(), buf.available_size(), 0,
          sender_sock_addr.sockaddr_ptr(), sender_sock_addr.size_ptr()
       );
+   #endif
       if (bytes_received >= 0) {
          break;
       }
@@ -20,6 +20,1227 @@ more details.
 #include <lofty/text.hxx>
 #include <lofty/text/str.hxx>
 #include <lofty/to_text_ostream.hxx>
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+      #include <immintrin.h> // _mm*()
+   #elif defined(__SSE2__)
+      #include <emmintrin.h> // _mm_*()
+   #endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace text { namespace _pvt {
+
+/* Fast paths for transcode(): runs of ASCII characters are converted between UTF encodings many characters at
+a time, since they always decode and encode the same way. Non-ASCII characters are left to the general code
+point-by-code point loop, or to the multi-byte fast paths further below, so error handling is unaffected.
+
+Each function converts the longest run of ASCII characters at the start of src, up to size characters, and
+returns its length; a nullptr dst means that the characters are only to be counted. A non-host byte order is
+handled by checking and shifting the bytes of each character, since swapping an ASCII character is the same as
+moving its only non-zero byte. */
+
+/*! Scalar implementation of the ASCII fast paths, used for the tail of each run, and where vector
+instructions are not available.
+
+@param src
+   Pointer to the source characters.
+@param src_swap
+   true if the source characters are not in host byte order.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param dst_swap
+   true if the destination characters must not be in host byte order.
+@param i
+   Count of characters already converted.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted, including i.
+*/
+template <typename TSrc, typename TDst>
+static std::size_t ascii_run_scalar(
+   std::uint8_t const * src, bool src_swap, std::uint8_t * dst, bool dst_swap, std::size_t i, std::size_t size
+) {
+   auto src_chars = reinterpret_cast<TSrc const *>(src);
+   auto dst_chars = reinterpret_cast<TDst *>(dst);
+   for (; i < size; ++i) {
+      TSrc ch = src_chars[i];
+      if (src_swap) {
+         ch = byte_order::swap(ch);
+      }
+      if (ch >= 0x80) {
+         break;
+      }
+      if (dst_chars) {
+         auto dst_ch = static_cast<TDst>(ch);
+         dst_chars[i] = dst_swap ? byte_order::swap(dst_ch) : dst_ch;
+      }
+   }
+   return i;
+}
+
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+/*! AVX2 implementation of ascii_run_8_to_8(), used if the CPU supports it.
+
+@param src
+   Pointer to the source characters.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+__attribute__((target("avx2"))) static std::size_t ascii_run_8_to_8_avx2(
+   std::uint8_t const * src, std::uint8_t * dst, std::size_t size
+) {
+   std::size_t i = 0;
+   for (; i + 32 <= size; i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+      if (_mm256_movemask_epi8(v)) {
+         break;
+      }
+      if (dst) {
+         _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+      }
+   }
+   return ascii_run_scalar<std::uint8_t, std::uint8_t>(src, false, dst, false, i, size);
+}
+   #endif
+#endif
+
+/*! Converts a run of ASCII characters from UTF-8 to UTF-8, which validates and copies it.
+
+@param src
+   Pointer to the source characters.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t ascii_run_8_to_8(std::uint8_t const * src, std::uint8_t * dst, std::size_t size) {
+   std::size_t i = 0;
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   // Checked once; the result is cached in a thread-safe way by the compiler.
+   static bool const avx2 = __builtin_cpu_supports("avx2") != 0;
+   if (avx2) {
+      return ascii_run_8_to_8_avx2(src, dst, size);
+   }
+   #endif
+   #ifdef __SSE2__
+   for (; i + 16 <= size; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+      if (_mm_movemask_epi8(v)) {
+         break;
+      }
+      if (dst) {
+         _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+      }
+   }
+   #endif
+#endif
+   return ascii_run_scalar<std::uint8_t, std::uint8_t>(src, false, dst, false, i, size);
+}
+
+/*! Converts a run of ASCII characters from UTF-8 to UTF-16.
+
+@param src
+   Pointer to the source characters.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param dst_swap
+   true if the destination characters must not be in host byte order.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t ascii_run_8_to_16(
+   std::uint8_t const * src, std::uint8_t * dst, bool dst_swap, std::size_t size
+) {
+   if (!dst) {
+      return ascii_run_8_to_8(src, nullptr, size);
+   }
+   std::size_t i = 0;
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+   __m128i zero = _mm_setzero_si128();
+   for (; i + 16 <= size; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+      if (_mm_movemask_epi8(v)) {
+         break;
+      }
+      __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+      if (dst_swap) {
+         lo = _mm_slli_epi16(lo, 8);
+         hi = _mm_slli_epi16(hi, 8);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2     ), lo);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2 + 16), hi);
+   }
+#endif
+   return ascii_run_scalar<std::uint8_t, char16_t>(src, false, dst, dst_swap, i, size);
+}
+
+/*! Converts a run of ASCII characters from UTF-8 to UTF-32.
+
+@param src
+   Pointer to the source characters.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param dst_swap
+   true if the destination characters must not be in host byte order.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t ascii_run_8_to_32(
+   std::uint8_t const * src, std::uint8_t * dst, bool dst_swap, std::size_t size
+) {
+   if (!dst) {
+      return ascii_run_8_to_8(src, nullptr, size);
+   }
+   std::size_t i = 0;
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+   __m128i zero = _mm_setzero_si128();
+   for (; i + 16 <= size; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i));
+      if (_mm_movemask_epi8(v)) {
+         break;
+      }
+      __m128i lo16 = _mm_unpacklo_epi8(v, zero), hi16 = _mm_unpackhi_epi8(v, zero);
+      __m128i v32[4] = {
+         _mm_unpacklo_epi16(lo16, zero), _mm_unpackhi_epi16(lo16, zero),
+         _mm_unpacklo_epi16(hi16, zero), _mm_unpackhi_epi16(hi16, zero)
+      };
+      for (unsigned j = 0; j < 4; ++j) {
+         if (dst_swap) {
+            v32[j] = _mm_slli_epi32(v32[j], 24);
+         }
+         _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4 + j * 16), v32[j]);
+      }
+   }
+#endif
+   return ascii_run_scalar<std::uint8_t, char32_t>(src, false, dst, dst_swap, i, size);
+}
+
+/*! Converts a run of ASCII characters from UTF-16 to UTF-8.
+
+@param src
+   Pointer to the source characters.
+@param src_swap
+   true if the source characters are not in host byte order.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t ascii_run_16_to_8(
+   std::uint8_t const * src, bool src_swap, std::uint8_t * dst, std::size_t size
+) {
+   std::size_t i = 0;
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+   // Bits that must be zero in an ASCII character, before shifting it into the low byte.
+   __m128i non_ascii_mask = _mm_set1_epi16(static_cast<short>(src_swap ? 0x80ff : 0xff80));
+   __m128i zero = _mm_setzero_si128();
+   for (; i + 16 <= size; i += 16) {
+      __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 2     ));
+      __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 2 + 16));
+      __m128i non_ascii = _mm_and_si128(_mm_or_si128(lo, hi), non_ascii_mask);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xffff) {
+         break;
+      }
+      if (dst) {
+         if (src_swap) {
+            lo = _mm_srli_epi16(lo, 8);
+            hi = _mm_srli_epi16(hi, 8);
+         }
+         _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+      }
+   }
+#endif
+   return ascii_run_scalar<char16_t, std::uint8_t>(src, src_swap, dst, false, i, size);
+}
+
+/*! Converts a run of ASCII characters from UTF-32 to UTF-8.
+
+@param src
+   Pointer to the source characters.
+@param src_swap
+   true if the source characters are not in host byte order.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t ascii_run_32_to_8(
+   std::uint8_t const * src, bool src_swap, std::uint8_t * dst, std::size_t size
+) {
+   std::size_t i = 0;
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && defined(__SSE2__)
+   // Bits that must be zero in an ASCII character, before shifting it into the low byte.
+   __m128i non_ascii_mask = _mm_set1_epi32(static_cast<int>(src_swap ? 0x80ffffffu : 0xffffff80u));
+   __m128i zero = _mm_setzero_si128();
+   for (; i + 16 <= size; i += 16) {
+      __m128i v[4];
+      __m128i all = zero;
+      for (unsigned j = 0; j < 4; ++j) {
+         v[j] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 4 + j * 16));
+         all = _mm_or_si128(all, v[j]);
+      }
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, non_ascii_mask), zero)) != 0xffff) {
+         break;
+      }
+      if (dst) {
+         if (src_swap) {
+            for (unsigned j = 0; j < 4; ++j) {
+               v[j] = _mm_srli_epi32(v[j], 24);
+            }
+         }
+         // All values are < 0x80, so the saturating packs are just narrowing.
+         __m128i lo = _mm_packs_epi32(v[0], v[1]), hi = _mm_packs_epi32(v[2], v[3]);
+         _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+      }
+   }
+#endif
+   return ascii_run_scalar<char32_t, std::uint8_t>(src, src_swap, dst, false, i, size);
+}
+
+/*! Returns true if transcode() can use transcode_ascii_run() for the specified encodings.
+
+@param src_enc
+   Source encoding.
+@param dst_enc
+   Destination encoding.
+@return
+   true if the ASCII fast path applies, or false otherwise.
+*/
+static bool ascii_run_supported(_pub::encoding src_enc, _pub::encoding dst_enc) {
+   auto is_utf = [] (_pub::encoding enc) -> bool {
+      switch (enc.base()) {
+         case _pub::encoding::utf8:
+         case _pub::encoding::utf16le:
+         case _pub::encoding::utf16be:
+         case _pub::encoding::utf32le:
+         case _pub::encoding::utf32be:
+            return true;
+         default:
+            return false;
+      }
+   };
+   // One of the two must be UTF-8; UTF-16/32 to UTF-16/32 is left to the general loop.
+   return is_utf(src_enc) && is_utf(dst_enc) && (
+      src_enc == _pub::encoding::utf8 || dst_enc == _pub::encoding::utf8
+   );
+}
+
+/*! Converts the longest run of ASCII characters at the start of src from src_enc to dst_enc. Only valid if
+ascii_run_supported(src_enc, dst_enc) returns true.
+
+@param src_enc
+   Source encoding.
+@param src
+   Pointer to the source characters.
+@param dst_enc
+   Destination encoding.
+@param dst
+   Pointer to the destination buffer, or nullptr to only count characters.
+@param size
+   Maximum count of characters to convert.
+@return
+   Count of characters converted.
+*/
+static std::size_t transcode_ascii_run(
+   _pub::encoding src_enc, std::uint8_t const * src, _pub::encoding dst_enc, std::uint8_t * dst,
+   std::size_t size
+) {
+   switch (src_enc.base()) {
+      case _pub::encoding::utf16le:
+      case _pub::encoding::utf16be:
+         return ascii_run_16_to_8(src, src_enc != _pub::encoding::utf16_host, dst, size);
+      case _pub::encoding::utf32le:
+      case _pub::encoding::utf32be:
+         return ascii_run_32_to_8(src, src_enc != _pub::encoding::utf32_host, dst, size);
+      default:
+         switch (dst_enc.base()) {
+            case _pub::encoding::utf16le:
+            case _pub::encoding::utf16be:
+               return ascii_run_8_to_16(src, dst, dst_enc != _pub::encoding::utf16_host, size);
+            case _pub::encoding::utf32le:
+            case _pub::encoding::utf32be:
+               return ascii_run_8_to_32(src, dst, dst_enc != _pub::encoding::utf32_host, size);
+            default:
+               return ascii_run_8_to_8(src, dst, size);
+         }
+   }
+}
+
+
+/* Fast paths for non-ASCII characters: blocks of 16 bytes are converted all at once with SSSE3, whose byte
+shuffles can pack and unpack variable-length sequences. A block is only converted up to the first character
+that is invalid, or that the general loop treats specially (unpaired surrogates, and surrogates encoded in
+UTF-8 or UTF-32); that character ends the run and is left to the general loop, so error handling is
+unaffected. Blocks of only ASCII characters are converted here as well, so that text mixing them with other
+characters doesn’t bounce between these and the ASCII fast paths, whose scalar tails would otherwise run once
+for each non-ASCII character.
+
+Each function converts blocks at the start of *src, only as long as the destination has room for the worst
+case of a block, advancing *src and *dst past what was converted. When only counting, transcode() passes an
+end that’s SIZE_MAX bytes past nullptr, so the room left is compared as an unsigned size. */
+
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+//! Byte shuffles used by the multi-byte fast paths.
+struct multibyte_shuffles {
+   //! For each 8-bit mask, moves the selected 16-bit lanes to the start of a vector.
+   std::uint8_t compress16[256][16];
+   //! For each 4-bit mask, moves the selected 32-bit lanes to the start of a vector.
+   std::uint8_t compress32[16][16];
+   /*! Moves the first 1-4 bytes of each 32-bit lane to the start of a vector. Indexed by the lengths of the
+   four lanes minus 1, two bits each, with lane 0 in the lowest bits. */
+   std::uint8_t gather_utf8[256][16];
+
+   //! Default constructor.
+   multibyte_shuffles() {
+      for (unsigned mask = 0; mask < 256; ++mask) {
+         // Bytes that are not selected are set to 0x80, which makes pshufb zero them.
+         for (unsigned j = 0; j < 16; ++j) {
+            compress16[mask][j] = gather_utf8[mask][j] = 0x80;
+            if (mask < 16) {
+               compress32[mask][j] = 0x80;
+            }
+         }
+         unsigned j = 0;
+         for (unsigned lane = 0; lane < 8; ++lane) {
+            if (mask & (1u << lane)) {
+               compress16[mask][j++] = static_cast<std::uint8_t>(lane * 2);
+               compress16[mask][j++] = static_cast<std::uint8_t>(lane * 2 + 1);
+            }
+         }
+         j = 0;
+         for (unsigned lane = 0; lane < 4; ++lane) {
+            for (unsigned k = 0; k <= ((mask >> (lane * 2)) & 3); ++k) {
+               gather_utf8[mask][j++] = static_cast<std::uint8_t>(lane * 4 + k);
+            }
+         }
+      }
+      for (unsigned mask = 0; mask < 16; ++mask) {
+         unsigned j = 0;
+         for (unsigned lane = 0; lane < 4; ++lane) {
+            if (mask & (1u << lane)) {
+               for (unsigned k = 0; k < 4; ++k) {
+                  compress32[mask][j++] = static_cast<std::uint8_t>(lane * 4 + k);
+               }
+            }
+         }
+      }
+   }
+};
+
+/*! Returns the shuffles used by the multi-byte fast paths, building them on the first call.
+
+@return
+   Shuffles.
+*/
+static multibyte_shuffles const & get_multibyte_shuffles() {
+   // Built once; the compiler makes this thread-safe.
+   static multibyte_shuffles const shuffles;
+   return shuffles;
+}
+
+/*! Compares each byte in v with x, as unsigned numbers.
+
+@param v
+   Bytes to compare.
+@param x
+   Value to compare with.
+@return
+   Mask of the bytes in v that are greater than or equal to x.
+*/
+static inline __m128i mm_cmpge_epu8(__m128i v, std::uint8_t x) {
+   return _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(static_cast<char>(x))), v);
+}
+
+/*! Selects bits from one of two vectors.
+
+@param mask
+   Mask of the bits to take from a; the others are taken from b.
+@param a
+   First vector.
+@param b
+   Second vector.
+@return
+   Combination of a and b.
+*/
+static inline __m128i mm_select(__m128i mask, __m128i a, __m128i b) {
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*! Swaps the bytes in each 16-bit lane of v.
+
+@param v
+   Vector to swap.
+@return
+   Swapped vector.
+*/
+static inline __m128i mm_swap_epi16(__m128i v) {
+   return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+/*! Swaps the bytes in each 32-bit lane of v.
+
+@param v
+   Vector to swap.
+@return
+   Swapped vector.
+*/
+__attribute__((target("ssse3"))) static inline __m128i mm_swap_epi32(__m128i v) {
+   return _mm_shuffle_epi8(v, _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+}
+
+/*! Zero-extends the bytes in v to 32 bits.
+
+@param v
+   Bytes to extend.
+@param lanes
+   Array that will receive bytes 0-3 of v in lanes[0], bytes 4-7 in lanes[1], and so on.
+*/
+static inline void mm_widen_epu8_epi32(__m128i v, __m128i * lanes) {
+   __m128i zero = _mm_setzero_si128();
+   __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+   lanes[0] = _mm_unpacklo_epi16(lo, zero);
+   lanes[1] = _mm_unpackhi_epi16(lo, zero);
+   lanes[2] = _mm_unpacklo_epi16(hi, zero);
+   lanes[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+/*! Validates a block of 16 UTF-8 bytes that starts with a character, finding how many of its bytes form
+whole, valid characters; the last character may continue in the next block, and an invalid one ends the
+count.
+
+@param v
+   Block to validate.
+@param leads
+   Pointer to a variable that will receive a mask of the bytes, among those in the returned size, that start a
+   character.
+@param four_byte_leads
+   Pointer to a variable that will receive a mask of the bytes, among those in the returned size, that start a
+   four-byte character.
+@return
+   Count of bytes at the start of the block that form whole, valid characters.
+*/
+__attribute__((target("ssse3,popcnt"))) static inline unsigned utf8_block_valid_size(
+   __m128i v, unsigned * leads, unsigned * four_byte_leads
+) {
+   // 0x80-0xbf, as a signed comparison.
+   __m128i cont = _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(0xc0)));
+   __m128i ge2 = mm_cmpge_epu8(v, 0xc0), ge3 = mm_cmpge_epu8(v, 0xe0), ge4 = mm_cmpge_epu8(v, 0xf0);
+   unsigned lead_mask = ~static_cast<unsigned>(_mm_movemask_epi8(cont)) & 0xffff;
+   if (!(lead_mask & 1)) {
+      return 0;
+   }
+   unsigned ge4_mask = static_cast<unsigned>(_mm_movemask_epi8(ge4));
+   // The last character only belongs to this block if all its bytes do.
+   unsigned last_lead = 31 - static_cast<unsigned>(__builtin_clz(lead_mask));
+   unsigned last_size = 1 +
+      ((static_cast<unsigned>(_mm_movemask_epi8(ge2)) >> last_lead) & 1) +
+      ((static_cast<unsigned>(_mm_movemask_epi8(ge3)) >> last_lead) & 1) +
+      ((ge4_mask >> last_lead) & 1);
+   unsigned size = last_lead + last_size <= 16 ? 16 : last_lead;
+   unsigned size_mask = (1u << size) - 1;
+
+   // A byte must be a continuation byte if, and only if, the lead byte before it calls for one.
+   __m128i needs_cont = _mm_or_si128(
+      _mm_or_si128(_mm_slli_si128(ge2, 1), _mm_slli_si128(ge3, 2)), _mm_slli_si128(ge4, 3)
+   );
+   /* This also checks the lead byte of an incomplete last character, in case a character before it claims it
+   as a continuation byte. */
+   unsigned seq_errors = static_cast<unsigned>(_mm_movemask_epi8(_mm_xor_si128(needs_cont, cont))) &
+      ((size_mask << 1) | 1);
+   // C0 and C1 can only start overlong sequences, and F5-FF code points beyond U+10FFFF.
+   __m128i bad = _mm_or_si128(
+      _mm_cmpeq_epi8(
+         _mm_and_si128(v, _mm_set1_epi8(static_cast<char>(0xfe))), _mm_set1_epi8(static_cast<char>(0xc0))
+      ),
+      mm_cmpge_epu8(v, 0xf5)
+   );
+   /* Other lead bytes restrict the byte after them: E0 and F0 must not start overlong sequences, ED must not
+   encode a surrogate, and F4 must not go beyond U+10FFFF. */
+   __m128i next = _mm_srli_si128(v, 1);
+   __m128i next_ge_a0 = mm_cmpge_epu8(next, 0xa0), next_ge_90 = mm_cmpge_epu8(next, 0x90);
+   bad = _mm_or_si128(bad, _mm_andnot_si128(
+      next_ge_a0, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xe0)))
+   ));
+   bad = _mm_or_si128(bad, _mm_and_si128(
+      next_ge_a0, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xed)))
+   ));
+   bad = _mm_or_si128(bad, _mm_andnot_si128(
+      next_ge_90, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xf0)))
+   ));
+   bad = _mm_or_si128(bad, _mm_and_si128(
+      next_ge_90, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xf4)))
+   ));
+   unsigned errors = seq_errors | (static_cast<unsigned>(_mm_movemask_epi8(bad)) & size_mask);
+   if (errors) {
+      unsigned first_error = static_cast<unsigned>(__builtin_ctz(errors));
+      // Stop at the character containing the first error.
+      unsigned leads_before = lead_mask & ((2u << first_error) - 1);
+      if (seq_errors & lead_mask & (1u << first_error)) {
+         // A lead byte where a continuation byte was expected: the character before it is incomplete.
+         leads_before &= ~(1u << first_error);
+      }
+      size = 31 - static_cast<unsigned>(__builtin_clz(leads_before));
+      size_mask = (1u << size) - 1;
+   }
+   *leads = lead_mask & size_mask;
+   *four_byte_leads = ge4_mask & size_mask;
+   return size;
+}
+
+/*! Builds the UTF-8 sequences for four code points, each in its own 32-bit lane with its lead byte in the
+lowest bits, i.e. in memory order. The code points must be within U+10FFFF; surrogates are encoded as any
+other code point.
+
+@param cp
+   Code points, one per 32-bit lane.
+@param ge2
+   Mask of the lanes whose code point needs two or more bytes.
+@param ge3
+   Mask of the lanes whose code point needs three or more bytes.
+@param ge4
+   Mask of the lanes whose code point needs four bytes.
+@return
+   Sequences.
+*/
+static inline __m128i utf8_build_4(__m128i cp, __m128i ge2, __m128i ge3, __m128i ge4) {
+   // Continuation bytes with bits 0-5, 6-11 and 12-17 of each code point.
+   __m128i six_bits = _mm_set1_epi32(0x3f), cont_tag = _mm_set1_epi32(0x80);
+   __m128i t0 = _mm_or_si128(_mm_and_si128(                cp     , six_bits), cont_tag);
+   __m128i t1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(cp,  6), six_bits), cont_tag);
+   __m128i t2 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(cp, 12), six_bits), cont_tag);
+   __m128i seq2 = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi32(cp, 6), _mm_set1_epi32(0xc0)), _mm_slli_epi32(t0, 8)
+   );
+   __m128i seq3 = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi32(cp, 12), _mm_set1_epi32(0xe0)),
+      _mm_or_si128(_mm_slli_epi32(t1, 8), _mm_slli_epi32(t0, 16))
+   );
+   __m128i seq4 = _mm_or_si128(
+      _mm_or_si128(_mm_srli_epi32(cp, 18), _mm_set1_epi32(0xf0)),
+      _mm_or_si128(_mm_slli_epi32(t2, 8), _mm_or_si128(_mm_slli_epi32(t1, 16), _mm_slli_epi32(t0, 24)))
+   );
+   return mm_select(ge4, seq4, mm_select(ge3, seq3, mm_select(ge2, seq2, cp)));
+}
+
+/*! Packs UTF-8 sequences built in 32-bit lanes, as returned by utf8_build_4(), at the start of a vector.
+
+@param seqs
+   Sequences.
+@param ge2_mask
+   Bit mask of the lanes whose sequence is two or more bytes long.
+@param ge3_mask
+   Bit mask of the lanes whose sequence is three or more bytes long.
+@param ge4_mask
+   Bit mask of the lanes whose sequence is four bytes long.
+@param lanes
+   Count of lanes, starting from the first, to pack; the bytes packed from the others are not valid.
+@param shuffles
+   Shuffles to pack the sequences with, or nullptr to only calculate *size.
+@param size
+   Pointer to a variable that will receive the count of bytes packed from the first lanes.
+@return
+   Packed sequences.
+*/
+__attribute__((target("ssse3,popcnt"))) static inline __m128i utf8_pack_4(
+   __m128i seqs, unsigned ge2_mask, unsigned ge3_mask, unsigned ge4_mask, unsigned lanes,
+   multibyte_shuffles const * shuffles, unsigned * size
+) {
+   //! Maps each bit i of a 4-bit number to bit 2i.
+   static std::uint8_t const spread_bits[16] = {
+      0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+   };
+
+   unsigned lanes_mask = (1u << lanes) - 1;
+   *size = lanes + static_cast<unsigned>(
+      __builtin_popcount(ge2_mask & lanes_mask) + __builtin_popcount(ge3_mask & lanes_mask) +
+      __builtin_popcount(ge4_mask & lanes_mask)
+   );
+   if (!shuffles) {
+      return seqs;
+   }
+   // Each lane’s length minus 1 is the count of thresholds its sequence reaches.
+   unsigned lengths = static_cast<unsigned>(
+      spread_bits[ge2_mask] + spread_bits[ge3_mask] + spread_bits[ge4_mask]
+   );
+   return _mm_shuffle_epi8(seqs, _mm_loadu_si128(
+      reinterpret_cast<__m128i const *>(shuffles->gather_utf8[lengths])
+   ));
+}
+
+/*! Encodes up to four code points in UTF-8. The code points must be within U+10FFFF.
+
+@param cp
+   Code points, one per 32-bit lane.
+@param lanes
+   Count of lanes, starting from the first, to encode; the bytes encoded from the others are not valid.
+@param shuffles
+   Shuffles to pack the encoded code points with, or nullptr to only calculate *size.
+@param size
+   Pointer to a variable that will receive the count of bytes of the code points encoded from the first lanes.
+@return
+   Encoded code points, at the start of the vector.
+*/
+__attribute__((target("ssse3,popcnt"))) static inline __m128i utf8_encode_4(
+   __m128i cp, unsigned lanes, multibyte_shuffles const * shuffles, unsigned * size
+) {
+   __m128i ge2 = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7f));
+   __m128i ge3 = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7ff));
+   __m128i ge4 = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0xffff));
+   return utf8_pack_4(
+      shuffles ? utf8_build_4(cp, ge2, ge3, ge4) : cp,
+      static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(ge2))),
+      static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(ge3))),
+      static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(ge4))), lanes, shuffles, size
+   );
+}
+
+/*! SSSE3 implementation of the conversion of a run of characters from UTF-8 to UTF-8, which validates and
+copies them.
+
+@param src
+   Pointer to a pointer to the source characters.
+@param src_end
+   End of the source characters.
+@param dst
+   Pointer to a pointer to the destination buffer.
+@param dst_end
+   End of the destination buffer.
+@param write
+   If false, the characters are only counted.
+*/
+__attribute__((target("ssse3,popcnt"))) static void multibyte_run_8_to_8(
+   std::uint8_t const ** src, std::uint8_t const * src_end, std::uint8_t ** dst, std::uint8_t const * dst_end,
+   bool write
+) {
+   std::uint8_t const * s = *src;
+   std::uint8_t * d = *dst;
+   while (src_end - s >= 16 && static_cast<std::size_t>(dst_end - d) >= 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+      unsigned size = 16;
+      if (_mm_movemask_epi8(v)) {
+         unsigned leads, four_byte_leads;
+         size = utf8_block_valid_size(v, &leads, &four_byte_leads);
+         if (!size) {
+            break;
+         }
+      }
+      if (write) {
+         _mm_storeu_si128(reinterpret_cast<__m128i *>(d), v);
+      }
+      s += size;
+      d += size;
+   }
+   *src = s;
+   *dst = d;
+}
+
+/*! Decodes half of a block of UTF-8 bytes validated by utf8_block_valid_size() into UTF-16 characters, in
+host byte order. Four-byte characters are decoded into surrogate pairs: the lead surrogate takes the place of
+the character at its lead byte, and the trail surrogate is decoded at the byte after it.
+
+@param v
+   Block to decode.
+@param half
+   0 to decode the first 8 bytes of v, or 1 to decode the last 8.
+@param lane_mask
+   Mask of the bytes in the selected half that start a character or, after a four-byte lead byte, a trail
+   surrogate.
+@param shuffles
+   Shuffles to pack the characters with.
+@return
+   Characters decoded at the bytes in lane_mask, packed at the start of the vector.
+*/
+__attribute__((target("ssse3"))) static inline __m128i utf8_decode_half(
+   __m128i v, unsigned half, unsigned lane_mask, multibyte_shuffles const & shuffles
+) {
+   // Decode a candidate character at each byte, then keep only the ones in lane_mask.
+   __m128i zero = _mm_setzero_si128(), six_bits = _mm_set1_epi16(0x3f);
+   __m128i vp = _mm_slli_si128(v, 1), v1 = _mm_srli_si128(v, 1), v2 = _mm_srli_si128(v, 2);
+   __m128i bp = half ? _mm_unpackhi_epi8(vp, zero) : _mm_unpacklo_epi8(vp, zero);
+   __m128i b0 = half ? _mm_unpackhi_epi8(v , zero) : _mm_unpacklo_epi8(v , zero);
+   __m128i b1 = half ? _mm_unpackhi_epi8(v1, zero) : _mm_unpacklo_epi8(v1, zero);
+   __m128i b2 = half ? _mm_unpackhi_epi8(v2, zero) : _mm_unpacklo_epi8(v2, zero);
+   __m128i c1 = _mm_and_si128(b1, six_bits), c2 = _mm_and_si128(b2, six_bits);
+   __m128i ch2 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b0, _mm_set1_epi16(0x1f)), 6), c1);
+   // Shifting b0 left by 12 drops its high nibble.
+   __m128i ch3 = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(b0, 12), _mm_slli_epi16(c1, 6)), c2);
+   // 0xd800 - (0x10000 >> 10) = 0xd7c0.
+   __m128i lead_surrogate = _mm_add_epi16(_mm_or_si128(_mm_or_si128(
+      _mm_slli_epi16(_mm_and_si128(b0, _mm_set1_epi16(0x07)), 8), _mm_slli_epi16(c1, 2)
+   ), _mm_srli_epi16(c2, 4)), _mm_set1_epi16(static_cast<short>(0xd7c0)));
+   __m128i trail_surrogate = _mm_or_si128(_mm_or_si128(
+      _mm_slli_epi16(_mm_and_si128(c1, _mm_set1_epi16(0x0f)), 6), c2
+   ), _mm_set1_epi16(static_cast<short>(0xdc00)));
+   __m128i ch = mm_select(
+      _mm_cmplt_epi16(b0, _mm_set1_epi16(0x80)), b0, mm_select(
+         _mm_cmpgt_epi16(bp, _mm_set1_epi16(0xef)), trail_surrogate, mm_select(
+            _mm_cmplt_epi16(b0, _mm_set1_epi16(0xe0)), ch2, mm_select(
+               _mm_cmplt_epi16(b0, _mm_set1_epi16(0xf0)), ch3, lead_surrogate
+            )
+         )
+      )
+   );
+   return _mm_shuffle_epi8(ch, _mm_loadu_si128(
+      reinterpret_cast<__m128i const *>(shuffles.compress16[lane_mask])
+   ));
+}
+
+/*! SSSE3 implementation of the conversion of a run of characters from UTF-8 to UTF-16.
+
+@param src
+   Pointer to a pointer to the source characters.
+@param src_end
+   End of the source characters.
+@param dst
+   Pointer to a pointer to the destination buffer.
+@param dst_end
+   End of the destination buffer.
+@param dst_swap
+   true if the destination characters must not be in host byte order.
+@param write
+   If false, the characters are only counted.
+*/
+__attribute__((target("ssse3,popcnt"))) static void multibyte_run_8_to_16(
+   std::uint8_t const ** src, std::uint8_t const * src_end, std::uint8_t ** dst, std::uint8_t const * dst_end,
+   bool dst_swap, bool write
+) {
+   multibyte_shuffles const & shuffles = get_multibyte_shuffles();
+   __m128i zero = _mm_setzero_si128();
+   std::uint8_t const * s = *src;
+   std::uint8_t * d = *dst;
+   // 16 characters take up to 32 bytes.
+   while (src_end - s >= 16 && static_cast<std::size_t>(dst_end - d) >= 32) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+      if (!_mm_movemask_epi8(v)) {
+         if (write) {
+            __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+            if (dst_swap) {
+               lo = _mm_slli_epi16(lo, 8);
+               hi = _mm_slli_epi16(hi, 8);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d     ), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 16), hi);
+         }
+         s += 16;
+         d += 32;
+         continue;
+      }
+      unsigned leads, four_byte_leads;
+      unsigned size = utf8_block_valid_size(v, &leads, &four_byte_leads);
+      if (!size) {
+         break;
+      }
+      // A four-byte character becomes a surrogate pair, so its second byte yields a character too.
+      unsigned units = leads | (four_byte_leads << 1);
+      if (write) {
+         for (unsigned half = 0; half < 2; ++half) {
+            unsigned lane_mask = (units >> (half * 8)) & 0xff;
+            __m128i ch = utf8_decode_half(v, half, lane_mask, shuffles);
+            if (dst_swap) {
+               ch = mm_swap_epi16(ch);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d), ch);
+            d += static_cast<unsigned>(__builtin_popcount(lane_mask)) * sizeof(char16_t);
+         }
+      } else {
+         d += static_cast<unsigned>(__builtin_popcount(units)) * sizeof(char16_t);
+      }
+      s += size;
+   }
+   *src = s;
+   *dst = d;
+}
+
+/*! SSSE3 implementation of the conversion of a run of characters from UTF-8 to UTF-32.
+
+@param src
+   Pointer to a pointer to the source characters.
+@param src_end
+   End of the source characters.
+@param dst
+   Pointer to a pointer to the destination buffer.
+@param dst_end
+   End of the destination buffer.
+@param dst_swap
+   true if the destination characters must not be in host byte order.
+@param write
+   If false, the characters are only counted.
+*/
+__attribute__((target("ssse3,popcnt"))) static void multibyte_run_8_to_32(
+   std::uint8_t const ** src, std::uint8_t const * src_end, std::uint8_t ** dst, std::uint8_t const * dst_end,
+   bool dst_swap, bool write
+) {
+   multibyte_shuffles const & shuffles = get_multibyte_shuffles();
+   __m128i zero = _mm_setzero_si128();
+   std::uint8_t const * s = *src;
+   std::uint8_t * d = *dst;
+   // 16 characters take up to 64 bytes.
+   while (src_end - s >= 16 && static_cast<std::size_t>(dst_end - d) >= 64) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+      if (!_mm_movemask_epi8(v)) {
+         if (write) {
+            __m128i lanes[4];
+            mm_widen_epu8_epi32(v, lanes);
+            for (unsigned quarter = 0; quarter < 4; ++quarter) {
+               _mm_storeu_si128(
+                  reinterpret_cast<__m128i *>(d + quarter * 16),
+                  dst_swap ? _mm_slli_epi32(lanes[quarter], 24) : lanes[quarter]
+               );
+            }
+         }
+         s += 16;
+         d += 64;
+         continue;
+      }
+      unsigned leads, four_byte_leads;
+      unsigned size = utf8_block_valid_size(v, &leads, &four_byte_leads);
+      if (!size) {
+         break;
+      }
+      if (write && !four_byte_leads) {
+         // Only BMP characters: decode them as UTF-16, which is cheaper, then widen them.
+         for (unsigned half = 0; half < 2; ++half) {
+            unsigned lane_mask = (leads >> (half * 8)) & 0xff;
+            __m128i ch = utf8_decode_half(v, half, lane_mask, shuffles);
+            __m128i lo = _mm_unpacklo_epi16(ch, zero), hi = _mm_unpackhi_epi16(ch, zero);
+            if (dst_swap) {
+               lo = mm_swap_epi32(lo);
+               hi = mm_swap_epi32(hi);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d     ), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 16), hi);
+            d += static_cast<unsigned>(__builtin_popcount(lane_mask)) * sizeof(char32_t);
+         }
+      } else if (write) {
+         // Decode a candidate character at each byte, then keep only the ones at lead bytes.
+         __m128i b0[4], b1[4], b2[4], b3[4];
+         mm_widen_epu8_epi32(v, b0);
+         mm_widen_epu8_epi32(_mm_srli_si128(v, 1), b1);
+         mm_widen_epu8_epi32(_mm_srli_si128(v, 2), b2);
+         mm_widen_epu8_epi32(_mm_srli_si128(v, 3), b3);
+         __m128i six_bits = _mm_set1_epi32(0x3f);
+         for (unsigned quarter = 0; quarter < 4; ++quarter) {
+            __m128i lead = b0[quarter];
+            __m128i c1 = _mm_and_si128(b1[quarter], six_bits);
+            __m128i c2 = _mm_and_si128(b2[quarter], six_bits);
+            __m128i c3 = _mm_and_si128(b3[quarter], six_bits);
+            __m128i ch2 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(lead, _mm_set1_epi32(0x1f)), 6), c1);
+            __m128i ch3 = _mm_or_si128(_mm_or_si128(
+               _mm_slli_epi32(_mm_and_si128(lead, _mm_set1_epi32(0x0f)), 12), _mm_slli_epi32(c1, 6)
+            ), c2);
+            __m128i ch4 = _mm_or_si128(_mm_or_si128(
+               _mm_slli_epi32(_mm_and_si128(lead, _mm_set1_epi32(0x07)), 18), _mm_slli_epi32(c1, 12)
+            ), _mm_or_si128(_mm_slli_epi32(c2, 6), c3));
+            __m128i ch = mm_select(
+               _mm_cmplt_epi32(lead, _mm_set1_epi32(0x80)), lead, mm_select(
+                  _mm_cmplt_epi32(lead, _mm_set1_epi32(0xe0)), ch2, mm_select(
+                     _mm_cmplt_epi32(lead, _mm_set1_epi32(0xf0)), ch3, ch4
+                  )
+               )
+            );
+            unsigned lane_mask = (leads >> (quarter * 4)) & 0xf;
+            ch = _mm_shuffle_epi8(ch, _mm_loadu_si128(
+               reinterpret_cast<__m128i const *>(shuffles.compress32[lane_mask])
+            ));
+            if (dst_swap) {
+               ch = mm_swap_epi32(ch);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d), ch);
+            d += static_cast<unsigned>(__builtin_popcount(lane_mask)) * sizeof(char32_t);
+         }
+      } else {
+         d += static_cast<unsigned>(__builtin_popcount(leads)) * sizeof(char32_t);
+      }
+      s += size;
+   }
+   *src = s;
+   *dst = d;
+}
+
+/*! SSSE3 implementation of the conversion of a run of characters from UTF-16 to UTF-8.
+
+@param src
+   Pointer to a pointer to the source characters.
+@param src_end
+   End of the source characters.
+@param src_swap
+   true if the source characters are not in host byte order.
+@param dst
+   Pointer to a pointer to the destination buffer.
+@param dst_end
+   End of the destination buffer.
+@param write
+   If false, the characters are only counted.
+*/
+__attribute__((target("ssse3,popcnt"))) static void multibyte_run_16_to_8(
+   std::uint8_t const ** src, std::uint8_t const * src_end, bool src_swap, std::uint8_t ** dst,
+   std::uint8_t const * dst_end, bool write
+) {
+   multibyte_shuffles const & shuffles = get_multibyte_shuffles();
+   __m128i zero = _mm_setzero_si128();
+   std::uint8_t const * s = *src;
+   std::uint8_t * d = *dst;
+   // 8 characters take up to 24 bytes, written by two 16-byte stores.
+   while (src_end - s >= 16 && static_cast<std::size_t>(dst_end - d) >= 32) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+      if (src_swap) {
+         v = mm_swap_epi16(v);
+      }
+      __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xff80))), zero);
+      if (_mm_movemask_epi8(ascii) == 0xffff) {
+         if (write) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(d), _mm_packus_epi16(v, zero));
+         }
+         s += 16;
+         d += 8;
+         continue;
+      }
+      __m128i surrogate_bits = _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xfc00)));
+      __m128i leads  = _mm_cmpeq_epi16(surrogate_bits, _mm_set1_epi16(static_cast<short>(0xd800)));
+      __m128i trails = _mm_cmpeq_epi16(surrogate_bits, _mm_set1_epi16(static_cast<short>(0xdc00)));
+      /* Each lead surrogate must be followed by a trail surrogate, and vice versa; stop at the first one that
+      isn’t, including a lead surrogate whose trail surrogate is in the next block. */
+      unsigned errors = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(
+         _mm_andnot_si128(_mm_srli_si128(trails, 2), leads),
+         _mm_andnot_si128(_mm_slli_si128(leads, 2), trails)
+      )));
+      unsigned units = errors ? static_cast<unsigned>(__builtin_ctz(errors)) / 2 : 8;
+      if (!units) {
+         break;
+      }
+      /* A surrogate pair becomes a four-byte sequence, whose first two bytes only depend on the lead
+      surrogate, and the last two mostly on the trail surrogate; so each surrogate is encoded in two bytes. */
+      __m128i prev = _mm_slli_si128(v, 2);
+      for (unsigned half = 0; half < 2 && half * 4 < units; ++half) {
+         __m128i cp, prev_cp, lead, trail;
+         if (half) {
+            cp      = _mm_unpackhi_epi16(v     , zero);
+            prev_cp = _mm_unpackhi_epi16(prev  , zero);
+            lead    = _mm_unpackhi_epi16(leads , leads );
+            trail   = _mm_unpackhi_epi16(trails, trails);
+         } else {
+            cp      = _mm_unpacklo_epi16(v     , zero);
+            prev_cp = _mm_unpacklo_epi16(prev  , zero);
+            lead    = _mm_unpacklo_epi16(leads , leads );
+            trail   = _mm_unpacklo_epi16(trails, trails);
+         }
+         __m128i surrogate = _mm_or_si128(lead, trail);
+         __m128i ge2 = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7f));
+         __m128i ge3 = _mm_andnot_si128(surrogate, _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7ff)));
+         unsigned size;
+         __m128i seqs = cp;
+         if (write) {
+            __m128i six_bits = _mm_set1_epi32(0x3f), cont_tag = _mm_set1_epi32(0x80);
+            // Bits 10-20 of the code point, minus 0x10000.
+            __m128i high = _mm_add_epi32(_mm_and_si128(cp, _mm_set1_epi32(0x3ff)), _mm_set1_epi32(0x40));
+            __m128i lead_seq = _mm_or_si128(
+               _mm_or_si128(_mm_srli_epi32(high, 8), _mm_set1_epi32(0xf0)),
+               _mm_slli_epi32(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(high, 2), six_bits), cont_tag), 8)
+            );
+            __m128i trail_seq = _mm_or_si128(
+               _mm_or_si128(
+                  _mm_slli_epi32(_mm_and_si128(prev_cp, _mm_set1_epi32(0x3)), 4),
+                  _mm_or_si128(_mm_and_si128(_mm_srli_epi32(cp, 6), _mm_set1_epi32(0xf)), cont_tag)
+               ),
+               _mm_slli_epi32(_mm_or_si128(_mm_and_si128(cp, six_bits), cont_tag), 8)
+            );
+            seqs = mm_select(lead, lead_seq, mm_select(trail, trail_seq, utf8_build_4(cp, ge2, ge3, zero)));
+         }
+         seqs = utf8_pack_4(
+            seqs, static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(ge2))),
+            static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(ge3))), 0,
+            units - half * 4 < 4 ? units - half * 4 : 4, write ? &shuffles : nullptr, &size
+         );
+         if (write) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d), seqs);
+         }
+         d += size;
+      }
+      s += units * sizeof(char16_t);
+   }
+   *src = s;
+   *dst = d;
+}
+
+/*! SSSE3 implementation of the conversion of a run of characters from UTF-32 to UTF-8. Surrogates and values
+beyond U+10FFFF are left to the general loop.
+
+@param src
+   Pointer to a pointer to the source characters.
+@param src_end
+   End of the source characters.
+@param src_swap
+   true if the source characters are not in host byte order.
+@param dst
+   Pointer to a pointer to the destination buffer.
+@param dst_end
+   End of the destination buffer.
+@param write
+   If false, the characters are only counted.
+*/
+__attribute__((target("ssse3,popcnt"))) static void multibyte_run_32_to_8(
+   std::uint8_t const ** src, std::uint8_t const * src_end, bool src_swap, std::uint8_t ** dst,
+   std::uint8_t const * dst_end, bool write
+) {
+   multibyte_shuffles const & shuffles = get_multibyte_shuffles();
+   __m128i zero = _mm_setzero_si128();
+   std::uint8_t const * s = *src;
+   std::uint8_t * d = *dst;
+   // 16 characters take up to 64 bytes.
+   while (src_end - s >= 64 && static_cast<std::size_t>(dst_end - d) >= 64) {
+      __m128i v[4];
+      __m128i all = zero;
+      for (unsigned quarter = 0; quarter < 4; ++quarter) {
+         v[quarter] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + quarter * 16));
+         if (src_swap) {
+            v[quarter] = mm_swap_epi32(v[quarter]);
+         }
+         all = _mm_or_si128(all, v[quarter]);
+      }
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, _mm_set1_epi32(~0x7f)), zero)) == 0xffff) {
+         if (write) {
+            // All values are < 0x80, so the saturating packs are just narrowing.
+            __m128i lo = _mm_packs_epi32(v[0], v[1]), hi = _mm_packs_epi32(v[2], v[3]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_packus_epi16(lo, hi));
+         }
+         s += 64;
+         d += 16;
+         continue;
+      }
+      for (unsigned quarter = 0; quarter < 4; ++quarter) {
+         __m128i cp = v[quarter];
+         __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi32(cp, zero), _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x10ffff))),
+            _mm_cmpeq_epi32(
+               _mm_and_si128(cp, _mm_set1_epi32(static_cast<int>(0xfffff800u))), _mm_set1_epi32(0xd800)
+            )
+         );
+         unsigned special_mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(special)));
+         unsigned lanes = special_mask ? static_cast<unsigned>(__builtin_ctz(special_mask)) : 4;
+         if (lanes) {
+            unsigned size;
+            __m128i seqs = utf8_encode_4(cp, lanes, write ? &shuffles : nullptr, &size);
+            if (write) {
+               _mm_storeu_si128(reinterpret_cast<__m128i *>(d), seqs);
+            }
+            d += size;
+            s += lanes * sizeof(char32_t);
+         }
+         if (lanes < 4) {
+            // Leave the special code point to the general loop.
+            *src = s;
+            *dst = d;
+            return;
+         }
+      }
+   }
+   *src = s;
+   *dst = d;
+}
+   #endif
+#endif
+
+/*! Returns true if transcode() can use transcode_multibyte_run(). Only valid if ascii_run_supported() also
+returns true for the encodings involved.
+
+@return
+   true if the multi-byte fast paths are available, or false otherwise.
+*/
+static bool multibyte_run_supported() {
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   // Checked once; the result is cached in a thread-safe way by the compiler.
+   static bool const ssse3 = __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("popcnt");
+   return ssse3;
+   #endif
+#endif
+   return false;
+}
+
+/*! Converts whole blocks of valid characters at the start of *src from src_enc to dst_enc. Only valid if
+ascii_run_supported(src_enc, dst_enc) and multibyte_run_supported() return true.
+
+@param src_enc
+   Source encoding.
+@param src
+   Pointer to a pointer to the source characters, which is advanced past the converted characters.
+@param src_end
+   End of the source characters.
+@param dst_enc
+   Destination encoding.
+@param dst
+   Pointer to a pointer to the destination buffer, which is advanced past the converted characters.
+@param dst_end
+   End of the destination buffer.
+@param write
+   If false, the characters are only counted.
+*/
+static void transcode_multibyte_run(
+   _pub::encoding src_enc, std::uint8_t const ** src, std::uint8_t const * src_end, _pub::encoding dst_enc,
+   std::uint8_t ** dst, std::uint8_t const * dst_end, bool write
+) {
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   switch (src_enc.base()) {
+      case _pub::encoding::utf16le:
+      case _pub::encoding::utf16be:
+         multibyte_run_16_to_8(src, src_end, src_enc != _pub::encoding::utf16_host, dst, dst_end, write);
+         return;
+      case _pub::encoding::utf32le:
+      case _pub::encoding::utf32be:
+         multibyte_run_32_to_8(src, src_end, src_enc != _pub::encoding::utf32_host, dst, dst_end, write);
+         return;
+      default:
+         switch (dst_enc.base()) {
+            case _pub::encoding::utf16le:
+            case _pub::encoding::utf16be:
+               multibyte_run_8_to_16(
+                  src, src_end, dst, dst_end, dst_enc != _pub::encoding::utf16_host, write
+               );
+               return;
+            case _pub::encoding::utf32le:
+            case _pub::encoding::utf32be:
+               multibyte_run_8_to_32(
+                  src, src_end, dst, dst_end, dst_enc != _pub::encoding::utf32_host, write
+               );
+               return;
+            default:
+               multibyte_run_8_to_8(src, src_end, dst, dst_end, write);
+               return;
+         }
+   }
+   #endif
+#endif
+   LOFTY_UNUSED_ARG(src_enc);
+   LOFTY_UNUSED_ARG(src);
+   LOFTY_UNUSED_ARG(src_end);
+   LOFTY_UNUSED_ARG(dst_enc);
+   LOFTY_UNUSED_ARG(dst);
+   LOFTY_UNUSED_ARG(dst_end);
+   LOFTY_UNUSED_ARG(write);
+}
+
+}}} //namespace lofty::text::_pvt
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -69,6 +1290,41 @@ str get_line_terminator_str(line_terminator lterm) {
    }
 }
 
+std::size_t get_valid_utf8_prefix_size(void const * src, std::size_t src_byte_size) {
+   // Smallest code point that may be encoded with a sequence of each length; anything less is overlong.
+   static char32_t const min_codepoints_by_seq_size[] = { 0, 0, 0x80, 0x800, 0x10000 };
+   auto src_bytes = static_cast<std::uint8_t const *>(src);
+   std::size_t i = 0;
+   for (;;) {
+      i += _pvt::ascii_run_8_to_8(src_bytes + i, nullptr, src_byte_size - i);
+      if (i == src_byte_size) {
+         break;
+      }
+      char8_t lead_ch = static_cast<char8_t>(src_bytes[i]);
+      if (!utf8_char_traits::is_valid_lead_char(lead_ch)) {
+         break;
+      }
+      unsigned seq_byte_size = utf8_char_traits::lead_char_to_codepoint_size(lead_ch);
+      if (seq_byte_size < 2 || seq_byte_size > 4 || seq_byte_size > src_byte_size - i) {
+         break;
+      }
+      char32_t cp = utf8_char_traits::get_lead_char_codepoint_bits(lead_ch, seq_byte_size - 1);
+      unsigned j = 1;
+      for (; j < seq_byte_size; ++j) {
+         char8_t trail_ch = static_cast<char8_t>(src_bytes[i + j]);
+         if (!utf8_char_traits::is_trail_char(trail_ch)) {
+            break;
+         }
+         cp = (cp << 6) | (trail_ch & 0x3f);
+      }
+      if (j < seq_byte_size || cp < min_codepoints_by_seq_size[seq_byte_size] || !is_codepoint_valid(cp)) {
+         break;
+      }
+      i += seq_byte_size;
+   }
+   return i;
+}
+
 encoding guess_encoding(
    void const * buf_begin, void const * buf_end, std::size_t src_total_bytes /*= 0*/,
    std::size_t * bom_byte_size /*= nullptr*/
@@ -344,8 +1600,36 @@ std::size_t transcode(
       dst_bytes_end = static_cast<std::uint8_t *>(nullptr) + numeric::max<std::size_t>::value;
    }
 
+   bool ascii_fast_path = _pvt::ascii_run_supported(src_enc, dst_enc);
+   bool multibyte_fast_path = ascii_fast_path && _pvt::multibyte_run_supported();
+   std::size_t src_char_size = get_encoding_size(src_enc), dst_char_size = get_encoding_size(dst_enc);
    std::uint8_t const * last_used_src_byte_ptr;
    for (;;) {
+      if (ascii_fast_path) {
+         /* Convert as many ASCII characters as possible in bulk, then whole blocks of other characters, for
+         as long as that makes progress; anything else goes through the code below. */
+         std::uint8_t const * run_begin;
+         do {
+            std::size_t size = static_cast<std::size_t>(src_bytes_end - src_bytes) / src_char_size;
+            if (dst_byte_size_max) {
+               size = std::min(size, static_cast<std::size_t>(dst_bytes_end - dst_bytes) / dst_char_size);
+            }
+            if (size) {
+               std::size_t ascii_size = _pvt::transcode_ascii_run(
+                  src_enc, src_bytes, dst_enc, write ? dst_bytes : nullptr, size
+               );
+               src_bytes += ascii_size * src_char_size;
+               dst_bytes += ascii_size * dst_char_size;
+            }
+            if (!multibyte_fast_path) {
+               break;
+            }
+            run_begin = src_bytes;
+            _pvt::transcode_multibyte_run(
+               src_enc, &src_bytes, src_bytes_end, dst_enc, &dst_bytes, dst_bytes_end, write
+            );
+         } while (src_bytes != run_begin);
+      }
       last_used_src_byte_ptr = src_bytes;
       char32_t ch32;
 
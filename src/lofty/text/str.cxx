@@ -23,6 +23,7 @@ more details.
 #include <lofty/text/parsers/dynamic.hxx>
 #include <lofty/text/parsers/regex.hxx>
 #include <lofty/text/str.hxx>
+#include <lofty/text/str_traits.hxx>
 #include <lofty/to_text_ostream.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -200,6 +201,13 @@ str::const_iterator str::find(str const & substr_, const_iterator whence) const
    return const_iterator(this, static_cast<std::size_t>(ptr - data()));
 }
 
+str::const_iterator str::find(str_searcher const & searcher, const_iterator whence) const {
+   char_t const * whence_ptr = data() + whence.char_index_;
+   validate_pointer(whence_ptr, true);
+   auto ptr = searcher.find(whence_ptr, data_end());
+   return const_iterator(this, static_cast<std::size_t>(ptr - data()));
+}
+
 str::const_iterator str::find_last(char_t ch, const_iterator whence) const {
    char_t const * whence_ptr = data() + whence.char_index_;
    validate_pointer(whence_ptr, true);
@@ -321,31 +329,8 @@ char_t const * str::validate_index_to_pointer(std::size_t char_index, bool allow
 
 namespace std {
 
-/* Implementation based on the Fowler/Noll/Vo variant 1a (FNV-1a) algorithm. See
-<http://www.isthe.com/chongo/tech/comp/fnv/> for details.
-
-The bases are calculated by src/fnv_hash_basis.py. */
 std::size_t hash<lofty::text::str>::operator()(lofty::text::str const & s) const {
-   static_assert(
-      sizeof(std::size_t) * 8 == LOFTY_HOST_WORD_SIZE,
-      "unexpected sizeof(std::size_t) will break FNV prime/basis selection"
-   );
-#if LOFTY_HOST_WORD_SIZE == 16
-   static std::size_t const fnv_prime = 0x1135;
-   static std::size_t const fnv_basis = 16635u;
-#elif LOFTY_HOST_WORD_SIZE == 32
-   static std::size_t const fnv_prime = 0x01000193;
-   static std::size_t const fnv_basis = 2166136261u;
-#elif LOFTY_HOST_WORD_SIZE == 64
-   static std::size_t const fnv_prime = 0x00000100000001b3;
-   static std::size_t const fnv_basis = 14695981039346656037u;
-#endif
-   std::size_t ret = fnv_basis;
-   LOFTY_FOR_EACH(auto cp, s) {
-      ret ^= static_cast<std::size_t>(cp);
-      ret *= fnv_prime;
-   }
-   return ret;
+   return lofty::text::str_traits::hash(s.data(), s.data_end());
 }
 
 } //namespace std
@@ -17,6 +17,525 @@ more details.
 #include <lofty/_std/new.hxx>
 #include <lofty/text.hxx>
 #include <lofty/text/str_traits.hxx>
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+      #include <immintrin.h> // _mm*()
+   #elif defined(__SSE2__)
+      #include <emmintrin.h> // _mm_*()
+   #endif
+#endif
+#if LOFTY_HOST_API_POSIX
+   #include <fcntl.h> // O_* open()
+   #include <unistd.h> // close() getpid() read()
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace text { namespace _pvt {
+
+/* Vector implementations of the search primitives compare many characters at a time, producing a bit mask
+with sizeof(char_t) bits for each matching character; for UTF-16, each pair of bits is the same. */
+
+/*! Scalar implementation of str_traits::find_char(char_t), used for the tail of the string, and where vector
+instructions are not available.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch
+   Character to search for.
+@return
+   Pointer to the first match, or str_end if no matches are found.
+*/
+static char_t const * find_char_scalar(char_t const * str_begin, char_t const * str_end, char_t ch) {
+   for (auto s = str_begin; s < str_end; ++s) {
+      if (*s == ch) {
+         return s;
+      }
+   }
+   return str_end;
+}
+
+/*! Scalar implementation of str_traits::find_char_last(char_t), used for the head of the string, and where
+vector instructions are not available.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch
+   Character to search for.
+@return
+   Pointer to the last match, or str_begin if no matches are found.
+*/
+static char_t const * find_char_last_scalar(char_t const * str_begin, char_t const * str_end, char_t ch) {
+   for (auto s = str_end; s > str_begin; ) {
+      if (*--s == ch) {
+         return s;
+      }
+   }
+   return str_begin;
+}
+
+/*! Scalar implementation of str_traits::find_either_char(), used for the tail of the string, and where vector
+instructions are not available.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch1
+   First character to search for.
+@param ch2
+   Second character to search for.
+@return
+   Pointer to the first match, or str_end if no matches are found.
+*/
+static char_t const * find_either_char_scalar(
+   char_t const * str_begin, char_t const * str_end, char_t ch1, char_t ch2
+) {
+   for (auto s = str_begin; s < str_end; ++s) {
+      if (*s == ch1 || *s == ch2) {
+         return s;
+      }
+   }
+   return str_end;
+}
+
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #ifdef __SSE2__
+/*! Returns a vector with every character set to the specified one.
+
+@param ch
+   Character to copy.
+@return
+   Vector filled with ch.
+*/
+static __m128i sse2_broadcast(char_t ch) {
+      #if LOFTY_HOST_UTF == 8
+   return _mm_set1_epi8(static_cast<char>(ch));
+      #elif LOFTY_HOST_UTF == 16
+   return _mm_set1_epi16(static_cast<short>(ch));
+      #endif
+}
+
+/*! Loads 16 bytes of characters into a vector.
+
+@param s
+   Pointer to the first character to load; it doesn’t need to be aligned.
+@return
+   Vector containing the characters.
+*/
+static __m128i sse2_load(char_t const * s) {
+   return _mm_loadu_si128(reinterpret_cast<__m128i const *>(s));
+}
+
+/*! Compares each character in a vector with those in another.
+
+@param left
+   First vector.
+@param right
+   Second vector.
+@return
+   Bit mask with sizeof(char_t) bits set for each matching character.
+*/
+static unsigned sse2_match_mask(__m128i left, __m128i right) {
+      #if LOFTY_HOST_UTF == 8
+   return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)));
+      #elif LOFTY_HOST_UTF == 16
+   return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(left, right)));
+      #endif
+}
+   #endif //ifdef __SSE2__
+
+   #if LOFTY_HOST_ARCH_X86_64
+/*! AVX2 implementation of str_traits::find_char(char_t), used if the CPU supports it.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch
+   Character to search for.
+@return
+   Pointer to the first match, or str_end if no matches are found.
+*/
+__attribute__((target("avx2"))) static char_t const * find_char_avx2(
+   char_t const * str_begin, char_t const * str_end, char_t ch
+) {
+      #if LOFTY_HOST_UTF == 8
+   __m256i ch_vec = _mm256_set1_epi8(static_cast<char>(ch));
+      #elif LOFTY_HOST_UTF == 16
+   __m256i ch_vec = _mm256_set1_epi16(static_cast<short>(ch));
+      #endif
+   auto s = str_begin;
+   for (; str_end - s >= static_cast<std::ptrdiff_t>(32 / sizeof(char_t)); s += 32 / sizeof(char_t)) {
+      __m256i chars = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(s));
+      #if LOFTY_HOST_UTF == 8
+      auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, ch_vec)));
+      #elif LOFTY_HOST_UTF == 16
+      auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(chars, ch_vec)));
+      #endif
+      if (mask) {
+         return s + static_cast<unsigned>(__builtin_ctz(mask)) / sizeof(char_t);
+      }
+   }
+   return find_char_scalar(s, str_end, ch);
+}
+
+/*! AVX2 implementation of str_traits::find_char_last(char_t), used if the CPU supports it.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch
+   Character to search for.
+@return
+   Pointer to the last match, or str_begin if no matches are found.
+*/
+__attribute__((target("avx2"))) static char_t const * find_char_last_avx2(
+   char_t const * str_begin, char_t const * str_end, char_t ch
+) {
+      #if LOFTY_HOST_UTF == 8
+   __m256i ch_vec = _mm256_set1_epi8(static_cast<char>(ch));
+      #elif LOFTY_HOST_UTF == 16
+   __m256i ch_vec = _mm256_set1_epi16(static_cast<short>(ch));
+      #endif
+   auto s = str_end;
+   while (s - str_begin >= static_cast<std::ptrdiff_t>(32 / sizeof(char_t))) {
+      s -= 32 / sizeof(char_t);
+      __m256i chars = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(s));
+      #if LOFTY_HOST_UTF == 8
+      auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, ch_vec)));
+      #elif LOFTY_HOST_UTF == 16
+      auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(chars, ch_vec)));
+      #endif
+      if (mask) {
+         return s + static_cast<unsigned>(31 - __builtin_clz(mask)) / sizeof(char_t);
+      }
+   }
+   return find_char_last_scalar(str_begin, s, ch);
+}
+
+/*! AVX2 implementation of str_traits::find_either_char(), used if the CPU supports it.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param ch1
+   First character to search for.
+@param ch2
+   Second character to search for.
+@return
+   Pointer to the first match, or str_end if no matches are found.
+*/
+__attribute__((target("avx2"))) static char_t const * find_either_char_avx2(
+   char_t const * str_begin, char_t const * str_end, char_t ch1, char_t ch2
+) {
+      #if LOFTY_HOST_UTF == 8
+   __m256i ch1_vec = _mm256_set1_epi8(static_cast<char>(ch1));
+   __m256i ch2_vec = _mm256_set1_epi8(static_cast<char>(ch2));
+      #elif LOFTY_HOST_UTF == 16
+   __m256i ch1_vec = _mm256_set1_epi16(static_cast<short>(ch1));
+   __m256i ch2_vec = _mm256_set1_epi16(static_cast<short>(ch2));
+      #endif
+   auto s = str_begin;
+   for (; str_end - s >= static_cast<std::ptrdiff_t>(32 / sizeof(char_t)); s += 32 / sizeof(char_t)) {
+      __m256i chars = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(s));
+      #if LOFTY_HOST_UTF == 8
+      __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(chars, ch1_vec), _mm256_cmpeq_epi8(chars, ch2_vec));
+      #elif LOFTY_HOST_UTF == 16
+      __m256i matches = _mm256_or_si256(
+         _mm256_cmpeq_epi16(chars, ch1_vec), _mm256_cmpeq_epi16(chars, ch2_vec)
+      );
+      #endif
+      if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(matches))) {
+         return s + static_cast<unsigned>(__builtin_ctz(mask)) / sizeof(char_t);
+      }
+   }
+   return find_either_char_scalar(s, str_end, ch1, ch2);
+}
+   #endif //if LOFTY_HOST_ARCH_X86_64
+#endif //if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+
+/*! Builds a failure restart table; see str_traits::_build_find_failure_restart_table().
+
+@param substr_begin
+   Pointer to the beginning of the search string.
+@param substr_end
+   Pointer to the end of the search string.
+@param failure_restarts
+   Pointer to an array with as many elements as the search string has characters.
+*/
+static void build_failure_restarts(
+   char_t const * substr_begin, char_t const * substr_end, std::size_t * failure_restarts
+) {
+   auto substr_size = static_cast<std::size_t>(substr_end - substr_begin);
+   /* failure_restarts[i] is the size of the longest proper prefix of substr[0 .. i) that is also its suffix,
+   i.e. how many characters are already known to match after a mismatch on substr[i]. */
+   failure_restarts[0] = 0;
+   std::size_t restart_index = 0;
+   for (std::size_t i = 1; i < substr_size; ++i) {
+      failure_restarts[i] = restart_index;
+      while (restart_index > 0 && substr_begin[i] != substr_begin[restart_index]) {
+         restart_index = failure_restarts[restart_index];
+      }
+      if (substr_begin[i] == substr_begin[restart_index]) {
+         ++restart_index;
+      }
+   }
+}
+
+/*! Searches for a substring using the Knuth-Morris-Pratt algorithm, which is linear in the size of the string
+to search regardless of the contents of either string.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param substr_begin
+   Pointer to the first character of the string to search for.
+@param substr_end
+   Pointer to beyond the last character of the string to search for.
+@param failure_restarts
+   Failure restart table for the substring.
+@return
+   Pointer to the beginning of the first match, or str_end if no matches are found.
+*/
+static char_t const * find_substr_kmp(
+   char_t const * str_begin, char_t const * str_end, char_t const * substr_begin, char_t const * substr_end,
+   std::size_t const * failure_restarts
+) {
+   auto substr_size = static_cast<std::size_t>(substr_end - substr_begin);
+   std::size_t matched = 0;
+   for (auto s = str_begin; s < str_end; ++s) {
+      /* The current character ends the match sequence; use failure_restarts to see how much into the
+      substring we can retry matching characters. */
+      while (matched > 0 && *s != substr_begin[matched]) {
+         matched = failure_restarts[matched];
+      }
+      if (*s == substr_begin[matched] && ++matched == substr_size) {
+         // The substring was exhausted, which means that all its characters were matched in the string.
+         return s + 1 - substr_size;
+      }
+   }
+   return str_end;
+}
+
+/*! Searches for a substring using the Knuth-Morris-Pratt algorithm, building the failure restart table first.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param substr_begin
+   Pointer to the first character of the string to search for.
+@param substr_end
+   Pointer to beyond the last character of the string to search for.
+@return
+   Pointer to the beginning of the first match, or str_end if no matches are found.
+*/
+static char_t const * find_substr_kmp(
+   char_t const * str_begin, char_t const * str_end, char_t const * substr_begin, char_t const * substr_end
+) {
+   try {
+      collections::_pub::vector<std::size_t, 64> failure_restarts;
+      failure_restarts.set_size(static_cast<std::size_t>(substr_end - substr_begin));
+      build_failure_restarts(substr_begin, substr_end, failure_restarts.data());
+      return find_substr_kmp(str_begin, str_end, substr_begin, substr_end, failure_restarts.data());
+   } catch (_std::bad_alloc const &) {
+      /* Could not allocate enough memory for the failure restart table: fall back to a plain (and potentially
+      slower) substring search. */
+      char_t substr0 = *substr_begin;
+      for (auto s = str_begin; s < str_end; ++s) {
+         if (*s == substr0) {
+            auto str_match = s;
+            auto substr = substr_begin;
+            while (++substr < substr_end && ++str_match < str_end && *str_match == *substr) {
+               ;
+            }
+            if (substr >= substr_end) {
+               // The substring was exhausted, which means that all its characters were matched in the str.
+               return s;
+            }
+         }
+      }
+      return str_end;
+   }
+}
+
+/*! Substring search for substrings of two or more characters. Where vector instructions are available,
+candidate positions are found by comparing the first and last characters of the substring with many
+characters of the string at once, and only those are checked fully; if too many candidates turn out not to be
+matches, the search continues with the Knuth-Morris-Pratt algorithm, which guarantees linear time.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param substr_begin
+   Pointer to the first character of the string to search for.
+@param substr_end
+   Pointer to beyond the last character of the string to search for.
+@param failure_restarts
+   Failure restart table for the substring, or nullptr to build one only if needed.
+@return
+   Pointer to the beginning of the first match, or str_end if no matches are found.
+*/
+static char_t const * find_substr(
+   char_t const * str_begin, char_t const * str_end, char_t const * substr_begin, char_t const * substr_end,
+   std::size_t const * failure_restarts
+) {
+   auto substr_size = static_cast<std::size_t>(substr_end - substr_begin);
+   if (static_cast<std::size_t>(str_end - str_begin) < substr_size) {
+      return str_end;
+   }
+   auto s = str_begin;
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #ifdef __SSE2__
+   std::size_t const last_offset = substr_size - 1, vector_chars = 16 / sizeof(char_t);
+   __m128i first_vec = sse2_broadcast(substr_begin[0]), last_vec = sse2_broadcast(substr_begin[last_offset]);
+   /* Count of characters compared to reject candidates; once it grows past a few times the characters
+   scanned, the substring is too repetitive for this approach. */
+   std::size_t rejected_chars = 0;
+   for (; static_cast<std::size_t>(str_end - s) >= last_offset + vector_chars; s += vector_chars) {
+      unsigned mask = sse2_match_mask(sse2_load(s), first_vec) &
+                      sse2_match_mask(sse2_load(s + last_offset), last_vec);
+      while (mask) {
+         auto bit = static_cast<unsigned>(__builtin_ctz(mask));
+         auto candidate = s + bit / sizeof(char_t);
+         std::size_t i = 1;
+         while (i < last_offset && candidate[i] == substr_begin[i]) {
+            ++i;
+         }
+         if (i >= last_offset) {
+            return candidate;
+         }
+         rejected_chars += i;
+         if (rejected_chars > static_cast<std::size_t>(candidate - str_begin) * 4 + substr_size * 16) {
+            // No matches start before candidate.
+            return failure_restarts
+               ? find_substr_kmp(candidate, str_end, substr_begin, substr_end, failure_restarts)
+               : find_substr_kmp(candidate, str_end, substr_begin, substr_end);
+         }
+         mask &= ~(((1u << sizeof(char_t)) - 1u) << bit);
+      }
+   }
+   // Check the last few possible positions, which would make the vector loads run past str_end.
+   for (; static_cast<std::size_t>(str_end - s) >= substr_size; ++s) {
+      std::size_t i = 0;
+      while (i < substr_size && s[i] == substr_begin[i]) {
+         ++i;
+      }
+      if (i == substr_size) {
+         return s;
+      }
+   }
+   return str_end;
+   #endif
+#endif
+   return failure_restarts
+      ? find_substr_kmp(s, str_end, substr_begin, substr_end, failure_restarts)
+      : find_substr_kmp(s, str_end, substr_begin, substr_end);
+}
+
+/*! Multiplies two 64-bit integers, returning the 128-bit product as two halves.
+
+@param a
+   Pointer to the first factor; on output, it will hold the low 64 bits of the product.
+@param b
+   Pointer to the second factor; on output, it will hold the high 64 bits of the product.
+*/
+static void hash_multiply(std::uint64_t * a, std::uint64_t * b) {
+#if (LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC) && LOFTY_HOST_WORD_SIZE >= 64
+   // __extension__ avoids -Wpedantic warnings about the non-standard type.
+   __extension__ typedef unsigned __int128 uint128_t;
+   uint128_t product = static_cast<uint128_t>(*a) * *b;
+   *a = static_cast<std::uint64_t>(product);
+   *b = static_cast<std::uint64_t>(product >> 64);
+#else
+   // Schoolbook multiplication of 32-bit halves.
+   std::uint64_t a_hi = *a >> 32, a_lo = static_cast<std::uint32_t>(*a);
+   std::uint64_t b_hi = *b >> 32, b_lo = static_cast<std::uint32_t>(*b);
+   std::uint64_t hh = a_hi * b_hi, hl = a_hi * b_lo, lh = a_lo * b_hi, ll = a_lo * b_lo;
+   std::uint64_t mid = (ll >> 32) + static_cast<std::uint32_t>(hl) + static_cast<std::uint32_t>(lh);
+   *a = (mid << 32) | static_cast<std::uint32_t>(ll);
+   *b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+/*! Mixes two 64-bit integers into one by folding their 128-bit product.
+
+@param a
+   First integer.
+@param b
+   Second integer.
+@return
+   Mixed value.
+*/
+static std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b) {
+   hash_multiply(&a, &b);
+   return a ^ b;
+}
+
+/*! Reads 8 unaligned bytes.
+
+@param p
+   Pointer to the bytes to read.
+@return
+   Bytes read, in host byte order.
+*/
+static std::uint64_t hash_read64(std::uint8_t const * p) {
+   std::uint64_t ret;
+   memory::copy(reinterpret_cast<std::uint8_t *>(&ret), p, sizeof ret);
+   return ret;
+}
+
+/*! Reads 4 unaligned bytes.
+
+@param p
+   Pointer to the bytes to read.
+@return
+   Bytes read, in host byte order.
+*/
+static std::uint64_t hash_read32(std::uint8_t const * p) {
+   std::uint32_t ret;
+   memory::copy(reinterpret_cast<std::uint8_t *>(&ret), p, sizeof ret);
+   return ret;
+}
+
+/*! Generates the seed for str_traits::hash(), reading it from the OS’s random number generator if possible,
+or mixing the time and addresses randomized by the OS otherwise.
+
+@return
+   Seed.
+*/
+static std::uint64_t generate_hash_seed() {
+   std::uint64_t seed = 0;
+#if LOFTY_HOST_API_POSIX
+   int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+   if (fd >= 0) {
+      ::ssize_t read_bytes = ::read(fd, &seed, sizeof seed);
+      ::close(fd);
+      if (read_bytes == static_cast< ::ssize_t>(sizeof seed)) {
+         return seed;
+      }
+   }
+   seed = static_cast<std::uint64_t>(::getpid());
+#elif LOFTY_HOST_API_WIN32
+   ::LARGE_INTEGER counter;
+   ::QueryPerformanceCounter(&counter);
+   seed = static_cast<std::uint64_t>(counter.QuadPart) ^ ::GetCurrentProcessId();
+#endif
+   // Addresses of code, static data and stack are randomized by most OSes.
+   seed = hash_mix(seed ^ reinterpret_cast<std::uintptr_t>(&generate_hash_seed), 0xa0761d6478bd642f);
+   return hash_mix(seed ^ reinterpret_cast<std::uintptr_t>(&seed), 0xe7037ed1a0b428db);
+}
+
+}}} //namespace lofty::text::_pvt
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -26,28 +545,8 @@ namespace lofty { namespace text {
    char_t const * substr_begin, char_t const * substr_end, collections::vector<std::size_t> * failure_restarts
 ) {
    failure_restarts->set_size(static_cast<std::size_t>(substr_end - substr_begin));
-   auto next_failure_restart_itr(failure_restarts->begin());
-
-   /* The earliest repetition of a non-first character can only occur on the fourth character, so start by
-   skipping two characters and storing two zeros for them, then the first iteration will also always store an
-   additional zero and consume one more character. */
-   auto substr = substr_begin + 2, substr_restart = substr_begin;
-   *next_failure_restart_itr++ = 0;
-   *next_failure_restart_itr++ = 0;
-   std::size_t restart_index = 0;
-   while (substr < substr_end) {
-      /* Store the current failure restart index, or 0 if the previous character was the third or was not a
-      match. */
-      *next_failure_restart_itr++ = restart_index;
-      if (*substr++ == *substr_restart) {
-         // Another match: move the restart to the next character.
-         ++restart_index;
-         ++substr_restart;
-      } else if (restart_index > 0) {
-         // End of a match: restart self-matching from index 0.
-         restart_index = 0;
-         substr_restart = substr_begin;
-      }
+   if (substr_begin < substr_end) {
+      _pvt::build_failure_restarts(substr_begin, substr_end, failure_restarts->data());
    }
 }
 
@@ -94,6 +593,29 @@ namespace lofty { namespace text {
    }
 }
 
+/*static*/ char_t const * str_traits::find_char(
+   char_t const * str_begin, char_t const * str_end, char_t ch
+) {
+   auto s = str_begin;
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   // Checked once; the result is cached in a thread-safe way by the compiler.
+   static bool const avx2 = __builtin_cpu_supports("avx2") != 0;
+   if (avx2) {
+      return _pvt::find_char_avx2(str_begin, str_end, ch);
+   }
+   #endif
+   #ifdef __SSE2__
+   __m128i ch_vec = _pvt::sse2_broadcast(ch);
+   for (; str_end - s >= static_cast<std::ptrdiff_t>(16 / sizeof(char_t)); s += 16 / sizeof(char_t)) {
+      if (unsigned mask = _pvt::sse2_match_mask(_pvt::sse2_load(s), ch_vec)) {
+         return s + static_cast<unsigned>(__builtin_ctz(mask)) / sizeof(char_t);
+      }
+   }
+   #endif
+#endif
+   return _pvt::find_char_scalar(s, str_end, ch);
+}
 /*static*/ char_t const * str_traits::find_char(
    char_t const * str_begin, char_t const * str_end, char32_t cp
 ) {
@@ -110,45 +632,53 @@ namespace lofty { namespace text {
 /*static*/ char_t const * str_traits::find_char(
    char_t const * str_begin, char_t const * str_end, char_t const * cp_chars
 ) {
+   /* Since the string is valid, the lead character of the code point can only appear at the start of a code
+   point, so search for it with the fast single-character search, then check the trailing characters. */
+   char_t cp_lead_ch = *cp_chars;
 #if LOFTY_HOST_UTF == 8
-   char8_t cp_lead_ch = *cp_chars;
-   for (char8_t const * s = str_begin, * str_next; s < str_end; s = str_next) {
-      char8_t ch = *s;
-      unsigned cp_size = host_char_traits::lead_char_to_codepoint_size(ch);
-      // Make the next iteration resume from the next code point.
-      str_next = s + cp_size;
-      if (ch == cp_lead_ch) {
-         if (--cp_size) {
-            // The lead bytes match; check if the trailing ones do as well.
-            auto str_cont = s, cp_cont = cp_chars;
-            while (++str_cont < str_next && *str_cont == *++cp_cont) {
-               ;
-            }
-            if (str_cont < str_next) {
-               continue;
-            }
-            // The lead and trailing bytes of str and code point match.
-         }
-         return s;
-      }
-   }
+   std::size_t cp_size = host_char_traits::lead_char_to_codepoint_size(cp_lead_ch);
 #elif LOFTY_HOST_UTF == 16 //if LOFTY_HOST_UTF == 8
    // In UTF-16, there’s always at most two characters per code point.
-   char16_t cp_char0 = cp_chars[0];
-   /* We only have a second character if the first is a lead surrogate. Using NUL as a special value is safe,
-   because if this is a surrogate, the tail surrogate cannot be NUL. */
-   char16_t cp_char1 = host_char_traits::is_lead_surrogate(cp_char0) ? cp_chars[1] : host_char(0);
-   /* The bounds of this loop are safe: since we assume that both strings are valid UTF-16, if
-   str[0] == cp_char0 and cp_char1 != NUL then str[1] must be accessible. */
-   for (auto s = str_begin; s < str_end; ++s) {
-      if (s[0] == cp_char0 && (cp_char1 == 0 || s[1] == cp_char1)) {
-         return s;
+   std::size_t cp_size = host_char_traits::is_lead_surrogate(cp_lead_ch) ? 2u : 1u;
+#endif //if LOFTY_HOST_UTF == 8 … elif LOFTY_HOST_UTF == 16
+   for (auto s = str_begin; (s = find_char(s, str_end, cp_lead_ch)) < str_end; ++s) {
+      if (static_cast<std::size_t>(str_end - s) >= cp_size) {
+         std::size_t i = 1;
+         while (i < cp_size && s[i] == cp_chars[i]) {
+            ++i;
+         }
+         if (i == cp_size) {
+            return s;
+         }
       }
    }
-#endif //if LOFTY_HOST_UTF == 8 … elif LOFTY_HOST_UTF == 16
    return str_end;
 }
 
+/*static*/ char_t const * str_traits::find_char_last(
+   char_t const * str_begin, char_t const * str_end, char_t cp_chars
+) {
+   auto s = str_end;
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   static bool const avx2 = __builtin_cpu_supports("avx2") != 0;
+   if (avx2) {
+      return _pvt::find_char_last_avx2(str_begin, str_end, cp_chars);
+   }
+   #endif
+   #ifdef __SSE2__
+   __m128i ch_vec = _pvt::sse2_broadcast(cp_chars);
+   while (s - str_begin >= static_cast<std::ptrdiff_t>(16 / sizeof(char_t))) {
+      s -= 16 / sizeof(char_t);
+      if (unsigned mask = _pvt::sse2_match_mask(_pvt::sse2_load(s), ch_vec)) {
+         return s + static_cast<unsigned>(31 - __builtin_clz(mask)) / sizeof(char_t);
+      }
+   }
+   #endif
+#endif
+   return _pvt::find_char_last_scalar(str_begin, s, cp_chars);
+}
+
 /*static*/ char_t const * str_traits::find_char_last(
    char_t const * str_begin, char_t const * str_end, char32_t cp
 ) {
@@ -165,61 +695,42 @@ namespace lofty { namespace text {
    }
 }
 
+/*static*/ char_t const * str_traits::find_either_char(
+   char_t const * str_begin, char_t const * str_end, char_t ch1, char_t ch2
+) {
+   auto s = str_begin;
+#if LOFTY_HOST_CXX_CLANG || LOFTY_HOST_CXX_GCC
+   #if LOFTY_HOST_ARCH_X86_64
+   // Checked once; the result is cached in a thread-safe way by the compiler.
+   static bool const avx2 = __builtin_cpu_supports("avx2") != 0;
+   if (avx2) {
+      return _pvt::find_either_char_avx2(str_begin, str_end, ch1, ch2);
+   }
+   #endif
+   #ifdef __SSE2__
+   __m128i ch1_vec = _pvt::sse2_broadcast(ch1), ch2_vec = _pvt::sse2_broadcast(ch2);
+   for (; str_end - s >= static_cast<std::ptrdiff_t>(16 / sizeof(char_t)); s += 16 / sizeof(char_t)) {
+      __m128i chars = _pvt::sse2_load(s);
+      if (unsigned mask = _pvt::sse2_match_mask(chars, ch1_vec) | _pvt::sse2_match_mask(chars, ch2_vec)) {
+         return s + static_cast<unsigned>(__builtin_ctz(mask)) / sizeof(char_t);
+      }
+   }
+   #endif
+#endif
+   return _pvt::find_either_char_scalar(s, str_end, ch1, ch2);
+}
+
 /*static*/ char_t const * str_traits::find_substr(
    char_t const * str_begin, char_t const * str_end, char_t const * substr_begin, char_t const * substr_end
 ) {
    if (substr_begin == substr_end) {
       // Empty substring, so just return the beginning of the str.
       return str_begin;
+   } else if (substr_end - substr_begin == 1) {
+      return find_char(str_begin, str_end, *substr_begin);
+   } else {
+      return _pvt::find_substr(str_begin, str_end, substr_begin, substr_end, nullptr);
    }
-   auto s = str_begin;
-   auto substr = substr_begin;
-   try {
-      // Build the failure restart table.
-      collections::vector<std::size_t, 64> failure_restarts;
-      _build_find_failure_restart_table(substr_begin, substr_end, failure_restarts.vector0_ptr());
-
-      std::size_t failure_restart_index = 0;
-      while (s < str_end) {
-         if (*s == *substr) {
-            ++substr;
-            if (substr == substr_end) {
-               // The substring was exhausted, which means that all its characters were matched in the string.
-               return s - failure_restart_index;
-            }
-            // Move to the next character and advance the index in failure_restarts.
-            ++s;
-            ++failure_restart_index;
-         } else if (failure_restart_index > 0) {
-            /* The current character ends the match sequence; use failure_restarts[failure_restart_index] to
-            see how much into the substring we can retry matching characters. */
-            failure_restart_index = failure_restarts[static_cast<std::ptrdiff_t>(failure_restart_index)];
-            substr = substr_begin + failure_restart_index;
-         } else {
-            /* Not a match, and no restart point: we’re out of options to match this character, so consider it
-            not-a-match and move past it. */
-            ++s;
-         }
-      }
-   } catch (_std::bad_alloc const &) {
-      /* Could not allocate enough memory for the failure restart table: fall back to a plain (and potentially
-      slower) substring search. */
-      char_t substr0 = *substr_begin;
-      for (; s < str_end; ++s) {
-         if (*s == substr0) {
-            auto str_match = s;
-            substr = substr_begin;
-            while (++substr < substr_end && *++str_match == *substr) {
-               ;
-            }
-            if (substr >= substr_end) {
-               // The substring was exhausted, which means that all its characters were matched in the str.
-               return s;
-            }
-         }
-      }
-   }
-   return str_end;
 }
 
 /*static*/ char_t const * str_traits::find_substr_last(
@@ -233,6 +744,57 @@ namespace lofty { namespace text {
    return str_end;
 }
 
+/*static*/ std::size_t str_traits::hash(char_t const * begin, char_t const * end) {
+   /* Implementation of the wyhash algorithm; see <https://github.com/wangyi-fudan/wyhash> for details. It
+   reads the string 8 or 16 bytes at a time, and is well distributed even for short strings. */
+   static std::uint64_t const p0 = 0xa0761d6478bd642f, p1 = 0xe7037ed1a0b428db, p2 = 0x8ebc6af09c88c6e3,
+      p3 = 0x589965cc75374cc3;
+   // Checked once; the result is cached in a thread-safe way by the compiler.
+   static std::uint64_t const process_seed = _pvt::generate_hash_seed();
+
+   auto bytes = reinterpret_cast<std::uint8_t const *>(begin);
+   auto size = static_cast<std::size_t>(reinterpret_cast<std::uint8_t const *>(end) - bytes);
+   std::uint64_t seed = process_seed ^ _pvt::hash_mix(process_seed ^ p0, p1), a, b;
+   if (size <= 16) {
+      if (size >= 4) {
+         std::size_t mid = (size >> 3) << 2;
+         a = (_pvt::hash_read32(bytes) << 32) | _pvt::hash_read32(bytes + mid);
+         b = (_pvt::hash_read32(bytes + size - 4) << 32) | _pvt::hash_read32(bytes + size - 4 - mid);
+      } else if (size > 0) {
+         a = (static_cast<std::uint64_t>(bytes[0]) << 16) |
+             (static_cast<std::uint64_t>(bytes[size >> 1]) << 8) | bytes[size - 1];
+         b = 0;
+      } else {
+         a = b = 0;
+      }
+   } else {
+      std::size_t remaining = size;
+      if (remaining > 48) {
+         std::uint64_t seed1 = seed, seed2 = seed;
+         do {
+            seed  = _pvt::hash_mix(_pvt::hash_read64(bytes     ) ^ p1, _pvt::hash_read64(bytes +  8) ^ seed );
+            seed1 = _pvt::hash_mix(_pvt::hash_read64(bytes + 16) ^ p2, _pvt::hash_read64(bytes + 24) ^ seed1);
+            seed2 = _pvt::hash_mix(_pvt::hash_read64(bytes + 32) ^ p3, _pvt::hash_read64(bytes + 40) ^ seed2);
+            bytes += 48;
+            remaining -= 48;
+         } while (remaining > 48);
+         seed ^= seed1 ^ seed2;
+      }
+      while (remaining > 16) {
+         seed = _pvt::hash_mix(_pvt::hash_read64(bytes) ^ p1, _pvt::hash_read64(bytes + 8) ^ seed);
+         bytes += 16;
+         remaining -= 16;
+      }
+      // The last 16 bytes, which may overlap with those already mixed in.
+      a = _pvt::hash_read64(bytes + remaining - 16);
+      b = _pvt::hash_read64(bytes + remaining - 8);
+   }
+   a ^= p1;
+   b ^= seed;
+   _pvt::hash_multiply(&a, &b);
+   return static_cast<std::size_t>(_pvt::hash_mix(a ^ p0 ^ size, b ^ p1));
+}
+
 /*static*/ std::size_t str_traits::size_in_codepoints(char_t const * begin, char_t const * end) {
    std::size_t size = 0;
    for (auto s = begin; s < end; s += host_char_traits::lead_char_to_codepoint_size(*s)) {
@@ -357,4 +919,27 @@ namespace lofty { namespace text {
 #endif //if LOFTY_HOST_UTF == 8 … elif LOFTY_HOST_UTF == 16
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+str_searcher::str_searcher(char_t const * substr_begin, char_t const * substr_end) :
+   substr(substr_begin, substr_end) {
+   str_traits::_build_find_failure_restart_table(substr_begin, substr_end, &failure_restarts);
+}
+
+str_searcher::~str_searcher() {
+}
+
+char_t const * str_searcher::find(char_t const * str_begin, char_t const * str_end) const {
+   switch (substr.size()) {
+      case 0:
+         return str_begin;
+      case 1:
+         return str_traits::find_char(str_begin, str_end, substr[0]);
+      default:
+         return _pvt::find_substr(
+            str_begin, str_end, substr.data(), substr.data_end(), failure_restarts.data()
+         );
+   }
+}
+
 }} //namespace lofty::text
@@ -363,6 +363,19 @@ _std::shared_ptr<coroutine::scheduler> const & attach_coroutine_scheduler(
    return curr_coro_sched;
 }
 
+_std::shared_ptr<coroutine::scheduler> const & attach_coroutine_scheduler(
+   coroutine::scheduler_options const & coro_sched_opts
+) {
+   auto & curr_coro_sched = get_impl()->coroutine_scheduler();
+   if (curr_coro_sched) {
+      // The current thread already has a coroutine scheduler.
+      // TODO: use a better exception class. Also, this shouldn’t need a qualifier (GCC BUG?).
+      LOFTY_THROW(lofty::generic_error, ());
+   }
+   curr_coro_sched = _std::make_shared<coroutine::scheduler>(coro_sched_opts);
+   return curr_coro_sched;
+}
+
 _std::shared_ptr<coroutine::scheduler> const & coroutine_scheduler() {
    return get_impl()->coroutine_scheduler();
 }
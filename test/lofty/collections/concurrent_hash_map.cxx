@@ -0,0 +1,142 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/collections.hxx>
+#include <lofty/collections/concurrent_hash_map.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/thread.hxx>
+#include <lofty/_std/atomic.hxx>
+#include <lofty/_std/memory.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_concurrent_hash_map_basic,
+   "lofty::collections::concurrent_hash_map – basic operations"
+) {
+   LOFTY_TRACE_FUNC();
+
+   collections::concurrent_hash_map<int, int> map;
+   int value;
+
+   ASSERT(map.size() == 0u);
+   ASSERT(!map.find(10, &value));
+
+   ASSERT(map.add_or_assign(10, 100));
+   ASSERT(map.add_or_assign(20, 200));
+   ASSERT(!map.add_or_assign(10, 101));
+   ASSERT(map.size() == 2u);
+   ASSERT(map.find(10, &value));
+   ASSERT(value == 101);
+   ASSERT(map.find(20, nullptr));
+
+   int visited = 0, sum = 0;
+   map.for_each([&visited, &sum] (int const & key, int & value_) {
+      ++visited;
+      sum += key;
+      value_ = -key;
+   });
+   ASSERT(visited == 2);
+   ASSERT(sum == 30);
+   ASSERT(map.pop(20) == -20);
+   ASSERT_THROWS(collections::bad_key, map.pop(20));
+   ASSERT(map.remove_if_found(10));
+   ASSERT(!map.remove_if_found(10));
+   ASSERT_THROWS(collections::bad_key, map.remove(10));
+   ASSERT(map.size() == 0u);
+
+   // A single shard should work just like many.
+   collections::concurrent_hash_map<int, int> map1(1);
+   for (int i = 0; i < 100; ++i) {
+      map1.add_or_assign(i, i);
+   }
+   ASSERT(map1.size() == 100u);
+   map1.clear();
+   ASSERT(map1.size() == 0u);
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_concurrent_hash_map_threads,
+   "lofty::collections::concurrent_hash_map – concurrent use by multiple threads"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const threads_size = 4, keys_per_thread = 5000;
+   collections::concurrent_hash_map<int, int> map;
+   _std::atomic<unsigned> errors(0);
+
+   /* Each thread adds its own keys, looks up keys being added by all the threads, and removes half of its own
+   keys; meanwhile, the main thread keeps iterating over the map. */
+   _std::unique_ptr<thread[]> threads(new thread[threads_size]);
+   for (int i = 0; i < threads_size; ++i) {
+      threads[static_cast<std::size_t>(i)] = thread([&map, &errors, i] () {
+         int first_key = i * keys_per_thread;
+         for (int key = first_key; key < first_key + keys_per_thread; ++key) {
+            map.add_or_assign(key, -key);
+            int value;
+            if (!map.find(key, &value) || value != -key) {
+               ++errors;
+            }
+            // Look up a key that another thread may or may not have added yet.
+            int other_key = (key + keys_per_thread) % (threads_size * keys_per_thread);
+            if (map.find(other_key, &value) && value != -other_key) {
+               ++errors;
+            }
+         }
+         for (int key = first_key; key < first_key + keys_per_thread; key += 2) {
+            if (map.pop(key) != -key) {
+               ++errors;
+            }
+         }
+      });
+   }
+   std::size_t max_visited = 0;
+   for (int pass = 0; pass < 10; ++pass) {
+      std::size_t visited = 0;
+      map.for_each([&visited, &errors] (int const & key, int & value) {
+         ++visited;
+         if (value != -key) {
+            ++errors;
+         }
+      });
+      if (visited > max_visited) {
+         max_visited = visited;
+      }
+   }
+   for (int i = 0; i < threads_size; ++i) {
+      threads[static_cast<std::size_t>(i)].join();
+   }
+
+   ASSERT(errors.load() == 0u);
+   ASSERT(max_visited <= static_cast<std::size_t>(threads_size * keys_per_thread));
+   ASSERT(map.size() == static_cast<std::size_t>(threads_size * keys_per_thread / 2));
+   unsigned missing = 0;
+   for (int key = 0; key < threads_size * keys_per_thread; ++key) {
+      if (map.find(key, nullptr) != ((key & 1) != 0)) {
+         ++missing;
+      }
+   }
+   ASSERT(missing == 0u);
+}
+
+}} //namespace lofty::test
@@ -0,0 +1,211 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/collections.hxx>
+#include <lofty/collections/flat_hash_map.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/to_str.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_flat_hash_map_basic,
+   "lofty::collections::flat_hash_map – basic operations"
+) {
+   LOFTY_TRACE_FUNC();
+
+   collections::flat_hash_map<int, int> map;
+
+   ASSERT(map.size() == 0u);
+   ASSERT((map.cbegin() == map.cend()));
+   ASSERT((map.find(10) == map.cend()));
+
+   map.add_or_assign(10, 100);
+   ASSERT(map.size() == 1u);
+   ASSERT(map[10] == 100);
+   {
+      auto itr(map.begin());
+      ASSERT(itr->key == 10);
+      ASSERT(itr->value == 100);
+      ++itr;
+      ASSERT((itr == map.cend()));
+   }
+
+   ASSERT(!map.add_or_assign(10, 101).added);
+   ASSERT(map.size() == 1u);
+   ASSERT(map[10] == 101);
+
+   map.add_or_assign(20, 200);
+   ASSERT(map.size() == 2u);
+   ASSERT(map[20] == 200);
+
+   ASSERT(map.remove_if_found(10));
+   ASSERT(!map.remove_if_found(10));
+   ASSERT_THROWS(collections::bad_key, map.remove(10));
+   ASSERT_THROWS(collections::bad_key, map[10]);
+   ASSERT(map.size() == 1u);
+   ASSERT(map.pop(20) == 200);
+   ASSERT(map.size() == 0u);
+
+   // Add enough key/value pairs until a resize occurs.
+   int key = 11, value = 110;
+   map.add_or_assign(key, value);
+   std::size_t initial_capacity = map.capacity();
+   do {
+      key += 11;
+      value += 110;
+      map.add_or_assign(key, value);
+   } while (map.capacity() == initial_capacity);
+   ASSERT(map[11] == 110);
+   ASSERT(map[22] == 220);
+   ASSERT(map[key] == value);
+
+   map.clear();
+   ASSERT(map.size() == 0u);
+   ASSERT((map.begin() == map.end()));
+
+   // Validate that non-copyable types can be stored in a map.
+   {
+      collections::flat_hash_map<int, _std::unique_ptr<int>> map2;
+      map2.add_or_assign(1, _std::unique_ptr<int>(new int(10)));
+      ASSERT(*map2[1] == 10);
+   }
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_flat_hash_map_slot_layout,
+   "lofty::collections::flat_hash_map – keys and values of different size and alignment"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const max = 1000;
+   unsigned errors;
+   collections::flat_hash_map<text::str, double> map;
+
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(to_str(i), i * 0.5);
+   }
+   ASSERT(map.size() == static_cast<std::size_t>(max));
+
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(map.find(to_str(i)));
+      if (itr == map.cend() || itr->value != i * 0.5) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+
+   // Iteration should visit every pair exactly once.
+   std::size_t visited = 0;
+   LOFTY_FOR_EACH(auto kv, map) {
+      LOFTY_UNUSED_ARG(kv);
+      ++visited;
+   }
+   ASSERT(visited == map.size());
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+namespace {
+
+/*! Inefficient hash function that results in 100% hash collisions.
+
+@param i
+   Value to hash.
+@return
+   Hash of i.
+*/
+struct poor_flat_hash {
+   std::size_t operator()(int i) const {
+      LOFTY_UNUSED_ARG(i);
+      return 0;
+   }
+};
+
+} //namespace
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_flat_hash_map_collisions_stress,
+   "lofty::collections::flat_hash_map – stress test with 100% collisions"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const max = 1000;
+   unsigned errors;
+   collections::flat_hash_map<int, int, poor_flat_hash> map;
+
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(i, i);
+   }
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      if (map[i] != i) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_flat_hash_map_removals_stress,
+   "lofty::collections::flat_hash_map – stress test with interleaved additions and removals"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const max = 20000, window = 500;
+   unsigned errors = 0;
+   collections::flat_hash_map<int, int> map;
+
+   /* Keep a sliding window of keys in the map, so that deleted slots accumulate and the table needs to be
+   rehashed without growing. */
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(i, -i);
+      if (i >= window) {
+         map.remove(i - window);
+         if (map.find(i - window / 2) == map.cend()) {
+            ++errors;
+         }
+      }
+   }
+   ASSERT(errors == 0u);
+   ASSERT(map.size() == static_cast<std::size_t>(window));
+   ASSERT(map.capacity() < static_cast<std::size_t>(window) * 4);
+
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(map.find(i));
+      if (i < max - window ? itr != map.cend() : itr == map.cend() || itr->value != -i) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+}
+
+}} //namespace lofty::test
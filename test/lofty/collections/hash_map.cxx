@@ -14,6 +14,7 @@ more details.
 
 #include <lofty/collections.hxx>
 #include <lofty/collections/hash_map.hxx>
+#include <lofty/exception.hxx>
 #include <lofty/logging.hxx>
 #include <lofty/_std/memory.hxx>
 #include <lofty/testing/test_case.hxx>
@@ -174,6 +175,161 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 
 namespace lofty { namespace test {
 
+namespace {
+
+//! Hash function that scatters keys, forcing the map to move keys around within their neighborhoods.
+class scattering_hash {
+public:
+   std::size_t operator()(int i) const {
+      std::size_t hash = static_cast<std::size_t>(i) * static_cast<std::size_t>(0x9e3779b97f4a7c15ull);
+      return hash ^ (hash >> 29);
+   }
+};
+
+} //namespace
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_hash_map_scattered_stress,
+   "lofty::collections::hash_map – stress test with scattered hashes"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const max = 20000;
+   unsigned errors;
+   collections::hash_map<int, int, scattering_hash> map;
+
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(i, i);
+   }
+   ASSERT(map.size() == static_cast<std::size_t>(max));
+
+   // Verify that moving keys to make room for others did not lose any of them.
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(map.find(i));
+      if (itr == map.cend() || itr->value != i) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+
+   // Assigning to existing keys must not change the count of keys.
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(i, i);
+   }
+   ASSERT(map.size() == static_cast<std::size_t>(max));
+
+   // Remove every other key, then assign the remaining ones: no duplicates should be added.
+   for (int i = 0; i < max; i += 2) {
+      map.remove(i);
+   }
+   for (int i = 1; i < max; i += 2) {
+      map.add_or_assign(i, -i);
+   }
+   ASSERT(map.size() == static_cast<std::size_t>(max / 2));
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(map.find(i));
+      if ((i & 1) ? itr == map.cend() || itr->value != -i : itr != map.cend()) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   collections_hash_map_capacity,
+   "lofty::collections::hash_map – capacity management and bulk additions"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const max = 20000;
+   unsigned errors;
+   typedef collections::hash_map<int, int, scattering_hash> map_type;
+
+   // A map with enough capacity and widening neighborhoods should never need to grow.
+   map_type map;
+   map.set_growth_policy(map.table_growth_factor(), map.max_load_percent(), true);
+   ASSERT(map.widens_neighborhoods());
+   map.set_capacity(max);
+   std::size_t capacity = map.capacity();
+   ASSERT(capacity >= static_cast<std::size_t>(max));
+   for (int i = 0; i < max; ++i) {
+      map.add_or_assign(i, i);
+   }
+   ASSERT(map.capacity() == capacity);
+
+   // Shrinking the table must preserve its contents.
+   for (int i = 0; i < max; i += 4) {
+      map.remove(i);
+   }
+   map.shrink_to_fit();
+   ASSERT(map.capacity() < capacity);
+   ASSERT(map.size() == static_cast<std::size_t>(max - max / 4));
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(map.find(i));
+      if ((i & 3) ? itr == map.cend() || itr->value != i : itr != map.cend()) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+   map.clear();
+   map.shrink_to_fit();
+   ASSERT(map.capacity() == 0u);
+
+   // Bulk additions, including a duplicate key whose last occurrence should win.
+   struct int_pair {
+      int key;
+      int value;
+   };
+   _std::unique_ptr<int_pair[]> pairs(new int_pair[max + 1]);
+   for (int i = 0; i < max; ++i) {
+      pairs[static_cast<std::size_t>(i)].key = i;
+      pairs[static_cast<std::size_t>(i)].value = -i;
+   }
+   pairs[max].key = 0;
+   pairs[max].value = 1;
+   map_type bulk_map(pairs.get(), pairs.get() + max + 1);
+   ASSERT(bulk_map.size() == static_cast<std::size_t>(max));
+   errors = 0;
+   for (int i = 0; i < max; ++i) {
+      auto itr(bulk_map.find(i));
+      if (itr == bulk_map.cend() || itr->value != (i ? -i : 1)) {
+         ++errors;
+      }
+   }
+   ASSERT(errors == 0u);
+
+   /* By default, the table grows instead of widening neighborhoods, so it ends up larger than that of a map
+   that widens them. */
+   map_type default_map, widening_map;
+   ASSERT(!default_map.widens_neighborhoods());
+   widening_map.set_growth_policy(widening_map.table_growth_factor(), widening_map.max_load_percent(), true);
+   for (int i = 0; i < max; ++i) {
+      default_map.add_or_assign(i, i);
+      widening_map.add_or_assign(i, i);
+   }
+   ASSERT(default_map.neighborhood_size() < widening_map.neighborhood_size());
+   ASSERT(default_map.capacity() > widening_map.capacity());
+
+   // A lower maximum load results in a larger table.
+   map_type sparse_map;
+   sparse_map.set_growth_policy(2, 50);
+   for (int i = 0; i < max; ++i) {
+      sparse_map.add_or_assign(i, i);
+   }
+   ASSERT(sparse_map.size() * 2 <= sparse_map.capacity());
+   ASSERT_THROWS(argument_error, sparse_map.set_growth_policy(3, 50));
+   ASSERT_THROWS(argument_error, sparse_map.set_growth_policy(2, 0));
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
 LOFTY_TESTING_TEST_CASE_FUNC(
    collections_hash_map_iterators,
    "lofty::collections::hash_map – operations with iterators"
@@ -12,18 +12,24 @@ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Les
 more details.
 ------------------------------------------------------------------------------------------------------------*/
 
+#include <lofty/channel.hxx>
 #include <lofty/coroutine.hxx>
 #include <lofty/event.hxx>
 #include <lofty/exception.hxx>
 #include <lofty/io.hxx>
+#include <lofty/io/binary.hxx>
 #include <lofty/io/text.hxx>
 #include <lofty/io/text/str.hxx>
 #include <lofty/keyed_demux.hxx>
 #include <lofty/logging.hxx>
 #include <lofty/memory.hxx>
 #include <lofty/mutex.hxx>
+#include <lofty/numeric.hxx>
+#include <lofty/os/path.hxx>
+#include <lofty/perf/stopwatch.hxx>
 #include <lofty/range.hxx>
 #include <lofty/_std/atomic.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/memory.hxx>
 #include <lofty/_std/mutex.hxx>
 #include <lofty/_std/utility.hxx>
@@ -32,6 +38,15 @@ more details.
 #include <lofty/thread.hxx>
 #include <lofty/to_str.hxx>
 #include <lofty/try_finally.hxx>
+#if LOFTY_HOST_API_POSIX
+   #include <errno.h> // ENOENT errno
+   #include <unistd.h> // unlink() usleep()
+#endif
+#if LOFTY_HOST_API_LINUX
+   #include <fcntl.h> // O_*
+   #include <linux/io_uring.h> // IORING_OP_*
+   #include <unistd.h> // pipe2()
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -219,6 +234,331 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 
 namespace lofty { namespace test {
 
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_sleep_cancelled_timeouts,
+   "lofty::coroutine – sleep among cancelled timeouts"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+
+   // These sleeps end in different levels of the scheduler’s timer wheel, and in a different order.
+   static std::size_t const sleepers_size = 6;
+   unsigned sleeps[sleepers_size] = { 130, 66, 1, 200, 61, 70 };
+   std::size_t sleepers_awoke[sleepers_size];
+   memory::clear(&sleepers_awoke);
+   std::size_t next_awaking_sleeper_slot = 0;
+   for (std::size_t i = 0; i < sleepers_size; ++i) {
+      coroutine([i, &sleeps, &sleepers_awoke, &next_awaking_sleeper_slot] () {
+         LOFTY_TRACE_FUNC();
+
+         this_coroutine::sleep_for_ms(sleeps[i]);
+         sleepers_awoke[next_awaking_sleeper_slot++] = i + 1;
+      });
+   }
+
+   /* Add many long timeouts that are cancelled before expiring; the first one arms the timer, which must be
+   rearmed for the shorter sleeps above. */
+   static std::size_t const waiters_size = 100;
+   event events[waiters_size];
+   std::size_t timedout = 0;
+   for (std::size_t i = 0; i < waiters_size; ++i) {
+      coroutine([i, &events, &timedout] () {
+         LOFTY_TRACE_FUNC();
+
+         try {
+            events[i].wait(60000);
+         } catch (io::timeout const &) {
+            ++timedout;
+         }
+      });
+   }
+   coroutine([&events] () {
+      LOFTY_TRACE_FUNC();
+
+      this_coroutine::sleep_for_ms(1);
+      LOFTY_FOR_EACH(auto & e, events) {
+         e.trigger();
+      }
+   });
+
+   this_thread::run_coroutines();
+
+   ASSERT(sleepers_awoke[0] == 3u);
+   ASSERT(sleepers_awoke[1] == 5u);
+   ASSERT(sleepers_awoke[2] == 2u);
+   ASSERT(sleepers_awoke[3] == 6u);
+   ASSERT(sleepers_awoke[4] == 1u);
+   ASSERT(sleepers_awoke[5] == 4u);
+   ASSERT(timedout == 0u);
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_batched_fd_readiness,
+   "lofty::coroutine – many file descriptors becoming ready at once"
+) {
+   LOFTY_TRACE_FUNC();
+
+   /* Use a batch size that’s not a divisor of the count of pipes, so that the scheduler will need more than
+   one wait, and the last one will return fewer notifications than allowed. */
+   coroutine::scheduler_options coro_sched_opts;
+   coro_sched_opts.max_events_per_wait = 3;
+   this_thread::attach_coroutine_scheduler(coro_sched_opts);
+
+   static std::size_t const pipes_size = 16;
+   io::binary::pipe pipes[pipes_size];
+   int values_read[pipes_size];
+   memory::clear(&values_read);
+   for (std::size_t i = 0; i < pipes_size; ++i) {
+      coroutine([i, &pipes, &values_read] () {
+         LOFTY_TRACE_FUNC();
+
+         int value;
+         if (pipes[i].read_end->read(&value)) {
+            values_read[i] = value;
+         }
+      });
+   }
+
+   coroutine([&pipes] () {
+      LOFTY_TRACE_FUNC();
+
+      // Let every reader block before making all of them ready at once.
+      this_coroutine::sleep_for_ms(1);
+      for (std::size_t i = 0; i < pipes_size; ++i) {
+         pipes[i].write_end->write(static_cast<int>(i + 1));
+      }
+   });
+
+   LOFTY_TRY {
+      this_thread::run_coroutines();
+   } LOFTY_FINALLY {
+      for (std::size_t i = 0; i < pipes_size; ++i) {
+         pipes[i].write_end->close();
+      }
+   };
+
+   for (std::size_t i = 0; i < pipes_size; ++i) {
+      ASSERT(values_read[i] == static_cast<int>(i + 1));
+   }
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_fd_reuse,
+   "lofty::coroutine – waiting on reused file descriptors"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+
+   /* Each iteration closes the pipe before creating the next one, so the OS will likely reuse the same file
+   descriptors; the scheduler must not mistake them for the ones it registered during the previous
+   iteration. */
+   int values_read[3];
+   memory::clear(&values_read);
+   for (int i = 0; i < 3; ++i) {
+      auto pipe_ptr(_std::make_shared<io::binary::pipe>());
+      coroutine([pipe_ptr, i, &values_read] () {
+         LOFTY_TRACE_FUNC();
+
+         int value;
+         if (pipe_ptr->read_end->read(&value)) {
+            values_read[i] = value;
+         }
+      });
+      coroutine([pipe_ptr, i] () {
+         LOFTY_TRACE_FUNC();
+
+         // Make sure the reader is blocked before writing.
+         this_coroutine::sleep_for_ms(1);
+         pipe_ptr->write_end->write(i + 1);
+         pipe_ptr->write_end->close();
+      });
+      this_thread::run_coroutines();
+   }
+
+   ASSERT(values_read[0] == 1);
+   ASSERT(values_read[1] == 2);
+   ASSERT(values_read[2] == 3);
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if LOFTY_HOST_API_LINUX
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_shared_fd,
+   "lofty::coroutine – multiple coroutines waiting on the same file descriptor"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+
+   io::binary::pipe pipe;
+   int values_read[2];
+   memory::clear(&values_read);
+   for (std::size_t i = 0; i < 2; ++i) {
+      coroutine([i, &pipe, &values_read] () {
+         LOFTY_TRACE_FUNC();
+
+         int value;
+         if (pipe.read_end->read(&value)) {
+            values_read[i] = value;
+         }
+      });
+   }
+
+   coroutine([&pipe] () {
+      LOFTY_TRACE_FUNC();
+
+      /* Let both readers block, then write one value at a time: the reader that doesn’t get the first value
+      must go back to waiting for the second one. */
+      this_coroutine::sleep_for_ms(1);
+      pipe.write_end->write(1);
+      this_coroutine::sleep_for_ms(1);
+      pipe.write_end->write(2);
+   });
+
+   LOFTY_TRY {
+      this_thread::run_coroutines();
+   } LOFTY_FINALLY {
+      pipe.write_end->close();
+   };
+
+   ASSERT(values_read[0] + values_read[1] == 3);
+   ASSERT(values_read[0] * values_read[1] == 2);
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+#endif //if LOFTY_HOST_API_LINUX
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if LOFTY_HOST_API_LINUX
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_io_uring,
+   "lofty::coroutine – I/O via io_uring"
+) {
+   LOFTY_TRACE_FUNC();
+
+   coroutine::scheduler_options coro_sched_opts;
+   coro_sched_opts.use_io_uring = true;
+   this_thread::attach_coroutine_scheduler(coro_sched_opts);
+
+   // Readers block until the writer gets to run; their reads are submitted together.
+   static std::size_t const pipes_size = 8;
+   io::binary::pipe pipes[pipes_size];
+   int values_read[pipes_size];
+   memory::clear(&values_read);
+   for (std::size_t i = 0; i < pipes_size; ++i) {
+      coroutine([i, &pipes, &values_read] () {
+         LOFTY_TRACE_FUNC();
+
+         int value;
+         if (pipes[i].read_end->read(&value)) {
+            values_read[i] = value;
+         }
+      });
+   }
+   coroutine([&pipes] () {
+      LOFTY_TRACE_FUNC();
+
+      for (std::size_t i = 0; i < pipes_size; ++i) {
+         pipes[i].write_end->write(static_cast<int>(i + 1));
+         pipes[i].write_end->close();
+      }
+   });
+
+   // A read that never completes must be cancelled by an interruption.
+   io::binary::pipe idle_pipe;
+   bool idle_read_interrupted = false;
+   coroutine idle_reader([&idle_pipe, &idle_read_interrupted] () {
+      LOFTY_TRACE_FUNC();
+
+      try {
+         int value;
+         idle_pipe.read_end->read(&value);
+      } catch (execution_interruption const &) {
+         idle_read_interrupted = true;
+      }
+   });
+   coroutine([&idle_pipe, &idle_reader] () {
+      LOFTY_TRACE_FUNC();
+
+      this_coroutine::sleep_for_ms(5);
+      idle_reader.interrupt();
+      idle_pipe.write_end->close();
+   });
+
+   // A read that never completes must also be cancelled by its timeout.
+   int raw_pipe_fds[2];
+   ASSERT(::pipe2(raw_pipe_fds, O_CLOEXEC | O_NONBLOCK) == 0);
+   io::filedesc raw_pipe_read_end(raw_pipe_fds[0]), raw_pipe_write_end(raw_pipe_fds[1]);
+   bool uring_available = false, timed_out = false;
+   coroutine([&raw_pipe_read_end, &uring_available, &timed_out] () {
+      LOFTY_TRACE_FUNC();
+
+      int value;
+      io::uring_op op(IORING_OP_READ, raw_pipe_read_end.get(), &value, sizeof value);
+      try {
+         uring_available = this_coroutine::perform_uring_op(&op, 10);
+      } catch (io::timeout const &) {
+         uring_available = true;
+         timed_out = true;
+      }
+   });
+
+   this_thread::run_coroutines();
+
+   for (std::size_t i = 0; i < pipes_size; ++i) {
+      ASSERT(values_read[i] == static_cast<int>(i + 1));
+   }
+   ASSERT(idle_read_interrupted);
+   // The OS may not support io_uring, in which case the scheduler falls back to epoll.
+   if (uring_available) {
+      ASSERT(timed_out);
+   }
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+#endif //if LOFTY_HOST_API_LINUX
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
 LOFTY_TESTING_TEST_CASE_FUNC(
    coroutine_join,
    "lofty::coroutine – joining"
@@ -291,7 +631,6 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 
 namespace lofty { namespace test {
 
-#if 0
 LOFTY_TESTING_TEST_CASE_FUNC(
    coroutine_on_multithreaded_scheduler,
    "lofty::coroutine – multiple threads sharing one scheduler"
@@ -303,8 +642,10 @@ LOFTY_TESTING_TEST_CASE_FUNC(
    static unsigned const threads_size = 16;
    static unsigned const coros_size = 64;
    thread threads[threads_size];
-   collections::vector<bool> coros_completed;
-   coros_completed.set_size(coros_size);
+   bool coros_completed[coros_size];
+   LOFTY_FOR_EACH(auto & coro_completed, coros_completed) {
+      coro_completed = false;
+   }
 
    // Schedule all the coroutines.
    for (unsigned i = 0; i < coros_size; ++i) {
@@ -338,16 +679,18 @@ LOFTY_TESTING_TEST_CASE_FUNC(
    }
 
    // Test that no false values can be found in coros_completed.
-   auto noncompleted_coro_itr(coros_completed.find(false));
-   int noncompleted_coro_index = noncompleted_coro_itr != coros_completed.cend()
-      ? static_cast<int>(noncompleted_coro_itr - coros_completed.cbegin())
-      : -1;
+   int noncompleted_coro_index = -1;
+   for (unsigned i = 0; i < coros_size; ++i) {
+      if (!coros_completed[i]) {
+         noncompleted_coro_index = static_cast<int>(i);
+         break;
+      }
+   }
    ASSERT(noncompleted_coro_index == -1);
 
    // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
    this_thread::detach_coroutine_scheduler();
 }
-#endif
 
 }} //namespace lofty::test
 
@@ -532,6 +875,336 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 
 namespace lofty { namespace test {
 
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_mutex_contention,
+   "lofty::mutex (using coroutines) – contention on multiple threads"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static unsigned const threads_size = 4;
+   static std::size_t const coros_size = 8;
+   static unsigned const increments_per_coro = 500;
+
+   auto coro_sched(this_thread::attach_coroutine_scheduler());
+   {
+      mutex counter_mutex;
+      // Deliberately not atomic: the mutex must be enough to keep increments from getting lost.
+      unsigned counter = 0;
+      _std::atomic<unsigned> owners(0), max_owners(0);
+
+      LOFTY_FOR_EACH(auto coro_index, make_range(std::size_t(0), coros_size)) {
+         coroutine([&counter_mutex, &counter, &owners, &max_owners, coro_index] () {
+            LOFTY_TRACE_FUNC();
+
+            LOFTY_FOR_EACH(auto i, make_range(0u, increments_per_coro)) {
+               _std::lock_guard<mutex> lock(counter_mutex);
+               unsigned curr_owners = owners.fetch_add(1) + 1;
+               if (curr_owners > max_owners.load()) {
+                  max_owners.store(curr_owners);
+               }
+               unsigned old_counter = counter;
+               if ((i + coro_index) % 50 == 0) {
+                  // Give other coroutines a chance to find the mutex locked and block on it.
+                  this_coroutine::sleep_for_ms(1);
+               }
+               counter = old_counter + 1;
+               owners.fetch_sub(1);
+            }
+         });
+      }
+
+      // Threads must not be started while this thread has a scheduler.
+      this_thread::detach_coroutine_scheduler();
+      thread threads[threads_size - 1];
+      LOFTY_FOR_EACH(auto & thread, threads) {
+         thread = lofty::thread([&coro_sched] () {
+            this_thread::attach_coroutine_scheduler(coro_sched);
+            this_thread::run_coroutines();
+         });
+      }
+      this_thread::attach_coroutine_scheduler(coro_sched);
+      this_thread::run_coroutines();
+      LOFTY_FOR_EACH(auto & thread, threads) {
+         thread.join();
+      }
+
+      ASSERT(counter == coros_size * increments_per_coro);
+      ASSERT(max_owners.load() == 1u);
+      ASSERT(counter_mutex.try_lock());
+      counter_mutex.unlock();
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_shared_mutex,
+   "lofty::shared_mutex (using coroutines)"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+
+   shared_mutex rw_mutex;
+   _std::atomic<unsigned> readers(0), max_readers(0), writers(0);
+   _std::atomic<bool> overlap(false);
+   int value = 0;
+
+   LOFTY_FOR_EACH(auto reader, make_range(0, 3)) {
+      coroutine([&rw_mutex, &readers, &max_readers, &writers, &overlap, reader] () {
+         LOFTY_TRACE_FUNC();
+
+         rw_mutex.lock_shared();
+         unsigned curr_readers = readers.fetch_add(1) + 1;
+         if (curr_readers > max_readers.load()) {
+            max_readers.store(curr_readers);
+         }
+         if (writers.load() != 0) {
+            overlap.store(true);
+         }
+         // While this reader sleeps, the others can acquire shared ownership too.
+         this_coroutine::sleep_for_ms(5 + static_cast<unsigned>(reader));
+         readers.fetch_sub(1);
+         rw_mutex.unlock_shared();
+      });
+   }
+   coroutine([&rw_mutex, &readers, &writers, &overlap, &value] () {
+      LOFTY_TRACE_FUNC();
+
+      // Let the readers in first.
+      this_coroutine::sleep_for_ms(1);
+      rw_mutex.lock();
+      writers.fetch_add(1);
+      if (readers.load() != 0) {
+         overlap.store(true);
+      }
+      this_coroutine::sleep_for_ms(1);
+      value = 42;
+      writers.fetch_sub(1);
+      rw_mutex.unlock();
+   });
+   coroutine([this, &rw_mutex, &value] () {
+      LOFTY_TRACE_FUNC();
+
+      this_coroutine::sleep_for_ms(2);
+      // The writer is now queued or running, so this must wait for it and observe its change.
+      rw_mutex.lock_shared();
+      ASSERT(value == 42);
+      rw_mutex.unlock_shared();
+   });
+
+   this_thread::run_coroutines();
+
+   ASSERT(max_readers.load() == 3u);
+   ASSERT(!overlap.load());
+   ASSERT(value == 42);
+
+   // Timed locks, from a coroutine while a thread owns the mutex.
+   rw_mutex.lock();
+   coroutine([this, &rw_mutex] () {
+      LOFTY_TRACE_FUNC();
+
+      ASSERT(!rw_mutex.try_lock_shared());
+      ASSERT(!rw_mutex.try_lock_shared_for(10));
+      ASSERT(!rw_mutex.try_lock_for(10));
+   });
+   this_thread::run_coroutines();
+   rw_mutex.unlock();
+   coroutine([this, &rw_mutex] () {
+      LOFTY_TRACE_FUNC();
+
+      ASSERT(rw_mutex.try_lock_for(10));
+      rw_mutex.unlock();
+      ASSERT(rw_mutex.try_lock_shared_for(10));
+      ASSERT(rw_mutex.try_lock_shared());
+      ASSERT(!rw_mutex.try_lock());
+      rw_mutex.unlock_shared();
+      rw_mutex.unlock_shared();
+      ASSERT(rw_mutex.try_lock());
+      rw_mutex.unlock();
+   });
+   this_thread::run_coroutines();
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_channel,
+   "lofty::channel (using coroutines) – multiple producers and consumers on multiple threads"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static unsigned const threads_size = 4;
+   static std::size_t const producers_size = 3;
+   static std::size_t const values_per_producer = 1000;
+
+   auto coro_sched(this_thread::attach_coroutine_scheduler());
+   {
+      // A small capacity forces both senders and receivers to block often.
+      channel<std::size_t> chan(4);
+      _std::atomic<std::size_t> producers_left(producers_size), received(0), received_sum(0);
+
+      LOFTY_FOR_EACH(auto producer, make_range(std::size_t(0), producers_size)) {
+         coroutine([&chan, &producers_left, producer] () {
+            LOFTY_TRACE_FUNC();
+
+            std::size_t first_value = producer * values_per_producer;
+            if (producer == 0) {
+               std::size_t values[values_per_producer];
+               LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), values_per_producer)) {
+                  values[i] = first_value + i;
+               }
+               chan.send_many(values, values_per_producer);
+            } else {
+               LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), values_per_producer)) {
+                  chan.send(first_value + i);
+               }
+            }
+            if (producers_left.fetch_sub(1) == 1) {
+               chan.close();
+            }
+         });
+      }
+      coroutine([&chan, &received, &received_sum] () {
+         LOFTY_TRACE_FUNC();
+
+         std::size_t value;
+         while (chan.receive(&value)) {
+            received.fetch_add(1);
+            received_sum.fetch_add(value);
+         }
+      });
+      coroutine([&chan, &received, &received_sum] () {
+         LOFTY_TRACE_FUNC();
+
+         std::size_t values[16];
+         while (std::size_t count = chan.receive_many(values, LOFTY_COUNTOF(values))) {
+            LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), count)) {
+               received.fetch_add(1);
+               received_sum.fetch_add(values[i]);
+            }
+         }
+      });
+
+      // Threads must not be started while this thread has a scheduler.
+      this_thread::detach_coroutine_scheduler();
+      thread threads[threads_size - 1];
+      LOFTY_FOR_EACH(auto & thread, threads) {
+         thread = lofty::thread([&coro_sched] () {
+            this_thread::attach_coroutine_scheduler(coro_sched);
+            this_thread::run_coroutines();
+         });
+      }
+      this_thread::attach_coroutine_scheduler(coro_sched);
+      this_thread::run_coroutines();
+      LOFTY_FOR_EACH(auto & thread, threads) {
+         thread.join();
+      }
+
+      std::size_t values_size = producers_size * values_per_producer;
+      ASSERT(received.load() == values_size);
+      ASSERT(received_sum.load() == values_size * (values_size - 1) / 2);
+      ASSERT(chan.closed());
+      ASSERT(chan.size() == 0u);
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_channel_close_and_interruption,
+   "lofty::channel (using coroutines) – non-blocking operations, closing and interruption"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+   {
+      channel<int> chan(2);
+      int value = 0;
+      ASSERT(chan.try_send(1));
+      ASSERT(chan.try_send(2));
+      ASSERT(!chan.try_send(3));
+      ASSERT(chan.size() == 2u);
+      ASSERT(chan.try_receive(&value));
+      ASSERT(value == 1);
+      ASSERT(chan.try_receive(&value));
+      ASSERT(value == 2);
+      ASSERT(!chan.try_receive(&value));
+      int values[4];
+      ASSERT(chan.try_send(3));
+      ASSERT(chan.try_send(4));
+      ASSERT(chan.receive_many(values, LOFTY_COUNTOF(values)) == 2u);
+      ASSERT(values[0] == 3);
+      ASSERT(values[1] == 4);
+
+      bool receiver_interrupted = false, value_kept = false, sender_failed = false;
+      int drained_value = 0;
+      coroutine receiver_coro([&chan, &receiver_interrupted] () {
+         LOFTY_TRACE_FUNC();
+
+         int received_value;
+         try {
+            chan.receive(&received_value);
+         } catch (execution_interruption const &) {
+            receiver_interrupted = true;
+         }
+      });
+      coroutine([&chan, &receiver_coro, &value_kept, &sender_failed, &drained_value] () {
+         LOFTY_TRACE_FUNC();
+
+         // Let receiver_coro block on the empty channel, then interrupt it.
+         this_coroutine::sleep_for_ms(5);
+         receiver_coro.interrupt();
+         receiver_coro.join();
+         // The interrupted receiver must have left the channel, so the value must stay in it.
+         chan.send(4);
+         value_kept = (chan.size() == 1);
+         chan.close();
+         sender_failed = !chan.send(5);
+         // The value sent before closing must still be received; then receive() must fail without blocking.
+         chan.receive(&drained_value);
+         int no_value;
+         if (chan.receive(&no_value)) {
+            drained_value = -1;
+         }
+      });
+
+      this_thread::run_coroutines();
+
+      ASSERT(receiver_interrupted);
+      ASSERT(value_kept);
+      ASSERT(sender_failed);
+      ASSERT(drained_value == 4);
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
 LOFTY_TESTING_TEST_CASE_FUNC(
    coroutine_keyed_demux,
    "lofty::keyed_demux (using coroutines)"
@@ -584,3 +1257,351 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 }
 
 }} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_keyed_demux_burst,
+   "lofty::keyed_demux (using coroutines) – bursts of values for many keys"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static int const keys_size = 1000;
+   // Nobody waits for this key.
+   static int const unexpected_key = keys_size;
+   // This key is waited for with a timeout, but never returned by the source.
+   static int const missing_key = keys_size + 1;
+
+   this_thread::attach_coroutine_scheduler();
+   {
+      keyed_demux<int, int> number_demux;
+      int next_key = keys_size;
+      bool unexpected_returned = false;
+      number_demux.set_source([&next_key, &unexpected_returned] (int * key) -> int {
+         LOFTY_TRACE_FUNC();
+
+         if (next_key == keys_size) {
+            // Let every get() call start waiting, then return all the values without yielding.
+            this_coroutine::sleep_for_ms(5);
+         }
+         if (!unexpected_returned && next_key == keys_size / 2) {
+            unexpected_returned = true;
+            *key = unexpected_key;
+            return 1;
+         }
+         if (next_key > 0) {
+            // In this test, the values are the keys plus 1.
+            *key = --next_key;
+            return next_key + 1;
+         }
+         // Let the timed get() expire before reporting EOF.
+         this_coroutine::sleep_for_ms(30);
+         return 0;
+      });
+
+      int get_returns[keys_size];
+      memory::clear(&get_returns);
+      LOFTY_FOR_EACH(int key, make_range(0, keys_size)) {
+         coroutine([&number_demux, &get_returns, key] () {
+            LOFTY_TRACE_FUNC();
+
+            get_returns[key] = number_demux.get(key);
+         });
+      }
+      bool missing_timedout = false;
+      coroutine([&number_demux, &missing_timedout] () {
+         LOFTY_TRACE_FUNC();
+
+         try {
+            number_demux.get(missing_key, 10);
+         } catch (io::timeout const &) {
+            missing_timedout = true;
+         }
+      });
+
+      this_thread::run_coroutines();
+
+      ASSERT(next_key == 0);
+      ASSERT(unexpected_returned);
+      ASSERT(missing_timedout);
+      bool all_delivered = true;
+      LOFTY_FOR_EACH(int key, make_range(0, keys_size)) {
+         if (get_returns[key] != key + 1) {
+            all_delivered = false;
+         }
+      }
+      ASSERT(all_delivered);
+      // The source has ended, so this must not block.
+      ASSERT(number_demux.get(0) == 0);
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+namespace {
+
+/*! Calls itself until the stack overflows.
+
+@param depth
+   Count of recursive calls so far.
+@return
+   Never returns, in practice.
+*/
+std::size_t recurse_until_stack_overflow(std::size_t depth) {
+   std::int8_t volatile buf[512];
+   buf[0] = static_cast<std::int8_t>(depth);
+   if (depth == numeric::max<std::size_t>::value) {
+      return 0;
+   }
+   return recurse_until_stack_overflow(depth + 1) + static_cast<std::size_t>(buf[0]);
+}
+
+} //namespace
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_stack_overflow,
+   "lofty::coroutine – stack overflow"
+) {
+   LOFTY_TRACE_FUNC();
+
+   coroutine::scheduler_options coro_sched_opts;
+   coro_sched_opts.stack_size = 16 * 1024;
+   this_thread::attach_coroutine_scheduler(coro_sched_opts);
+
+   bool overflowed = false, other_coro_ran = false;
+   coroutine([&overflowed] () {
+      LOFTY_TRACE_FUNC();
+
+      try {
+         recurse_until_stack_overflow(0);
+      } catch (memory::stack_overflow const &) {
+         overflowed = true;
+      }
+   });
+   // This will reuse the stack of the first coroutine if it’s still usable, or get a new one.
+   coroutine([&other_coro_ran] () {
+      LOFTY_TRACE_FUNC();
+
+      this_coroutine::sleep_for_ms(1);
+      other_coro_ran = true;
+   });
+
+   this_thread::run_coroutines();
+
+   ASSERT(overflowed);
+   ASSERT(other_coro_ran);
+
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_ping_pong,
+   "lofty::coroutine – context switch speed (ping-pong via events)"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static std::size_t const round_trips = 10000;
+
+   this_thread::attach_coroutine_scheduler();
+   {
+      event ping, pong;
+      std::size_t pings = 0, pongs = 0;
+
+      coroutine([&ping, &pong, &pings] () {
+         LOFTY_TRACE_FUNC();
+
+         LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), round_trips)) {
+            LOFTY_UNUSED_ARG(i);
+            ping.trigger();
+            pong.wait();
+            ++pings;
+         }
+      });
+      coroutine([&ping, &pong, &pongs] () {
+         LOFTY_TRACE_FUNC();
+
+         LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), round_trips)) {
+            LOFTY_UNUSED_ARG(i);
+            ping.wait();
+            ++pongs;
+            pong.trigger();
+         }
+      });
+
+      perf::stopwatch sw;
+      sw.start();
+      this_thread::run_coroutines();
+      auto ns = sw.stop();
+
+      ASSERT(pings == round_trips);
+      ASSERT(pongs == round_trips);
+
+      // Each round trip resumes each coroutine once.
+      std::size_t switches = round_trips * 2;
+      LOFTY_LOG(
+         info, LOFTY_SL("coroutine ping-pong: {} context switches in {} ns, {} switches/s\n"),
+         switches, ns, ns ? static_cast<std::uint64_t>(switches) * 1000000000u / ns : 0
+      );
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if LOFTY_HOST_API_POSIX
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_blocking_io,
+   "lofty::coroutine – blocking I/O on helper threads"
+) {
+   LOFTY_TRACE_FUNC();
+
+   this_thread::attach_coroutine_scheduler();
+   {
+      bool blocking_done = false, file_done = false;
+      int blocking_errno = 0;
+      std::size_t ticks = 0;
+      std::int8_t read_back[4096] = {};
+
+      coroutine([&blocking_done, &blocking_errno] () {
+         LOFTY_TRACE_FUNC();
+
+         // Block a helper thread long enough for the other coroutine to run several times.
+         _std::function<void ()> blocking_fn([] () {
+            ::usleep(50000);
+            errno = ENOENT;
+         });
+         this_coroutine::run_blocking_io(blocking_fn);
+         blocking_errno = errno;
+         blocking_done = true;
+      });
+      coroutine([&blocking_done, &ticks] () {
+         LOFTY_TRACE_FUNC();
+
+         while (!blocking_done) {
+            this_coroutine::sleep_for_ms(1);
+            ++ticks;
+         }
+      });
+      coroutine([&file_done, &read_back] () {
+         LOFTY_TRACE_FUNC();
+
+         std::int8_t data[sizeof read_back];
+         LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), sizeof data)) {
+            data[i] = static_cast<std::int8_t>(i * 7);
+         }
+         os::path path(LOFTY_SL("lofty-test-blocking-io.tmp"));
+         {
+            auto ostream(io::binary::open_ostream(path));
+            ostream->write_bytes(data, sizeof data);
+            ostream->flush();
+            ostream->close();
+         }
+         {
+            auto istream(io::binary::open_istream(path));
+            std::size_t bytes_read = 0, last_read;
+            while ((last_read = istream->read_bytes(read_back + bytes_read, sizeof read_back - bytes_read))) {
+               bytes_read += last_read;
+            }
+         }
+         ::unlink(path.os_str().c_str());
+         file_done = true;
+         LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), sizeof data)) {
+            if (read_back[i] != data[i]) {
+               file_done = false;
+            }
+         }
+      });
+
+      this_thread::run_coroutines();
+
+      ASSERT(blocking_done);
+      // errno must be propagated from the helper thread.
+      ASSERT(blocking_errno == ENOENT);
+      // The thread must have kept running coroutines while the helper thread was blocked.
+      ASSERT(ticks > 1u);
+      ASSERT(file_done);
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   coroutine_blocking_io_queue_full,
+   "lofty::coroutine – blocking I/O with a full job queue"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // Allow one running and one queued job, so most of the coroutines below will find the queue full.
+   coroutine::scheduler_options coro_sched_opts;
+   coro_sched_opts.blocking_io_threads = 1;
+   coro_sched_opts.blocking_io_queue_depth = 1;
+   this_thread::attach_coroutine_scheduler(coro_sched_opts);
+   {
+      static std::size_t const jobs = 6;
+      ::pthread_t sched_thread = ::pthread_self();
+      std::size_t jobs_done = 0, jobs_on_sched_thread = 0, ticks = 0;
+      _std::function<void ()> blocking_fn([sched_thread, &jobs_on_sched_thread] () {
+         if (::pthread_equal(::pthread_self(), sched_thread)) {
+            ++jobs_on_sched_thread;
+         }
+         ::usleep(10000);
+      });
+
+      LOFTY_FOR_EACH(auto i, make_range(std::size_t(0), jobs)) {
+         LOFTY_UNUSED_ARG(i);
+         coroutine([&blocking_fn, &jobs_done] () {
+            LOFTY_TRACE_FUNC();
+
+            this_coroutine::run_blocking_io(blocking_fn);
+            ++jobs_done;
+         });
+      }
+      coroutine([&jobs_done, &ticks] () {
+         LOFTY_TRACE_FUNC();
+
+         while (jobs_done < jobs) {
+            this_coroutine::sleep_for_ms(1);
+            ++ticks;
+         }
+      });
+      this_thread::run_coroutines();
+
+      ASSERT(jobs_done == jobs);
+      // Coroutines that found the queue full must have waited for room, instead of blocking this thread.
+      ASSERT(jobs_on_sched_thread == 0u);
+      ASSERT(ticks > jobs);
+   }
+   // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+   this_thread::detach_coroutine_scheduler();
+}
+
+}} //namespace lofty::test
+
+#endif //if LOFTY_HOST_API_POSIX
@@ -0,0 +1,185 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/io/binary.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/try_finally.hxx>
+#include <lofty/_std/memory.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Writes a sequence of bytes to a buffered stream, in chunks of the specified size.
+
+@param buf_ostream
+   Stream to write to.
+@param total_size
+   Count of bytes to write.
+@param chunk_size
+   Size of each chunk.
+*/
+static void write_sequence(
+   io::binary::buffered_ostream * buf_ostream, std::size_t total_size, std::size_t chunk_size
+) {
+   for (std::size_t written_size = 0; written_size < total_size; written_size += chunk_size) {
+      auto chunk(buf_ostream->get_buffer<std::uint8_t>(chunk_size));
+      for (std::size_t i = 0; i < chunk_size; ++i) {
+         chunk.ptr[i] = static_cast<std::uint8_t>(written_size + i);
+      }
+      buf_ostream->commit<std::uint8_t>(chunk_size);
+   }
+   buf_ostream->flush();
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_binary_default_buffered_pipe,
+   "lofty::io::binary::default_buffered_istream/ostream – fixed and adaptive buffer sizes on a pipe"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // Less than the capacity of a pipe, so that the whole sequence can be written before reading it.
+   static std::size_t const total_size = 0x8000;
+   io::binary::pipe pipe;
+   LOFTY_TRY {
+      auto fixed_ostream(io::binary::buffer_ostream(pipe.write_end, 0x1000));
+      auto fixed_istream(io::binary::buffer_istream(pipe.read_end, 0x1000));
+      write_sequence(fixed_ostream.get(), total_size, 0x80);
+      // A fixed-size buffer never holds more than its size, unless a larger peek is requested.
+      std::size_t read_size = 0, max_peek_size = 0, errors = 0;
+      while (read_size < total_size) {
+         auto peeked(fixed_istream->peek<std::uint8_t>(1));
+         if (peeked.size > max_peek_size) {
+            max_peek_size = peeked.size;
+         }
+         for (std::size_t i = 0; i < peeked.size; ++i) {
+            if (peeked.ptr[i] != static_cast<std::uint8_t>(read_size + i)) {
+               ++errors;
+            }
+         }
+         fixed_istream->consume<std::uint8_t>(peeked.size);
+         read_size += peeked.size;
+      }
+      ASSERT(read_size == total_size);
+      ASSERT(max_peek_size <= 0x1000u);
+      ASSERT(errors == 0u);
+
+      write_sequence(fixed_ostream.get(), 0x3000, 0x3000);
+      ASSERT(fixed_istream->peek<std::uint8_t>(0x3000).size >= 0x3000u);
+      fixed_istream->consume<std::uint8_t>(0x3000);
+      fixed_ostream->close();
+
+      // The automatically sized buffer of a pipe can take the whole sequence in one read.
+      auto auto_ostream(io::binary::buffer_ostream(pipe.write_end));
+      auto auto_istream(io::binary::buffer_istream(pipe.read_end));
+      write_sequence(auto_ostream.get(), total_size, 0x80);
+      auto peeked(auto_istream->peek<std::uint8_t>(1));
+      ASSERT(peeked.size == total_size);
+      errors = 0;
+      for (std::size_t i = 0; i < peeked.size; ++i) {
+         if (peeked.ptr[i] != static_cast<std::uint8_t>(i)) {
+            ++errors;
+         }
+      }
+      ASSERT(errors == 0u);
+      auto_istream->consume<std::uint8_t>(peeked.size);
+      auto_ostream->close();
+   } LOFTY_FINALLY {
+      pipe.write_end->close();
+   };
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Checks that a stream returns the next bytes of a sequence.
+
+@param buf_istream
+   Stream to read from.
+@param first
+   Expected first byte.
+@param size
+   Count of bytes to read.
+@return
+   true if the bytes read match the sequence, or false otherwise.
+*/
+static bool read_sequence(io::binary::buffered_istream * buf_istream, std::size_t first, std::size_t size) {
+   auto peeked(buf_istream->peek<std::uint8_t>(size));
+   if (peeked.size < size) {
+      return false;
+   }
+   for (std::size_t i = 0; i < size; ++i) {
+      if (peeked.ptr[i] != static_cast<std::uint8_t>(first + i)) {
+         return false;
+      }
+   }
+   buf_istream->consume<std::uint8_t>(size);
+   return true;
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_binary_default_buffered_ostream_vectored,
+   "lofty::io::binary::default_buffered_ostream – vectored writes and writes by reference"
+) {
+   LOFTY_TRACE_FUNC();
+
+   std::uint8_t src[0x3000];
+   for (std::size_t i = 0; i < sizeof src; ++i) {
+      src[i] = static_cast<std::uint8_t>(i);
+   }
+   io::binary::pipe pipe;
+   LOFTY_TRY {
+      auto buf_istream(io::binary::buffer_istream(pipe.read_end));
+
+      // Unbuffered vectored write, with an empty range in the middle.
+      io::binary::buffer_range<void const> ranges[] = {
+         io::binary::buffer_range<void const>(src, 10),
+         io::binary::buffer_range<void const>(src + 10, 0),
+         io::binary::buffer_range<void const>(src + 10, 90)
+      };
+      ASSERT(pipe.write_end->write_vectored(ranges, sizeof ranges / sizeof ranges[0]) == 100u);
+      ASSERT(read_sequence(buf_istream.get(), 0, 100));
+
+      auto buf_ostream(io::binary::buffer_ostream(pipe.write_end, 0x1000));
+      // Buffered bytes, then bytes by reference, then more buffered bytes: all must be written in order.
+      buf_ostream->write(src, 100);
+      bool written = false;
+      buf_ostream->write_bytes_by_ref(src + 100, 1000, [&written] () {
+         written = true;
+      });
+      buf_ostream->write(src + 1100, 50);
+      ASSERT(!written);
+      buf_ostream->flush();
+      ASSERT(written);
+      ASSERT(read_sequence(buf_istream.get(), 0, 1150));
+
+      // An array larger than the buffer is written immediately, right after the buffered bytes.
+      buf_ostream->write(src, 10);
+      buf_ostream->write(src + 10, 0x2000);
+      ASSERT(read_sequence(buf_istream.get(), 0, 10 + 0x2000));
+
+      // Bytes by reference still queued when the stream is closed are written, too.
+      buf_ostream->write_bytes_by_ref(src, 0x3000, nullptr);
+      buf_ostream->close();
+      ASSERT(read_sequence(buf_istream.get(), 0, 0x3000));
+   } LOFTY_FINALLY {
+      pipe.write_end->close();
+   };
+}
+
+}} //namespace lofty::test
@@ -0,0 +1,114 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/io.hxx>
+#include <lofty/io/binary.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/os/path.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/_std/memory.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Compares two byte arrays.
+
+@param bytes1
+   First array.
+@param bytes2
+   Second array.
+@param size
+   Size of each array.
+@return
+   true if the two arrays have the same contents, or false otherwise.
+*/
+static bool bytes_equal(std::int8_t const * bytes1, std::int8_t const * bytes2, std::size_t size) {
+   for (std::size_t i = 0; i < size; ++i) {
+      if (bytes1[i] != bytes2[i]) {
+         return false;
+      }
+   }
+   return true;
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_binary_mapped_file_istream_read,
+   "lofty::io::binary::mapped_file_istream – peeking, consuming and seeking"
+) {
+   LOFTY_TRACE_FUNC();
+
+   os::path path(LOFTY_SL("test/lofty/io/text/data/utf8_mixed_no-trailing-nl.txt"));
+   // Read the whole file the usual way, for comparison.
+   auto buf_istream(io::binary::buffer_istream(io::binary::open_istream(path)));
+   auto expected(buf_istream->peek<std::int8_t>(0x10000));
+
+   auto mapped_istream(io::binary::open_mapped_istream(path));
+   // The stream must be its own buffer, instead of being wrapped by another one.
+   ASSERT(mapped_istream->unbuffered().get() == static_cast<io::binary::istream *>(mapped_istream.get()));
+   auto mapped(mapped_istream->peek<std::int8_t>(1));
+   ASSERT(mapped.size == expected.size);
+   ASSERT(bytes_equal(mapped.ptr, expected.ptr, expected.size));
+
+   mapped_istream->consume<std::int8_t>(10);
+   auto after_consume(mapped_istream->peek<std::int8_t>(1));
+   ASSERT(after_consume.ptr == mapped.ptr + 10);
+   ASSERT(after_consume.size == mapped.size - 10);
+
+   auto seekable_istream(_std::dynamic_pointer_cast<io::binary::seekable>(mapped_istream));
+   ASSERT(seekable_istream != nullptr);
+   ASSERT(seekable_istream->seek(-5, io::seek_from::current) == 5);
+   ASSERT(seekable_istream->tell() == 5);
+   std::int8_t read_buf[3];
+   ASSERT(mapped_istream->read_bytes(read_buf, sizeof read_buf) == sizeof read_buf);
+   ASSERT(bytes_equal(read_buf, expected.ptr + 5, sizeof read_buf));
+   ASSERT(seekable_istream->tell() == 8);
+
+   seekable_istream->seek(0, io::seek_from::end);
+   ASSERT(mapped_istream->peek<std::int8_t>(1).size == 0u);
+   ASSERT_THROWS(io::error, seekable_istream->seek(1, io::seek_from::end));
+   ASSERT_THROWS(io::error, seekable_istream->seek(-1, io::seek_from::start));
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_binary_mapped_file_istream_text,
+   "lofty::io::binary::mapped_file_istream – reading text"
+) {
+   LOFTY_TRACE_FUNC();
+
+   os::path path(LOFTY_SL("test/lofty/io/text/data/utf8_mixed_no-trailing-nl.txt"));
+   text::str expected, mapped;
+   auto read_istream(io::text::open_istream(path, text::encoding::utf8));
+   LOFTY_FOR_EACH(auto & line, read_istream->lines()) {
+      expected += line;
+      expected += LOFTY_SL("|");
+   }
+   auto mapped_istream(io::text::make_istream(io::binary::open_mapped_istream(path), text::encoding::utf8));
+   LOFTY_FOR_EACH(auto & line, mapped_istream->line_views()) {
+      mapped += line;
+      mapped += LOFTY_SL("|");
+   }
+   ASSERT(mapped == expected);
+}
+
+}} //namespace lofty::test
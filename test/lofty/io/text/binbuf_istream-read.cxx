@@ -12,11 +12,15 @@ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Les
 more details.
 ------------------------------------------------------------------------------------------------------------*/
 
+#include <lofty/exception.hxx>
+#include <lofty/io/binary/memory.hxx>
 #include <lofty/io/text.hxx>
 #include <lofty/logging.hxx>
 #include <lofty/os/path.hxx>
 #include <lofty/testing/test_case.hxx>
+#include <lofty/text.hxx>
 #include <lofty/text/str.hxx>
+#include <lofty/_std/memory.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -205,3 +209,113 @@ public:
 }} //namespace lofty::test
 
 LOFTY_TESTING_REGISTER_TEST_CASE(lofty::test::binbuf_istream_read_line_utf32le_mixed_no_trailing_nl)
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Returns a text input stream reading the specified characters, encoded in UTF-16LE so that they have to be
+transcoded into the peek buffer of the stream.
+
+@param s
+   Characters to read.
+@return
+   Text input stream.
+*/
+static _std::unique_ptr<io::text::binbuf_istream> make_utf16le_istream(text::str const & s) {
+   auto mems(_std::make_shared<io::binary::memory_stream>());
+   void const * src = s.data();
+   std::size_t src_byte_size = s.size_in_chars() * sizeof(text::char_t);
+   std::uint8_t utf16[1024];
+   void * utf16_end = utf16;
+   std::size_t utf16_byte_size = sizeof utf16;
+   text::transcode(
+      true, text::encoding::host, &src, &src_byte_size, text::encoding::utf16le, &utf16_end, &utf16_byte_size
+   );
+   mems->write(utf16, sizeof utf16 - utf16_byte_size);
+   return _std::unique_ptr<io::text::binbuf_istream>(
+      new io::text::binbuf_istream(mems, text::encoding::utf16le)
+   );
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_text_binbuf_istream_unconsume_chars,
+   "lofty::io::text::binbuf_istream – unconsuming characters after consuming some"
+) {
+   LOFTY_TRACE_FUNC();
+
+   auto istream(make_utf16le_istream(text::str(LOFTY_SL("line1\nline2"))));
+   ASSERT(istream->peek_chars(1) == LOFTY_SL("line1\nline2"));
+   // Unconsumed characters must go back right before the ones not consumed yet.
+   istream->consume_chars(3);
+   istream->unconsume_chars(text::str(LOFTY_SL("LI")));
+   ASSERT(istream->peek_chars(1) == LOFTY_SL("LIe1\nline2"));
+   // More than were consumed, which requires shifting the characters not consumed yet.
+   istream->unconsume_chars(text::str(LOFTY_SL("01234")));
+   ASSERT(istream->peek_chars(1) == LOFTY_SL("01234LIe1\nline2"));
+   text::str line;
+   ASSERT(istream->read_line(&line));
+   ASSERT(line == LOFTY_SL("01234LIe1"));
+   ASSERT(istream->read_line(&line));
+   ASSERT(line == LOFTY_SL("line2"));
+   ASSERT(!istream->read_line(&line));
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_text_binbuf_istream_peek_multibyte,
+   "lofty::io::text::binbuf_istream – peeking up to a character that doesn’t fit the peek buffer"
+) {
+   LOFTY_TRACE_FUNC();
+
+   /* Enough characters to fill the default size of the peek buffer but for one, followed by one that takes
+   up more than one text::char_t. */
+   text::str s;
+   for (unsigned i = 0; i < 127; ++i) {
+      s += LOFTY_SL("a");
+   }
+   s += char32_t(0x1f600);
+   s += LOFTY_SL("b");
+   auto istream(make_utf16le_istream(s));
+   ASSERT(istream->peek_chars(128).size_in_chars() >= 128u);
+   text::str line;
+   ASSERT(istream->read_line(&line));
+   ASSERT(line == s);
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_text_binbuf_istream_passthrough,
+   "lofty::io::text::binbuf_istream – UTF-8 passthrough, consuming and unconsuming"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static std::uint8_t const utf8[] = {
+      'l', 'i', 'n', 'e', '1', '\n', 'l', 0xc3, 0xa8, 'n', 'e', '2', '\n', 0xc0, 0x81
+   };
+   auto mems(_std::make_shared<io::binary::memory_stream>());
+   mems->write(utf8, sizeof utf8);
+   io::text::binbuf_istream istream(mems, text::encoding::utf8);
+
+   // The valid prefix is returned as a whole, without transcoding.
+   text::str s(istream.peek_chars(1));
+   ASSERT(s.size_in_chars() == 13u);
+   istream.consume_chars(2);
+   ASSERT_THROWS(argument_error, istream.consume_chars(12));
+   istream.unconsume_chars(text::str(LOFTY_SL("li")));
+   text::str line;
+   ASSERT(istream.read_line(&line));
+   ASSERT(line == LOFTY_SL("line1"));
+   ASSERT(istream.read_line(&line));
+   ASSERT(line == LOFTY_SL("lène2"));
+   // The overlong sequence is not passed through, but transcoded into U+0001.
+   ASSERT(istream.read_line(&line));
+   ASSERT(line == LOFTY_SL("\x01"));
+   ASSERT(!istream.read_line(&line));
+}
+
+}} //namespace lofty::test
@@ -0,0 +1,112 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/collections/vector.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/io/text/str.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/_std/algorithm.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+namespace {
+
+/*! String input stream that returns at most a few characters from each call to peek_chars() (unless more are
+requested), to exercise line terminators split across peek buffers. */
+class chunked_str_istream : public io::text::str_istream {
+public:
+   /*! Constructor.
+
+   @param src
+      Source string.
+   @param chunk_size_
+      See chunk_size.
+   */
+   chunked_str_istream(text::str const & src, std::size_t chunk_size_) :
+      io::text::str_stream(src),
+      io::text::str_istream(src),
+      chunk_size(chunk_size_) {
+   }
+
+   //! See io::text::str_istream::peek_chars().
+   virtual text::str peek_chars(std::size_t count_min) override {
+      text::str peeked(io::text::str_istream::peek_chars(count_min));
+      return text::str(
+         external_buffer, peeked.data(),
+         _std::min(peeked.size_in_chars(), _std::max(count_min, chunk_size))
+      );
+   }
+
+private:
+   //! Maximum count of characters returned by peek_chars(), unless more are requested.
+   std::size_t chunk_size;
+};
+
+/*! Reads all the lines in a string, joining them with “|”.
+
+@param src
+   Source string.
+@param lterm
+   Line terminator to use.
+@param chunk_size
+   Maximum count of characters to make available at once.
+@param views
+   If true, lines will be read with line_views() instead of lines().
+@return
+   Lines read, joined by “|”.
+*/
+text::str read_lines(text::str const & src, text::line_terminator lterm, std::size_t chunk_size, bool views) {
+   chunked_str_istream istream(src, chunk_size);
+   istream.set_line_terminator(lterm);
+   text::str ret;
+   bool first = true;
+   LOFTY_FOR_EACH(auto & line, views ? istream.line_views() : istream.lines()) {
+      if (!first) {
+         ret += LOFTY_SL("|");
+      }
+      first = false;
+      ret += line;
+   }
+   return ret;
+}
+
+} //namespace
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_text_istream_read_line,
+   "lofty::io::text::istream – reading lines with each line terminator, as copies and as views"
+) {
+   LOFTY_TRACE_FUNC();
+
+   typedef text::line_terminator lt;
+   text::str src(LOFTY_SL("ab\r\ncd\ref\ngh\r\r\nij"));
+   static std::size_t const chunk_sizes[] = { 1, 2, 3, 1000 };
+   for (std::size_t i = 0; i < sizeof chunk_sizes / sizeof chunk_sizes[0]; ++i) {
+      for (int views = 0; views < 2; ++views) {
+         std::size_t chunk_size = chunk_sizes[i];
+         bool as_views = views != 0;
+         ASSERT(read_lines(src, lt::any, chunk_size, as_views) == LOFTY_SL("ab|cd|ef|gh||ij"));
+         ASSERT(read_lines(src, lt::lf, chunk_size, as_views) == LOFTY_SL("ab\r|cd\ref|gh\r\r|ij"));
+         ASSERT(read_lines(src, lt::cr, chunk_size, as_views) == LOFTY_SL("ab|\ncd|ef\ngh||\nij"));
+         ASSERT(read_lines(src, lt::cr_lf, chunk_size, as_views) == LOFTY_SL("ab|cd\ref\ngh\r|ij"));
+      }
+   }
+}
+
+}} //namespace lofty::test
@@ -12,6 +12,8 @@ warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Les
 more details.
 ------------------------------------------------------------------------------------------------------------*/
 
+#include <lofty/collections.hxx>
+#include <lofty/io/text.hxx>
 #include <lofty/io/text/str.hxx>
 #include <lofty/logging.hxx>
 #include <lofty/testing/test_case.hxx>
@@ -116,3 +118,38 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 }
 
 }} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   io_text_prepared_format,
+   "lofty::io::text::prepared_format – printing with a pre-parsed format string"
+) {
+   LOFTY_TRACE_FUNC();
+
+   text::sstr<128> buf;
+   io::text::str_ostream ostream(external_buffer, buf.str_ptr());
+
+   // Errors are reported on construction.
+   ASSERT_THROWS(text::syntax_error, io::text::prepared_format<int>(LOFTY_SL("{")));
+   ASSERT_THROWS(text::syntax_error, io::text::prepared_format<int>(LOFTY_SL("}}}")));
+   ASSERT_THROWS(collections::out_of_range, io::text::prepared_format<int>(LOFTY_SL("{1}")));
+
+   io::text::prepared_format<> none(LOFTY_SL("x{{}}"));
+   ostream.clear();
+   none.print(&ostream);
+   ASSERT(ostream.get_str() == LOFTY_SL("x{}"));
+
+   io::text::prepared_format<text::str, int> two(LOFTY_SL("{1:#x}{0}x{{{0}}}{1}"));
+   ostream.clear();
+   two.print(&ostream, LOFTY_SL("a"), 34);
+   ASSERT(ostream.get_str() == LOFTY_SL("0x22ax{a}34"));
+   // Printing again reuses the same pre-parsed format specifications.
+   ostream.clear();
+   two.print(&ostream, LOFTY_SL("bc"), 255);
+   ASSERT(ostream.get_str() == LOFTY_SL("0xffbcx{bc}255"));
+}
+
+}} //namespace lofty::test
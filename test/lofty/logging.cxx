@@ -0,0 +1,316 @@
+﻿/* -*- coding: utf-8; mode: c++; tab-width: 3; indent-tabs-mode: nil -*-
+
+Copyright 2018 Raffaello D. Di Napoli
+
+This file is part of Lofty.
+
+Lofty is free software: you can redistribute it and/or modify it under the terms of version 2.1 of the GNU
+Lesser General Public License as published by the Free Software Foundation.
+
+Lofty is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for
+more details.
+------------------------------------------------------------------------------------------------------------*/
+
+#include <lofty/coroutine.hxx>
+#include <lofty/event.hxx>
+#include <lofty/io/text.hxx>
+#include <lofty/io/text/str.hxx>
+#include <lofty/logging.hxx>
+#include <lofty/_std/memory.hxx>
+#include <lofty/_std/utility.hxx>
+#include <lofty/testing/test_case.hxx>
+#include <lofty/text.hxx>
+#include <lofty/text/str.hxx>
+#include <lofty/thread.hxx>
+#include <lofty/to_str.hxx>
+#include <lofty/try_finally.hxx>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   logging_level_filter,
+   "lofty::logging – level filtering"
+) {
+   LOFTY_TRACE_FUNC();
+
+   logging::level prev_max_level = logging::max_level();
+   unsigned evaluations = 0;
+   logging::set_max_level(logging::level::err);
+   // Filtered messages must not have their arguments evaluated.
+   LOFTY_LOG(dbg, LOFTY_SL("{}\n"), ++evaluations);
+   LOFTY_LOG(warn, LOFTY_SL("{}\n"), ++evaluations);
+   ASSERT(evaluations == 0u);
+   ASSERT(logging::get_ostream_if(logging::level::info) == nullptr);
+   ASSERT(logging::get_ostream_if(logging::level::err) != nullptr);
+   logging::set_max_level(prev_max_level);
+   ASSERT(logging::max_level() == prev_max_level);
+   // With no records pending, this must return promptly.
+   logging::flush();
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   logging_deferred_args,
+   "lofty::logging – deferred arguments outliving their source"
+) {
+   LOFTY_TRACE_FUNC();
+
+   text::char_t buf[] = LOFTY_SL("abc");
+   text::str view(external_buffer, buf, 3);
+   text::str format(external_buffer, LOFTY_SL("{}"));
+   /* Capture the arguments as LOFTY_LOG() does, then overwrite what they refer to before formatting them, as
+   the writer thread would; e.g. a line from read_line_view() is overwritten by reading the next one. */
+   logging::_pvt::deferred_record<text::str> record(text::str(format.data(), format.data_end()), view);
+   buf[0] = 'x';
+   buf[1] = 'y';
+   buf[2] = 'z';
+   io::text::str_ostream ostream;
+   record.print(&ostream);
+   ASSERT(ostream.get_str() == LOFTY_SL("abc"));
+}
+
+}} //namespace lofty::test
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+namespace lofty { namespace test {
+
+/*! String stream that can hold the log writer thread in flush(), so that records pile up in the ring of the
+thread logging them. Used in place of io::text::stderr. */
+class gated_str_ostream : public io::text::str_ostream {
+public:
+   //! Default constructor.
+   gated_str_ostream() :
+      hold(false) {
+   }
+
+   /*! Makes the next flush() block until release() is called.
+
+   @return
+      Event triggered once the writer thread is blocked.
+   */
+   event & hold_next_flush() {
+      hold = true;
+      return entered;
+   }
+
+   //! Lets the writer thread return from flush().
+   void release() {
+      released.trigger();
+   }
+
+   //! See io::text::str_ostream::flush().
+   virtual void flush() override {
+      if (hold) {
+         hold = false;
+         entered.trigger();
+         released.wait();
+      }
+      io::text::str_ostream::flush();
+   }
+
+private:
+   //! If true, the next flush() will block.
+   bool hold;
+   //! Triggered by flush() when it blocks.
+   event entered;
+   //! Triggered by release().
+   event released;
+};
+
+/*! Logs records of alternating sizes, so that the ring can’t be filled by records of the same size and has to
+skip the leftover space at its end with padding.
+
+@param first
+   Number of the first record.
+@param count
+   Count of records to log.
+*/
+static void log_numbered_records(std::size_t first, std::size_t count) {
+   for (std::size_t i = first; i < first + count; ++i) {
+      if (i % 3 == 0) {
+         LOFTY_LOG(info, LOFTY_SL("{}\n"), i);
+      } else {
+         LOFTY_LOG(info, LOFTY_SL("{}{}\n"), i, text::str(text::str::empty));
+      }
+   }
+}
+
+/*! Reads consecutive numbered records written by log_numbered_records().
+
+@param istream
+   Stream to read from.
+@param first
+   Number of the first expected record.
+@param line
+   Pointer to a string that will receive the first line that didn’t contain the expected record, or be left
+   empty if the end of istream was reached.
+@return
+   Count of records read.
+*/
+static std::size_t read_numbered_records(io::text::istream * istream, std::size_t first, text::str * line) {
+   std::size_t i = first;
+   while (istream->read_line(line)) {
+      if (*line != to_str(i)) {
+         return i - first;
+      }
+      ++i;
+   }
+   line->clear();
+   return i - first;
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   logging_async_writer_block,
+   "lofty::logging – deferred records with overflow_policy::block"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // Way more than a ring can hold, to have it wrap around many times.
+   static std::size_t const records = 20000;
+
+   logging::flush();
+   auto capturing_stderr(_std::make_shared<gated_str_ostream>());
+   auto old_stderr(io::text::stderr);
+   io::text::stderr = capturing_stderr;
+   LOFTY_TRY {
+      /* Hold the writer thread after the first record, and only release it once this thread is likely blocked
+      waiting for room in its ring. */
+      event & writer_blocked = capturing_stderr->hold_next_flush();
+      LOFTY_LOG(info, LOFTY_SL("first\n"));
+      writer_blocked.wait();
+      thread releaser([&capturing_stderr] () {
+         this_thread::sleep_for_ms(50);
+         capturing_stderr->release();
+      });
+      log_numbered_records(0, records);
+      // flush() must only return once everything logged so far has been written.
+      logging::flush();
+      releaser.join();
+   } LOFTY_FINALLY {
+      io::text::stderr = _std::move(old_stderr);
+   };
+
+   io::text::str_istream istream(capturing_stderr->get_str());
+   text::str line;
+   ASSERT(istream.read_line(&line));
+   ASSERT(line == LOFTY_SL("first"));
+   // Nothing must be lost or reordered while the ring is full, wrapping around, or skipping padding.
+   ASSERT(read_numbered_records(&istream, 0, &line) == records);
+   ASSERT(line == text::str::empty);
+}
+
+}} //namespace lofty::test
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   logging_async_writer_drop,
+   "lofty::logging – deferred records with overflow_policy::drop"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static std::size_t const records = 20000;
+
+   logging::flush();
+   auto capturing_stderr(_std::make_shared<gated_str_ostream>());
+   auto old_stderr(io::text::stderr);
+   io::text::stderr = capturing_stderr;
+   logging::set_overflow_policy(logging::overflow_policy::drop);
+   LOFTY_TRY {
+      // Hold the writer thread after the first record, so that this thread’s ring fills up and stays full.
+      event & writer_blocked = capturing_stderr->hold_next_flush();
+      LOFTY_LOG(info, LOFTY_SL("first\n"));
+      writer_blocked.wait();
+      log_numbered_records(0, records);
+      capturing_stderr->release();
+      logging::flush();
+   } LOFTY_FINALLY {
+      logging::set_overflow_policy(logging::overflow_policy::block);
+      io::text::stderr = _std::move(old_stderr);
+   };
+
+   io::text::str_istream istream(capturing_stderr->get_str());
+   text::str line;
+   ASSERT(istream.read_line(&line));
+   ASSERT(line == LOFTY_SL("first"));
+   /* Once the ring is full, smaller records may still fit after larger ones are dropped. The records that fit
+   must be written in order, followed by the count of the others. */
+   std::size_t kept = 0;
+   for (std::size_t next = 0; istream.read_line(&line); ++next, ++kept) {
+      while (next < records && line != to_str(next)) {
+         ++next;
+      }
+      if (next == records) {
+         // Not a record, or one out of order.
+         break;
+      }
+   }
+   ASSERT(kept > 0u);
+   ASSERT(kept < records);
+   io::text::str_ostream dropped_report;
+   dropped_report.print(LOFTY_SL("logging: {} records dropped"), records - kept);
+   ASSERT(line == dropped_report.get_str());
+   ASSERT(!istream.read_line(&line));
+}
+
+}} //namespace lofty::test
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOFTY_CXX_VARIADIC_TEMPLATES
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   logging_flush_coroutine,
+   "lofty::logging – flush() from a coroutine"
+) {
+   LOFTY_TRACE_FUNC();
+
+   static std::size_t const records = 5000;
+
+   logging::flush();
+   auto capturing_stderr(_std::make_shared<io::text::str_ostream>());
+   auto old_stderr(io::text::stderr);
+   io::text::stderr = capturing_stderr;
+   bool all_written = false;
+   LOFTY_TRY {
+      this_thread::attach_coroutine_scheduler();
+      coroutine([&capturing_stderr, &all_written] () {
+         LOFTY_TRACE_FUNC();
+
+         log_numbered_records(0, records);
+         logging::flush();
+         // Check right away, before anything else can be logged.
+         io::text::str_istream istream(capturing_stderr->get_str());
+         text::str line;
+         all_written = read_numbered_records(&istream, 0, &line) == records && line == text::str::empty;
+      });
+      this_thread::run_coroutines();
+   } LOFTY_FINALLY {
+      // Avoid running other tests with a coroutine scheduler, as it might change their behavior.
+      this_thread::detach_coroutine_scheduler();
+      io::text::stderr = _std::move(old_stderr);
+   };
+
+   ASSERT(all_written);
+}
+
+}} //namespace lofty::test
+#endif //ifdef LOFTY_CXX_VARIADIC_TEMPLATES
@@ -13,14 +13,17 @@ more details.
 ------------------------------------------------------------------------------------------------------------*/
 
 #include <lofty/collections.hxx>
+#include <lofty/collections/hash_map.hxx>
 #include <lofty/collections/vector.hxx>
 #include <lofty/from_str.hxx>
 #include <lofty/logging.hxx>
+#include <lofty/_std/functional.hxx>
 #include <lofty/_std/utility.hxx>
 #include <lofty/testing/test_case.hxx>
 #include <lofty/testing/utility.hxx>
 #include <lofty/text.hxx>
 #include <lofty/text/str.hxx>
+#include <lofty/text/str_traits.hxx>
 #include <lofty/to_str.hxx>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -337,6 +340,434 @@ LOFTY_TESTING_TEST_CASE_FUNC(
 
 namespace lofty { namespace test {
 
+LOFTY_TESTING_TEST_CASE_FUNC(
+   text_transcode_ascii_runs,
+   "lofty::text::transcode() – ASCII runs mixed with other characters"
+) {
+   LOFTY_TRACE_FUNC();
+
+   /* Move a two-byte character (U+00E8) and an invalid byte across a string long enough to be converted in
+   multiple vector-sized blocks, to check that every block boundary is handled. */
+   static std::size_t const size = 80;
+   for (std::size_t pos = 0; pos < size; ++pos) {
+      std::uint8_t utf8[size + 1], utf8_back[size + 1], utf16[size * 2], utf32[size * 4];
+      for (std::size_t i = 0; i < size; ++i) {
+         utf8[i] = static_cast<std::uint8_t>('a' + i % 26);
+      }
+      utf8[pos] = 0xc3;
+      // Shift the tail right to make room for the trail byte.
+      for (std::size_t i = size; i > pos + 1; --i) {
+         utf8[i] = utf8[i - 1];
+      }
+      utf8[pos + 1] = 0xa8;
+
+      // UTF-8 to UTF-32, and back.
+      void const * src = utf8;
+      std::size_t src_size = size + 1, dst_size = sizeof utf32;
+      void * dst = utf32;
+      text::transcode(true, text::encoding::utf8, &src, &src_size, text::encoding::utf32le, &dst, &dst_size);
+      ASSERT(src_size == 0u);
+      ASSERT(dst_size == 0u);
+      ASSERT(utf32[pos * 4] == 0xe8);
+      ASSERT(utf32[pos * 4 + 1] == 0x00);
+      if (pos < size - 1) {
+         ASSERT(utf32[(size - 1) * 4] == utf8[size]);
+      }
+      src = utf32;
+      src_size = sizeof utf32;
+      dst = utf8_back;
+      dst_size = sizeof utf8_back;
+      text::transcode(true, text::encoding::utf32le, &src, &src_size, text::encoding::utf8, &dst, &dst_size);
+      ASSERT(dst_size == 0u);
+      for (std::size_t i = 0; i < size + 1; ++i) {
+         if (utf8_back[i] != utf8[i]) {
+            ASSERT(utf8_back[i] == utf8[i]);
+            break;
+         }
+      }
+
+      // UTF-8 to UTF-16BE, and back.
+      src = utf8;
+      src_size = size + 1;
+      dst = utf16;
+      dst_size = sizeof utf16;
+      text::transcode(true, text::encoding::utf8, &src, &src_size, text::encoding::utf16be, &dst, &dst_size);
+      ASSERT(dst_size == 0u);
+      ASSERT(utf16[0] == 0x00);
+      if (pos > 0) {
+         ASSERT(utf16[1] == utf8[0]);
+      }
+      ASSERT(utf16[pos * 2] == 0x00);
+      ASSERT(utf16[pos * 2 + 1] == 0xe8);
+      src = utf16;
+      src_size = sizeof utf16;
+      dst = utf8_back;
+      dst_size = sizeof utf8_back;
+      text::transcode(true, text::encoding::utf16be, &src, &src_size, text::encoding::utf8, &dst, &dst_size);
+      ASSERT(dst_size == 0u);
+      for (std::size_t i = 0; i < size + 1; ++i) {
+         if (utf8_back[i] != utf8[i]) {
+            ASSERT(utf8_back[i] == utf8[i]);
+            break;
+         }
+      }
+
+      // A destination too small stops at a character boundary.
+      src = utf8;
+      src_size = size + 1;
+      dst = utf8_back;
+      dst_size = pos + 1;
+      text::transcode(true, text::encoding::utf8, &src, &src_size, text::encoding::utf8, &dst, &dst_size);
+      ASSERT(src_size == size + 1 - pos);
+      ASSERT(dst_size == 1u);
+
+      // Invalid bytes are replaced, or cause an exception.
+      utf8[pos] = 0xff;
+      src = utf8;
+      src_size = size + 1;
+      ASSERT(text::transcode(false, text::encoding::utf8, &src, &src_size, text::encoding::utf8) == size + 3);
+      src = utf8;
+      src_size = size + 1;
+      ASSERT_THROWS(
+         text::decode_error,
+         text::transcode(true, text::encoding::utf8, &src, &src_size, text::encoding::utf8)
+      );
+   }
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Encodes a code point in UTF-8, UTF-16 or UTF-32, without relying on text::transcode().
+
+@param cp
+   Code point to encode.
+@param enc
+   Encoding to use.
+@param dst
+   Pointer to the destination buffer.
+@param dst_size
+   Pointer to the count of bytes in the buffer, which will be increased by the size of the encoded code point.
+*/
+static void append_encoded_cp(char32_t cp, text::encoding enc, std::uint8_t * dst, std::size_t * dst_size) {
+   std::uint8_t * p = dst + *dst_size;
+   if (enc == text::encoding::utf8) {
+      if (cp < 0x80) {
+         *p++ = static_cast<std::uint8_t>(cp);
+      } else if (cp < 0x800) {
+         *p++ = static_cast<std::uint8_t>(0xc0 | (cp >> 6));
+         *p++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3f));
+      } else if (cp < 0x10000) {
+         *p++ = static_cast<std::uint8_t>(0xe0 | (cp >> 12));
+         *p++ = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3f));
+         *p++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3f));
+      } else {
+         *p++ = static_cast<std::uint8_t>(0xf0 | (cp >> 18));
+         *p++ = static_cast<std::uint8_t>(0x80 | ((cp >> 12) & 0x3f));
+         *p++ = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3f));
+         *p++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3f));
+      }
+   } else if (enc == text::encoding::utf16le || enc == text::encoding::utf16be) {
+      char32_t units[2];
+      unsigned units_size = 1;
+      if (cp < 0x10000) {
+         units[0] = cp;
+      } else {
+         units[0] = 0xd800 | ((cp - 0x10000) >> 10);
+         units[1] = 0xdc00 | (cp & 0x3ff);
+         units_size = 2;
+      }
+      for (unsigned i = 0; i < units_size; ++i) {
+         std::uint8_t lo = static_cast<std::uint8_t>(units[i]), hi = static_cast<std::uint8_t>(units[i] >> 8);
+         *p++ = enc == text::encoding::utf16le ? lo : hi;
+         *p++ = enc == text::encoding::utf16le ? hi : lo;
+      }
+   } else {
+      for (unsigned i = 0; i < 4; ++i) {
+         unsigned shift = enc == text::encoding::utf32le ? i * 8 : 24 - i * 8;
+         *p++ = static_cast<std::uint8_t>(cp >> shift);
+      }
+   }
+   *dst_size = static_cast<std::size_t>(p - dst);
+}
+
+/*! Checks that text::transcode() converts a buffer in whole, and into the expected bytes.
+
+@param src_enc
+   Source encoding.
+@param src
+   Source buffer.
+@param src_size
+   Size of src, in bytes.
+@param dst_enc
+   Destination encoding.
+@param expected
+   Expected result.
+@param expected_size
+   Size of expected, in bytes.
+@return
+   true if the result is correct, or false otherwise.
+*/
+static bool check_transcode(
+   text::encoding src_enc, std::uint8_t const * src, std::size_t src_size, text::encoding dst_enc,
+   std::uint8_t const * expected, std::size_t expected_size
+) {
+   std::uint8_t dst[1024];
+   void const * src_ptr = src;
+   std::size_t src_left = src_size;
+   if (text::transcode(false, src_enc, &src_ptr, &src_left, dst_enc) != expected_size) {
+      return false;
+   }
+   src_ptr = src;
+   src_left = src_size;
+   void * dst_ptr = dst;
+   std::size_t dst_left = sizeof dst;
+   text::transcode(false, src_enc, &src_ptr, &src_left, dst_enc, &dst_ptr, &dst_left);
+   if (src_left != 0 || sizeof dst - dst_left != expected_size) {
+      return false;
+   }
+   for (std::size_t i = 0; i < expected_size; ++i) {
+      if (dst[i] != expected[i]) {
+         return false;
+      }
+   }
+   return true;
+}
+
+/*! Checks that text::transcode() converts a buffer with a sequence inserted into it the same way as it
+converts each of the three parts separately.
+
+@param src_enc
+   Source encoding.
+@param src
+   Source buffer.
+@param src_size
+   Size of src, in bytes.
+@param pos
+   Offset in src at which to insert the sequence.
+@param seq
+   Sequence to insert.
+@param seq_size
+   Size of seq, in bytes.
+@param dst_enc
+   Destination encoding.
+@return
+   true if the result is correct, or false otherwise.
+*/
+static bool check_transcode_insertion(
+   text::encoding src_enc, std::uint8_t const * src, std::size_t src_size, std::size_t pos,
+   std::uint8_t const * seq, std::size_t seq_size, text::encoding dst_enc
+) {
+   std::uint8_t whole[512];
+   std::size_t whole_size = 0;
+   for (std::size_t i = 0; i < pos; ++i) {
+      whole[whole_size++] = src[i];
+   }
+   for (std::size_t i = 0; i < seq_size; ++i) {
+      whole[whole_size++] = seq[i];
+   }
+   for (std::size_t i = pos; i < src_size; ++i) {
+      whole[whole_size++] = src[i];
+   }
+   std::uint8_t expected[1024];
+   std::size_t expected_size = 0;
+   std::uint8_t const * parts[] = { src, seq, src + pos };
+   std::size_t part_sizes[] = { pos, seq_size, src_size - pos };
+   for (std::size_t i = 0; i < 3; ++i) {
+      void const * part = parts[i];
+      std::size_t part_size = part_sizes[i], dst_size = sizeof expected - expected_size;
+      void * dst = expected + expected_size;
+      text::transcode(false, src_enc, &part, &part_size, dst_enc, &dst, &dst_size);
+      expected_size = sizeof expected - dst_size;
+   }
+   return check_transcode(src_enc, whole, whole_size, dst_enc, expected, expected_size);
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   text_transcode_multibyte_runs,
+   "lofty::text::transcode() – runs of characters of every size"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // The first and last code points of each UTF-8 length, and some in between.
+   static char32_t const cps[] = {
+      'a', 0x7f, 0x80, 0xe8, 0x7ff, 0x800, 0x20ac, 0xd7ff, 0xe000, 0xfffd, 0xffff, 0x10000, 0x1f600, 0x10ffff
+   };
+   static std::size_t const cps_size = sizeof cps / sizeof cps[0];
+   // Index of the first code point beyond the BMP.
+   static std::size_t const bmp_cps_size = 11;
+   static text::encoding const encs[] = {
+      text::encoding::utf16le, text::encoding::utf16be, text::encoding::utf32le, text::encoding::utf32be
+   };
+   /* Sequences that are not valid UTF-8, which the fast paths must leave to the general loop: overlong
+   sequences, an encoded surrogate, code points beyond U+10FFFF, stray continuation bytes, and sequences cut
+   short by another character. */
+   static struct {
+      std::uint8_t bytes[5];
+      std::size_t size;
+   } const odd_utf8_seqs[] = {
+      { { 0xc0, 0x80 }, 2 },
+      { { 0xc1, 0xbf }, 2 },
+      { { 0xe0, 0x80, 0x80 }, 3 },
+      { { 0xed, 0xa0, 0x80 }, 3 },
+      { { 0xf0, 0x80, 0x80, 0x80 }, 4 },
+      { { 0xf4, 0x90, 0x80, 0x80 }, 4 },
+      { { 0x80 }, 1 },
+      { { 0xbf, 0xbf }, 2 },
+      { { 0xf8, 0x88, 0x80, 0x80, 0x80 }, 5 },
+      { { 0xff }, 1 },
+      { { 0xe2, 0x82, 0x41 }, 3 },
+      { { 0xf0, 0x9f, 0x98, 0xc3, 0xa8 }, 5 }
+   };
+   /* Lone surrogates in UTF-16LE, followed by other characters so that they’re not mistaken for the first
+   part of a surrogate pair split across two reads. */
+   static struct {
+      std::uint8_t bytes[6];
+      std::size_t size;
+   } const odd_utf16_seqs[] = {
+      { { 0x00, 0xd8, 0x41, 0x00 }, 4 },
+      { { 0xff, 0xdb, 0xff, 0xdb, 0x41, 0x00 }, 6 },
+      { { 0x00, 0xdc }, 2 },
+      { { 0x00, 0xdc, 0x00, 0xd8, 0x00, 0xdc }, 6 }
+   };
+
+   /* Long sequences of code points, mixed so that characters of every length straddle every position in a
+   vector-sized block; with and without characters beyond the BMP, which take a different path to UTF-16. */
+   for (unsigned bmp_only = 0; bmp_only < 2; ++bmp_only) {
+      std::size_t mix_size = bmp_only ? bmp_cps_size : cps_size;
+      for (std::size_t offset = 0; offset < 16; ++offset) {
+         std::uint8_t utf8[400];
+         std::size_t utf8_size = 0;
+         char32_t seq[100];
+         for (std::size_t i = 0; i < 100; ++i) {
+            // Runs of ASCII characters of different lengths, mixed with other characters.
+            if ((i + offset) % 5 < 2) {
+               seq[i] = static_cast<char32_t>('a' + i % 26);
+            } else {
+               seq[i] = cps[(i * 7 + offset) % mix_size];
+            }
+            append_encoded_cp(seq[i], text::encoding::utf8, utf8, &utf8_size);
+         }
+         for (std::size_t i = 0; i < sizeof encs / sizeof encs[0]; ++i) {
+            std::uint8_t expected[400];
+            std::size_t expected_size = 0;
+            for (std::size_t j = 0; j < 100; ++j) {
+               append_encoded_cp(seq[j], encs[i], expected, &expected_size);
+            }
+            ASSERT(check_transcode(text::encoding::utf8, utf8, utf8_size, encs[i], expected, expected_size));
+            ASSERT(check_transcode(encs[i], expected, expected_size, text::encoding::utf8, utf8, utf8_size));
+         }
+         ASSERT(check_transcode(
+            text::encoding::utf8, utf8, utf8_size, text::encoding::utf8, utf8, utf8_size
+         ));
+
+         /* Insert each invalid sequence at the start of a character, and check that it’s decoded the same
+         way as it would be in isolation, which is handled by the general loop. */
+         std::size_t pos = 0;
+         for (std::size_t i = 0; i < offset * 3; ++i) {
+            pos += utf8[pos] < 0x80 ? 1 : utf8[pos] < 0xe0 ? 2 : utf8[pos] < 0xf0 ? 3 : 4;
+         }
+         for (std::size_t i = 0; i < sizeof odd_utf8_seqs / sizeof odd_utf8_seqs[0]; ++i) {
+            ASSERT(check_transcode_insertion(
+               text::encoding::utf8, utf8, utf8_size, pos, odd_utf8_seqs[i].bytes, odd_utf8_seqs[i].size,
+               text::encoding::utf32le
+            ));
+         }
+         std::uint8_t utf16[400];
+         std::size_t utf16_size = 0;
+         pos = 0;
+         for (std::size_t i = 0; i < 100; ++i) {
+            if (i == offset * 3) {
+               pos = utf16_size;
+            }
+            append_encoded_cp(seq[i], text::encoding::utf16le, utf16, &utf16_size);
+         }
+         for (std::size_t i = 0; i < sizeof odd_utf16_seqs / sizeof odd_utf16_seqs[0]; ++i) {
+            ASSERT(check_transcode_insertion(
+               text::encoding::utf16le, utf16, utf16_size, pos, odd_utf16_seqs[i].bytes,
+               odd_utf16_seqs[i].size, text::encoding::utf8
+            ));
+         }
+      }
+   }
+
+   // A stray continuation byte causes an exception if requested, even in the middle of a run.
+   std::uint8_t utf8[60];
+   std::size_t utf8_size = 0;
+   for (std::size_t i = 0; i < 20; ++i) {
+      append_encoded_cp(0x20ac, text::encoding::utf8, utf8, &utf8_size);
+   }
+   utf8[30] = 0x80;
+   void const * src = utf8;
+   ASSERT_THROWS(text::decode_error, text::transcode(
+      true, text::encoding::utf8, &src, &utf8_size, text::encoding::utf16le
+   ));
+
+   // So does a UTF-32 code unit beyond U+10FFFF, which can’t be encoded at all.
+   std::uint8_t utf32[80];
+   std::size_t utf32_size = 0;
+   for (std::size_t i = 0; i < 20; ++i) {
+      append_encoded_cp(i == 10 ? 0x110000 : 0x20ac, text::encoding::utf32le, utf32, &utf32_size);
+   }
+   src = utf32;
+   ASSERT_THROWS(text::error, text::transcode(
+      false, text::encoding::utf32le, &src, &utf32_size, text::encoding::utf8
+   ));
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   text_get_valid_utf8_prefix_size,
+   "lofty::text::get_valid_utf8_prefix_size() – validation of UTF-8 buffers"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // ASCII, then U+00E8, U+20AC and U+24B62, long enough to span multiple vector-sized blocks.
+   static std::uint8_t const valid[] = {
+      'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+      'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', 'a', 'b', 'c', 'd', 'e', 'f',
+      'g', 'h', 'i', 'j', 0xc3, 0xa8, 0xe2, 0x82, 0xac, 0xf0, 0xa4, 0xad, 0xa2, 'k'
+   };
+   ASSERT(text::get_valid_utf8_prefix_size(valid, 0) == 0u);
+   ASSERT(text::get_valid_utf8_prefix_size(valid, sizeof valid) == sizeof valid);
+   // Sequences cut short by the end of the buffer are not part of the prefix.
+   ASSERT(text::get_valid_utf8_prefix_size(valid, 37) == 36u);
+   ASSERT(text::get_valid_utf8_prefix_size(valid, 40) == 38u);
+   ASSERT(text::get_valid_utf8_prefix_size(valid, 44) == 41u);
+
+   // Stray trail byte.
+   static std::uint8_t const stray_trail[] = { 'a', 0x81, 'b' };
+   ASSERT(text::get_valid_utf8_prefix_size(stray_trail, sizeof stray_trail) == 1u);
+   // Sequence interrupted by an ASCII character.
+   static std::uint8_t const interrupted[] = { 'a', 0xe2, 0x82, 'b' };
+   ASSERT(text::get_valid_utf8_prefix_size(interrupted, sizeof interrupted) == 1u);
+   // Overlong encodings of U+0001 and U+007F.
+   static std::uint8_t const overlong2[] = { 'a', 0xc0, 0x81 };
+   ASSERT(text::get_valid_utf8_prefix_size(overlong2, sizeof overlong2) == 1u);
+   static std::uint8_t const overlong3[] = { 'a', 0xe0, 0x81, 0xbf };
+   ASSERT(text::get_valid_utf8_prefix_size(overlong3, sizeof overlong3) == 1u);
+   // Beyond U+10FFFF.
+   static std::uint8_t const too_large[] = { 'a', 0xf4, 0x90, 0x80, 0x80 };
+   ASSERT(text::get_valid_utf8_prefix_size(too_large, sizeof too_large) == 1u);
+   // Technically possible, but not valid UTF-8.
+   static std::uint8_t const five_bytes[] = { 'a', 0xf9, 0x81, 0x81, 0x81, 0x81 };
+   ASSERT(text::get_valid_utf8_prefix_size(five_bytes, sizeof five_bytes) == 1u);
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
 LOFTY_TESTING_TEST_CASE_FUNC(
    text_str_char_replacement,
    "lofty::text::str – character replacement"
@@ -471,6 +902,178 @@ LOFTY_TESTING_TEST_CASE_FUNC(
    ASSERT(s.find_last(LOFTY_SL("ac")) == s.cend() - 9);
    ASSERT(s.find_last(LOFTY_SL("ca")) == s.cend() - 2);
 #endif
+
+   text::str const substr(text::str::empty + 'a' + cp2 + cp0 + 'a');
+   text::str_searcher const searcher(substr.data(), substr.data_end());
+   ASSERT(s.find(searcher) == s.cbegin() + 5);
+   ASSERT(s.find(searcher, s.cbegin() + 6) == s.find(substr, s.cbegin() + 6));
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+/*! Returns the first occurrence of a substring in a string, searching naively.
+
+@param str_begin
+   Pointer to the first character of the string to be searched.
+@param str_end
+   Pointer to beyond the last character of the string to be searched.
+@param substr_begin
+   Pointer to the first character of the string to search for.
+@param substr_end
+   Pointer to beyond the last character of the string to search for.
+@return
+   Pointer to the beginning of the first match, or str_end if no matches are found.
+*/
+static text::char_t const * naive_find_substr(
+   text::char_t const * str_begin, text::char_t const * str_end,
+   text::char_t const * substr_begin, text::char_t const * substr_end
+) {
+   auto substr_size = substr_end - substr_begin;
+   for (auto s = str_begin; str_end - s >= substr_size; ++s) {
+      if (text::str_traits::compare(s, s + substr_size, substr_begin, substr_end) == 0) {
+         return s;
+      }
+   }
+   return str_end;
+}
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   text_str_traits_find,
+   "lofty::text::str_traits – character and substring search"
+) {
+   LOFTY_TRACE_FUNC();
+
+   // Substrings that partially match themselves.
+   {
+      text::str const s(LOFTY_SL("AAAB"));
+      ASSERT(s.find(LOFTY_SL("AAB")) == s.cbegin() + 1);
+   }
+   {
+      text::str const s(LOFTY_SL("xxAAAAB"));
+      ASSERT(s.find(LOFTY_SL("AAAB")) == s.cbegin() + 3);
+   }
+   {
+      text::str const s(LOFTY_SL("ABABABC"));
+      ASSERT(s.find(LOFTY_SL("ABABC")) == s.cbegin() + 2);
+   }
+
+   /* Move a match across a string long enough to be searched in multiple vector-sized blocks, to check that
+   every block boundary is handled. */
+   text::str const substrs[] = {
+      text::str(LOFTY_SL("xy")),
+      text::str(LOFTY_SL("xay")),
+      text::str(LOFTY_SL("aaaaaaax")),
+      text::str(LOFTY_SL("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaax"))
+   };
+   for (std::size_t j = 0; j < sizeof substrs / sizeof substrs[0]; ++j) {
+      text::str const & substr = substrs[j];
+      text::str_searcher const searcher(substr.data(), substr.data_end());
+      for (std::size_t pos = 0; pos < 100; ++pos) {
+         // Fill the string with partial matches, which are all rejected.
+         text::str s;
+         for (std::size_t i = 0; i < 100; ++i) {
+            s += i == pos ? substr : text::str(substr.data(), substr.data_end() - 1);
+         }
+         auto expected = naive_find_substr(s.data(), s.data_end(), substr.data(), substr.data_end());
+         ASSERT(text::str_traits::find_substr(
+            s.data(), s.data_end(), substr.data(), substr.data_end()
+         ) == expected);
+         ASSERT(searcher.find(s.data(), s.data_end()) == expected);
+         ASSERT(text::str_traits::find_substr(
+            s.data(), expected + substr.size_in_chars() - 1, substr.data(), substr.data_end()
+         ) == expected + substr.size_in_chars() - 1);
+      }
+   }
+
+   /* Every position is a candidate that fails late: this should switch to the search that doesn’t depend on
+   the substring’s contents, and still find the match. */
+   {
+      text::str const substr(LOFTY_SL("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaabaa"));
+      text::str s;
+      for (std::size_t i = 0; i < 1000; ++i) {
+         s += 'a';
+      }
+      s += substr;
+      ASSERT(s.find(substr) == s.cbegin() + 1000);
+      s += substr;
+      ASSERT(s.find(substr, s.cbegin() + 1001) == s.cbegin() + 1000 + 35);
+   }
+
+   text::str s;
+   for (std::size_t i = 0; i < 100; ++i) {
+      s += LOFTY_SL("abcdefg");
+   }
+   for (std::size_t pos = 0; pos < s.size_in_chars(); ++pos) {
+      text::char_t const * begin = s.data(), * end = s.data_end(), * at = begin + pos;
+      ASSERT(text::str_traits::find_char(at, end, *at) == at);
+      ASSERT(text::str_traits::find_char(begin, end, 'x') == end);
+      ASSERT(text::str_traits::find_char_last(begin, at + 1, *at) == at);
+      ASSERT(text::str_traits::find_char_last(begin, at + 1, 'x') == begin);
+   }
+   // Code points longer than one character are found by their lead character.
+   s = s + plane2_cp + s;
+   auto cp2_itr(s.find(plane2_cp));
+   ASSERT(cp2_itr == s.cbegin() + 700);
+   ASSERT(s.find(plane2_cp, cp2_itr + 1) == s.cend());
+}
+
+}} //namespace lofty::test
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace lofty { namespace test {
+
+LOFTY_TESTING_TEST_CASE_FUNC(
+   text_str_hash,
+   "lofty::text::str – hashing"
+) {
+   LOFTY_TRACE_FUNC();
+
+   _std::hash<text::str> hasher;
+   // Equal strings hash equally, regardless of how their characters are stored.
+   text::str const literal(LOFTY_SL("hash map key"));
+   text::str copy(literal.data(), literal.data_end());
+   text::sstr<64> embedded;
+   embedded += literal;
+   ASSERT(hasher(copy) == hasher(literal));
+   ASSERT(hasher(embedded.str()) == hasher(literal));
+   ASSERT(hasher(text::str::empty) == hasher(text::str()));
+
+   /* Strings of every size up to a few blocks of the hash function, and strings differing only in their last
+   character, should all hash differently. */
+   collections::vector<std::size_t> hashes;
+   text::str s;
+   for (std::size_t i = 0; i < 100; ++i) {
+      s += static_cast<char>('a' + i % 26);
+      hashes.push_back(hasher(s));
+      s += '!';
+      hashes.push_back(hasher(s));
+      s.set_size_in_chars(s.size_in_chars() - 1);
+   }
+   unsigned collisions = 0;
+   for (std::size_t i = 0; i < hashes.size(); ++i) {
+      for (std::size_t j = i + 1; j < hashes.size(); ++j) {
+         if (hashes[static_cast<std::ptrdiff_t>(i)] == hashes[static_cast<std::ptrdiff_t>(j)]) {
+            ++collisions;
+         }
+      }
+   }
+   ASSERT(collisions == 0u);
+
+   text::hashed_str const key(LOFTY_SL("hash map key"));
+   ASSERT(key.hash() == hasher(literal));
+   ASSERT((key == text::hashed_str(copy)));
+   ASSERT((key != text::hashed_str(LOFTY_SL("hash map keY"))));
+   collections::hash_map<text::hashed_str, int> map;
+   map.add_or_assign(key, 1);
+   map.add_or_assign(LOFTY_SL("other key"), 2);
+   ASSERT(map[key] == 1);
+   ASSERT(map[text::hashed_str(copy)] == 1);
+   ASSERT(map[LOFTY_SL("other key")] == 2);
 }
 
 }} //namespace lofty::test